@@ -0,0 +1,278 @@
+﻿/****************************************************************************
+ * ==> AABB tree refit test ------------------------------------------------*
+ ****************************************************************************
+ * Description : A console test checking that the AABB trees built on the   *
+ *               first frame of the MDL models may be refit to their other  *
+ *               frames, and give the same hits as trees built on each      *
+ *               frame                                                      *
+ * Developer   : Jean-Milost Reymond                                        *
+ * Copyright   : 2017 - 2022, this file is part of the CompactStar Engine.  *
+ *               You are free to copy or redistribute this file, modify it, *
+ *               or use it for your own projects, commercial or not. This   *
+ *               file is provided "as is", WITHOUT ANY WARRANTY OF ANY      *
+ *               KIND. THE DEVELOPER IS NOT RESPONSIBLE FOR ANY DAMAGE OF   *
+ *               ANY KIND, ANY LOSS OF DATA, OR ANY LOSS OF PRODUCTIVITY    *
+ *               TIME THAT MAY RESULT FROM THE USAGE OF THIS SOURCE CODE,   *
+ *               DIRECTLY OR NOT.                                           *
+ ****************************************************************************/
+
+// NOTE this test is built and run by the CMakeLists.txt file located in the engine root directory,
+// e.g. with ctest. It should be run from the engine root directory, thus the resources may be found.
+// It returns 0 if all the checks succeeded, otherwise 1
+
+// std
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// compactStar engine
+#include "SDK/CSR_Common.h"
+#include "SDK/CSR_Geometry.h"
+#include "SDK/CSR_Collision.h"
+#include "SDK/CSR_Vertex.h"
+#include "SDK/CSR_Model.h"
+#include "SDK/CSR_Mdl.h"
+
+// resources
+#define WIZARD_FILE    "Resources/wizard.mdl"
+#define RAINDROP_FILE  "Resources/RaindropChar_Walking.mdl"
+
+// test values
+#define RAY_COUNT      256
+#define HIT_TOLERANCE  0.0001f
+
+//------------------------------------------------------------------------------
+size_t g_FailCount = 0;
+//------------------------------------------------------------------------------
+void Check(int condition, const char* pFileName, size_t frame, const char* pMessage)
+{
+    if (condition)
+        return;
+
+    printf("FAILED: %s, frame %u: %s\n", pFileName, (unsigned)frame, pMessage);
+    ++g_FailCount;
+}
+//------------------------------------------------------------------------------
+const CSR_Mesh* GetFrame(const CSR_MDL* pMDL, size_t index)
+{
+    // each MDL model contains a frame
+    return &pMDL->m_pModel[index].m_pMesh[0];
+}
+//------------------------------------------------------------------------------
+int IsSameIndexBuffer(const CSR_IndexBuffer* pIB1, const CSR_IndexBuffer* pIB2)
+{
+    const size_t indexSize = (pIB1->m_Format == CSR_IF_16Bit) ? sizeof(unsigned short) : sizeof(unsigned);
+
+    return pIB1->m_Count  == pIB2->m_Count  &&
+           pIB1->m_Format == pIB2->m_Format &&
+           !memcmp(pIB1->m_pData, pIB2->m_pData, pIB1->m_Count * indexSize);
+}
+//------------------------------------------------------------------------------
+void GetRay(const CSR_Box* pBox, size_t index, CSR_Ray3* pRay)
+{
+    CSR_Vector3 center;
+    CSR_Vector3 target;
+    CSR_Vector3 pos;
+    CSR_Vector3 dir;
+    float       radius;
+    float       theta;
+    float       phi;
+
+    center.m_X = (pBox->m_Min.m_X + pBox->m_Max.m_X) * 0.5f;
+    center.m_Y = (pBox->m_Min.m_Y + pBox->m_Max.m_Y) * 0.5f;
+    center.m_Z = (pBox->m_Min.m_Z + pBox->m_Max.m_Z) * 0.5f;
+
+    radius = (pBox->m_Max.m_X - pBox->m_Min.m_X) +
+             (pBox->m_Max.m_Y - pBox->m_Min.m_Y) +
+             (pBox->m_Max.m_Z - pBox->m_Min.m_Z);
+
+    // spread the ray origins on a sphere surrounding the model, using the golden angle
+    theta = (float)index * 2.3999632f;
+    phi   = acosf(1.0f - (2.0f * ((float)index + 0.5f)) / (float)RAY_COUNT);
+
+    pos.m_X = center.m_X + radius * sinf(phi) * cosf(theta);
+    pos.m_Y = center.m_Y + radius * cosf(phi);
+    pos.m_Z = center.m_Z + radius * sinf(phi) * sinf(theta);
+
+    // aim at a point around the model center, thus the rays reach the model at various places
+    target.m_X = center.m_X + (pBox->m_Max.m_X - center.m_X) * 0.5f * sinf(theta * 3.0f);
+    target.m_Y = center.m_Y + (pBox->m_Max.m_Y - center.m_Y) * 0.5f * cosf(theta * 5.0f);
+    target.m_Z = center.m_Z + (pBox->m_Max.m_Z - center.m_Z) * 0.5f * sinf(theta * 7.0f);
+
+    csrVec3Sub(&target, &pos, &dir);
+    csrVec3Normalize(&dir, &dir);
+    csrRay3FromPointDir(&pos, &dir, pRay);
+}
+//------------------------------------------------------------------------------
+int IsBoxInside(const CSR_Box* pBox, const CSR_Box* pContainer)
+{
+    return pBox->m_Min.m_X >= pContainer->m_Min.m_X && pBox->m_Max.m_X <= pContainer->m_Max.m_X &&
+           pBox->m_Min.m_Y >= pContainer->m_Min.m_Y && pBox->m_Max.m_Y <= pContainer->m_Max.m_Y &&
+           pBox->m_Min.m_Z >= pContainer->m_Min.m_Z && pBox->m_Max.m_Z <= pContainer->m_Max.m_Z;
+}
+//------------------------------------------------------------------------------
+void CheckSameHits(const char*         pFileName,
+                   size_t              frame,
+                   const CSR_AABBNode* pRefitTree,
+                   const CSR_AABBNode* pFrameTree)
+{
+    size_t          i;
+    int             refitResult;
+    int             frameResult;
+    CSR_Ray3        ray;
+    CSR_AABBTreeHit refitHit;
+    CSR_AABBTreeHit frameHit;
+
+    for (i = 0; i < RAY_COUNT; ++i)
+    {
+        GetRay(pFrameTree->m_pBox, i, &ray);
+
+        refitResult = csrAABBTreeRayCast(&ray, pRefitTree, -1.0f, &refitHit);
+        frameResult = csrAABBTreeRayCast(&ray, pFrameTree, -1.0f, &frameHit);
+
+        if (refitResult != frameResult)
+        {
+            Check(0, pFileName, frame, "the refit tree and the frame tree hit different polygons");
+            return;
+        }
+
+        if (refitResult && fabs(refitHit.m_Distance - frameHit.m_Distance) > HIT_TOLERANCE * frameHit.m_Distance)
+        {
+            Check(0, pFileName, frame, "the refit tree and the frame tree hit at different distances");
+            return;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void CheckModel(const char* pFileName)
+{
+    size_t          i;
+    size_t          frameCount;
+    unsigned short  swap;
+    CSR_MDL*        pMDL;
+    CSR_AABBNode*   pRefitTree;
+    CSR_AABBNode*   pUnionTree;
+    CSR_AABBNode*   pFrameTree;
+    CSR_IndexBuffer index;
+
+    pMDL = csrMDLOpen(pFileName, 0, 0, 0, 0, 0, 0, 0);
+
+    if (!pMDL)
+    {
+        Check(0, pFileName, 0, "the model could not be opened");
+        return;
+    }
+
+    frameCount = pMDL->m_ModelCount;
+
+    printf("%s: %u frames\n", pFileName, (unsigned)frameCount);
+
+    Check(frameCount > 1, pFileName, 0, "the model isn't animated");
+
+    // all the frames should be welded the same way, thus the same vertices match in each of them
+    for (i = 1; i < frameCount; ++i)
+    {
+        Check(GetFrame(pMDL, i)->m_pVB->m_Count == GetFrame(pMDL, 0)->m_pVB->m_Count,
+              pFileName,
+              i,
+              "the frame vertex count differs from the first frame");
+        Check(IsSameIndexBuffer(&GetFrame(pMDL, i)->m_pVB->m_Index, &GetFrame(pMDL, 0)->m_pVB->m_Index),
+              pFileName,
+              i,
+              "the frame indices differ from the first frame");
+    }
+
+    pRefitTree = csrAABBTreeFromMesh(GetFrame(pMDL, 0));
+    pUnionTree = csrAABBTreeFromMesh(GetFrame(pMDL, 0));
+
+    if (!pRefitTree || !pUnionTree)
+    {
+        Check(0, pFileName, 0, "the trees could not be created");
+        csrAABBTreeNodeRelease(pRefitTree);
+        csrAABBTreeNodeRelease(pUnionTree);
+        csrMDLRelease(pMDL, 0);
+        return;
+    }
+
+    // refit the trees to each frame, and compare them with a tree built on the frame
+    for (i = 1; i < frameCount; ++i)
+    {
+        Check(csrAABBTreeRefit(pRefitTree, GetFrame(pMDL, i - 1), GetFrame(pMDL, i), 0),
+              pFileName,
+              i,
+              "the tree could not be refit");
+        Check(csrAABBTreeRefit(pUnionTree, GetFrame(pMDL, 0), GetFrame(pMDL, i), 1),
+              pFileName,
+              i,
+              "the union tree could not be refit");
+
+        pFrameTree = csrAABBTreeFromMesh(GetFrame(pMDL, i));
+
+        if (!pFrameTree)
+        {
+            Check(0, pFileName, i, "the frame tree could not be created");
+            continue;
+        }
+
+        CheckSameHits(pFileName, i, pRefitTree, pFrameTree);
+
+        Check(IsBoxInside(pFrameTree->m_pBox, pUnionTree->m_pBox),
+              pFileName,
+              i,
+              "the union tree doesn't surround the frame");
+
+        csrAABBTreeNodeRelease(pFrameTree);
+    }
+
+    csrAABBTreeNodeRelease(pRefitTree);
+    csrAABBTreeNodeRelease(pUnionTree);
+
+    // a frame whose indices differ should be rejected, even if its vertex count is the same
+    if (frameCount > 1 && GetFrame(pMDL, 1)->m_pVB->m_Index.m_Format == CSR_IF_16Bit)
+    {
+        index = GetFrame(pMDL, 1)->m_pVB->m_Index;
+
+        swap                                = ((unsigned short*)index.m_pData)[0];
+        ((unsigned short*)index.m_pData)[0] = ((unsigned short*)index.m_pData)[1];
+        ((unsigned short*)index.m_pData)[1] = swap;
+
+        pRefitTree = csrAABBTreeFromMesh(GetFrame(pMDL, 0));
+        pUnionTree = csrAABBTreeFromMesh(GetFrame(pMDL, 0));
+
+        Check(pRefitTree && !csrAABBTreeRefit(pRefitTree, GetFrame(pMDL, 0), GetFrame(pMDL, 1), 0),
+              pFileName,
+              1,
+              "the tree was refit to a frame with different indices");
+        Check(pUnionTree && !csrAABBTreeRefit(pUnionTree, GetFrame(pMDL, 0), GetFrame(pMDL, 1), 1),
+              pFileName,
+              1,
+              "the union tree was refit to a frame with different indices");
+
+        csrAABBTreeNodeRelease(pRefitTree);
+        csrAABBTreeNodeRelease(pUnionTree);
+
+        ((unsigned short*)index.m_pData)[1] = ((unsigned short*)index.m_pData)[0];
+        ((unsigned short*)index.m_pData)[0] = swap;
+    }
+
+    csrMDLRelease(pMDL, 0);
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    // the wizard frames weld the same way, whereas the raindrop character frames would not, if
+    // they were welded separately
+    CheckModel(WIZARD_FILE);
+    CheckModel(RAINDROP_FILE);
+
+    if (g_FailCount)
+    {
+        printf("%u checks failed\n", (unsigned)g_FailCount);
+        return 1;
+    }
+
+    printf("All checks succeeded\n");
+    return 0;
+}
+//------------------------------------------------------------------------------
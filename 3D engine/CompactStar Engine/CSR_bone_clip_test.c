@@ -0,0 +1,244 @@
+﻿/****************************************************************************
+ * ==> Bone clip test ------------------------------------------------------*
+ ****************************************************************************
+ * Description : A console test checking that the baked animation clips,    *
+ *               quantized or not, restore the same bone matrices as the    *
+ *               bone pose calculated from the animation keys               *
+ * Developer   : Jean-Milost Reymond                                        *
+ * Copyright   : 2017 - 2022, this file is part of the CompactStar Engine.  *
+ *               You are free to copy or redistribute this file, modify it, *
+ *               or use it for your own projects, commercial or not. This   *
+ *               file is provided "as is", WITHOUT ANY WARRANTY OF ANY      *
+ *               KIND. THE DEVELOPER IS NOT RESPONSIBLE FOR ANY DAMAGE OF   *
+ *               ANY KIND, ANY LOSS OF DATA, OR ANY LOSS OF PRODUCTIVITY    *
+ *               TIME THAT MAY RESULT FROM THE USAGE OF THIS SOURCE CODE,   *
+ *               DIRECTLY OR NOT.                                           *
+ ****************************************************************************/
+
+// NOTE this test is built and run by the CMakeLists.txt file located in the engine root directory,
+// e.g. with ctest. It should be run from the engine root directory, thus the resources may be found.
+// It returns 0 if all the checks succeeded, otherwise 1
+
+// std
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+// compactStar engine
+#include "SDK/CSR_Common.h"
+#include "SDK/CSR_Geometry.h"
+#include "SDK/CSR_Model.h"
+#include "SDK/CSR_X.h"
+
+// resources
+#define TINY_FILE             "Resources/tiny_4anim.x"
+
+// test values
+#define FRAME_STRIDE          7
+#define BLEND_STEP            4
+#define ROTATION_TOLERANCE    0.01f
+#define TRANSLATION_TOLERANCE 0.01f
+#define MIRRORED_SET          3
+#define MIRRORED_FRAME        2720
+#define MIRRORED_BONE         23
+
+//------------------------------------------------------------------------------
+size_t g_FailCount = 0;
+//------------------------------------------------------------------------------
+void Check(int condition, size_t animSetIndex, size_t frame, const char* pMessage)
+{
+    if (condition)
+        return;
+
+    printf("FAILED: set %u, frame %u: %s\n", (unsigned)animSetIndex, (unsigned)frame, pMessage);
+    ++g_FailCount;
+}
+//------------------------------------------------------------------------------
+float GetDeterminant(const CSR_Matrix4* pMatrix)
+{
+    return pMatrix->m_Table[0][0] * ((pMatrix->m_Table[1][1] * pMatrix->m_Table[2][2]) -
+                                     (pMatrix->m_Table[1][2] * pMatrix->m_Table[2][1])) -
+           pMatrix->m_Table[0][1] * ((pMatrix->m_Table[1][0] * pMatrix->m_Table[2][2]) -
+                                     (pMatrix->m_Table[1][2] * pMatrix->m_Table[2][0])) +
+           pMatrix->m_Table[0][2] * ((pMatrix->m_Table[1][0] * pMatrix->m_Table[2][1]) -
+                                     (pMatrix->m_Table[1][1] * pMatrix->m_Table[2][0]));
+}
+//------------------------------------------------------------------------------
+int IsSameScaling(const CSR_Matrix4* pClipMatrix, const CSR_Matrix4* pPoseMatrix)
+{
+    size_t i;
+    float  clipScaling;
+    float  poseScaling;
+
+    // the scaling is the length of each matrix axis, a blended rotation shouldn't shrink it
+    for (i = 0; i < 3; ++i)
+    {
+        clipScaling = sqrtf((pClipMatrix->m_Table[i][0] * pClipMatrix->m_Table[i][0]) +
+                            (pClipMatrix->m_Table[i][1] * pClipMatrix->m_Table[i][1]) +
+                            (pClipMatrix->m_Table[i][2] * pClipMatrix->m_Table[i][2]));
+        poseScaling = sqrtf((pPoseMatrix->m_Table[i][0] * pPoseMatrix->m_Table[i][0]) +
+                            (pPoseMatrix->m_Table[i][1] * pPoseMatrix->m_Table[i][1]) +
+                            (pPoseMatrix->m_Table[i][2] * pPoseMatrix->m_Table[i][2]));
+
+        if (fabs(clipScaling - poseScaling) > ROTATION_TOLERANCE)
+            return 0;
+    }
+
+    return 1;
+}
+//------------------------------------------------------------------------------
+int IsSameMatrix(const CSR_Matrix4* pClipMatrix, const CSR_Matrix4* pPoseMatrix)
+{
+    size_t i;
+    size_t j;
+
+    for (i = 0; i < 3; ++i)
+        for (j = 0; j < 3; ++j)
+            if (fabs(pClipMatrix->m_Table[i][j] - pPoseMatrix->m_Table[i][j]) > ROTATION_TOLERANCE)
+                return 0;
+
+    for (j = 0; j < 3; ++j)
+        if (fabs(pClipMatrix->m_Table[3][j] - pPoseMatrix->m_Table[3][j]) > TRANSLATION_TOLERANCE)
+            return 0;
+
+    return 1;
+}
+//------------------------------------------------------------------------------
+void GetClipPose(const CSR_X* pX, size_t animSetIndex, size_t frame, CSR_Matrix4* pMatrices)
+{
+    csrBoneClipGetPose(&pX->m_pClips[animSetIndex], (float)frame, pX->m_pPose);
+    memcpy(pMatrices, pX->m_pPose->m_pMatrices, pX->m_pPose->m_Count * sizeof(CSR_Matrix4));
+}
+//------------------------------------------------------------------------------
+void CheckQuantizedClips(CSR_X* pX, CSR_Matrix4* pMatrices)
+{
+    size_t i;
+    size_t j;
+    size_t frame;
+    size_t frameCount;
+
+    // bake a sample per frame, thus the quantization is the only difference with the bone pose
+    if (!csrXBakeAnimations(pX, 1, 1))
+    {
+        Check(0, 0, 0, "the quantized clips could not be baked");
+        return;
+    }
+
+    for (i = 0; i < pX->m_AnimationSetCount; ++i)
+    {
+        frameCount = csrBoneAnimSetGetFrameCount(&pX->m_pAnimationSet[i]);
+
+        for (frame = 0; frame < frameCount; frame += FRAME_STRIDE)
+        {
+            GetClipPose(pX, i, frame, pMatrices);
+            csrBonePoseUpdate(pX->m_pPose, i, frame, 0);
+
+            for (j = 0; j < pX->m_pPose->m_Count; ++j)
+                if (!IsSameMatrix(&pMatrices[j], &pX->m_pPose->m_pMatrices[j]))
+                {
+                    Check(0, i, frame, "the quantized clip differs from the bone pose");
+                    break;
+                }
+        }
+    }
+
+    // this bone is mirrored, it should be restored with its mirroring
+    GetClipPose(pX, MIRRORED_SET, MIRRORED_FRAME, pMatrices);
+    csrBonePoseUpdate(pX->m_pPose, MIRRORED_SET, MIRRORED_FRAME, 0);
+
+    Check(GetDeterminant(&pX->m_pPose->m_pMatrices[MIRRORED_BONE]) < 0.0f,
+          MIRRORED_SET,
+          MIRRORED_FRAME,
+          "the bone isn't mirrored in the bone pose");
+    Check(IsSameMatrix(&pMatrices[MIRRORED_BONE], &pX->m_pPose->m_pMatrices[MIRRORED_BONE]),
+          MIRRORED_SET,
+          MIRRORED_FRAME,
+          "the mirrored bone differs from the bone pose");
+}
+//------------------------------------------------------------------------------
+void CheckBlendedClips(CSR_X* pX, CSR_Matrix4* pMatrices)
+{
+    size_t i;
+    size_t j;
+    size_t frame;
+    size_t frameCount;
+
+    // bake the matrices every few frames, thus the frames between them are blended. NOTE the
+    // previous clips are replaced
+    if (!csrXBakeAnimations(pX, BLEND_STEP, 0))
+    {
+        Check(0, 0, 0, "the matrix clips could not be baked");
+        return;
+    }
+
+    for (i = 0; i < pX->m_AnimationSetCount; ++i)
+    {
+        frameCount = csrBoneAnimSetGetFrameCount(&pX->m_pAnimationSet[i]);
+
+        for (frame = 0; frame < frameCount; frame += FRAME_STRIDE)
+        {
+            GetClipPose(pX, i, frame, pMatrices);
+            csrBonePoseUpdate(pX->m_pPose, i, frame, 0);
+
+            // the samples should be restored as is, and the blended bones should keep their scaling
+            for (j = 0; j < pX->m_pPose->m_Count; ++j)
+                if (!(frame % BLEND_STEP) && memcmp(&pMatrices[j], &pX->m_pPose->m_pMatrices[j], sizeof(CSR_Matrix4)))
+                {
+                    Check(0, i, frame, "the matrix clip sample differs from the bone pose");
+                    break;
+                }
+                else
+                if (!IsSameScaling(&pMatrices[j], &pX->m_pPose->m_pMatrices[j]))
+                {
+                    Check(0, i, frame, "the blended bone scaling differs from the bone pose");
+                    break;
+                }
+        }
+    }
+}
+//------------------------------------------------------------------------------
+int main(void)
+{
+    CSR_X*       pX;
+    CSR_Matrix4* pMatrices;
+
+    pX = csrXOpen(TINY_FILE, 0, 0, 0, 0, 0, 0, 0, 0, 0);
+
+    if (!pX || !pX->m_pPose || !pX->m_AnimationSetCount)
+    {
+        printf("FAILED: %s could not be opened\n", TINY_FILE);
+        csrXRelease(pX, 0);
+        return 1;
+    }
+
+    printf("%s: %u bones, %u animation sets\n",
+           TINY_FILE,
+           (unsigned)pX->m_pPose->m_Count,
+           (unsigned)pX->m_AnimationSetCount);
+
+    pMatrices = (CSR_Matrix4*)malloc(pX->m_pPose->m_Count * sizeof(CSR_Matrix4));
+
+    if (!pMatrices)
+    {
+        printf("FAILED: out of memory\n");
+        csrXRelease(pX, 0);
+        return 1;
+    }
+
+    CheckQuantizedClips(pX, pMatrices);
+    CheckBlendedClips(pX, pMatrices);
+
+    free(pMatrices);
+    csrXRelease(pX, 0);
+
+    if (g_FailCount)
+    {
+        printf("%u checks failed\n", (unsigned)g_FailCount);
+        return 1;
+    }
+
+    printf("All checks succeeded\n");
+    return 0;
+}
+//------------------------------------------------------------------------------
@@ -384,8 +384,13 @@ int LoadLandscapeFromBitmap(const char* fileName)
 
     // succeeded?
     if (pSceneItem)
+    {
         pSceneItem->m_CollisionType = CSR_CO_Ground;
 
+        // the landscape hills hide the objects behind them
+        pSceneItem->m_Occluder = 1;
+    }
+
     // keep the key
     g_pLandscapeKey = pModel;
 
@@ -945,6 +950,9 @@ void on_GLES2_Init(int view_w, int view_h)
     // initialize the scene
     g_pScene = csrSceneCreate();
 
+    // cull the objects hidden by the landscape
+    csrSceneEnableOcclusion(g_pScene, 256, 128);
+
     // configure the scene background color
     g_pScene->m_Color.m_R = 0.45f;
     g_pScene->m_Color.m_G = 0.8f;
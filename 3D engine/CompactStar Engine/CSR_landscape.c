@@ -101,6 +101,7 @@ ALCdevice*        g_pOpenALDevice  = 0;
 ALCcontext*       g_pOpenALContext = 0;
 CSR_Sound*        g_pSound         = 0;
 CSR_OpenGLID      g_ID[1];
+CSR_OpenGLStaticVB g_StaticVB[1];
 //---------------------------------------------------------------------------
 void* OnGetID(const void* pKey)
 {
@@ -112,6 +113,12 @@ void* OnGetID(const void* pKey)
         if (pKey == g_ID[i].m_pKey)
             return &g_ID[i];
 
+    // iterate through static vertex buffers
+    for (i = 0; i < 1; ++i)
+        // found the vertex buffer to get?
+        if (pKey == g_StaticVB[i].m_pKey)
+            return &g_StaticVB[i];
+
     return 0;
 }
 //---------------------------------------------------------------------------
@@ -295,6 +302,15 @@ void on_GLES2_Init(int view_w, int view_h)
     // landscape texture will no longer be used
     csrPixelBufferRelease(pPixelBuffer);
 
+    // keep the landscape vertex buffer on the GPU side, it will be copied on the first draw
+    csrOpenGLStaticVBInit(&g_StaticVB[0]);
+
+    if (g_pMesh)
+    {
+        g_StaticVB[0].m_pKey     = g_pMesh->m_pVB;
+        g_StaticVB[0].m_UseCount = 1;
+    }
+
     csrSoundInitializeOpenAL(&g_pOpenALDevice, &g_pOpenALContext);
 
     // load step sound file
@@ -303,6 +319,9 @@ void on_GLES2_Init(int view_w, int view_h)
 //------------------------------------------------------------------------------
 void on_GLES2_Final()
 {
+    // delete the landscape vertex buffer from the GPU
+    csrOpenGLStaticVBContentRelease(&g_StaticVB[0]);
+
     // delete the landscape
     csrMeshRelease(g_pMesh, OnDeleteTexture);
     g_pMesh = 0;
@@ -139,6 +139,7 @@ ALCdevice*        g_pOpenALDevice  = 0;
 ALCcontext*       g_pOpenALContext = 0;
 CSR_Sound*        g_pSound         = 0;
 CSR_OpenGLID      g_ID[2];
+CSR_OpenGLStaticVB g_StaticVB[2];
 //---------------------------------------------------------------------------
 void* OnGetShader(const void* pModel, CSR_EModelType type)
 {
@@ -158,6 +159,12 @@ void* OnGetID(const void* pKey)
         if (pKey == g_ID[i].m_pKey)
             return &g_ID[i];
 
+    // iterate through static vertex buffers
+    for (i = 0; i < 2; ++i)
+        // found the vertex buffer to get?
+        if (pKey == g_StaticVB[i].m_pKey)
+            return &g_StaticVB[i];
+
     return 0;
 }
 //---------------------------------------------------------------------------
@@ -419,6 +426,11 @@ void on_GLES2_Init(int view_w, int view_h)
     // landscape texture will no longer be used
     csrPixelBufferRelease(pPixelBuffer);
 
+    // keep the landscape vertex buffer on the GPU side, it will be copied on the first draw
+    csrOpenGLStaticVBInit(&g_StaticVB[0]);
+    g_StaticVB[0].m_pKey     = ((CSR_Model*)(pItem->m_pModel))->m_pMesh[0].m_pVB;
+    g_StaticVB[0].m_UseCount = 1;
+
     // load the skybox shader
     g_pSkyboxShader = csrOpenGLShaderLoadFromStr(&g_VSSkybox[0],
                                                   sizeof(g_VSSkybox),
@@ -458,6 +470,11 @@ void on_GLES2_Init(int view_w, int view_h)
     g_ID[1].m_ID       = csrOpenGLCubemapLoad(pCubemapFileNames);
     g_ID[1].m_UseCount = 1;
 
+    // keep the skybox vertex buffer on the GPU side
+    csrOpenGLStaticVBInit(&g_StaticVB[1]);
+    g_StaticVB[1].m_pKey     = g_pScene->m_pSkybox->m_pVB;
+    g_StaticVB[1].m_UseCount = 1;
+
     csrSoundInitializeOpenAL(&g_pOpenALDevice, &g_pOpenALContext);
 
     // load step sound file
@@ -466,6 +483,10 @@ void on_GLES2_Init(int view_w, int view_h)
 //------------------------------------------------------------------------------
 void on_GLES2_Final()
 {
+    // delete the landscape and skybox vertex buffers from the GPU
+    csrOpenGLStaticVBContentRelease(&g_StaticVB[0]);
+    csrOpenGLStaticVBContentRelease(&g_StaticVB[1]);
+
     // delete the scene
     csrSceneRelease(g_pScene, OnDeleteTexture);
     g_pScene = 0;
@@ -0,0 +1,133 @@
+﻿/****************************************************************************
+ * ==> Matrix array benchmark ----------------------------------------------*
+ ****************************************************************************
+ * Description : A console benchmark measuring the time required to add,    *
+ *               find and delete a large amount of model matrices in a      *
+ *               scene item, e.g. all the walls or trees of a level         *
+ * Developer   : Jean-Milost Reymond                                        *
+ * Copyright   : 2017 - 2022, this file is part of the CompactStar Engine.  *
+ *               You are free to copy or redistribute this file, modify it, *
+ *               or use it for your own projects, commercial or not. This   *
+ *               file is provided "as is", WITHOUT ANY WARRANTY OF ANY      *
+ *               KIND. THE DEVELOPER IS NOT RESPONSIBLE FOR ANY DAMAGE OF   *
+ *               ANY KIND, ANY LOSS OF DATA, OR ANY LOSS OF PRODUCTIVITY    *
+ *               TIME THAT MAY RESULT FROM THE USAGE OF THIS SOURCE CODE,   *
+ *               DIRECTLY OR NOT.                                           *
+ ****************************************************************************/
+
+// supported platforms check. NOTE iOS only, but may works on other platforms
+#if !defined(_OS_IOS_) && !defined(_OS_ANDROID_) && !defined(_OS_WINDOWS_)
+    #error "Not supported platform!"
+#endif
+
+// std
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+// opengl
+#include <gles2.h>
+#include <gles2ext.h>
+
+// compactStar engine
+#include "SDK/CSR_Common.h"
+#include "SDK/CSR_Geometry.h"
+#include "SDK/CSR_Vertex.h"
+#include "SDK/CSR_Model.h"
+#include "SDK/CSR_Renderer.h"
+#include "SDK/CSR_Renderer_OpenGL.h"
+#include "SDK/CSR_Scene.h"
+
+#define MATRIX_COUNT 100000
+
+//------------------------------------------------------------------------------
+double GetElapsedTime(clock_t startTime)
+{
+    return ((double)(clock() - startTime) * 1000.0) / (double)CLOCKS_PER_SEC;
+}
+//------------------------------------------------------------------------------
+int main()
+{
+    size_t           i;
+    size_t           found;
+    clock_t          startTime;
+    CSR_Scene*       pScene;
+    CSR_Mesh*        pMesh;
+    CSR_Matrix4*     pMatrices;
+    CSR_SceneItem*   pSceneItem;
+    CSR_VertexFormat vertexFormat;
+
+    // create the scene
+    pScene = csrSceneCreate();
+
+    // create a box, which will be used as shared model by all the matrices
+    csrVertexFormatInit(&vertexFormat);
+    pMesh = csrShapeCreateBox(1.0f, 1.0f, 1.0f, 0, &vertexFormat, 0, 0, 0);
+
+    // create the matrices
+    pMatrices = (CSR_Matrix4*)malloc(sizeof(CSR_Matrix4) * MATRIX_COUNT);
+
+    if (!pScene || !pMesh || !pMatrices)
+    {
+        printf("Failed to initialize the benchmark\n");
+        return 1;
+    }
+
+    // add the model to the scene
+    csrSceneAddMesh(pScene, pMesh, 0, 0);
+
+    for (i = 0; i < MATRIX_COUNT; ++i)
+    {
+        csrMat4Identity(&pMatrices[i]);
+        pMatrices[i].m_Table[3][0] = (float)i;
+    }
+
+    // measure the time required to add the matrices to the model
+    startTime = clock();
+
+    for (i = 0; i < MATRIX_COUNT; ++i)
+        csrSceneAddModelMatrix(pScene, pMesh, &pMatrices[i]);
+
+    printf("Add %d matrices:    %.2f ms\n", MATRIX_COUNT, GetElapsedTime(startTime));
+
+    // measure the time required to add the same matrices again, they should all be rejected
+    startTime = clock();
+
+    for (i = 0; i < MATRIX_COUNT; ++i)
+        csrSceneAddModelMatrix(pScene, pMesh, &pMatrices[i]);
+
+    pSceneItem = csrSceneGetItem(pScene, pMesh);
+
+    printf("Re-add %d matrices: %.2f ms (%u matrices in item)\n",
+           MATRIX_COUNT,
+           GetElapsedTime(startTime),
+           pSceneItem ? (unsigned)pSceneItem->m_pMatrixArray->m_Count : 0);
+
+    // measure the time required to find the scene item owning each matrix
+    found     = 0;
+    startTime = clock();
+
+    for (i = 0; i < MATRIX_COUNT; ++i)
+        if (csrSceneGetItem(pScene, &pMatrices[i]))
+            ++found;
+
+    printf("Find %d matrices:   %.2f ms (%u found)\n",
+           MATRIX_COUNT,
+           GetElapsedTime(startTime),
+           (unsigned)found);
+
+    // measure the time required to delete all the matrices
+    startTime = clock();
+
+    for (i = 0; i < MATRIX_COUNT; ++i)
+        csrSceneDeleteFrom(pScene, &pMatrices[i], 0);
+
+    printf("Delete %d matrices: %.2f ms\n", MATRIX_COUNT, GetElapsedTime(startTime));
+
+    // release the scene, it will also release the mesh
+    csrSceneRelease(pScene, 0);
+    free(pMatrices);
+
+    return 0;
+}
+//------------------------------------------------------------------------------
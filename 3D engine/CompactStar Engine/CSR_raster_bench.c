@@ -0,0 +1,1148 @@
+﻿/****************************************************************************
+ * ==> Software raster benchmark -------------------------------------------*
+ ****************************************************************************
+ * Description : A console benchmark moving a camera along a fixed path     *
+ *               through the demo models and landscapes, and drawing them   *
+ *               with the software rasterizer. No window or GPU is needed,  *
+ *               the scene update, collision and raster times are measured  *
+ *               separately for each frame                                  *
+ * Developer   : Jean-Milost Reymond                                        *
+ * Copyright   : 2017 - 2022, this file is part of the CompactStar Engine.  *
+ *               You are free to copy or redistribute this file, modify it, *
+ *               or use it for your own projects, commercial or not. This   *
+ *               file is provided "as is", WITHOUT ANY WARRANTY OF ANY      *
+ *               KIND. THE DEVELOPER IS NOT RESPONSIBLE FOR ANY DAMAGE OF   *
+ *               ANY KIND, ANY LOSS OF DATA, OR ANY LOSS OF PRODUCTIVITY    *
+ *               TIME THAT MAY RESULT FROM THE USAGE OF THIS SOURCE CODE,   *
+ *               DIRECTLY OR NOT.                                           *
+ ****************************************************************************/
+
+// NOTE unlike the other demos, this benchmark doesn't depend on OpenGL, and may also be built on a
+// desktop with the CMakeLists.txt file located in the engine root directory, e.g.
+// cmake -S . -B build -DCMAKE_BUILD_TYPE=Release && cmake --build build
+// It should be run from the engine root directory, thus the resources may be found. If a directory is given as argument, some
+// frames are also written in this directory as PPM images, e.g. to compare them with golden images. With the --tiles option,
+// the scene is drawn with the tiled rasterizer, using one thread per processor, or the thread count given as --tiles=<count>.
+// The frames signature should be the same in both modes, whatever the thread count
+
+// std
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+
+// compactStar engine
+#include "SDK/CSR_Common.h"
+#include "SDK/CSR_Geometry.h"
+#include "SDK/CSR_Collision.h"
+#include "SDK/CSR_Vertex.h"
+#include "SDK/CSR_Model.h"
+#include "SDK/CSR_Mdl.h"
+#include "SDK/CSR_X.h"
+#include "SDK/CSR_Collada.h"
+#include "SDK/CSR_Wavefront.h"
+#include "SDK/CSR_SoftwareRaster.h"
+
+#define LANDSCAPE_TEXTURE_FILE "Resources/grass.bmp"
+#define LANDSCAPE_DATA_FILE_1  "Resources/level.bmp"
+#define LANDSCAPE_DATA_FILE_2  "Resources/bot_level.bmp"
+#define WIZARD_FILE            "Resources/wizard.mdl"
+#define SPACESHIP_FILE         "Resources/spaceship.mdl"
+#define TINY_FILE              "Resources/tiny_4anim.x"
+#define COLLADA_FILE           "Resources/SimpleAnimDemo.dae"
+#define BALLOON_FILE           "Resources/balloon.obj"
+
+#define SCREEN_WIDTH    640
+#define SCREEN_HEIGHT   480
+#define FRAME_COUNT     360
+#define FRAME_TIME      (1.0 / 60.0)
+#define DUMP_FRAME_STEP 60
+#define MODEL_COUNT     5
+#define INSTANCE_COUNT  20
+#define LANDSCAPE_COUNT 2
+#define MODEL_SIZE      0.4f
+#define CAMERA_DISTANCE 10.0f
+#define CAMERA_HEIGHT   5.0f
+
+//------------------------------------------------------------------------------
+/**
+* Benchmark model type
+*/
+typedef enum
+{
+    E_BM_MDL,
+    E_BM_X,
+    E_BM_Collada,
+    E_BM_Model
+}
+CSR_EBenchModelType;
+//------------------------------------------------------------------------------
+/**
+* Benchmark model
+*/
+typedef struct
+{
+    CSR_EBenchModelType m_Type;
+    void*               m_pModel;
+    CSR_Matrix4         m_Matrix;        // matrix fitting the model on the landscape
+    CSR_VertexBuffer*   m_pSkinnedVB;    // skinned vertex buffer for each mesh, 0 if not animated
+    CSR_Matrix4*        m_pBones;        // bone matrices of the mesh being skinned
+    size_t              m_BoneCount;
+    size_t              m_FrameCount;
+    size_t              m_FrameIndex;
+    size_t              m_SkinIndex;
+    size_t              m_ModelIndex;
+    size_t              m_MeshIndex;
+    double              m_TextureLastTime;
+    double              m_ModelLastTime;
+    double              m_MeshLastTime;
+} CSR_BenchModel;
+//------------------------------------------------------------------------------
+/**
+* Benchmark model instance
+*/
+typedef struct
+{
+    size_t      m_ModelIndex;
+    CSR_Sphere  m_Geometry;
+    CSR_Matrix4 m_Matrix;
+    float       m_Angle;
+} CSR_BenchInstance;
+//------------------------------------------------------------------------------
+CSR_BenchModel         g_Models[MODEL_COUNT];
+CSR_BenchInstance      g_Instances[INSTANCE_COUNT];
+CSR_Mesh*              g_pLandscapes[LANDSCAPE_COUNT]     = {0};
+CSR_AABBNode*          g_pLandscapeTrees[LANDSCAPE_COUNT] = {0};
+CSR_Matrix4            g_LandscapeMatrices[LANDSCAPE_COUNT];
+CSR_PixelBuffer*       g_pLandscapeTexture                = 0;
+CSR_Raster             g_Raster;
+CSR_FrameBuffer*       g_pFrameBuffer                     = 0;
+CSR_DepthBuffer*       g_pDepthBuffer                     = 0;
+CSR_RasterTiles*       g_pTiles                           = 0;
+CSR_Matrix4            g_DrawMatrices[LANDSCAPE_COUNT + INSTANCE_COUNT];
+CSR_Matrix4            g_ViewMatrix;
+const float            g_zNear                            = 0.01f;
+const float            g_zFar                             = 100.0f;
+double                 g_UpdateTime[FRAME_COUNT];
+double                 g_CollisionTime[FRAME_COUNT];
+double                 g_RasterTime[FRAME_COUNT];
+double                 g_FrameTime[FRAME_COUNT];
+//------------------------------------------------------------------------------
+double GetTime(void)
+{
+    struct timespec time;
+
+    // NOTE the wall time is measured, because clock() would add the time of all the raster threads
+    if (!timespec_get(&time, TIME_UTC))
+        return 0.0;
+
+    return ((double)time.tv_sec * 1000.0) + ((double)time.tv_nsec / 1000000.0);
+}
+//------------------------------------------------------------------------------
+double GetElapsedTime(double startTime)
+{
+    return GetTime() - startTime;
+}
+//------------------------------------------------------------------------------
+CSR_PixelBuffer* OnLoadTexture(const char* pTextureName)
+{
+    char             fileName[256];
+    CSR_PixelBuffer* pPixelBuffer;
+
+    // build the texture file name, the textures are stored with the models
+    if (strlen(pTextureName) + 11 > sizeof(fileName))
+        return 0;
+
+    strcpy(fileName,      "Resources/");
+    strcpy(fileName + 10, pTextureName);
+
+    pPixelBuffer = csrPixelBufferFromBitmapFile(fileName);
+
+    return pPixelBuffer;
+}
+//------------------------------------------------------------------------------
+void OnApplyFragmentShader(const CSR_Matrix4*  pMatrix,
+                           const CSR_Polygon3* pPolygon,
+                           const CSR_Vector2*  pST,
+                           const CSR_Vector3*  pSampler,
+                                 float         z,
+                                 CSR_Color*    pColor,
+                           const void*         pCustomData)
+{
+    float                  stX;
+    float                  stY;
+    size_t                 x;
+    size_t                 y;
+    size_t                 line;
+    size_t                 index;
+    const CSR_PixelBuffer* pTexture = (const CSR_PixelBuffer*)pCustomData;
+
+    // only the texture coordinates are used to get the pixel color
+    (void)pMatrix;
+    (void)pPolygon;
+    (void)pSampler;
+    (void)z;
+
+    pColor->m_A = 1.0f;
+
+    // no texture? (NOTE in this case the per-vertex color is kept)
+    if (!pTexture || !pTexture->m_pData)
+        return;
+
+    // limit the texture coordinate between 0 and 1 (equivalent to OpenGL clamp mode)
+    csrMathClamp(pST->m_X, 0.0f, 1.0f, &stX);
+    csrMathClamp(pST->m_Y, 0.0f, 1.0f, &stY);
+
+    // calculate the x and y coordinate to pick in the texture, and the line length in pixels
+    x    = (size_t)(stX * (pTexture->m_Width  - 1));
+    y    = (size_t)(stY * (pTexture->m_Height - 1));
+    line = pTexture->m_Width * pTexture->m_BytePerPixel;
+
+    // calculate the pixel index to get
+    index = (y * line) + (x * pTexture->m_BytePerPixel);
+
+    // get the pixel color from texture
+    pColor->m_R = (float)(((unsigned char*)(pTexture->m_pData))[index])     / 255.0f;
+    pColor->m_G = (float)(((unsigned char*)(pTexture->m_pData))[index + 1]) / 255.0f;
+    pColor->m_B = (float)(((unsigned char*)(pTexture->m_pData))[index + 2]) / 255.0f;
+}
+//------------------------------------------------------------------------------
+const CSR_Mesh* GetModelMeshes(const CSR_BenchModel* pModel, size_t* pCount)
+{
+    *pCount = 0;
+
+    switch (pModel->m_Type)
+    {
+        case E_BM_MDL:
+        {
+            const CSR_Mesh* pMesh = csrMDLGetMesh((const CSR_MDL*)pModel->m_pModel,
+                                                  pModel->m_ModelIndex,
+                                                  pModel->m_MeshIndex);
+
+            if (pMesh)
+                *pCount = 1;
+
+            return pMesh;
+        }
+
+        case E_BM_X:
+            *pCount = ((const CSR_X*)pModel->m_pModel)->m_MeshCount;
+            return ((const CSR_X*)pModel->m_pModel)->m_pMesh;
+
+        case E_BM_Collada:
+            *pCount = ((const CSR_Collada*)pModel->m_pModel)->m_MeshCount;
+            return ((const CSR_Collada*)pModel->m_pModel)->m_pMesh;
+
+        case E_BM_Model:
+            if (!((const CSR_Model*)pModel->m_pModel)->m_MeshCount)
+                return 0;
+
+            *pCount = 1;
+            return ((const CSR_Model*)pModel->m_pModel)->m_pMesh;
+    }
+
+    return 0;
+}
+//------------------------------------------------------------------------------
+const CSR_PixelBuffer* GetModelTexture(const CSR_BenchModel* pModel, const CSR_Mesh* pMesh)
+{
+    const CSR_MDL* pMDL;
+
+    // the MDL skins are stored in the model, the other textures in the mesh
+    if (pModel->m_Type != E_BM_MDL)
+        return pMesh->m_Skin.m_Texture.m_pBuffer;
+
+    pMDL = (const CSR_MDL*)pModel->m_pModel;
+
+    if (pModel->m_SkinIndex >= pMDL->m_SkinCount)
+        return 0;
+
+    return pMDL->m_pSkin[pModel->m_SkinIndex].m_Texture.m_pBuffer;
+}
+//------------------------------------------------------------------------------
+void GetSkinData(const CSR_BenchModel*          pModel,
+                       CSR_Bone_Pose**          ppPose,
+                       CSR_Skin_Weights_Group** ppWeights,
+                       size_t*                  pWeightsCount)
+{
+    *ppPose        = 0;
+    *ppWeights     = 0;
+    *pWeightsCount = 0;
+
+    switch (pModel->m_Type)
+    {
+        case E_BM_X:
+        {
+            CSR_X* pX = (CSR_X*)pModel->m_pModel;
+
+            if (pX->m_MeshOnly || !pX->m_pSkeleton)
+                return;
+
+            *ppPose        = pX->m_pPose;
+            *ppWeights     = pX->m_pMeshWeights;
+            *pWeightsCount = pX->m_MeshWeightsCount;
+            return;
+        }
+
+        case E_BM_Collada:
+        {
+            CSR_Collada* pCollada = (CSR_Collada*)pModel->m_pModel;
+
+            if (pCollada->m_MeshOnly || !pCollada->m_pMeshWeights)
+                return;
+
+            *ppPose        = pCollada->m_pPose;
+            *ppWeights     = pCollada->m_pMeshWeights;
+            *pWeightsCount = pCollada->m_MeshWeightsCount;
+            return;
+        }
+
+        default:
+            return;
+    }
+}
+//------------------------------------------------------------------------------
+void SkinVertexBuffer(const CSR_VertexBuffer*        pVB,
+                      const CSR_Skin_Vertex_Weights* pWeights,
+                      const CSR_Matrix4*             pBones,
+                            size_t                   boneCount,
+                            CSR_VertexBuffer*        pSkinnedVB)
+{
+    size_t       i;
+    size_t       j;
+    size_t       count;
+    size_t       boneIndex;
+    float        weight;
+    float*       pDst;
+    const float* pSrc;
+    const float* pItem;
+    CSR_Vector3  inputVertex;
+    CSR_Vector3  outputVertex;
+    const size_t stride = pVB->m_Format.m_Stride;
+
+    // get the vertex count to skin
+    count = pVB->m_Count / stride;
+
+    if (count > pWeights->m_Count)
+        count = pWeights->m_Count;
+
+    for (i = 0; i < count; ++i)
+    {
+        pSrc  = &pVB->m_pData[i * stride];
+        pDst  = &pSkinnedVB->m_pData[i * stride];
+        pItem = &pWeights->m_pData[i * M_CSR_Max_Bone_Influences * 2];
+
+        // copy the vertex data, then replace the position by the skinned one
+        memcpy(pDst, pSrc, stride * sizeof(float));
+
+        inputVertex.m_X = pSrc[0];
+        inputVertex.m_Y = pSrc[1];
+        inputVertex.m_Z = pSrc[2];
+
+        pDst[0] = 0.0f;
+        pDst[1] = 0.0f;
+        pDst[2] = 0.0f;
+
+        // apply each bone influencing the vertex, weighted
+        for (j = 0; j < M_CSR_Max_Bone_Influences; ++j)
+        {
+            weight    = pItem[M_CSR_Max_Bone_Influences + j];
+            boneIndex = (size_t)pItem[j];
+
+            if (weight == 0.0f || boneIndex >= boneCount)
+                continue;
+
+            csrMat4Transform(&pBones[boneIndex], &inputVertex, &outputVertex);
+
+            pDst[0] += outputVertex.m_X * weight;
+            pDst[1] += outputVertex.m_Y * weight;
+            pDst[2] += outputVertex.m_Z * weight;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+int CreateSkinnedBuffers(CSR_BenchModel* pModel)
+{
+    size_t                  i;
+    size_t                  meshCount;
+    size_t                  weightsCount;
+    const CSR_Mesh*         pMeshes;
+    CSR_Bone_Pose*          pPose;
+    CSR_Skin_Weights_Group* pWeights;
+
+    GetSkinData(pModel, &pPose, &pWeights, &weightsCount);
+
+    // not animated?
+    if (!pPose || !pWeights)
+        return 1;
+
+    pMeshes = GetModelMeshes(pModel, &meshCount);
+
+    // create a skinned vertex buffer for each mesh, which will receive the animated vertices
+    pModel->m_pSkinnedVB = (CSR_VertexBuffer*)calloc(meshCount, sizeof(CSR_VertexBuffer));
+
+    if (!pModel->m_pSkinnedVB)
+        return 0;
+
+    for (i = 0; i < meshCount; ++i)
+    {
+        csrVertexBufferInit(&pModel->m_pSkinnedVB[i]);
+
+        // only the meshes made of one vertex buffer may be skinned
+        if (i >= weightsCount || !pWeights[i].m_pSkinWeights || pMeshes[i].m_Count != 1)
+            continue;
+
+        pModel->m_pSkinnedVB[i].m_Format   = pMeshes[i].m_pVB->m_Format;
+        pModel->m_pSkinnedVB[i].m_Culling  = pMeshes[i].m_pVB->m_Culling;
+        pModel->m_pSkinnedVB[i].m_Material = pMeshes[i].m_pVB->m_Material;
+        pModel->m_pSkinnedVB[i].m_pData    = (float*)malloc(pMeshes[i].m_pVB->m_Count * sizeof(float));
+
+        if (!pModel->m_pSkinnedVB[i].m_pData)
+            return 0;
+
+        pModel->m_pSkinnedVB[i].m_Count    = pMeshes[i].m_pVB->m_Count;
+        pModel->m_pSkinnedVB[i].m_Capacity = pMeshes[i].m_pVB->m_Count;
+
+        // keep enough bone matrices for the mesh owning the most skin weights
+        if (pWeights[i].m_Count > pModel->m_BoneCount)
+            pModel->m_BoneCount = pWeights[i].m_Count;
+    }
+
+    pModel->m_pBones = (CSR_Matrix4*)malloc((pModel->m_BoneCount + 1) * sizeof(CSR_Matrix4));
+
+    return (pModel->m_pBones != 0);
+}
+//------------------------------------------------------------------------------
+void FitModel(CSR_BenchModel* pModel)
+{
+    size_t          i;
+    size_t          j;
+    size_t          k;
+    size_t          meshCount;
+    int             first;
+    float           size;
+    const float*    pVertex;
+    const CSR_Mesh* pMeshes;
+    CSR_Box         box;
+    CSR_Vector3     t;
+    CSR_Vector3     factor;
+    CSR_Matrix4     translateMatrix;
+    CSR_Matrix4     scaleMatrix;
+
+    memset(&box, 0, sizeof(CSR_Box));
+    first = 1;
+
+    pMeshes = GetModelMeshes(pModel, &meshCount);
+
+    // measure the model in its default pose
+    for (i = 0; i < meshCount; ++i)
+        for (j = 0; j < pMeshes[i].m_Count; ++j)
+            for (k = 0; k + 2 < pMeshes[i].m_pVB[j].m_Count; k += pMeshes[i].m_pVB[j].m_Format.m_Stride)
+            {
+                pVertex = &pMeshes[i].m_pVB[j].m_pData[k];
+
+                if (first)
+                {
+                    box.m_Min.m_X = box.m_Max.m_X = pVertex[0];
+                    box.m_Min.m_Y = box.m_Max.m_Y = pVertex[1];
+                    box.m_Min.m_Z = box.m_Max.m_Z = pVertex[2];
+                    first         = 0;
+                    continue;
+                }
+
+                box.m_Min.m_X = pVertex[0] < box.m_Min.m_X ? pVertex[0] : box.m_Min.m_X;
+                box.m_Min.m_Y = pVertex[1] < box.m_Min.m_Y ? pVertex[1] : box.m_Min.m_Y;
+                box.m_Min.m_Z = pVertex[2] < box.m_Min.m_Z ? pVertex[2] : box.m_Min.m_Z;
+                box.m_Max.m_X = pVertex[0] > box.m_Max.m_X ? pVertex[0] : box.m_Max.m_X;
+                box.m_Max.m_Y = pVertex[1] > box.m_Max.m_Y ? pVertex[1] : box.m_Max.m_Y;
+                box.m_Max.m_Z = pVertex[2] > box.m_Max.m_Z ? pVertex[2] : box.m_Max.m_Z;
+            }
+
+    // get the largest model side
+    size = box.m_Max.m_X - box.m_Min.m_X;
+
+    if (box.m_Max.m_Y - box.m_Min.m_Y > size)
+        size = box.m_Max.m_Y - box.m_Min.m_Y;
+
+    if (box.m_Max.m_Z - box.m_Min.m_Z > size)
+        size = box.m_Max.m_Z - box.m_Min.m_Z;
+
+    if (size <= 0.0f)
+        size = 1.0f;
+
+    // center the model above the origin, and scale it to the benchmark model size
+    t.m_X = -(box.m_Min.m_X + box.m_Max.m_X) * 0.5f;
+    t.m_Y = - box.m_Min.m_Y;
+    t.m_Z = -(box.m_Min.m_Z + box.m_Max.m_Z) * 0.5f;
+
+    factor.m_X = MODEL_SIZE / size;
+    factor.m_Y = MODEL_SIZE / size;
+    factor.m_Z = MODEL_SIZE / size;
+
+    csrMat4Translate(&t, &translateMatrix);
+    csrMat4Scale(&factor, &scaleMatrix);
+    csrMat4Multiply(&translateMatrix, &scaleMatrix, &pModel->m_Matrix);
+}
+//------------------------------------------------------------------------------
+int LoadModels(void)
+{
+    size_t            i;
+    CSR_VertexFormat  vertexFormat;
+    CSR_VertexCulling vertexCulling;
+    CSR_Material      material;
+
+    memset(g_Models, 0, sizeof(g_Models));
+
+    // configure the vertex format
+    vertexFormat.m_HasNormal         = 0;
+    vertexFormat.m_HasTexCoords      = 1;
+    vertexFormat.m_HasPerVertexColor = 1;
+
+    // configure the vertex culling
+    vertexCulling.m_Type = CSR_CT_None;
+    vertexCulling.m_Face = CSR_CF_CW;
+
+    // configure the material
+    material.m_Color       = 0xD08040FF;
+    material.m_Transparent = 0;
+    material.m_Wireframe   = 0;
+
+    // load the models. NOTE no skin callback is given, thus the textures remain in the models
+    g_Models[0].m_Type   = E_BM_MDL;
+    g_Models[0].m_pModel = csrMDLOpen(WIZARD_FILE, 0, &vertexFormat, &vertexCulling, &material, 0, 0, 0);
+    g_Models[1].m_Type   = E_BM_MDL;
+    g_Models[1].m_pModel = csrMDLOpen(SPACESHIP_FILE, 0, &vertexFormat, &vertexCulling, &material, 0, 0, 0);
+    g_Models[2].m_Type   = E_BM_X;
+    g_Models[2].m_pModel = csrXOpen(TINY_FILE,
+                                   &vertexFormat,
+                                   &vertexCulling,
+                                   &material,
+                                    0,
+                                    0,
+                                    0,
+                                    OnLoadTexture,
+                                    0,
+                                    0);
+    g_Models[3].m_Type   = E_BM_Collada;
+    g_Models[3].m_pModel = csrColladaOpen(COLLADA_FILE,
+                                         &vertexFormat,
+                                         &vertexCulling,
+                                         &material,
+                                          0,
+                                          0,
+                                          0,
+                                          OnLoadTexture,
+                                          0,
+                                          0);
+    g_Models[4].m_Type   = E_BM_Model;
+    g_Models[4].m_pModel = csrWaveFrontOpen(BALLOON_FILE, &vertexFormat, &vertexCulling, &material, 0, 0, 0);
+
+    for (i = 0; i < MODEL_COUNT; ++i)
+    {
+        if (!g_Models[i].m_pModel)
+            return 0;
+
+        // get the animation frame count, if any
+        switch (g_Models[i].m_Type)
+        {
+            case E_BM_X:
+                if (((CSR_X*)g_Models[i].m_pModel)->m_AnimationSetCount)
+                    g_Models[i].m_FrameCount =
+                            csrBoneAnimSetGetFrameCount(((CSR_X*)g_Models[i].m_pModel)->m_pAnimationSet);
+
+                break;
+
+            case E_BM_Collada:
+                if (((CSR_Collada*)g_Models[i].m_pModel)->m_AnimationSetCount)
+                    g_Models[i].m_FrameCount =
+                            csrBoneAnimSetGetFrameCount(((CSR_Collada*)g_Models[i].m_pModel)->m_pAnimationSet);
+
+                break;
+
+            default:
+                break;
+        }
+
+        FitModel(&g_Models[i]);
+
+        if (!CreateSkinnedBuffers(&g_Models[i]))
+            return 0;
+    }
+
+    return 1;
+}
+//------------------------------------------------------------------------------
+void ReleaseModels(void)
+{
+    size_t i;
+    size_t j;
+    size_t meshCount;
+
+    for (i = 0; i < MODEL_COUNT; ++i)
+    {
+        if (!g_Models[i].m_pModel)
+            continue;
+
+        // release the skinned vertex buffers
+        if (g_Models[i].m_pSkinnedVB)
+        {
+            GetModelMeshes(&g_Models[i], &meshCount);
+
+            for (j = 0; j < meshCount; ++j)
+                free(g_Models[i].m_pSkinnedVB[j].m_pData);
+
+            free(g_Models[i].m_pSkinnedVB);
+        }
+
+        free(g_Models[i].m_pBones);
+
+        switch (g_Models[i].m_Type)
+        {
+            case E_BM_MDL:     csrMDLRelease((CSR_MDL*)g_Models[i].m_pModel, 0);         break;
+            case E_BM_X:       csrXRelease((CSR_X*)g_Models[i].m_pModel, 0);             break;
+            case E_BM_Collada: csrColladaRelease((CSR_Collada*)g_Models[i].m_pModel, 0); break;
+            case E_BM_Model:   csrModelRelease((CSR_Model*)g_Models[i].m_pModel, 0);     break;
+        }
+    }
+}
+//------------------------------------------------------------------------------
+int LoadLandscapes(void)
+{
+    size_t            i;
+    CSR_PixelBuffer*  pBitmap;
+    CSR_VertexFormat  vertexFormat;
+    CSR_VertexCulling vertexCulling;
+    CSR_Material      material;
+    CSR_Vector3       t;
+    const char*       fileNames[LANDSCAPE_COUNT] = {LANDSCAPE_DATA_FILE_1, LANDSCAPE_DATA_FILE_2};
+
+    vertexFormat.m_HasNormal         = 0;
+    vertexFormat.m_HasTexCoords      = 1;
+    vertexFormat.m_HasPerVertexColor = 1;
+
+    vertexCulling.m_Type = CSR_CT_None;
+    vertexCulling.m_Face = CSR_CF_CW;
+
+    material.m_Color       = 0xFFFFFFFF;
+    material.m_Transparent = 0;
+    material.m_Wireframe   = 0;
+
+    for (i = 0; i < LANDSCAPE_COUNT; ++i)
+    {
+        // load the grayscale bitmap from which the landscape will be generated
+        pBitmap = csrPixelBufferFromBitmapFile(fileNames[i]);
+
+        if (!pBitmap)
+            return 0;
+
+        g_pLandscapes[i] = csrLandscapeCreate(pBitmap, 3.0f, 0.2f, &vertexFormat, &vertexCulling, &material, 0);
+        csrPixelBufferRelease(pBitmap);
+
+        if (!g_pLandscapes[i])
+            return 0;
+
+        // create the tree used to find the ground
+        g_pLandscapeTrees[i] = csrAABBTreeFromMesh(g_pLandscapes[i]);
+
+        if (!g_pLandscapeTrees[i])
+            return 0;
+
+        // place the landscapes side by side
+        t.m_X = ((float)i - 0.5f) * 6.2f;
+        t.m_Y = 0.0f;
+        t.m_Z = 0.0f;
+
+        csrMat4Translate(&t, &g_LandscapeMatrices[i]);
+    }
+
+    g_pLandscapeTexture = csrPixelBufferFromBitmapFile(LANDSCAPE_TEXTURE_FILE);
+
+    return (g_pLandscapeTexture != 0);
+}
+//------------------------------------------------------------------------------
+void ReleaseLandscapes(void)
+{
+    size_t i;
+
+    for (i = 0; i < LANDSCAPE_COUNT; ++i)
+    {
+        csrAABBTreeNodeRelease(g_pLandscapeTrees[i]);
+        csrMeshRelease(g_pLandscapes[i], 0);
+    }
+
+    csrPixelBufferRelease(g_pLandscapeTexture);
+}
+//------------------------------------------------------------------------------
+void InitInstances(void)
+{
+    size_t i;
+    float  angle;
+
+    // spread the instances on an ellipse crossing both landscapes
+    for (i = 0; i < INSTANCE_COUNT; ++i)
+    {
+        angle = ((float)i * 2.0f * (float)M_PI) / (float)INSTANCE_COUNT;
+
+        g_Instances[i].m_ModelIndex            = i % MODEL_COUNT;
+        g_Instances[i].m_Angle                 = angle;
+        g_Instances[i].m_Geometry.m_Center.m_X = cosf(angle) * 4.5f;
+        g_Instances[i].m_Geometry.m_Center.m_Y = 0.0f;
+        g_Instances[i].m_Geometry.m_Center.m_Z = sinf(angle) * 1.5f;
+        g_Instances[i].m_Geometry.m_Radius     = MODEL_SIZE * 0.5f;
+    }
+}
+//------------------------------------------------------------------------------
+void UpdateScene(size_t frame)
+{
+    size_t                  i;
+    size_t                  j;
+    size_t                  meshCount;
+    size_t                  weightsCount;
+    float                   angle;
+    const CSR_Mesh*         pMeshes;
+    CSR_Bone_Pose*          pPose;
+    CSR_Skin_Weights_Group* pWeights;
+    CSR_BenchModel*         pModel;
+    CSR_Vector3             t;
+    CSR_Vector3             axis;
+    CSR_Matrix4             translateMatrix;
+    CSR_Matrix4             yawMatrix;
+    CSR_Matrix4             pitchMatrix;
+    CSR_Matrix4             viewMatrix;
+
+    // animate the models
+    for (i = 0; i < MODEL_COUNT; ++i)
+    {
+        pModel = &g_Models[i];
+
+        if (pModel->m_Type == E_BM_MDL)
+        {
+            csrMDLUpdateIndex((const CSR_MDL*)pModel->m_pModel,
+                              10,
+                              0,
+                             &pModel->m_SkinIndex,
+                             &pModel->m_ModelIndex,
+                             &pModel->m_MeshIndex,
+                             &pModel->m_TextureLastTime,
+                             &pModel->m_ModelLastTime,
+                             &pModel->m_MeshLastTime,
+                              FRAME_TIME);
+            continue;
+        }
+
+        if (!pModel->m_pSkinnedVB)
+            continue;
+
+        GetSkinData(pModel, &pPose, &pWeights, &weightsCount);
+
+        // calculate the bone matrices of the current frame
+        pModel->m_FrameIndex = pModel->m_FrameCount ? frame % pModel->m_FrameCount : 0;
+
+        csrBonePoseUpdate(pPose,
+                          pModel->m_FrameCount ? 0 : M_CSR_Unknown_Index,
+                          pModel->m_FrameIndex,
+                          (pModel->m_Type == E_BM_Collada &&
+                           ((CSR_Collada*)pModel->m_pModel)->m_pSkeletons) ?
+                                  &((CSR_Collada*)pModel->m_pModel)->m_pSkeletons->m_InitialMatrix : 0);
+
+        pMeshes = GetModelMeshes(pModel, &meshCount);
+
+        // skin the meshes
+        for (j = 0; j < meshCount; ++j)
+        {
+            if (!pModel->m_pSkinnedVB[j].m_pData || !pWeights[j].m_VertexWeights.m_pData)
+                continue;
+
+            if (!csrBonePoseGetSkinMatrices(pPose, &pWeights[j], pModel->m_pBones))
+                continue;
+
+            SkinVertexBuffer(pMeshes[j].m_pVB,
+                            &pWeights[j].m_VertexWeights,
+                             pModel->m_pBones,
+                             pWeights[j].m_Count,
+                            &pModel->m_pSkinnedVB[j]);
+        }
+    }
+
+    // move the instances along their ellipse
+    for (i = 0; i < INSTANCE_COUNT; ++i)
+    {
+        g_Instances[i].m_Angle += 0.002f;
+
+        g_Instances[i].m_Geometry.m_Center.m_X = cosf(g_Instances[i].m_Angle) * 4.5f;
+        g_Instances[i].m_Geometry.m_Center.m_Z = sinf(g_Instances[i].m_Angle) * 1.5f;
+    }
+
+    // turn the camera around the landscapes, looking down at their center. NOTE the software
+    // rasterizer doesn't clip the polygons against the near plane, thus the camera remains outside
+    // the scene
+    angle = ((float)frame * 2.0f * (float)M_PI) / (float)FRAME_COUNT;
+
+    t.m_X = -sinf(angle) * CAMERA_DISTANCE;
+    t.m_Y = -CAMERA_HEIGHT;
+    t.m_Z = -cosf(angle) * CAMERA_DISTANCE;
+
+    csrMat4Translate(&t, &translateMatrix);
+
+    axis.m_X = 0.0f;
+    axis.m_Y = 1.0f;
+    axis.m_Z = 0.0f;
+
+    csrMat4Rotate(-angle, &axis, &yawMatrix);
+
+    axis.m_X = 1.0f;
+    axis.m_Y = 0.0f;
+    axis.m_Z = 0.0f;
+
+    csrMat4Rotate(atanf(CAMERA_HEIGHT / CAMERA_DISTANCE), &axis, &pitchMatrix);
+
+    csrMat4Multiply(&translateMatrix, &yawMatrix,   &viewMatrix);
+    csrMat4Multiply(&viewMatrix,      &pitchMatrix, &g_ViewMatrix);
+}
+//------------------------------------------------------------------------------
+void ApplyGroundCollision(void)
+{
+    size_t      i;
+    size_t      j;
+    float       groundY[INSTANCE_COUNT];
+    int         found[INSTANCE_COUNT];
+    CSR_Sphere  spheres[INSTANCE_COUNT];
+    CSR_Vector3 groundDir;
+    CSR_Vector3 axis;
+    CSR_Vector3 t;
+    CSR_Matrix4 translateMatrix;
+    CSR_Matrix4 rotateMatrix;
+    CSR_Matrix4 modelMatrix;
+
+    groundDir.m_X =  0.0f;
+    groundDir.m_Y = -1.0f;
+    groundDir.m_Z =  0.0f;
+
+    // find the ground below each instance, on each landscape
+    for (i = 0; i < LANDSCAPE_COUNT; ++i)
+    {
+        // convert the instance spheres in the landscape coordinates system
+        for (j = 0; j < INSTANCE_COUNT; ++j)
+        {
+            spheres[j]             = g_Instances[j].m_Geometry;
+            spheres[j].m_Center.m_X -= g_LandscapeMatrices[i].m_Table[3][0];
+            spheres[j].m_Center.m_Z -= g_LandscapeMatrices[i].m_Table[3][2];
+        }
+
+        csrGroundPosYBatch(spheres, INSTANCE_COUNT, g_pLandscapeTrees[i], &groundDir, 0, groundY, found);
+
+        for (j = 0; j < INSTANCE_COUNT; ++j)
+            if (found[j])
+                g_Instances[j].m_Geometry.m_Center.m_Y = groundY[j];
+    }
+
+    axis.m_X = 0.0f;
+    axis.m_Y = 1.0f;
+    axis.m_Z = 0.0f;
+
+    // build the instance matrices, the models stand on the ground and face their moving direction
+    for (i = 0; i < INSTANCE_COUNT; ++i)
+    {
+        csrMat4Rotate(-g_Instances[i].m_Angle, &axis, &rotateMatrix);
+
+        t.m_X = g_Instances[i].m_Geometry.m_Center.m_X;
+        t.m_Y = g_Instances[i].m_Geometry.m_Center.m_Y - g_Instances[i].m_Geometry.m_Radius;
+        t.m_Z = g_Instances[i].m_Geometry.m_Center.m_Z;
+
+        csrMat4Translate(&t, &translateMatrix);
+        csrMat4Multiply(&g_Models[g_Instances[i].m_ModelIndex].m_Matrix, &rotateMatrix, &modelMatrix);
+        csrMat4Multiply(&modelMatrix, &translateMatrix, &g_Instances[i].m_Matrix);
+    }
+}
+//------------------------------------------------------------------------------
+void DrawVertexBuffer(const CSR_Matrix4*      pMatrix,
+                      const CSR_VertexBuffer* pVB,
+                      const CSR_PixelBuffer*  pTexture)
+{
+    // queue the vertex buffer in the tiles, if the tiled rasterizer is used
+    if (g_pTiles)
+    {
+        csrRasterTilesDraw(pMatrix,
+                           g_zNear,
+                           pVB,
+                          &g_Raster,
+                           g_pTiles,
+                           0,
+                           OnApplyFragmentShader,
+                           pTexture);
+        return;
+    }
+
+    csrRasterDraw(pMatrix,
+                  g_zNear,
+                  g_zFar,
+                  pVB,
+                 &g_Raster,
+                  g_pFrameBuffer,
+                  g_pDepthBuffer,
+                  0,
+                  OnApplyFragmentShader,
+                  pTexture);
+}
+//------------------------------------------------------------------------------
+void DrawModel(const CSR_BenchModel* pModel, const CSR_Matrix4* pModelMatrix, CSR_Matrix4* pMatrix)
+{
+    size_t                  i;
+    size_t                  j;
+    size_t                  meshCount;
+    const CSR_Mesh*         pMeshes;
+    const CSR_VertexBuffer* pVB;
+    const CSR_PixelBuffer*  pTexture;
+
+    // NOTE the matrix is kept by the caller, because the tiled rasterizer only uses it once the
+    // whole scene is queued
+    csrMat4Multiply(pModelMatrix, &g_ViewMatrix, pMatrix);
+
+    pMeshes = GetModelMeshes(pModel, &meshCount);
+
+    for (i = 0; i < meshCount; ++i)
+    {
+        pTexture = GetModelTexture(pModel, &pMeshes[i]);
+
+        for (j = 0; j < pMeshes[i].m_Count; ++j)
+        {
+            // draw the animated vertices, if any
+            if (pModel->m_pSkinnedVB && pModel->m_pSkinnedVB[i].m_pData)
+                pVB = &pModel->m_pSkinnedVB[i];
+            else
+                pVB = &pMeshes[i].m_pVB[j];
+
+            DrawVertexBuffer(pMatrix, pVB, pTexture);
+        }
+    }
+}
+//------------------------------------------------------------------------------
+void DrawScene(void)
+{
+    size_t    i;
+    CSR_Pixel pixel;
+
+    pixel.m_R = 115;
+    pixel.m_G = 204;
+    pixel.m_B = 255;
+    pixel.m_A = 255;
+
+    // clear the buffers
+    csrFrameBufferClear(g_pFrameBuffer, &pixel);
+    csrDepthBufferClear(g_pDepthBuffer, g_zFar);
+
+    // begin to queue the scene in the tiles, if the tiled rasterizer is used
+    if (g_pTiles)
+        csrRasterTilesBegin(g_pTiles, g_pFrameBuffer, g_pDepthBuffer);
+
+    // draw the landscapes
+    for (i = 0; i < LANDSCAPE_COUNT; ++i)
+    {
+        csrMat4Multiply(&g_LandscapeMatrices[i], &g_ViewMatrix, &g_DrawMatrices[i]);
+        DrawVertexBuffer(&g_DrawMatrices[i], g_pLandscapes[i]->m_pVB, g_pLandscapeTexture);
+    }
+
+    // draw the model instances
+    for (i = 0; i < INSTANCE_COUNT; ++i)
+        DrawModel(&g_Models[g_Instances[i].m_ModelIndex],
+                  &g_Instances[i].m_Matrix,
+                  &g_DrawMatrices[LANDSCAPE_COUNT + i]);
+
+    // draw the queued scene
+    if (g_pTiles)
+        csrRasterTilesEnd(g_pTiles);
+}
+//------------------------------------------------------------------------------
+unsigned HashFrame(unsigned hash)
+{
+    size_t i;
+
+    // FNV-1a hash of the frame colors, to detect any change in the rendered images
+    for (i = 0; i < g_pFrameBuffer->m_Size; ++i)
+    {
+        hash = (hash ^ g_pFrameBuffer->m_pPixel[i].m_R) * 16777619u;
+        hash = (hash ^ g_pFrameBuffer->m_pPixel[i].m_G) * 16777619u;
+        hash = (hash ^ g_pFrameBuffer->m_pPixel[i].m_B) * 16777619u;
+    }
+
+    return hash;
+}
+//------------------------------------------------------------------------------
+int DumpFrame(const char* pDir, size_t frame)
+{
+    size_t i;
+    char   fileName[512];
+    FILE*  pFile;
+
+    sprintf(fileName, "%.480s/frame_%04u.ppm", pDir, (unsigned)frame);
+
+    pFile = fopen(fileName, "wb");
+
+    if (!pFile)
+        return 0;
+
+    fprintf(pFile, "P6\n%u %u\n255\n", (unsigned)g_pFrameBuffer->m_Width, (unsigned)g_pFrameBuffer->m_Height);
+
+    for (i = 0; i < g_pFrameBuffer->m_Size; ++i)
+    {
+        fputc(g_pFrameBuffer->m_pPixel[i].m_R, pFile);
+        fputc(g_pFrameBuffer->m_pPixel[i].m_G, pFile);
+        fputc(g_pFrameBuffer->m_pPixel[i].m_B, pFile);
+    }
+
+    fclose(pFile);
+
+    return 1;
+}
+//------------------------------------------------------------------------------
+int CompareTimes(const void* pLeft, const void* pRight)
+{
+    const double left  = *(const double*)pLeft;
+    const double right = *(const double*)pRight;
+
+    if (left < right)
+        return -1;
+
+    if (left > right)
+        return 1;
+
+    return 0;
+}
+//------------------------------------------------------------------------------
+void PrintTimes(const char* pName, double* pTimes)
+{
+    size_t i;
+    double total;
+
+    total = 0.0;
+
+    for (i = 0; i < FRAME_COUNT; ++i)
+        total += pTimes[i];
+
+    // sort the times to get the percentiles
+    qsort(pTimes, FRAME_COUNT, sizeof(double), CompareTimes);
+
+    printf("%-10s %9.3f %9.3f %9.3f %9.3f\n",
+           pName,
+           total / (double)FRAME_COUNT,
+           pTimes[FRAME_COUNT / 2],
+           pTimes[(FRAME_COUNT * 99) / 100],
+           pTimes[FRAME_COUNT - 1]);
+}
+//------------------------------------------------------------------------------
+int main(int argc, char** argv)
+{
+    size_t          i;
+    size_t          vertexCount;
+    size_t          meshCount;
+    unsigned        hash;
+    double          startTime;
+    double          frameTime;
+    const char*     pDumpDir;
+    const CSR_Mesh* pMeshes;
+
+    pDumpDir = 0;
+
+    // read the options
+    for (i = 1; i < (size_t)argc; ++i)
+        if (!strcmp(argv[i], "--tiles"))
+            g_pTiles = csrRasterTilesCreate(0, 0);
+        else
+        if (!strncmp(argv[i], "--tiles=", 8))
+            g_pTiles = csrRasterTilesCreate(0, (size_t)atoi(argv[i] + 8));
+        else
+            pDumpDir = argv[i];
+
+    // initialize the software rasterizer
+    csrRasterInit(&g_Raster);
+    g_pFrameBuffer = csrFrameBufferCreate(SCREEN_WIDTH, SCREEN_HEIGHT);
+    g_pDepthBuffer = csrDepthBufferCreate(SCREEN_WIDTH, SCREEN_HEIGHT);
+
+    // load the resources
+    startTime = GetTime();
+
+    if (!g_pFrameBuffer || !g_pDepthBuffer || !LoadModels() || !LoadLandscapes())
+    {
+        printf("Failed to initialize the benchmark, is it running from the engine root directory?\n");
+        ReleaseModels();
+        ReleaseLandscapes();
+        csrFrameBufferRelease(g_pFrameBuffer);
+        csrDepthBufferRelease(g_pDepthBuffer);
+        csrRasterTilesRelease(g_pTiles);
+        return 1;
+    }
+
+    printf("Load resources: %.2f ms\n", GetElapsedTime(startTime));
+
+    // count the drawn vertices, to make the benchmark results comparable
+    vertexCount = 0;
+
+    for (i = 0; i < LANDSCAPE_COUNT; ++i)
+        vertexCount += csrVertexBufferGetVertexCount(g_pLandscapes[i]->m_pVB);
+
+    for (i = 0; i < INSTANCE_COUNT; ++i)
+    {
+        pMeshes = GetModelMeshes(&g_Models[i % MODEL_COUNT], &meshCount);
+
+        while (meshCount--)
+            vertexCount += csrVertexBufferGetVertexCount(pMeshes[meshCount].m_pVB);
+    }
+
+    printf("Draw %d frames of %dx%d pixels, %u vertices per frame\n",
+           FRAME_COUNT,
+           SCREEN_WIDTH,
+           SCREEN_HEIGHT,
+           (unsigned)vertexCount);
+
+    if (g_pTiles)
+        printf("Draw with the tiled rasterizer\n");
+
+    InitInstances();
+
+    hash = 2166136261u;
+
+    // run the camera path
+    for (i = 0; i < FRAME_COUNT; ++i)
+    {
+        frameTime = GetTime();
+
+        startTime = GetTime();
+        UpdateScene(i);
+        g_UpdateTime[i] = GetElapsedTime(startTime);
+
+        startTime = GetTime();
+        ApplyGroundCollision();
+        g_CollisionTime[i] = GetElapsedTime(startTime);
+
+        startTime = GetTime();
+        DrawScene();
+        g_RasterTime[i] = GetElapsedTime(startTime);
+
+        g_FrameTime[i] = GetElapsedTime(frameTime);
+
+        // keep the frame signature, and dump it if required
+        hash = HashFrame(hash);
+
+        if (pDumpDir && !(i % DUMP_FRAME_STEP) && !DumpFrame(pDumpDir, i))
+            printf("Failed to write the frame %u in %s\n", (unsigned)i, pDumpDir);
+    }
+
+    // show the results, in ms per frame
+    printf("%-10s %9s %9s %9s %9s\n", "Stage", "mean", "p50", "p99", "max");
+    PrintTimes("Update",    g_UpdateTime);
+    PrintTimes("Collision", g_CollisionTime);
+    PrintTimes("Raster",    g_RasterTime);
+    PrintTimes("Frame",     g_FrameTime);
+    printf("Frames signature: %08x\n", hash);
+
+    // release the resources
+    ReleaseModels();
+    ReleaseLandscapes();
+    csrFrameBufferRelease(g_pFrameBuffer);
+    csrDepthBufferRelease(g_pDepthBuffer);
+    csrRasterTilesRelease(g_pTiles);
+
+    return 0;
+}
+//------------------------------------------------------------------------------
@@ -98,7 +98,8 @@ void OnApplyFragmentShader(const CSR_Matrix4*  pMatrix,
                            const CSR_Vector2*  pST,
                            const CSR_Vector3*  pSampler,
                                  float         z,
-                                 CSR_Color*    pColor)
+                                 CSR_Color*    pColor,
+                           const void*         pCustomData)
 {
     float  stX;
     float  stY;
@@ -352,7 +353,8 @@ void OnRender()
                   g_pFrameBuffer,
                   g_pDepthBuffer,
                   0,
-                  OnApplyFragmentShader);
+                  OnApplyFragmentShader,
+                  0);
 
     // begin a SDL drawing
     SDL_SetRenderTarget(g_pRenderer, g_pTexture);
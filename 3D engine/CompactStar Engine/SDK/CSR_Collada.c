@@ -3743,6 +3743,10 @@ int csrColladaMeshBuild(const CSR_VertexFormat*     pVertFormat,
     // calculate the stride
     csrVertexFormatCalculateStride(&pMesh->m_pVB->m_Format);
 
+    // reserve the memory for all the vertices at once
+    if (stride && !csrVertexBufferReserve(indicesCount / stride, pMesh->m_pVB))
+        return 0;
+
     // iterate through indices
     for (i = 0; i < indicesCount; i += stride)
     {
@@ -6867,25 +6871,28 @@ int csrColladaAnimationBuild(CSR_Collada_Animation* pAnimation,
         if (!pAnimatedBone->m_pKeys)
             return 0;
 
-        // allocate memory for animation keys
+        // initialize the animation keys
+        csrAnimKeysInit(pAnimatedBone->m_pKeys);
+
+        // allocate memory for the key frames and values
         pAnimatedBone->m_pKeys->m_Type       = CSR_KT_Matrix;
-        pAnimatedBone->m_pKeys->m_pKey       = (CSR_AnimationKey*)malloc(keyCount * sizeof(CSR_AnimationKey));
+        pAnimatedBone->m_pKeys->m_pFrames    = (size_t*)malloc(keyCount * sizeof(size_t));
+        pAnimatedBone->m_pKeys->m_pValues    = (float*)malloc(keyCount * stride * sizeof(float));
+        pAnimatedBone->m_pKeys->m_Stride     = stride;
         pAnimatedBone->m_pKeys->m_Count      = keyCount;
         pAnimatedBone->m_pKeys->m_ColOverRow = 1;
 
-        // iterate through keys to populate
+        if (!pAnimatedBone->m_pKeys->m_pFrames || !pAnimatedBone->m_pKeys->m_pValues)
+            return 0;
+
+        // set the key frames
         for (j = 0; j < keyCount; ++j)
-        {
-            // set key frame and count, and reserve memory for data
-            pAnimatedBone->m_pKeys->m_pKey[j].m_Frame   = j;
-            pAnimatedBone->m_pKeys->m_pKey[j].m_Count   = stride;
-            pAnimatedBone->m_pKeys->m_pKey[j].m_pValues = (float*)malloc(stride * sizeof(float));
-
-            // copy key matrix data
-            memcpy(pAnimatedBone->m_pKeys->m_pKey[j].m_pValues,
-                  &pOutput->m_pFloatArray->m_pData[j * stride],
-                   stride * sizeof(float));
-        }
+            pAnimatedBone->m_pKeys->m_pFrames[j] = j;
+
+        // copy the key matrices data
+        memcpy(pAnimatedBone->m_pKeys->m_pValues,
+               pOutput->m_pFloatArray->m_pData,
+               keyCount * stride * sizeof(float));
     }
 
     return 1;
@@ -7734,6 +7741,9 @@ int csrColladaParse(const CSR_Buffer*           pBuffer,
             // initialize the mesh skin weights item
             pCollada->m_pMeshWeights[i].m_pSkinWeights = 0;
             pCollada->m_pMeshWeights[i].m_Count        = 0;
+            pCollada->m_pMeshWeights[i].m_pMatrices    = 0;
+            csrSkinVertexWeightsInit(&pCollada->m_pMeshWeights[i].m_VertexWeights);
+            csrVertexBufferInit(&pCollada->m_pMeshWeights[i].m_SkinnedVB);
 
             // iterate through geometry libraries
             for (j = 0; j < geometryCount; ++j)
@@ -7931,6 +7941,59 @@ CSR_Collada* csrColladaCreate(const CSR_Buffer*           pBuffer,
                          fOnDeleteTexture))
         return 0;
 
+    // skin weights?
+    if (pCollada->m_pMeshWeights)
+    {
+        size_t i;
+
+        // convert the skin weights per vertex, thus the skinning may be processed by the GPU
+        for (i = 0; i < pCollada->m_MeshWeightsCount && i < pCollada->m_MeshCount; ++i)
+            if (pCollada->m_pMeshWeights[i].m_pSkinWeights && pCollada->m_pMesh[i].m_Count == 1)
+                csrSkinVertexWeightsFromGroup(&pCollada->m_pMeshWeights[i],
+                                              pCollada->m_pMesh[i].m_pVB,
+                                              &pCollada->m_pMeshWeights[i].m_VertexWeights);
+
+        // allocate the final matrix of each skin weights, thus they aren't allocated on each frame
+        for (i = 0; i < pCollada->m_MeshWeightsCount; ++i)
+            if (pCollada->m_pMeshWeights[i].m_pSkinWeights)
+                pCollada->m_pMeshWeights[i].m_pMatrices =
+                        (CSR_Matrix4*)malloc(pCollada->m_pMeshWeights[i].m_Count * sizeof(CSR_Matrix4));
+    }
+
+    // skeletons?
+    if (pCollada->m_pSkeletons && !pCollada->m_MeshOnly)
+    {
+        size_t i;
+        size_t j;
+        int    success = 1;
+
+        // create the bone pose, which calculates all the bone matrices of a frame at once
+        pCollada->m_pPose = csrBonePoseCreate();
+
+        // add all the skeletons to the bone pose
+        for (i = 0; i < pCollada->m_SkeletonCount && pCollada->m_pPose; ++i)
+            if (pCollada->m_pSkeletons[i].m_pRoot)
+                success &= csrBonePoseAddSkeleton(pCollada->m_pSkeletons[i].m_pRoot, pCollada->m_pPose);
+
+        // succeeded?
+        if (pCollada->m_pPose && success)
+        {
+            // link the animations to the bones
+            if (!pCollada->m_PoseOnly)
+                csrBonePoseLinkAnimSets(pCollada->m_pAnimationSet,
+                                        pCollada->m_AnimationSetCount,
+                                        pCollada->m_pPose);
+
+            // link the skin weights to the bones
+            if (pCollada->m_pMeshWeights)
+                for (i = 0; i < pCollada->m_MeshWeightsCount; ++i)
+                    for (j = 0; j < pCollada->m_pMeshWeights[i].m_Count; ++j)
+                        pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_BoneIndex =
+                                csrBonePoseGetIndex(pCollada->m_pPose,
+                                                    pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_pBone);
+        }
+    }
+
     return pCollada;
 }
 //---------------------------------------------------------------------------
@@ -7993,6 +8056,8 @@ void csrColladaInit(CSR_Collada* pCollada)
     pCollada->m_SkeletonCount       = 0;
     pCollada->m_pAnimationSet       = 0;
     pCollada->m_AnimationSetCount   = 0;
+    pCollada->m_pPose               = 0;
+    pCollada->m_pClips              = 0;
     pCollada->m_MeshOnly            = 0;
     pCollada->m_PoseOnly            = 0;
 }
@@ -8020,9 +8085,14 @@ void csrColladaRelease(CSR_Collada* pCollada, const CSR_fOnDeleteTexture fOnDele
             {
                 // free the mesh vertex buffer content
                 for (j = 0; j < pCollada->m_pMesh[i].m_Count; ++j)
+                {
                     if (pCollada->m_pMesh[i].m_pVB[j].m_pData)
                         free(pCollada->m_pMesh[i].m_pVB[j].m_pData);
 
+                    if (pCollada->m_pMesh[i].m_pVB[j].m_Index.m_pData)
+                        free(pCollada->m_pMesh[i].m_pVB[j].m_Index.m_pData);
+                }
+
                 // free the mesh vertex buffer
                 free(pCollada->m_pMesh[i].m_pVB);
             }
@@ -8044,6 +8114,13 @@ void csrColladaRelease(CSR_Collada* pCollada, const CSR_fOnDeleteTexture fOnDele
 
             // free the mesh skin weights
             free(pCollada->m_pMeshWeights[i].m_pSkinWeights);
+
+            // release the mesh vertex skin weights
+            csrSkinVertexWeightsRelease(&pCollada->m_pMeshWeights[i].m_VertexWeights);
+
+            // free the skin weights matrices and the skinned vertices
+            free(pCollada->m_pMeshWeights[i].m_pMatrices);
+            free(pCollada->m_pMeshWeights[i].m_SkinnedVB.m_pData);
         }
 
         // free the mesh weights
@@ -8076,7 +8153,72 @@ void csrColladaRelease(CSR_Collada* pCollada, const CSR_fOnDeleteTexture fOnDele
         free(pCollada->m_pAnimationSet);
     }
 
+    // release the baked animation clips
+    if (pCollada->m_pClips)
+    {
+        // release the baked animation clips content
+        for (i = 0; i < pCollada->m_AnimationSetCount; ++i)
+            csrBoneClipRelease(&pCollada->m_pClips[i], 1);
+
+        // free the baked animation clips
+        free(pCollada->m_pClips);
+    }
+
+    // release the bone pose
+    csrBonePoseRelease(pCollada->m_pPose, 0);
+
     // release the model
     free(pCollada);
 }
 //---------------------------------------------------------------------------
+int csrColladaBakeAnimations(CSR_Collada* pCollada, size_t frameStep, int quantize)
+{
+    size_t             i;
+    size_t             frameCount;
+    const CSR_Matrix4* pInitialMatrix;
+
+    // validate the inputs
+    if (!pCollada || !pCollada->m_pPose || !pCollada->m_pAnimationSet || !frameStep)
+        return 0;
+
+    // get the initial matrix from which the bone matrices should be get
+    pInitialMatrix = pCollada->m_pSkeletons ? &pCollada->m_pSkeletons->m_InitialMatrix : 0;
+
+    // create the baked animation clips, if still not done
+    if (!pCollada->m_pClips)
+    {
+        pCollada->m_pClips = (CSR_Bone_Clip*)malloc(pCollada->m_AnimationSetCount * sizeof(CSR_Bone_Clip));
+
+        // succeeded?
+        if (!pCollada->m_pClips)
+            return 0;
+
+        // initialize the baked animation clips
+        for (i = 0; i < pCollada->m_AnimationSetCount; ++i)
+            csrBoneClipInit(&pCollada->m_pClips[i]);
+    }
+
+    // bake each animation set
+    for (i = 0; i < pCollada->m_AnimationSetCount; ++i)
+    {
+        // get the animation set frame count
+        frameCount = csrBoneAnimSetGetFrameCount(&pCollada->m_pAnimationSet[i]);
+
+        // nothing to bake?
+        if (!frameCount)
+            continue;
+
+        // bake the animation set
+        if (!csrBoneClipBake(pCollada->m_pPose,
+                             i,
+                             frameCount,
+                             frameStep,
+                             pInitialMatrix,
+                             quantize,
+                             &pCollada->m_pClips[i]))
+            return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
@@ -55,6 +55,8 @@ typedef struct
     size_t                  m_SkeletonCount;       // skeleton count
     CSR_AnimationSet_Bone*  m_pAnimationSet;       // set of animations to apply to bones
     size_t                  m_AnimationSetCount;   // animation set count
+    CSR_Bone_Pose*          m_pPose;               // bone pose, to calculate all the bone matrices of a frame at once
+    CSR_Bone_Clip*          m_pClips;              // baked animation clips, one per animation set, 0 if not baked
     int                     m_MeshOnly;            // if activated, only the mesh will be drawn. All other data will be ignored
     int                     m_PoseOnly;            // if activated, the model will take the default pose but will not be animated
 } CSR_Collada;
@@ -132,6 +134,16 @@ typedef struct
         */
         void csrColladaRelease(CSR_Collada* pCollada, const CSR_fOnDeleteTexture fOnDeleteTexture);
 
+        /**
+        * Bakes the Collada model animation sets, to speed up their playback
+        *@param[in, out] pCollada - Collada model for which the animations should be baked
+        *@param frameStep - animation frame count between 2 baked samples
+        *@param quantize - if 1, the baked bones will be quantized on 16 bits
+        *@return 1 on success, otherwise 0
+        *@note Once baked, the animations are played from the baked clips, by blending their samples
+        */
+        int csrColladaBakeAnimations(CSR_Collada* pCollada, size_t frameStep, int quantize);
+
 #ifdef __cplusplus
     }
 #endif
@@ -17,423 +17,3341 @@
 
 // std
 #include <stdlib.h>
+#include <math.h>
+#include <string.h>
+
+// vectorized ray casts, if available on the target platform
+#if defined(_OS_IOS_) || defined(_OS_ANDROID_) || defined(_OS_WINDOWS_) || defined(CSR_GEOMETRY_NO_SIMD)
+    // the rays are processed one by one
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define CSR_COLLISION_SSE2
+#endif
 
 //---------------------------------------------------------------------------
-// Aligned-Axis Bounding Box tree functions
+// Global defines
 //---------------------------------------------------------------------------
-int csrAABBTreeFromIndexedPolygonBuffer(const CSR_IndexedPolygonBuffer* pIPB,
-                                              CSR_AABBNode*             pNode)
+#define M_CSR_AABB_Tree_Bin_Count         16
+#define M_CSR_AABB_Tree_Max_Leaf_Polygons  4
+#define M_CSR_AABB_Tree_Stack_Size        64
+#define M_CSR_AABB_Tree_Hit_Tolerance      1.0E-5f
+#define M_CSR_AABB_Tree_File_Version       1
+#define M_CSR_AABB_Tree_File_ID           (('T' << 24) + ('B' << 16) + ('A' << 8) + 'C')
+#define M_CSR_AABB_Tree_File_Left          0x1
+#define M_CSR_AABB_Tree_File_Right         0x2
+//---------------------------------------------------------------------------
+// Aligned-Axis Bounding Box tree private structures
+//---------------------------------------------------------------------------
+
+/**
+* AABB tree file header
+*/
+typedef struct
+{
+    unsigned m_ID;
+    unsigned m_Version;
+    unsigned m_Hash;         // hash of the mesh the tree was built from
+    unsigned m_NodeCount;
+    unsigned m_PolygonCount;
+} CSR_AABBTreeFileHeader;
+
+/**
+* AABB tree file node, the nodes are written in depth-first order, left child first
+*/
+typedef struct
+{
+    CSR_Box  m_Box;
+    unsigned m_Children;     // combination of M_CSR_AABB_Tree_File_Left and M_CSR_AABB_Tree_File_Right
+    unsigned m_PolygonCount; // polygons following the previous node polygons
+} CSR_AABBTreeFileNode;
+
+/**
+* AABB tree file polygon
+*/
+typedef struct
+{
+    unsigned m_VB;           // vertex buffer index in the mesh
+    unsigned m_Index[3];
+} CSR_AABBTreeFilePolygon;
+
+//---------------------------------------------------------------------------
+// Flat AABB tree private structures
+//---------------------------------------------------------------------------
+
+/**
+* Polygon reference, used while the flat AABB tree is built
+*/
+typedef struct
+{
+    CSR_Box     m_Box;
+    CSR_Vector3 m_Center;
+    size_t      m_Index;
+} CSR_AABBFlatTreePolygonRef;
+
+/**
+* Pending node, used while the flat AABB tree is ray casted
+*/
+typedef struct
+{
+    size_t m_Index;
+    float  m_Near;
+} CSR_AABBFlatTreeStackItem;
+
+//---------------------------------------------------------------------------
+// Aligned-Axis Bounding Box tree private functions
+//---------------------------------------------------------------------------
+void csrAABBTreeBoxMerge(const CSR_Box* pBox, CSR_Box* pR, int* pEmpty)
+{
+    // is resulting box empty?
+    if (*pEmpty)
+    {
+         *pR     = *pBox;
+         *pEmpty = 0;
+        return;
+    }
+
+    csrMathMin(pR->m_Min.m_X, pBox->m_Min.m_X, &pR->m_Min.m_X);
+    csrMathMin(pR->m_Min.m_Y, pBox->m_Min.m_Y, &pR->m_Min.m_Y);
+    csrMathMin(pR->m_Min.m_Z, pBox->m_Min.m_Z, &pR->m_Min.m_Z);
+    csrMathMax(pR->m_Max.m_X, pBox->m_Max.m_X, &pR->m_Max.m_X);
+    csrMathMax(pR->m_Max.m_Y, pBox->m_Max.m_Y, &pR->m_Max.m_Y);
+    csrMathMax(pR->m_Max.m_Z, pBox->m_Max.m_Z, &pR->m_Max.m_Z);
+}
+//---------------------------------------------------------------------------
+void csrAABBTreeRaySlab(float  pos,
+                        float  invDir,
+                        float  min,
+                        float  max,
+                        float  inf,
+                        float* pNear,
+                        float* pFar)
+{
+    float t1;
+    float t2;
+
+    // calculate the points where the ray intersects the slab, a zero direction is stored as
+    // infinite value, in this case the result only depends on which side the ray is
+    if (invDir != inf)
+    {
+        t1 = (min - pos) * invDir;
+        t2 = (max - pos) * invDir;
+    }
+    else
+    {
+        t1 = ((min - pos) < 0.0f) ? -inf : inf;
+        t2 = ((max - pos) < 0.0f) ? -inf : inf;
+    }
+
+    // NOTE this function is called very often while a tree is traversed, so the min/max values
+    // are calculated here rather than by calling csrMathMin()/csrMathMax()
+    if (t1 < t2)
+    {
+        *pNear = t1;
+        *pFar  = t2;
+    }
+    else
+    {
+        *pNear = t2;
+        *pFar  = t1;
+    }
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeRayBox(const CSR_Ray3* pRay, const CSR_Box* pBox, float* pNear, float* pFar)
+{
+    float xNear;
+    float xFar;
+    float yNear;
+    float yFar;
+    float zNear;
+    float zFar;
+    float tNear;
+    float tFar;
+
+    // get infinite value
+    #ifdef _MSC_VER
+        const float inf = INFINITY;
+    #else
+        const float inf = 1.0f / 0.0f;
+    #endif
+
+    csrAABBTreeRaySlab(pRay->m_Pos.m_X, pRay->m_InvDir.m_X, pBox->m_Min.m_X, pBox->m_Max.m_X, inf, &xNear, &xFar);
+    csrAABBTreeRaySlab(pRay->m_Pos.m_Y, pRay->m_InvDir.m_Y, pBox->m_Min.m_Y, pBox->m_Max.m_Y, inf, &yNear, &yFar);
+    csrAABBTreeRaySlab(pRay->m_Pos.m_Z, pRay->m_InvDir.m_Z, pBox->m_Min.m_Z, pBox->m_Max.m_Z, inf, &zNear, &zFar);
+
+    // calculate final near/far intersection point
+    tNear = (yNear > zNear) ? yNear : zNear;
+    tNear = (xNear > tNear) ? xNear : tNear;
+    tFar  = (yFar  < zFar)  ? yFar  : zFar;
+    tFar  = (xFar  < tFar)  ? xFar  : tFar;
+
+    if (pNear)
+        *pNear = tNear;
+
+    if (pFar)
+        *pFar = tFar;
+
+    // check if ray intersects box. A small tolerance is added, otherwise a ray crossing exactly a
+    // polygon edge may miss both the flat boxes surrounding the adjacent polygons
+    return (tFar + (float)M_CSR_Epsilon >= tNear);
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeRayCastBox(const CSR_Ray3* pRay, const CSR_Box* pBox, float maxDistance, float* pNear)
+{
+    float tNear;
+    float tFar;
+
+    // check if the ray line intersects the box
+    if (!csrAABBTreeRayBox(pRay, pBox, &tNear, &tFar))
+        return 0;
+
+    // the box is behind the ray origin, or farther than the nearest hit found until now
+    if (tFar < 0.0f || tNear > maxDistance)
+        return 0;
+
+    *pNear = tNear;
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeRayCastTriangle(const CSR_Ray3*           pRay,
+                               const CSR_IndexedPolygon* pPolygon,
+                               const CSR_Vector3*        pVertex,
+                               const CSR_Vector3*        pE1,
+                               const CSR_Vector3*        pE2,
+                                     float*              pMaxDistance,
+                                     CSR_AABBTreeHit*    pHit)
+{
+    CSR_Vector3 p;
+    CSR_Vector3 q;
+    CSR_Vector3 s;
+    float       det;
+    float       invDet;
+    float       u;
+    float       v;
+    float       t;
+
+    // calculate the determinant, if 0 the ray is parallel to the polygon plane
+    csrVec3Cross(&pRay->m_Dir, pE2, &p);
+    csrVec3Dot(pE1, &p, &det);
+
+    if (!det)
+        return 0;
+
+    invDet = 1.0f / det;
+
+    // calculate the first barycentric coordinate
+    csrVec3Sub(&pRay->m_Pos, pVertex, &s);
+    csrVec3Dot(&s, &p, &u);
+    u *= invDet;
+
+    // a small tolerance is added, otherwise a ray crossing exactly an edge may miss both the
+    // adjacent polygons
+    if (u < -M_CSR_AABB_Tree_Hit_Tolerance || u > 1.0f + M_CSR_AABB_Tree_Hit_Tolerance)
+        return 0;
+
+    // calculate the second barycentric coordinate
+    csrVec3Cross(&s, pE1, &q);
+    csrVec3Dot(&pRay->m_Dir, &q, &v);
+    v *= invDet;
+
+    if (v < -M_CSR_AABB_Tree_Hit_Tolerance || u + v > 1.0f + M_CSR_AABB_Tree_Hit_Tolerance)
+        return 0;
+
+    // calculate the hit distance
+    csrVec3Dot(pE2, &q, &t);
+    t *= invDet;
+
+    // polygon is behind the ray origin, or not nearer than the previous hit
+    if (t < 0.0f || t >= *pMaxDistance)
+        return 0;
+
+    *pMaxDistance = t;
+
+    // populate the hit
+    pHit->m_pPolygon = pPolygon;
+    pHit->m_Distance = t;
+    pHit->m_U        = u;
+    pHit->m_V        = v;
+    csrVec3Cross(pE1, pE2, &pHit->m_Normal);
+    csrVec3Normalize(&pHit->m_Normal, &pHit->m_Normal);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeRayCastPolygon(const CSR_Ray3*           pRay,
+                              const CSR_IndexedPolygon* pPolygon,
+                                    float*              pMaxDistance,
+                                    CSR_AABBTreeHit*    pHit)
+{
+    CSR_Polygon3 polygon;
+    CSR_Vector3  e1;
+    CSR_Vector3  e2;
+
+    // get the polygon vertices
+    if (!csrIndexedPolygonToPolygon(pPolygon, &polygon))
+        return 0;
+
+    // calculate the polygon edges
+    csrVec3Sub(&polygon.m_Vertex[1], &polygon.m_Vertex[0], &e1);
+    csrVec3Sub(&polygon.m_Vertex[2], &polygon.m_Vertex[0], &e2);
+
+    return csrAABBTreeRayCastTriangle(pRay, pPolygon, &polygon.m_Vertex[0], &e1, &e2, pMaxDistance, pHit);
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeRayCastNode(const CSR_Ray3*        pRay,
+                           const CSR_AABBNode*    pNode,
+                                 float*           pMaxDistance,
+                                 CSR_AABBTreeHit* pHit)
+{
+    size_t              i;
+    float               leftNear;
+    float               rightNear;
+    float               secondNear;
+    int                 leftHit  = 0;
+    int                 rightHit = 0;
+    int                 result   = 0;
+    const CSR_AABBNode* pFirst;
+    const CSR_AABBNode* pSecond;
+
+    // is leaf?
+    if (!pNode->m_pLeft && !pNode->m_pRight)
+    {
+        // test all the polygons contained in the leaf, keep the nearest one
+        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+            result |= csrAABBTreeRayCastPolygon(pRay,
+                                               &pNode->m_pPolygonBuffer->m_pIndexedPolygon[i],
+                                                pMaxDistance,
+                                                pHit);
+
+        return result;
+    }
+
+    // check which children the ray intersects
+    if (pNode->m_pLeft)
+        leftHit = csrAABBTreeRayCastBox(pRay, pNode->m_pLeft->m_pBox, *pMaxDistance, &leftNear);
+
+    if (pNode->m_pRight)
+        rightHit = csrAABBTreeRayCastBox(pRay, pNode->m_pRight->m_pBox, *pMaxDistance, &rightNear);
+
+    // only one child may contain a hit?
+    if (!leftHit || !rightHit)
+    {
+        if (leftHit)
+            return csrAABBTreeRayCastNode(pRay, pNode->m_pLeft, pMaxDistance, pHit);
+
+        if (rightHit)
+            return csrAABBTreeRayCastNode(pRay, pNode->m_pRight, pMaxDistance, pHit);
+
+        return 0;
+    }
+
+    // visit the nearest child first
+    if (leftNear <= rightNear)
+    {
+        pFirst     = pNode->m_pLeft;
+        pSecond    = pNode->m_pRight;
+        secondNear = rightNear;
+    }
+    else
+    {
+        pFirst     = pNode->m_pRight;
+        pSecond    = pNode->m_pLeft;
+        secondNear = leftNear;
+    }
+
+    result = csrAABBTreeRayCastNode(pRay, pFirst, pMaxDistance, pHit);
+
+    // the farthest child may be skipped if a nearer hit was found in the nearest one
+    if (secondNear <= *pMaxDistance)
+        result |= csrAABBTreeRayCastNode(pRay, pSecond, pMaxDistance, pHit);
+
+    return result;
+}
+//---------------------------------------------------------------------------
+#ifdef CSR_COLLISION_SSE2
+    void csrAABBTreeRaySlabSSE2(__m128  pos,
+                                __m128  invDir,
+                                float   min,
+                                float   max,
+                                __m128  inf,
+                                __m128* pNear,
+                                __m128* pFar)
+    {
+        __m128 finite;
+        __m128 behind;
+        __m128 t1;
+        __m128 t2;
+
+        const __m128 minDist = _mm_sub_ps(_mm_set1_ps(min), pos);
+        const __m128 maxDist = _mm_sub_ps(_mm_set1_ps(max), pos);
+        const __m128 negInf  = _mm_sub_ps(_mm_setzero_ps(), inf);
+
+        // calculate the points where the rays intersect the slab, a zero direction is stored as
+        // infinite value, in this case the result only depends on which side the ray is
+        finite = _mm_cmpneq_ps(invDir, inf);
+
+        behind = _mm_cmplt_ps(minDist, _mm_setzero_ps());
+        t1     = _mm_or_ps(_mm_and_ps(finite, _mm_mul_ps(minDist, invDir)),
+                           _mm_andnot_ps(finite, _mm_or_ps(_mm_and_ps(behind, negInf), _mm_andnot_ps(behind, inf))));
+
+        behind = _mm_cmplt_ps(maxDist, _mm_setzero_ps());
+        t2     = _mm_or_ps(_mm_and_ps(finite, _mm_mul_ps(maxDist, invDir)),
+                           _mm_andnot_ps(finite, _mm_or_ps(_mm_and_ps(behind, negInf), _mm_andnot_ps(behind, inf))));
+
+        // NOTE the operand order matches the csrAABBTreeRaySlab() comparisons, thus the result is
+        // the same, even with NaN values
+        *pNear = _mm_min_ps(t1, t2);
+        *pFar  = _mm_max_ps(t2, t1);
+    }
+    //---------------------------------------------------------------------------
+    void csrAABBTreeRayCastBoxes(const CSR_Ray3* pRays,
+                                 const CSR_Box*  pBox,
+                                 const float*    pMaxDistances,
+                                 const size_t*   pIndices,
+                                       size_t    count,
+                                       int*      pInside)
+    {
+        size_t          i;
+        size_t          j;
+        int             mask;
+        float           tNear;
+        __m128          xNear;
+        __m128          xFar;
+        __m128          yNear;
+        __m128          yFar;
+        __m128          zNear;
+        __m128          zFar;
+        __m128          nearest;
+        __m128          farthest;
+        __m128          hit;
+        __m128          miss;
+        const CSR_Ray3* pRay[4];
+
+        // get infinite value
+        #ifdef _MSC_VER
+            const __m128 inf = _mm_set1_ps(INFINITY);
+        #else
+            const __m128 inf = _mm_set1_ps(1.0f / 0.0f);
+        #endif
+
+        const __m128 zero    = _mm_setzero_ps();
+        const __m128 epsilon = _mm_set1_ps((float)M_CSR_Epsilon);
+
+        // check the rays 4 by 4
+        for (i = 0; i + 4 <= count; i += 4)
+        {
+            for (j = 0; j < 4; ++j)
+                pRay[j] = &pRays[pIndices[i + j]];
+
+            csrAABBTreeRaySlabSSE2(_mm_set_ps(pRay[3]->m_Pos.m_X,    pRay[2]->m_Pos.m_X,    pRay[1]->m_Pos.m_X,    pRay[0]->m_Pos.m_X),
+                                   _mm_set_ps(pRay[3]->m_InvDir.m_X, pRay[2]->m_InvDir.m_X, pRay[1]->m_InvDir.m_X, pRay[0]->m_InvDir.m_X),
+                                   pBox->m_Min.m_X,
+                                   pBox->m_Max.m_X,
+                                   inf,
+                                  &xNear,
+                                  &xFar);
+            csrAABBTreeRaySlabSSE2(_mm_set_ps(pRay[3]->m_Pos.m_Y,    pRay[2]->m_Pos.m_Y,    pRay[1]->m_Pos.m_Y,    pRay[0]->m_Pos.m_Y),
+                                   _mm_set_ps(pRay[3]->m_InvDir.m_Y, pRay[2]->m_InvDir.m_Y, pRay[1]->m_InvDir.m_Y, pRay[0]->m_InvDir.m_Y),
+                                   pBox->m_Min.m_Y,
+                                   pBox->m_Max.m_Y,
+                                   inf,
+                                  &yNear,
+                                  &yFar);
+            csrAABBTreeRaySlabSSE2(_mm_set_ps(pRay[3]->m_Pos.m_Z,    pRay[2]->m_Pos.m_Z,    pRay[1]->m_Pos.m_Z,    pRay[0]->m_Pos.m_Z),
+                                   _mm_set_ps(pRay[3]->m_InvDir.m_Z, pRay[2]->m_InvDir.m_Z, pRay[1]->m_InvDir.m_Z, pRay[0]->m_InvDir.m_Z),
+                                   pBox->m_Min.m_Z,
+                                   pBox->m_Max.m_Z,
+                                   inf,
+                                  &zNear,
+                                  &zFar);
+
+            // calculate final near/far intersection points
+            nearest  = _mm_max_ps(xNear, _mm_max_ps(yNear, zNear));
+            farthest = _mm_min_ps(xFar,  _mm_min_ps(yFar,  zFar));
+
+            // check if the rays intersect the box, with the same tolerance as csrAABBTreeRayBox()
+            hit = _mm_cmpge_ps(_mm_add_ps(farthest, epsilon), nearest);
+
+            // the box is behind the ray origin, or farther than the nearest hit found until now
+            miss = _mm_or_ps(_mm_cmplt_ps(farthest, zero),
+                             _mm_cmpgt_ps(nearest, _mm_set_ps(pMaxDistances[pIndices[i + 3]],
+                                                              pMaxDistances[pIndices[i + 2]],
+                                                              pMaxDistances[pIndices[i + 1]],
+                                                              pMaxDistances[pIndices[i]])));
+
+            mask = _mm_movemask_ps(_mm_andnot_ps(miss, hit));
+
+            for (j = 0; j < 4; ++j)
+                pInside[pIndices[i + j]] = (mask >> j) & 1;
+        }
+
+        // check the remaining rays
+        for (; i < count; ++i)
+            pInside[pIndices[i]] = csrAABBTreeRayCastBox(&pRays[pIndices[i]],
+                                                          pBox,
+                                                          pMaxDistances[pIndices[i]],
+                                                         &tNear);
+    }
+#else
+    void csrAABBTreeRayCastBoxes(const CSR_Ray3* pRays,
+                                 const CSR_Box*  pBox,
+                                 const float*    pMaxDistances,
+                                 const size_t*   pIndices,
+                                       size_t    count,
+                                       int*      pInside)
+    {
+        size_t i;
+        float  tNear;
+
+        for (i = 0; i < count; ++i)
+            pInside[pIndices[i]] = csrAABBTreeRayCastBox(&pRays[pIndices[i]],
+                                                          pBox,
+                                                          pMaxDistances[pIndices[i]],
+                                                         &tNear);
+    }
+#endif
+//---------------------------------------------------------------------------
+size_t csrAABBTreeRayCastPartition(const CSR_Ray3* pRays,
+                                   const CSR_Box*  pBox,
+                                   const float*    pMaxDistances,
+                                         size_t*   pIndices,
+                                         size_t    count,
+                                         int*      pInside)
+{
+    size_t i = 0;
+    size_t j = count;
+    size_t index;
+
+    // find which rays intersect the box
+    csrAABBTreeRayCastBoxes(pRays, pBox, pMaxDistances, pIndices, count, pInside);
+
+    // move the rays intersecting the box at the beginning of the list
+    while (i < j)
+        if (pInside[pIndices[i]])
+            ++i;
+        else
+        {
+            --j;
+            index       = pIndices[i];
+            pIndices[i] = pIndices[j];
+            pIndices[j] = index;
+        }
+
+    return i;
+}
+//---------------------------------------------------------------------------
+void csrAABBTreeRayCastStream(const CSR_Ray3*        pRays,
+                              const CSR_AABBNode*    pNode,
+                                    size_t*          pIndices,
+                                    size_t           count,
+                                    float*           pMaxDistances,
+                                    int*             pInside,
+                                    CSR_AABBTreeHit* pHits,
+                                    int*             pResults)
 {
     size_t                    i;
     size_t                    j;
-    CSR_Box                   leftBox;
-    CSR_Box                   rightBox;
+    size_t                    index;
+    size_t                    hitCount;
+    float                     leftNear;
+    float                     rightNear;
+    int                       leftHit;
+    int                       rightHit;
     CSR_Polygon3              polygon;
-    CSR_IndexedPolygon*       pNewPolygons    = 0;
-    CSR_IndexedPolygonBuffer* pLeftPolygons   = 0;
-    CSR_IndexedPolygonBuffer* pRightPolygons  = 0;
-    int                       boxEmpty        = 1;
-    int                       insideLeft      = 0;
-    int                       insideRight     = 0;
-    int                       canResolveLeft  = 0;
-    int                       canResolveRight = 0;
-    int                       result          = 0;
+    CSR_Vector3               e1;
+    CSR_Vector3               e2;
+    const CSR_IndexedPolygon* pPolygon;
+    const CSR_AABBNode*       pChildren[2];
 
-    // no indexed polygon buffer?
-    if (!pIPB)
+    // is leaf?
+    if (!pNode->m_pLeft && !pNode->m_pRight)
+    {
+        // test each polygon against all the rays which reached the leaf
+        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+        {
+            pPolygon = &pNode->m_pPolygonBuffer->m_pIndexedPolygon[i];
+
+            // get the polygon vertices and edges, only once for the whole stream
+            if (!csrIndexedPolygonToPolygon(pPolygon, &polygon))
+                continue;
+
+            csrVec3Sub(&polygon.m_Vertex[1], &polygon.m_Vertex[0], &e1);
+            csrVec3Sub(&polygon.m_Vertex[2], &polygon.m_Vertex[0], &e2);
+
+            for (j = 0; j < count; ++j)
+            {
+                index = pIndices[j];
+
+                if (csrAABBTreeRayCastTriangle(&pRays[index],
+                                                pPolygon,
+                                               &polygon.m_Vertex[0],
+                                               &e1,
+                                               &e2,
+                                               &pMaxDistances[index],
+                                               &pHits[index]))
+                    pResults[index] = 1;
+            }
+        }
+
+        return;
+    }
+
+    pChildren[0] = pNode->m_pLeft;
+    pChildren[1] = pNode->m_pRight;
+
+    // the rays of a stream are expected to be coherent, so use the first one to determine which
+    // child is the nearest, and visit it first
+    if (pNode->m_pLeft && pNode->m_pRight)
+    {
+        index    = pIndices[0];
+        leftHit  = csrAABBTreeRayCastBox(&pRays[index], pNode->m_pLeft->m_pBox,  pMaxDistances[index], &leftNear);
+        rightHit = csrAABBTreeRayCastBox(&pRays[index], pNode->m_pRight->m_pBox, pMaxDistances[index], &rightNear);
+
+        if ((!leftHit && rightHit) || (leftHit && rightHit && rightNear < leftNear))
+        {
+            pChildren[0] = pNode->m_pRight;
+            pChildren[1] = pNode->m_pLeft;
+        }
+    }
+
+    for (i = 0; i < 2; ++i)
+    {
+        if (!pChildren[i])
+            continue;
+
+        // keep only the rays intersecting the child box. NOTE the list content is only reordered,
+        // so the whole stream is still available for the next child
+        hitCount = csrAABBTreeRayCastPartition(pRays, pChildren[i]->m_pBox, pMaxDistances, pIndices, count, pInside);
+
+        if (hitCount)
+            csrAABBTreeRayCastStream(pRays, pChildren[i], pIndices, hitCount, pMaxDistances, pInside, pHits, pResults);
+    }
+}
+//---------------------------------------------------------------------------
+void csrAABBTreeBarycentric(const CSR_Vector3* pPoint,
+                            const CSR_Vector3* pVertex,
+                            const CSR_Vector3* pE1,
+                            const CSR_Vector3* pE2,
+                                  float*       pU,
+                                  float*       pV)
+{
+    CSR_Vector3 p;
+    float       d11;
+    float       d12;
+    float       d22;
+    float       dp1;
+    float       dp2;
+    float       denom;
+
+    csrVec3Sub(pPoint, pVertex, &p);
+    csrVec3Dot(pE1, pE1, &d11);
+    csrVec3Dot(pE1, pE2, &d12);
+    csrVec3Dot(pE2, pE2, &d22);
+    csrVec3Dot(&p,  pE1, &dp1);
+    csrVec3Dot(&p,  pE2, &dp2);
+
+    denom = d11 * d22 - d12 * d12;
+
+    // degenerated polygon?
+    if (!denom)
+    {
+        *pU = -1.0f;
+        *pV = -1.0f;
+        return;
+    }
+
+    *pU = (d22 * dp1 - d12 * dp2) / denom;
+    *pV = (d11 * dp2 - d12 * dp1) / denom;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeSphereCastBox(const CSR_Ray3* pRay,
+                                   float     radius,
+                             const CSR_Box*  pBox,
+                                   float     maxDistance,
+                                   float*    pNear)
+{
+    CSR_Box box;
+
+    // the sphere reaches the box when its center reaches the box extended by its radius
+    box.m_Min.m_X = pBox->m_Min.m_X - radius;
+    box.m_Min.m_Y = pBox->m_Min.m_Y - radius;
+    box.m_Min.m_Z = pBox->m_Min.m_Z - radius;
+    box.m_Max.m_X = pBox->m_Max.m_X + radius;
+    box.m_Max.m_Y = pBox->m_Max.m_Y + radius;
+    box.m_Max.m_Z = pBox->m_Max.m_Z + radius;
+
+    return csrAABBTreeRayCastBox(pRay, &box, maxDistance, pNear);
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeSphereCastPoint(const CSR_Ray3*    pRay,
+                                     float        radius,
+                               const CSR_Vector3* pPoint,
+                                     float*       pMaxDistance)
+{
+    CSR_Vector3 m;
+    float       b;
+    float       c;
+    float       discriminant;
+    float       t;
+
+    // solve |pos + t * dir - point| = radius, the direction being normalized
+    csrVec3Sub(&pRay->m_Pos, pPoint, &m);
+    csrVec3Dot(&m, &pRay->m_Dir, &b);
+    csrVec3Dot(&m, &m, &c);
+    c -= radius * radius;
+
+    // the sphere already contains the point, or moves away from it?
+    if (c <= 0.0f || b >= 0.0f)
         return 0;
 
-    // no node?
-    if (!pNode)
+    discriminant = b * b - c;
+
+    if (discriminant < 0.0f)
         return 0;
 
-    // initialize node content
-    pNode->m_pParent        = 0;
-    pNode->m_pLeft          = 0;
-    pNode->m_pRight         = 0;
-    pNode->m_pBox           = (CSR_Box*)malloc(sizeof(CSR_Box));
-    pNode->m_pPolygonBuffer = csrIndexedPolygonBufferCreate();
+    t = -b - (float)sqrt(discriminant);
 
-    // succeeded?
-    if (!pNode->m_pBox || !pNode->m_pPolygonBuffer)
+    if (t < 0.0f || t > *pMaxDistance)
+        return 0;
+
+    *pMaxDistance = t;
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeSphereCastEdge(const CSR_Ray3*    pRay,
+                                    float        radius,
+                              const CSR_Vector3* pStart,
+                              const CSR_Vector3* pEnd,
+                                    float*       pMaxDistance,
+                                    CSR_Vector3* pContact)
+{
+    CSR_Vector3 e;
+    CSR_Vector3 m;
+    float       ee;
+    float       ed;
+    float       em;
+    float       dm;
+    float       mm;
+    float       a;
+    float       b;
+    float       c;
+    float       discriminant;
+    float       s;
+    float       t;
+
+    // solve the distance between the sphere center and the infinite line crossing the edge
+    csrVec3Sub(pEnd,         pStart, &e);
+    csrVec3Sub(&pRay->m_Pos, pStart, &m);
+    csrVec3Dot(&e, &e,            &ee);
+    csrVec3Dot(&e, &pRay->m_Dir,  &ed);
+    csrVec3Dot(&e, &m,            &em);
+    csrVec3Dot(&pRay->m_Dir, &m,  &dm);
+    csrVec3Dot(&m, &m,            &mm);
+
+    a = ee - ed * ed;
+    b = ee * dm - ed * em;
+    c = ee * (mm - radius * radius) - em * em;
+
+    // the sphere moves parallel to the edge (in this case only its vertices may be hit), or
+    // already intersects the line?
+    if (a <= 0.0f || c <= 0.0f)
+        return 0;
+
+    discriminant = b * b - a * c;
+
+    if (discriminant < 0.0f)
+        return 0;
+
+    t = (-b - (float)sqrt(discriminant)) / a;
+
+    if (t < 0.0f || t > *pMaxDistance)
+        return 0;
+
+    // is the touched point outside the edge?
+    s = (em + t * ed) / ee;
+
+    if (s < 0.0f || s > 1.0f)
+        return 0;
+
+    *pMaxDistance = t;
+
+    pContact->m_X = pStart->m_X + e.m_X * s;
+    pContact->m_Y = pStart->m_Y + e.m_Y * s;
+    pContact->m_Z = pStart->m_Z + e.m_Z * s;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeSphereCastPolygon(const CSR_Ray3*           pRay,
+                                       float               radius,
+                                 const CSR_IndexedPolygon* pPolygon,
+                                       float*              pMaxDistance,
+                                       CSR_AABBTreeHit*    pHit)
+{
+    size_t       i;
+    CSR_Polygon3 polygon;
+    CSR_Vector3  e1;
+    CSR_Vector3  e2;
+    CSR_Vector3  n;
+    CSR_Vector3  m;
+    CSR_Vector3  center;
+    CSR_Vector3  contact;
+    float        length;
+    float        distance;
+    float        dirDotN;
+    float        t;
+    float        u;
+    float        v;
+    int          found = 0;
+
+    // get the polygon vertices
+    if (!csrIndexedPolygonToPolygon(pPolygon, &polygon))
+        return 0;
+
+    // calculate the polygon edges and normal
+    csrVec3Sub(&polygon.m_Vertex[1], &polygon.m_Vertex[0], &e1);
+    csrVec3Sub(&polygon.m_Vertex[2], &polygon.m_Vertex[0], &e2);
+    csrVec3Cross(&e1, &e2, &n);
+    csrVec3Length(&n, &length);
+    csrVec3Dot(&e1, &e1, &u);
+    csrVec3Dot(&e2, &e2, &v);
+
+    // degenerated polygon? (NOTE its normal would be meaningless, and its edges are shared with
+    // its neighbors anyway)
+    if (length * length <= M_CSR_AABB_Tree_Hit_Tolerance * u * v)
+        return 0;
+
+    n.m_X /= length;
+    n.m_Y /= length;
+    n.m_Z /= length;
+
+    // calculate the distance between the sphere center and the polygon plane. The polygons are
+    // double sided, so the normal is turned to the side the sphere is
+    csrVec3Sub(&pRay->m_Pos, &polygon.m_Vertex[0], &m);
+    csrVec3Dot(&n, &m, &distance);
+
+    if (distance < 0.0f)
     {
-        csrAABBTreeNodeContentRelease(pNode);
+        n.m_X    = -n.m_X;
+        n.m_Y    = -n.m_Y;
+        n.m_Z    = -n.m_Z;
+        distance = -distance;
+    }
+
+    csrVec3Dot(&pRay->m_Dir, &n, &dirDotN);
+
+    // does the sphere already intersect the polygon plane?
+    if (distance <= radius)
+    {
+        // get the polygon point nearest to the sphere center
+        contact.m_X = pRay->m_Pos.m_X - n.m_X * distance;
+        contact.m_Y = pRay->m_Pos.m_Y - n.m_Y * distance;
+        contact.m_Z = pRay->m_Pos.m_Z - n.m_Z * distance;
+
+        csrAABBTreeBarycentric(&contact, &polygon.m_Vertex[0], &e1, &e2, &u, &v);
+
+        if (u < 0.0f || v < 0.0f || u + v > 1.0f)
+            csrPolygon3ClosestPoint(&pRay->m_Pos, &polygon, &contact);
+
+        csrVec3Sub(&pRay->m_Pos, &contact, &m);
+        csrVec3Length(&m, &length);
+
+        // does the sphere already intersect the polygon?
+        if (length <= radius)
+        {
+            *pMaxDistance = 0.0f;
+
+            // the sphere is pushed away from the nearest point
+            if (length > 0.0f)
+                csrVec3DivVal(&m, length, &pHit->m_Normal);
+            else
+                pHit->m_Normal = n;
+
+            pHit->m_pPolygon = pPolygon;
+            pHit->m_Distance = 0.0f;
+            csrAABBTreeBarycentric(&contact, &polygon.m_Vertex[0], &e1, &e2, &pHit->m_U, &pHit->m_V);
+
+            return 1;
+        }
+    }
+    else
+    {
+        // the sphere moves away from the polygon plane, or parallel to it?
+        if (dirDotN >= 0.0f)
+            return 0;
+
+        // calculate the distance at which the sphere touches the polygon plane. The polygon
+        // cannot be touched before
+        t = (distance - radius) / -dirDotN;
+
+        if (t > *pMaxDistance)
+            return 0;
+
+        // calculate the point where the sphere touches the plane
+        contact.m_X = pRay->m_Pos.m_X + pRay->m_Dir.m_X * t - n.m_X * radius;
+        contact.m_Y = pRay->m_Pos.m_Y + pRay->m_Dir.m_Y * t - n.m_Y * radius;
+        contact.m_Z = pRay->m_Pos.m_Z + pRay->m_Dir.m_Z * t - n.m_Z * radius;
+
+        csrAABBTreeBarycentric(&contact, &polygon.m_Vertex[0], &e1, &e2, &u, &v);
+
+        // is the touched point inside the polygon?
+        if (u >= -M_CSR_AABB_Tree_Hit_Tolerance &&
+            v >= -M_CSR_AABB_Tree_Hit_Tolerance &&
+            u + v <= 1.0f + M_CSR_AABB_Tree_Hit_Tolerance)
+        {
+            *pMaxDistance = t;
+
+            pHit->m_pPolygon = pPolygon;
+            pHit->m_Distance = t;
+            pHit->m_U        = u;
+            pHit->m_V        = v;
+            pHit->m_Normal   = n;
+
+            return 1;
+        }
+    }
+
+    // the sphere can only touch the polygon edges or vertices
+    for (i = 0; i < 3; ++i)
+        found |= csrAABBTreeSphereCastEdge(pRay,
+                                           radius,
+                                          &polygon.m_Vertex[i],
+                                          &polygon.m_Vertex[(i + 1) % 3],
+                                           pMaxDistance,
+                                          &contact);
+
+    for (i = 0; i < 3; ++i)
+        if (csrAABBTreeSphereCastPoint(pRay, radius, &polygon.m_Vertex[i], pMaxDistance))
+        {
+            contact = polygon.m_Vertex[i];
+            found   = 1;
+        }
+
+    if (!found)
+        return 0;
+
+    // calculate the sphere center when it touches the polygon, the sliding plane normal points
+    // from the touched point to this center
+    center.m_X = pRay->m_Pos.m_X + pRay->m_Dir.m_X * *pMaxDistance;
+    center.m_Y = pRay->m_Pos.m_Y + pRay->m_Dir.m_Y * *pMaxDistance;
+    center.m_Z = pRay->m_Pos.m_Z + pRay->m_Dir.m_Z * *pMaxDistance;
+
+    csrVec3Sub(&center, &contact, &m);
+    csrVec3Normalize(&m, &pHit->m_Normal);
+
+    pHit->m_pPolygon = pPolygon;
+    pHit->m_Distance = *pMaxDistance;
+    csrAABBTreeBarycentric(&contact, &polygon.m_Vertex[0], &e1, &e2, &pHit->m_U, &pHit->m_V);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeSphereCastNode(const CSR_Ray3*        pRay,
+                                    float            radius,
+                              const CSR_AABBNode*    pNode,
+                                    float*           pMaxDistance,
+                                    CSR_AABBTreeHit* pHit)
+{
+    size_t              i;
+    float               leftNear;
+    float               rightNear;
+    float               secondNear;
+    int                 leftHit  = 0;
+    int                 rightHit = 0;
+    int                 result   = 0;
+    const CSR_AABBNode* pFirst;
+    const CSR_AABBNode* pSecond;
+
+    // is leaf?
+    if (!pNode->m_pLeft && !pNode->m_pRight)
+    {
+        // test all the polygons contained in the leaf, keep the first touched one
+        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+            result |= csrAABBTreeSphereCastPolygon(pRay,
+                                                   radius,
+                                                  &pNode->m_pPolygonBuffer->m_pIndexedPolygon[i],
+                                                   pMaxDistance,
+                                                   pHit);
+
+        return result;
+    }
+
+    // check which children the sphere reaches
+    if (pNode->m_pLeft)
+        leftHit = csrAABBTreeSphereCastBox(pRay, radius, pNode->m_pLeft->m_pBox, *pMaxDistance, &leftNear);
+
+    if (pNode->m_pRight)
+        rightHit = csrAABBTreeSphereCastBox(pRay, radius, pNode->m_pRight->m_pBox, *pMaxDistance, &rightNear);
+
+    // only one child may contain a hit?
+    if (!leftHit || !rightHit)
+    {
+        if (leftHit)
+            return csrAABBTreeSphereCastNode(pRay, radius, pNode->m_pLeft, pMaxDistance, pHit);
+
+        if (rightHit)
+            return csrAABBTreeSphereCastNode(pRay, radius, pNode->m_pRight, pMaxDistance, pHit);
+
+        return 0;
+    }
+
+    // visit the nearest child first
+    if (leftNear <= rightNear)
+    {
+        pFirst     = pNode->m_pLeft;
+        pSecond    = pNode->m_pRight;
+        secondNear = rightNear;
+    }
+    else
+    {
+        pFirst     = pNode->m_pRight;
+        pSecond    = pNode->m_pLeft;
+        secondNear = leftNear;
+    }
+
+    result = csrAABBTreeSphereCastNode(pRay, radius, pFirst, pMaxDistance, pHit);
+
+    // the farthest child may be skipped if a nearer hit was found in the nearest one
+    if (secondNear <= *pMaxDistance)
+        result |= csrAABBTreeSphereCastNode(pRay, radius, pSecond, pMaxDistance, pHit);
+
+    return result;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeRefitCheckMeshes(const CSR_Mesh* pFromMesh, const CSR_Mesh* pToMesh)
+{
+    size_t                 i;
+    size_t                 indexSize;
+    const CSR_IndexBuffer* pFromIndex;
+    const CSR_IndexBuffer* pToIndex;
+
+    // both meshes should contain the same vertex buffers
+    if (pFromMesh->m_Count != pToMesh->m_Count)
+        return 0;
+
+    // all the vertex buffers should share the same layout, thus the polygon indexes stay valid
+    for (i = 0; i < pFromMesh->m_Count; ++i)
+    {
+        if (pFromMesh->m_pVB[i].m_Count           != pToMesh->m_pVB[i].m_Count           ||
+            pFromMesh->m_pVB[i].m_Format.m_Stride != pToMesh->m_pVB[i].m_Format.m_Stride ||
+            pFromMesh->m_pVB[i].m_Format.m_Type   != pToMesh->m_pVB[i].m_Format.m_Type)
+            return 0;
+
+        pFromIndex = &pFromMesh->m_pVB[i].m_Index;
+        pToIndex   = &pToMesh->m_pVB[i].m_Index;
+
+        // both vertex buffers should be indexed, or not
+        if (!pFromIndex->m_pData != !pToIndex->m_pData)
+            return 0;
+
+        // not indexed?
+        if (!pFromIndex->m_pData)
+            continue;
+
+        // the indices should be identical, otherwise the same offsets may point to other vertices
+        if (pFromIndex->m_Count != pToIndex->m_Count || pFromIndex->m_Format != pToIndex->m_Format)
+            return 0;
+
+        indexSize = (pFromIndex->m_Format == CSR_IF_16Bit) ? sizeof(unsigned short) : sizeof(unsigned);
+
+        if (pFromIndex->m_pData != pToIndex->m_pData &&
+            memcmp(pFromIndex->m_pData, pToIndex->m_pData, pFromIndex->m_Count * indexSize))
+            return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeRefitPolygon(      CSR_IndexedPolygon* pPolygon,
+                            const CSR_Mesh*           pFromMesh,
+                            const CSR_Mesh*           pToMesh,
+                                  int                 merge,
+                                  CSR_Box*            pBox,
+                                  int*                pEmpty)
+{
+    size_t             i;
+    CSR_IndexedPolygon polygon;
+    CSR_Polygon3       vertices;
+
+    // search for the vertex buffer the polygon belongs to
+    for (i = 0; i < pFromMesh->m_Count; ++i)
+        if (pPolygon->m_pVB == &pFromMesh->m_pVB[i])
+            break;
+
+    // not found?
+    if (i == pFromMesh->m_Count)
+        return 0;
+
+    // get the same polygon in the target mesh
+    polygon       = *pPolygon;
+    polygon.m_pVB = &pToMesh->m_pVB[i];
+
+    if (!csrIndexedPolygonToPolygon(&polygon, &vertices))
+        return 0;
+
+    // extend the box to the polygon
+    csrBoxExtendToPolygon(&vertices, pBox, pEmpty);
+
+    // reference the target mesh, unless the boxes should surround both meshes
+    if (!merge)
+        *pPolygon = polygon;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeRefitNode(      CSR_AABBNode* pNode,
+                         const CSR_Mesh*     pFromMesh,
+                         const CSR_Mesh*     pToMesh,
+                               int           merge)
+{
+    size_t  i;
+    CSR_Box box;
+    int     empty;
+
+    // refit the children first
+    if (pNode->m_pLeft && !csrAABBTreeRefitNode(pNode->m_pLeft, pFromMesh, pToMesh, merge))
+        return 0;
+
+    if (pNode->m_pRight && !csrAABBTreeRefitNode(pNode->m_pRight, pFromMesh, pToMesh, merge))
+        return 0;
+
+    // when merging, the new box should also surround the previous one
+    if (merge)
+    {
+        box   = *pNode->m_pBox;
+        empty = 0;
+    }
+    else
+        empty = 1;
+
+    // is leaf?
+    if (!pNode->m_pLeft && !pNode->m_pRight)
+    {
+        // no polygon in this leaf, keep its box
+        if (!pNode->m_pPolygonBuffer || !pNode->m_pPolygonBuffer->m_Count)
+            return 1;
+
+        // surround the leaf polygons
+        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+            if (!csrAABBTreeRefitPolygon(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i],
+                                          pFromMesh,
+                                          pToMesh,
+                                          merge,
+                                         &box,
+                                         &empty))
+                return 0;
+    }
+    else
+    {
+        // surround the children
+        if (pNode->m_pLeft)
+            csrAABBTreeBoxMerge(pNode->m_pLeft->m_pBox, &box, &empty);
+
+        if (pNode->m_pRight)
+            csrAABBTreeBoxMerge(pNode->m_pRight->m_pBox, &box, &empty);
+    }
+
+    *pNode->m_pBox = box;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+unsigned csrAABBTreeHashData(unsigned hash, const void* pData, size_t length)
+{
+    size_t               i;
+    const unsigned char* pBytes = (const unsigned char*)pData;
+
+    // FNV-1a hash
+    for (i = 0; i < length; ++i)
+    {
+        hash ^= pBytes[i];
+        hash *= 16777619u;
+    }
+
+    return hash;
+}
+//---------------------------------------------------------------------------
+unsigned csrAABBTreeHashMesh(const CSR_Mesh* pMesh)
+{
+    size_t   i;
+    size_t   indexSize;
+    unsigned value;
+    unsigned hash = 2166136261u;
+
+    value = (unsigned)pMesh->m_Count;
+    hash  = csrAABBTreeHashData(hash, &value, sizeof(unsigned));
+
+    // iterate through the mesh vertex buffers
+    for (i = 0; i < pMesh->m_Count; ++i)
+    {
+        const CSR_VertexBuffer* pVB = &pMesh->m_pVB[i];
+
+        // hash the vertex buffer layout
+        value = (unsigned)pVB->m_Format.m_Type;
+        hash  = csrAABBTreeHashData(hash, &value, sizeof(unsigned));
+        value = pVB->m_Format.m_Stride;
+        hash  = csrAABBTreeHashData(hash, &value, sizeof(unsigned));
+        value = (unsigned)pVB->m_Count;
+        hash  = csrAABBTreeHashData(hash, &value, sizeof(unsigned));
+
+        // hash the vertex buffer content
+        if (pVB->m_pData)
+            hash = csrAABBTreeHashData(hash, pVB->m_pData, pVB->m_Count * sizeof(float));
+
+        value = (unsigned)pVB->m_Index.m_Count;
+        hash  = csrAABBTreeHashData(hash, &value, sizeof(unsigned));
+
+        // hash the vertex indices, if any
+        if (pVB->m_Index.m_pData)
+        {
+            indexSize = (pVB->m_Index.m_Format == CSR_IF_16Bit) ? sizeof(unsigned short) : sizeof(unsigned);
+            hash      = csrAABBTreeHashData(hash, pVB->m_Index.m_pData, pVB->m_Index.m_Count * indexSize);
+        }
+    }
+
+    return hash;
+}
+//---------------------------------------------------------------------------
+void csrAABBTreeCount(const CSR_AABBNode* pNode, size_t* pNodeCount, size_t* pPolygonCount)
+{
+    ++(*pNodeCount);
+
+    if (pNode->m_pPolygonBuffer)
+        *pPolygonCount += pNode->m_pPolygonBuffer->m_Count;
+
+    if (pNode->m_pLeft)
+        csrAABBTreeCount(pNode->m_pLeft, pNodeCount, pPolygonCount);
+
+    if (pNode->m_pRight)
+        csrAABBTreeCount(pNode->m_pRight, pNodeCount, pPolygonCount);
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeWriteNode(const CSR_AABBNode*            pNode,
+                         const CSR_Mesh*                pMesh,
+                               CSR_AABBTreeFileNode*    pNodes,
+                               CSR_AABBTreeFilePolygon* pPolygons,
+                               size_t*                  pNodeIndex,
+                               size_t*                  pPolygonIndex)
+{
+    size_t                    i;
+    size_t                    j;
+    const CSR_IndexedPolygon* pPolygon;
+    CSR_AABBTreeFileNode*     pFileNode;
+    CSR_AABBTreeFilePolygon*  pFilePolygon;
+
+    // every node should own a box
+    if (!pNode->m_pBox)
+        return 0;
+
+    // get the next node to write
+    pFileNode = &pNodes[*pNodeIndex];
+    ++(*pNodeIndex);
+
+    pFileNode->m_Box          = *pNode->m_pBox;
+    pFileNode->m_Children     = 0;
+    pFileNode->m_PolygonCount = 0;
+
+    if (pNode->m_pLeft)
+        pFileNode->m_Children |= M_CSR_AABB_Tree_File_Left;
+
+    if (pNode->m_pRight)
+        pFileNode->m_Children |= M_CSR_AABB_Tree_File_Right;
+
+    // write the node polygons
+    if (pNode->m_pPolygonBuffer)
+    {
+        pFileNode->m_PolygonCount = (unsigned)pNode->m_pPolygonBuffer->m_Count;
+
+        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+        {
+            pPolygon = &pNode->m_pPolygonBuffer->m_pIndexedPolygon[i];
+
+            // search for the vertex buffer the polygon belongs to
+            for (j = 0; j < pMesh->m_Count; ++j)
+                if (pPolygon->m_pVB == &pMesh->m_pVB[j])
+                    break;
+
+            // not found?
+            if (j == pMesh->m_Count)
+                return 0;
+
+            // get the next polygon to write
+            pFilePolygon = &pPolygons[*pPolygonIndex];
+            ++(*pPolygonIndex);
+
+            pFilePolygon->m_VB = (unsigned)j;
+
+            for (j = 0; j < 3; ++j)
+                pFilePolygon->m_Index[j] = (unsigned)pPolygon->m_pIndex[j];
+        }
+    }
+
+    // write the children, left first
+    if (pNode->m_pLeft && !csrAABBTreeWriteNode(pNode->m_pLeft, pMesh, pNodes, pPolygons, pNodeIndex, pPolygonIndex))
+        return 0;
+
+    if (pNode->m_pRight && !csrAABBTreeWriteNode(pNode->m_pRight, pMesh, pNodes, pPolygons, pNodeIndex, pPolygonIndex))
+        return 0;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeReadNode(const CSR_AABBTreeFileHeader*  pHeader,
+                        const CSR_AABBTreeFileNode*    pNodes,
+                        const CSR_AABBTreeFilePolygon* pPolygons,
+                        const CSR_Mesh*                pMesh,
+                              size_t*                  pNodeIndex,
+                              size_t*                  pPolygonIndex,
+                              CSR_AABBNode*            pNode)
+{
+    size_t                         i;
+    size_t                         j;
+    CSR_IndexedPolygon*            pPolygon;
+    const CSR_AABBTreeFileNode*    pFileNode;
+    const CSR_AABBTreeFilePolygon* pFilePolygon;
+
+    // initialize the node content, thus it may be released on error
+    pNode->m_pParent        = 0;
+    pNode->m_pLeft          = 0;
+    pNode->m_pRight         = 0;
+    pNode->m_pBox           = 0;
+    pNode->m_pPolygonBuffer = 0;
+
+    // no more node to read?
+    if (*pNodeIndex >= pHeader->m_NodeCount)
+        return 0;
+
+    // get the next node to read
+    pFileNode = &pNodes[*pNodeIndex];
+    ++(*pNodeIndex);
+
+    // not enough polygons remaining?
+    if (pFileNode->m_PolygonCount > pHeader->m_PolygonCount - *pPolygonIndex)
+        return 0;
+
+    pNode->m_pBox           = (CSR_Box*)malloc(sizeof(CSR_Box));
+    pNode->m_pPolygonBuffer = csrIndexedPolygonBufferCreate();
+
+    // succeeded?
+    if (!pNode->m_pBox || !pNode->m_pPolygonBuffer)
+        return 0;
+
+    *pNode->m_pBox = pFileNode->m_Box;
+
+    // read the node polygons
+    if (pFileNode->m_PolygonCount)
+    {
+        pNode->m_pPolygonBuffer->m_pIndexedPolygon =
+                (CSR_IndexedPolygon*)malloc(sizeof(CSR_IndexedPolygon) * pFileNode->m_PolygonCount);
+
+        // succeeded?
+        if (!pNode->m_pPolygonBuffer->m_pIndexedPolygon)
+            return 0;
+
+        pNode->m_pPolygonBuffer->m_Count = pFileNode->m_PolygonCount;
+
+        for (i = 0; i < pFileNode->m_PolygonCount; ++i)
+        {
+            // get the next polygon to read
+            pFilePolygon = &pPolygons[*pPolygonIndex];
+            ++(*pPolygonIndex);
+
+            // is vertex buffer out of bounds?
+            if (pFilePolygon->m_VB >= pMesh->m_Count)
+                return 0;
+
+            pPolygon        = &pNode->m_pPolygonBuffer->m_pIndexedPolygon[i];
+            pPolygon->m_pVB = &pMesh->m_pVB[pFilePolygon->m_VB];
+
+            for (j = 0; j < 3; ++j)
+            {
+                // is vertex out of bounds?
+                if ((size_t)pFilePolygon->m_Index[j] + 3 > pPolygon->m_pVB->m_Count)
+                    return 0;
+
+                pPolygon->m_pIndex[j] = pFilePolygon->m_Index[j];
+            }
+        }
+    }
+
+    // read the left child
+    if (pFileNode->m_Children & M_CSR_AABB_Tree_File_Left)
+    {
+        pNode->m_pLeft = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+
+        // succeeded?
+        if (!pNode->m_pLeft)
+            return 0;
+
+        if (!csrAABBTreeReadNode(pHeader, pNodes, pPolygons, pMesh, pNodeIndex, pPolygonIndex, pNode->m_pLeft))
+            return 0;
+
+        pNode->m_pLeft->m_pParent = pNode;
+    }
+
+    // read the right child
+    if (pFileNode->m_Children & M_CSR_AABB_Tree_File_Right)
+    {
+        pNode->m_pRight = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+
+        // succeeded?
+        if (!pNode->m_pRight)
+            return 0;
+
+        if (!csrAABBTreeReadNode(pHeader, pNodes, pPolygons, pMesh, pNodeIndex, pPolygonIndex, pNode->m_pRight))
+            return 0;
+
+        pNode->m_pRight->m_pParent = pNode;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+// Aligned-Axis Bounding Box tree functions
+//---------------------------------------------------------------------------
+int csrAABBTreeFromIndexedPolygonBuffer(const CSR_IndexedPolygonBuffer* pIPB,
+                                              CSR_AABBNode*             pNode)
+{
+    size_t                    i;
+    size_t                    j;
+    CSR_Box                   leftBox;
+    CSR_Box                   rightBox;
+    CSR_Polygon3              polygon;
+    CSR_IndexedPolygon*       pNewPolygons    = 0;
+    CSR_IndexedPolygonBuffer* pLeftPolygons   = 0;
+    CSR_IndexedPolygonBuffer* pRightPolygons  = 0;
+    int                       boxEmpty        = 1;
+    int                       insideLeft      = 0;
+    int                       insideRight     = 0;
+    int                       canResolveLeft  = 0;
+    int                       canResolveRight = 0;
+    int                       result          = 0;
+
+    // no indexed polygon buffer?
+    if (!pIPB)
+        return 0;
+
+    // no node?
+    if (!pNode)
+        return 0;
+
+    // initialize node content
+    pNode->m_pParent        = 0;
+    pNode->m_pLeft          = 0;
+    pNode->m_pRight         = 0;
+    pNode->m_pBox           = (CSR_Box*)malloc(sizeof(CSR_Box));
+    pNode->m_pPolygonBuffer = csrIndexedPolygonBufferCreate();
+
+    // succeeded?
+    if (!pNode->m_pBox || !pNode->m_pPolygonBuffer)
+    {
+        csrAABBTreeNodeContentRelease(pNode);
+        return 0;
+    }
+
+    // create the polygon buffers that will contain the divided polygons
+    pLeftPolygons  = csrIndexedPolygonBufferCreate();
+    pRightPolygons = csrIndexedPolygonBufferCreate();
+
+    // succeeded?
+    if (!pLeftPolygons || !pRightPolygons)
+    {
+        csrIndexedPolygonBufferRelease(pLeftPolygons);
+        csrIndexedPolygonBufferRelease(pRightPolygons);
+        csrAABBTreeNodeContentRelease(pNode);
+        return 0;
+    }
+
+    // iterate through polygons to divide
+    for (i = 0; i < pIPB->m_Count; ++i)
+    {
+        // using its index, extract the polygon from its vertex buffer
+        csrIndexedPolygonToPolygon(&pIPB->m_pIndexedPolygon[i], &polygon);
+
+        // extend the bounding box to include the polygon
+        csrBoxExtendToPolygon(&polygon, pNode->m_pBox, &boxEmpty);
+    }
+
+    // divide the bounding box in 2 sub-boxes
+    csrBoxCut(pNode->m_pBox, &leftBox, &rightBox);
+
+    // iterate again through polygons to divide
+    for (i = 0; i < pIPB->m_Count; ++i)
+    {
+        // get the concrete polygon (i.e. with physical coordinates, not indexes)
+        csrIndexedPolygonToPolygon(&pIPB->m_pIndexedPolygon[i], &polygon);
+
+        insideLeft  = 0;
+        insideRight = 0;
+
+        // check which box contains the most vertices
+        for (j = 0; j < 3; ++j)
+            // is vertex inside left or right sub-box?
+            if (csrInsideBox(&polygon.m_Vertex[j], &leftBox))
+                ++insideLeft;
+            else
+                ++insideRight;
+
+        // check at which sub-box the polygon belongs (and thus to which buffer it should be added)
+        if (insideLeft >= insideRight)
+        {
+            // allocate the memory to add a new polygon in the left polygon buffer
+            pNewPolygons = (CSR_IndexedPolygon*)csrMemoryAlloc(pLeftPolygons->m_pIndexedPolygon,
+                                                               sizeof(CSR_IndexedPolygon),
+                                                               pLeftPolygons->m_Count + 1);
+
+            // succeeded?
+            if (!pNewPolygons)
+            {
+                csrIndexedPolygonBufferRelease(pLeftPolygons);
+                csrIndexedPolygonBufferRelease(pRightPolygons);
+                csrAABBTreeNodeContentRelease(pNode);
+                return 0;
+            }
+
+            // update the buffer content
+            pLeftPolygons->m_pIndexedPolygon = pNewPolygons;
+            ++pLeftPolygons->m_Count;
+
+            // copy the polygon index content in the left buffer
+            pLeftPolygons->m_pIndexedPolygon[pLeftPolygons->m_Count - 1] = pIPB->m_pIndexedPolygon[i];
+        }
+        else
+        {
+            // allocate the memory to add a new polygon in the left polygon buffer
+            pNewPolygons = (CSR_IndexedPolygon*)csrMemoryAlloc(pRightPolygons->m_pIndexedPolygon,
+                                                               sizeof(CSR_IndexedPolygon),
+                                                               pRightPolygons->m_Count + 1);
+
+            // succeeded?
+            if (!pNewPolygons)
+            {
+                csrIndexedPolygonBufferRelease(pLeftPolygons);
+                csrIndexedPolygonBufferRelease(pRightPolygons);
+                csrAABBTreeNodeContentRelease(pNode);
+                return 0;
+            }
+
+            // update the buffer content
+            pRightPolygons->m_pIndexedPolygon = pNewPolygons;
+            ++pRightPolygons->m_Count;
+
+            // copy the polygon content inside its buffer
+            pRightPolygons->m_pIndexedPolygon[pRightPolygons->m_Count - 1] = pIPB->m_pIndexedPolygon[i];
+        }
+    }
+
+    canResolveLeft  = (pLeftPolygons->m_Count  && pLeftPolygons->m_Count  < pIPB->m_Count);
+    canResolveRight = (pRightPolygons->m_Count && pRightPolygons->m_Count < pIPB->m_Count);
+
+    // leaf reached?
+    if (!canResolveLeft && !canResolveRight)
+    {
+        // iterate through left polygons to copy to the leaf polygon buffer
+        for (i = 0; i < pLeftPolygons->m_Count; ++i)
+        {
+            // allocate the memory to add a new polygon in the leaf node
+            pNewPolygons = (CSR_IndexedPolygon*)csrMemoryAlloc(pNode->m_pPolygonBuffer->m_pIndexedPolygon,
+                                                               sizeof(CSR_IndexedPolygon),
+                                                               pNode->m_pPolygonBuffer->m_Count + 1);
+
+            // succeeded?
+            if (!pNewPolygons)
+            {
+                csrIndexedPolygonBufferRelease(pLeftPolygons);
+                csrIndexedPolygonBufferRelease(pRightPolygons);
+                csrAABBTreeNodeContentRelease(pNode);
+                return 0;
+            }
+
+            // update the buffer content
+            pNode->m_pPolygonBuffer->m_pIndexedPolygon = pNewPolygons;
+            ++pNode->m_pPolygonBuffer->m_Count;
+
+            // copy the polygon content inside the polygon buffer
+            pNode->m_pPolygonBuffer->m_pIndexedPolygon[pNode->m_pPolygonBuffer->m_Count - 1] =
+                    pLeftPolygons->m_pIndexedPolygon[i];
+        }
+
+        // iterate through right polygons to copy to the leaf polygon buffer
+        for (i = 0; i < pRightPolygons->m_Count; ++i)
+        {
+            // allocate the memory to add a new polygon in the leaf node
+            pNewPolygons = (CSR_IndexedPolygon*)csrMemoryAlloc(pNode->m_pPolygonBuffer->m_pIndexedPolygon,
+                                                               sizeof(CSR_IndexedPolygon),
+                                                               pNode->m_pPolygonBuffer->m_Count + 1);
+
+            // succeeded?
+            if (!pNewPolygons)
+            {
+                csrIndexedPolygonBufferRelease(pLeftPolygons);
+                csrIndexedPolygonBufferRelease(pRightPolygons);
+                csrAABBTreeNodeContentRelease(pNode);
+                return 0;
+            }
+
+            // update the buffer content
+            pNode->m_pPolygonBuffer->m_pIndexedPolygon = pNewPolygons;
+            ++pNode->m_pPolygonBuffer->m_Count;
+
+            // copy the polygon content inside the polygon buffer
+            pNode->m_pPolygonBuffer->m_pIndexedPolygon[pNode->m_pPolygonBuffer->m_Count - 1] =
+                    pRightPolygons->m_pIndexedPolygon[i];
+        }
+
+        // release the left and right polygon buffers, as they will no longer be used
+        csrIndexedPolygonBufferRelease(pLeftPolygons);
+        csrIndexedPolygonBufferRelease(pRightPolygons);
+
+        return 1;
+    }
+
+    // do create left node?
+    if (canResolveLeft)
+    {
+        // create the left node
+        pNode->m_pLeft = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+
+        // populate it
+        result |= csrAABBTreeFromIndexedPolygonBuffer(pLeftPolygons, pNode->m_pLeft);
+
+        // set node parent. IMPORTANT must be done after the node is populated (because this value
+        // will be reseted while the node is filled by csrAABBTreeFromIndexedPolygonBuffer())
+        pNode->m_pLeft->m_pParent = pNode;
+
+        // delete left polygon buffer, as it will no longer be used
+        csrIndexedPolygonBufferRelease(pLeftPolygons);
+    }
+
+    // do create right node?
+    if (canResolveRight)
+    {
+        // create the right node
+        pNode->m_pRight = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+
+        // populate it
+        result |= csrAABBTreeFromIndexedPolygonBuffer(pRightPolygons, pNode->m_pRight);
+
+        // set node parent. IMPORTANT must be done after the node is populated (because this value
+        // will be reseted while the node is filled by csrAABBTreeFromIndexedPolygonBuffer())
+        pNode->m_pRight->m_pParent = pNode;
+
+        // delete right polygon buffer, as it will no longer be used
+        csrIndexedPolygonBufferRelease(pRightPolygons);
+    }
+
+    return result;
+}
+//---------------------------------------------------------------------------
+CSR_AABBNode* csrAABBTreeFromMesh(const CSR_Mesh* pMesh)
+{
+    CSR_AABBNode* pRoot;
+    int           success;
+
+    // get indexed polygon buffer from mesh
+    CSR_IndexedPolygonBuffer* pIPB = csrIndexedPolygonBufferFromMesh(pMesh);
+
+    // succeeded?
+    if (!pIPB)
+        return 0;
+
+    // create the root node
+    pRoot = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+
+    // succeeded?
+    if (!pRoot)
+    {
+        csrIndexedPolygonBufferRelease(pIPB);
+        return 0;
+    }
+
+    // populate the AABB tree
+    success = csrAABBTreeFromIndexedPolygonBuffer(pIPB, pRoot);
+
+    // release the polygon buffer
+    csrIndexedPolygonBufferRelease(pIPB);
+
+    // tree was populated successfully?
+    if (!success)
+    {
+        csrAABBTreeNodeRelease(pRoot);
+        return 0;
+    }
+
+    return pRoot;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeResolve(const CSR_Ray3*           pRay,
+                       const CSR_AABBNode*       pNode,
+                             size_t              deep,
+                             CSR_Polygon3Buffer* pPolygons)
+{
+    #ifdef _MSC_VER
+        unsigned      i;
+        int           leftResolved   = 0;
+        int           rightResolved  = 0;
+        CSR_Polygon3* pPolygonBuffer = 0;
+        CSR_Figure3   ray            = {0};
+        CSR_Figure3   box            = {0};
+    #else
+        unsigned      i;
+        int           leftResolved  = 0;
+        int           rightResolved = 0;
+        CSR_Polygon3* pPolygonBuffer;
+        CSR_Figure3   ray;
+        CSR_Figure3   box;
+    #endif
+
+    // no ray?
+    if (!pRay)
+        return 0;
+
+    // no node to resolve?
+    if (!pNode)
+        return 0;
+
+    // no polygon buffer to contain the result?
+    if (!pPolygons)
+        return 0;
+
+    // is the first iteration?
+    if (!deep)
+    {
+        // ensure the polygon buffer is initialized, otherwise this may cause hard-to-debug bugs
+        pPolygons->m_pPolygon = 0;
+        pPolygons->m_Count    = 0;
+    }
+
+    // is leaf?
+    if (!pNode->m_pLeft && !pNode->m_pRight)
+    {
+        // iterate through polygons contained in leaf
+        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
+        {
+            // allocate memory for a new polygon in the buffer
+            pPolygonBuffer = (CSR_Polygon3*)csrMemoryAlloc(pPolygons->m_pPolygon,
+                                                           sizeof(CSR_Polygon3),
+                                                           pPolygons->m_Count + 1);
+
+            // succeeded?
+            if (!pPolygonBuffer)
+                return 0;
+
+            // update the polygon buffer
+            pPolygons->m_pPolygon = pPolygonBuffer;
+            ++pPolygons->m_Count;
+
+            // copy the polygon content
+            if (!csrIndexedPolygonToPolygon(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i],
+                                            &pPolygons->m_pPolygon[pPolygons->m_Count - 1]))
+                return 0;
+        }
+
+        return 1;
+    }
+
+    // convert ray to geometric figure
+    ray.m_Type    = CSR_F3_Ray;
+    ray.m_pFigure = pRay;
+
+    // node contains a left child?
+    if (pNode->m_pLeft)
+    {
+        // convert left box to geometric figure
+        box.m_Type    = CSR_F3_Box;
+        box.m_pFigure = pNode->m_pLeft->m_pBox;
+
+        // check if ray intersects the left box
+        if (csrIntersect3(&ray, &box, 0, 0, 0))
+            // resolve left node
+            leftResolved = csrAABBTreeResolve(pRay, pNode->m_pLeft, deep + 1, pPolygons);
+    }
+
+    // node contains a right child?
+    if (pNode->m_pRight)
+    {
+        // convert right box to geometric figure
+        box.m_Type    = CSR_F3_Box;
+        box.m_pFigure = pNode->m_pRight->m_pBox;
+
+        // check if ray intersects the right box
+        if (csrIntersect3(&ray, &box, 0, 0, 0))
+            // resolve right node
+            rightResolved = csrAABBTreeResolve(pRay, pNode->m_pRight, deep + 1, pPolygons);
+    }
+
+    return (leftResolved || rightResolved);
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeRayCast(const CSR_Ray3*        pRay,
+                       const CSR_AABBNode*    pNode,
+                             float            maxDistance,
+                             CSR_AABBTreeHit* pHit)
+{
+    float nearest;
+
+    // get infinite value
+    #ifdef _MSC_VER
+        const float inf = INFINITY;
+    #else
+        const float inf = 1.0f / 0.0f;
+    #endif
+
+    // validate the inputs
+    if (!pRay || !pNode || !pHit)
+        return 0;
+
+    // no distance limit?
+    if (maxDistance < 0.0f)
+        maxDistance = inf;
+
+    // check if the ray intersects the tree
+    if (!pNode->m_pBox || !csrAABBTreeRayCastBox(pRay, pNode->m_pBox, maxDistance, &nearest))
+        return 0;
+
+    return csrAABBTreeRayCastNode(pRay, pNode, &maxDistance, pHit);
+}
+//---------------------------------------------------------------------------
+size_t csrAABBTreeRayCastBatch(const CSR_Ray3*        pRays,
+                                     size_t           count,
+                               const CSR_AABBNode*    pNode,
+                                     float            maxDistance,
+                                     CSR_AABBTreeHit* pHits,
+                                     int*             pResults)
+{
+    size_t  i;
+    size_t  hitCount;
+    size_t  streamCount;
+    size_t* pIndices;
+    float*  pMaxDistances;
+    int*    pInside;
+
+    // get infinite value
+    #ifdef _MSC_VER
+        const float inf = INFINITY;
+    #else
+        const float inf = 1.0f / 0.0f;
+    #endif
+
+    // validate the inputs
+    if (!pRays || !pNode || !pHits || !pResults)
+        return 0;
+
+    // no distance limit?
+    if (maxDistance < 0.0f)
+        maxDistance = inf;
+
+    // nothing to cast?
+    if (!count)
+        return 0;
+
+    // create the ray stream
+    pIndices      = (size_t*)malloc(sizeof(size_t) * count);
+    pMaxDistances = (float*) malloc(sizeof(float)  * count);
+    pInside       = (int*)   malloc(sizeof(int)    * count);
+
+    // succeeded?
+    if (!pIndices || !pMaxDistances || !pInside)
+    {
+        free(pIndices);
+        free(pMaxDistances);
+        free(pInside);
+
+        for (i = 0; i < count; ++i)
+            pResults[i] = 0;
+
+        return 0;
+    }
+
+    // initialize the stream
+    for (i = 0; i < count; ++i)
+    {
+        pIndices[i]      = i;
+        pMaxDistances[i] = maxDistance;
+        pResults[i]      = 0;
+    }
+
+    // keep only the rays intersecting the tree
+    if (pNode->m_pBox)
+        streamCount = csrAABBTreeRayCastPartition(pRays, pNode->m_pBox, pMaxDistances, pIndices, count, pInside);
+    else
+        streamCount = 0;
+
+    // traverse the tree with the whole stream
+    if (streamCount)
+        csrAABBTreeRayCastStream(pRays, pNode, pIndices, streamCount, pMaxDistances, pInside, pHits, pResults);
+
+    free(pIndices);
+    free(pMaxDistances);
+    free(pInside);
+
+    // count the hits
+    hitCount = 0;
+
+    for (i = 0; i < count; ++i)
+        if (pResults[i])
+            ++hitCount;
+
+    return hitCount;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeSphereCast(const CSR_Ray3*        pRay,
+                                float            radius,
+                          const CSR_AABBNode*    pNode,
+                                float            maxDistance,
+                                CSR_AABBTreeHit* pHit)
+{
+    float nearest;
+
+    // get infinite value
+    #ifdef _MSC_VER
+        const float inf = INFINITY;
+    #else
+        const float inf = 1.0f / 0.0f;
+    #endif
+
+    // validate the inputs
+    if (!pRay || !pNode || !pHit || radius < 0.0f)
+        return 0;
+
+    // no distance limit?
+    if (maxDistance < 0.0f)
+        maxDistance = inf;
+
+    // check if the sphere reaches the tree
+    if (!pNode->m_pBox || !csrAABBTreeSphereCastBox(pRay, radius, pNode->m_pBox, maxDistance, &nearest))
+        return 0;
+
+    return csrAABBTreeSphereCastNode(pRay, radius, pNode, &maxDistance, pHit);
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeRefit(      CSR_AABBNode* pNode,
+                     const CSR_Mesh*     pFromMesh,
+                     const CSR_Mesh*     pToMesh,
+                           int           merge)
+{
+    // validate the inputs
+    if (!pNode || !pNode->m_pBox || !pFromMesh || !pToMesh)
+        return 0;
+
+    // nothing to do?
+    if (pFromMesh == pToMesh)
+        return 1;
+
+    // both meshes should share the same topology
+    if (!csrAABBTreeRefitCheckMeshes(pFromMesh, pToMesh))
+        return 0;
+
+    return csrAABBTreeRefitNode(pNode, pFromMesh, pToMesh, merge);
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeToBuffer(const CSR_AABBNode* pNode, const CSR_Mesh* pMesh, CSR_Buffer* pBuffer)
+{
+    size_t                   nodeCount    = 0;
+    size_t                   polygonCount = 0;
+    size_t                   nodeIndex    = 0;
+    size_t                   polygonIndex = 0;
+    CSR_AABBTreeFileHeader   header;
+    CSR_AABBTreeFileNode*    pNodes;
+    CSR_AABBTreeFilePolygon* pPolygons    = 0;
+    int                      success;
+
+    // validate the inputs
+    if (!pNode || !pMesh || !pBuffer)
+        return 0;
+
+    // measure the tree
+    csrAABBTreeCount(pNode, &nodeCount, &polygonCount);
+
+    // allocate memory for the file records
+    pNodes = (CSR_AABBTreeFileNode*)malloc(sizeof(CSR_AABBTreeFileNode) * nodeCount);
+
+    if (polygonCount)
+        pPolygons = (CSR_AABBTreeFilePolygon*)malloc(sizeof(CSR_AABBTreeFilePolygon) * polygonCount);
+
+    // succeeded?
+    if (!pNodes || (polygonCount && !pPolygons))
+    {
+        free(pNodes);
+        free(pPolygons);
+        return 0;
+    }
+
+    // flatten the tree
+    success = csrAABBTreeWriteNode(pNode, pMesh, pNodes, pPolygons, &nodeIndex, &polygonIndex);
+
+    if (success)
+    {
+        // populate the header
+        header.m_ID           = M_CSR_AABB_Tree_File_ID;
+        header.m_Version      = M_CSR_AABB_Tree_File_Version;
+        header.m_Hash         = csrAABBTreeHashMesh(pMesh);
+        header.m_NodeCount    = (unsigned)nodeCount;
+        header.m_PolygonCount = (unsigned)polygonCount;
+
+        // write the file content
+        success = csrBufferWrite(pBuffer, &header, sizeof(CSR_AABBTreeFileHeader), 1) &&
+                  csrBufferWrite(pBuffer, pNodes,  sizeof(CSR_AABBTreeFileNode),   nodeCount);
+
+        if (success && polygonCount)
+            success = csrBufferWrite(pBuffer, pPolygons, sizeof(CSR_AABBTreeFilePolygon), polygonCount);
+    }
+
+    free(pNodes);
+    free(pPolygons);
+
+    return success;
+}
+//---------------------------------------------------------------------------
+CSR_AABBNode* csrAABBTreeFromBuffer(const CSR_Buffer* pBuffer, const CSR_Mesh* pMesh)
+{
+    size_t                         offset       = 0;
+    size_t                         nodeIndex    = 0;
+    size_t                         polygonIndex = 0;
+    size_t                         length;
+    CSR_AABBTreeFileHeader         header;
+    const CSR_AABBTreeFileNode*    pNodes;
+    const CSR_AABBTreeFilePolygon* pPolygons;
+    CSR_AABBNode*                  pRoot;
+
+    // validate the inputs
+    if (!pBuffer || !pBuffer->m_pData || !pMesh)
+        return 0;
+
+    // is buffer too small to contain the header?
+    if (pBuffer->m_Length < sizeof(CSR_AABBTreeFileHeader))
+        return 0;
+
+    // read the header
+    if (!csrBufferRead(pBuffer, &offset, sizeof(CSR_AABBTreeFileHeader), 1, &header))
+        return 0;
+
+    // is file valid? (NOTE a file written on a machine using another endianness is rejected here)
+    if (header.m_ID != M_CSR_AABB_Tree_File_ID || header.m_Version != M_CSR_AABB_Tree_File_Version)
+        return 0;
+
+    // was the tree built from another mesh?
+    if (header.m_Hash != csrAABBTreeHashMesh(pMesh))
+        return 0;
+
+    length = pBuffer->m_Length - offset;
+
+    // the buffer should contain exactly the declared nodes and polygons
+    if (!header.m_NodeCount || length / sizeof(CSR_AABBTreeFileNode) < header.m_NodeCount)
+        return 0;
+
+    length -= header.m_NodeCount * sizeof(CSR_AABBTreeFileNode);
+
+    if (length % sizeof(CSR_AABBTreeFilePolygon) ||
+        length / sizeof(CSR_AABBTreeFilePolygon) != header.m_PolygonCount)
+        return 0;
+
+    // the records are read in place, the buffer isn't copied
+    pNodes    = (const CSR_AABBTreeFileNode*)((const unsigned char*)pBuffer->m_pData + offset);
+    pPolygons = (const CSR_AABBTreeFilePolygon*)(pNodes + header.m_NodeCount);
+
+    // create the root node
+    pRoot = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+
+    // succeeded?
+    if (!pRoot)
+        return 0;
+
+    // rebuild the tree, all the records should be used
+    if (!csrAABBTreeReadNode(&header, pNodes, pPolygons, pMesh, &nodeIndex, &polygonIndex, pRoot) ||
+        nodeIndex    != header.m_NodeCount                                                        ||
+        polygonIndex != header.m_PolygonCount)
+    {
+        csrAABBTreeNodeRelease(pRoot);
+        return 0;
+    }
+
+    return pRoot;
+}
+//---------------------------------------------------------------------------
+int csrAABBTreeSave(const char* pFileName, const CSR_AABBNode* pNode, const CSR_Mesh* pMesh)
+{
+    CSR_Buffer* pBuffer;
+    int         success;
+
+    // validate the inputs
+    if (!pFileName)
+        return 0;
+
+    // create a buffer to write to
+    pBuffer = csrBufferCreate();
+
+    // succeeded?
+    if (!pBuffer)
+        return 0;
+
+    // write the tree and save it
+    success = csrAABBTreeToBuffer(pNode, pMesh, pBuffer) && csrFileSave(pFileName, pBuffer);
+
+    csrBufferRelease(pBuffer);
+
+    return success;
+}
+//---------------------------------------------------------------------------
+CSR_AABBNode* csrAABBTreeLoad(const char* pFileName, const CSR_Mesh* pMesh)
+{
+    CSR_Buffer*   pBuffer;
+    CSR_AABBNode* pTree;
+
+    // open the tree file
+    pBuffer = csrFileOpen(pFileName);
+
+    // succeeded?
+    if (!pBuffer || !pBuffer->m_Length)
+    {
+        csrBufferRelease(pBuffer);
+        return 0;
+    }
+
+    // read the tree from the file content
+    pTree = csrAABBTreeFromBuffer(pBuffer, pMesh);
+
+    // release the file buffer (no longer required)
+    csrBufferRelease(pBuffer);
+
+    return pTree;
+}
+//---------------------------------------------------------------------------
+void csrAABBTreeNodeContentRelease(CSR_AABBNode* pNode)
+{
+    // release the bounding box
+    if (pNode->m_pBox)
+    {
+        free(pNode->m_pBox);
+        pNode->m_pBox = 0;
+    }
+
+    // release the polygon buffer
+    if (pNode->m_pPolygonBuffer)
+    {
+        // release the polygon buffer content
+        if (pNode->m_pPolygonBuffer->m_pIndexedPolygon)
+            free(pNode->m_pPolygonBuffer->m_pIndexedPolygon);
+
+        free(pNode->m_pPolygonBuffer);
+        pNode->m_pPolygonBuffer = 0;
+    }
+}
+//---------------------------------------------------------------------------
+void csrAABBTreeNodeRelease(CSR_AABBNode* pNode)
+{
+    if (!pNode)
+        return;
+
+    // release all children on left side
+    if (pNode->m_pLeft)
+        csrAABBTreeNodeRelease(pNode->m_pLeft);
+
+    // release all children on right side
+    if (pNode->m_pRight)
+        csrAABBTreeNodeRelease(pNode->m_pRight);
+
+    // delete node content
+    csrAABBTreeNodeContentRelease(pNode);
+
+    // delete node
+    free(pNode);
+}
+//---------------------------------------------------------------------------
+// Flat Aligned-Axis Bounding Box tree private functions
+//---------------------------------------------------------------------------
+float csrAABBFlatTreeGetAxis(const CSR_Vector3* pVector, size_t axis)
+{
+    switch (axis)
+    {
+        case 0:  return pVector->m_X;
+        case 1:  return pVector->m_Y;
+        default: return pVector->m_Z;
+    }
+}
+//---------------------------------------------------------------------------
+float csrAABBFlatTreeBoxArea(const CSR_Box* pBox)
+{
+    const float x = pBox->m_Max.m_X - pBox->m_Min.m_X;
+    const float y = pBox->m_Max.m_Y - pBox->m_Min.m_Y;
+    const float z = pBox->m_Max.m_Z - pBox->m_Min.m_Z;
+
+    // the half area is enough to compare the split costs
+    return (x * y) + (y * z) + (z * x);
+}
+//---------------------------------------------------------------------------
+size_t csrAABBFlatTreeGetBin(float center, float min, float scale)
+{
+    const float bin = (center - min) * scale;
+
+    if (bin <= 0.0f)
+        return 0;
+
+    if (bin >= (float)(M_CSR_AABB_Tree_Bin_Count - 1))
+        return M_CSR_AABB_Tree_Bin_Count - 1;
+
+    return (size_t)bin;
+}
+//---------------------------------------------------------------------------
+int csrAABBFlatTreeBuildNode(CSR_AABBFlatTree*           pTree,
+                             CSR_AABBFlatTreePolygonRef* pRefs,
+                             size_t                      first,
+                             size_t                      count,
+                             size_t                      depth)
+{
+    size_t                     i;
+    size_t                     j;
+    size_t                     axis;
+    size_t                     bestAxis;
+    size_t                     bestSplit;
+    size_t                     nodeIndex;
+    size_t                     leftCount;
+    size_t                     binCount[M_CSR_AABB_Tree_Bin_Count];
+    size_t                     rightCount[M_CSR_AABB_Tree_Bin_Count];
+    float                      rightArea[M_CSR_AABB_Tree_Bin_Count];
+    int                        binEmpty[M_CSR_AABB_Tree_Bin_Count];
+    CSR_Box                    binBox[M_CSR_AABB_Tree_Bin_Count];
+    CSR_Box                    box;
+    CSR_Box                    centerBox;
+    CSR_Box                    sideBox;
+    CSR_Box                    centerPointBox;
+    CSR_AABBFlatTreePolygonRef ref;
+    float                      min;
+    float                      extent;
+    float                      scale;
+    float                      area;
+    float                      cost;
+    float                      bestCost;
+    size_t                     sideCount;
+    int                        boxEmpty       = 1;
+    int                        centerBoxEmpty = 1;
+    int                        sideBoxEmpty;
+
+    // reserve the node. The nodes are allocated for the worst case before the build begins, so
+    // the node array is never reallocated here
+    nodeIndex = pTree->m_NodeCount;
+    ++pTree->m_NodeCount;
+
+    // update the tree depth
+    if (depth > pTree->m_Depth)
+        pTree->m_Depth = depth;
+
+    // calculate the node box and the box surrounding the polygon centers
+    for (i = first; i < first + count; ++i)
+    {
+        centerPointBox.m_Min = pRefs[i].m_Center;
+        centerPointBox.m_Max = pRefs[i].m_Center;
+
+        csrAABBTreeBoxMerge(&pRefs[i].m_Box, &box,       &boxEmpty);
+        csrAABBTreeBoxMerge(&centerPointBox, &centerBox, &centerBoxEmpty);
+    }
+
+    pTree->m_pNodes[nodeIndex].m_Box = box;
+
+    bestAxis  = 0;
+    bestSplit = 0;
+    bestCost  = 0.0f;
+    area      = csrAABBFlatTreeBoxArea(&box);
+
+    // search for the split with the lowest cost, only if the node may be split
+    if (count > 1 && area > 0.0f)
+        for (axis = 0; axis < 3; ++axis)
+        {
+            min    = csrAABBFlatTreeGetAxis(&centerBox.m_Min, axis);
+            extent = csrAABBFlatTreeGetAxis(&centerBox.m_Max, axis) - min;
+
+            // all the polygon centers are on the same plane on this axis, can't split on it
+            if (extent <= 0.0f)
+                continue;
+
+            scale = (float)M_CSR_AABB_Tree_Bin_Count / extent;
+
+            for (j = 0; j < M_CSR_AABB_Tree_Bin_Count; ++j)
+            {
+                binCount[j] = 0;
+                binEmpty[j] = 1;
+            }
+
+            // distribute the polygons in the bins
+            for (i = first; i < first + count; ++i)
+            {
+                j = csrAABBFlatTreeGetBin(csrAABBFlatTreeGetAxis(&pRefs[i].m_Center, axis), min, scale);
+
+                ++binCount[j];
+                csrAABBTreeBoxMerge(&pRefs[i].m_Box, &binBox[j], &binEmpty[j]);
+            }
+
+            sideCount    = 0;
+            sideBoxEmpty = 1;
+
+            // accumulate the bins from the right, the split j leaves the bins [j, count[ on right
+            for (j = M_CSR_AABB_Tree_Bin_Count - 1; j > 0; --j)
+            {
+                if (!binEmpty[j])
+                    csrAABBTreeBoxMerge(&binBox[j], &sideBox, &sideBoxEmpty);
+
+                sideCount    += binCount[j];
+                rightCount[j] = sideCount;
+                rightArea[j]  = sideBoxEmpty ? 0.0f : csrAABBFlatTreeBoxArea(&sideBox);
+            }
+
+            sideCount    = 0;
+            sideBoxEmpty = 1;
+
+            // sweep the bins from the left and evaluate each split cost
+            for (j = 1; j < M_CSR_AABB_Tree_Bin_Count; ++j)
+            {
+                if (!binEmpty[j - 1])
+                    csrAABBTreeBoxMerge(&binBox[j - 1], &sideBox, &sideBoxEmpty);
+
+                sideCount += binCount[j - 1];
+
+                // one side is empty, not a valid split
+                if (!sideCount || !rightCount[j])
+                    continue;
+
+                cost = ((float)sideCount * csrAABBFlatTreeBoxArea(&sideBox)) + ((float)rightCount[j] * rightArea[j]);
+
+                if (!bestSplit || cost < bestCost)
+                {
+                    bestAxis  = axis;
+                    bestSplit = j;
+                    bestCost  = cost;
+                }
+            }
+        }
+
+    // is leaf? This is the case if the node can't be split, or if testing all its polygons is
+    // cheaper than traversing its children (the traversal cost is considered equal to a polygon test)
+    if (count == 1 || (count <= M_CSR_AABB_Tree_Max_Leaf_Polygons && (!bestSplit || area + bestCost >= area * (float)count)))
+    {
+        pTree->m_pNodes[nodeIndex].m_Offset = (unsigned int)first;
+        pTree->m_pNodes[nodeIndex].m_Count  = (unsigned int)count;
+        return 1;
+    }
+
+    // found a valid split?
+    if (bestSplit)
+    {
+        min   = csrAABBFlatTreeGetAxis(&centerBox.m_Min, bestAxis);
+        scale = (float)M_CSR_AABB_Tree_Bin_Count / (csrAABBFlatTreeGetAxis(&centerBox.m_Max, bestAxis) - min);
+        i     = first;
+        j     = first + count;
+
+        // partition the polygons, those belonging to the bins before the split are moved on the left
+        while (i < j)
+            if (csrAABBFlatTreeGetBin(csrAABBFlatTreeGetAxis(&pRefs[i].m_Center, bestAxis), min, scale) < bestSplit)
+                ++i;
+            else
+            {
+                --j;
+                ref      = pRefs[i];
+                pRefs[i] = pRefs[j];
+                pRefs[j] = ref;
+            }
+
+        leftCount = i - first;
+    }
+    else
+        // the polygons can't be separated, just cut the list in 2 halves
+        leftCount = count / 2;
+
+    // should never happen, but a degenerated partition would cause an infinite recursion
+    if (!leftCount || leftCount == count)
+        leftCount = count / 2;
+
+    pTree->m_pNodes[nodeIndex].m_Count = 0;
+
+    // build the left child, which is always the next node
+    if (!csrAABBFlatTreeBuildNode(pTree, pRefs, first, leftCount, depth + 1))
+        return 0;
+
+    // the right child begins after the whole left sub-tree
+    pTree->m_pNodes[nodeIndex].m_Offset = (unsigned int)pTree->m_NodeCount;
+
+    return csrAABBFlatTreeBuildNode(pTree, pRefs, first + leftCount, count - leftCount, depth + 1);
+}
+//---------------------------------------------------------------------------
+// Flat Aligned-Axis Bounding Box tree functions
+//---------------------------------------------------------------------------
+CSR_AABBFlatTree* csrAABBFlatTreeCreate(void)
+{
+    // create a new flat AABB tree
+    CSR_AABBFlatTree* pTree = (CSR_AABBFlatTree*)malloc(sizeof(CSR_AABBFlatTree));
+
+    // succeeded?
+    if (!pTree)
+        return 0;
+
+    // initialize the flat AABB tree content
+    csrAABBFlatTreeInit(pTree);
+
+    return pTree;
+}
+//---------------------------------------------------------------------------
+void csrAABBFlatTreeRelease(CSR_AABBFlatTree* pTree, int contentOnly)
+{
+    // no tree to release?
+    if (!pTree)
+        return;
+
+    // free the nodes
+    if (pTree->m_pNodes)
+        free(pTree->m_pNodes);
+
+    // free the polygons
+    if (pTree->m_pPolygons)
+        free(pTree->m_pPolygons);
+
+    // release the tree itself, if required
+    if (contentOnly)
+        csrAABBFlatTreeInit(pTree);
+    else
+        free(pTree);
+}
+//---------------------------------------------------------------------------
+void csrAABBFlatTreeInit(CSR_AABBFlatTree* pTree)
+{
+    // no tree to initialize?
+    if (!pTree)
+        return;
+
+    // initialize the flat AABB tree content
+    pTree->m_pNodes        = 0;
+    pTree->m_NodeCount     = 0;
+    pTree->m_pPolygons     = 0;
+    pTree->m_PolygonCount  = 0;
+    pTree->m_Depth         = 0;
+}
+//---------------------------------------------------------------------------
+int csrAABBFlatTreeFromIndexedPolygonBuffer(const CSR_IndexedPolygonBuffer* pIPB,
+                                                  CSR_AABBFlatTree*         pTree)
+{
+    size_t                      i;
+    size_t                      j;
+    CSR_Polygon3                polygon;
+    CSR_AABBFlatNode*           pNodes;
+    CSR_AABBFlatTreePolygonRef* pRefs;
+    int                         boxEmpty;
+
+    // validate the inputs
+    if (!pIPB || !pTree)
+        return 0;
+
+    // clear the previous tree content, if any
+    csrAABBFlatTreeRelease(pTree, 1);
+
+    // nothing to build?
+    if (!pIPB->m_Count)
+        return 0;
+
+    // the node and polygon offsets are stored as unsigned int to keep the nodes compact
+    if (pIPB->m_Count > 0x7FFFFFFF)
+        return 0;
+
+    // allocate the tree content. A tree containing n leaves contains 2n - 1 nodes at most
+    pTree->m_pNodes    = (CSR_AABBFlatNode*)  malloc(sizeof(CSR_AABBFlatNode)   * ((pIPB->m_Count * 2) - 1));
+    pTree->m_pPolygons = (CSR_IndexedPolygon*)malloc(sizeof(CSR_IndexedPolygon) *   pIPB->m_Count);
+    pRefs              = (CSR_AABBFlatTreePolygonRef*)malloc(sizeof(CSR_AABBFlatTreePolygonRef) * pIPB->m_Count);
+
+    // succeeded?
+    if (!pTree->m_pNodes || !pTree->m_pPolygons || !pRefs)
+    {
+        free(pRefs);
+        csrAABBFlatTreeRelease(pTree, 1);
+        return 0;
+    }
+
+    // calculate each polygon box and center
+    for (i = 0; i < pIPB->m_Count; ++i)
+    {
+        // get the polygon
+        if (!csrIndexedPolygonToPolygon(&pIPB->m_pIndexedPolygon[i], &polygon))
+        {
+            free(pRefs);
+            csrAABBFlatTreeRelease(pTree, 1);
+            return 0;
+        }
+
+        boxEmpty = 1;
+        csrBoxExtendToPolygon(&polygon, &pRefs[i].m_Box, &boxEmpty);
+
+        // the box center is used as polygon center, it's the value the SAH bins should sort
+        pRefs[i].m_Center.m_X = (pRefs[i].m_Box.m_Min.m_X + pRefs[i].m_Box.m_Max.m_X) * 0.5f;
+        pRefs[i].m_Center.m_Y = (pRefs[i].m_Box.m_Min.m_Y + pRefs[i].m_Box.m_Max.m_Y) * 0.5f;
+        pRefs[i].m_Center.m_Z = (pRefs[i].m_Box.m_Min.m_Z + pRefs[i].m_Box.m_Max.m_Z) * 0.5f;
+        pRefs[i].m_Index      =  i;
+    }
+
+    // build the tree
+    if (!csrAABBFlatTreeBuildNode(pTree, pRefs, 0, pIPB->m_Count, 1))
+    {
+        free(pRefs);
+        csrAABBFlatTreeRelease(pTree, 1);
+        return 0;
+    }
+
+    // copy the polygons in the order the leaves reference them
+    for (j = 0; j < pIPB->m_Count; ++j)
+        pTree->m_pPolygons[j] = pIPB->m_pIndexedPolygon[pRefs[j].m_Index];
+
+    pTree->m_PolygonCount = pIPB->m_Count;
+
+    free(pRefs);
+
+    // shrink the node array to the node count really used
+    pNodes = (CSR_AABBFlatNode*)csrMemoryAlloc(pTree->m_pNodes, sizeof(CSR_AABBFlatNode), pTree->m_NodeCount);
+
+    if (pNodes)
+        pTree->m_pNodes = pNodes;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+CSR_AABBFlatTree* csrAABBFlatTreeFromMesh(const CSR_Mesh* pMesh)
+{
+    CSR_AABBFlatTree* pTree;
+    int               success;
+
+    // get indexed polygon buffer from mesh
+    CSR_IndexedPolygonBuffer* pIPB = csrIndexedPolygonBufferFromMesh(pMesh);
+
+    // succeeded?
+    if (!pIPB)
+        return 0;
+
+    // create the tree
+    pTree = csrAABBFlatTreeCreate();
+
+    // succeeded?
+    if (!pTree)
+    {
+        csrIndexedPolygonBufferRelease(pIPB);
+        return 0;
+    }
+
+    // populate the flat AABB tree
+    success = csrAABBFlatTreeFromIndexedPolygonBuffer(pIPB, pTree);
+
+    // release the polygon buffer
+    csrIndexedPolygonBufferRelease(pIPB);
+
+    // tree was populated successfully?
+    if (!success)
+    {
+        csrAABBFlatTreeRelease(pTree, 0);
+        return 0;
+    }
+
+    return pTree;
+}
+//---------------------------------------------------------------------------
+int csrAABBFlatTreeResolve(const CSR_Ray3*           pRay,
+                           const CSR_AABBFlatTree*   pTree,
+                                 CSR_Polygon3Buffer* pPolygons)
+{
+    size_t                  i;
+    size_t                  index;
+    size_t                  stackCount;
+    size_t                  localStack[M_CSR_AABB_Tree_Stack_Size];
+    size_t*                 pStack;
+    CSR_Polygon3*           pPolygonBuffer;
+    const CSR_AABBFlatNode* pNode;
+    int                     result;
+
+    // validate the inputs
+    if (!pRay || !pTree || !pPolygons)
+        return 0;
+
+    // ensure the polygon buffer is initialized, otherwise this may cause hard-to-debug bugs
+    pPolygons->m_pPolygon = 0;
+    pPolygons->m_Count    = 0;
+
+    // empty tree?
+    if (!pTree->m_NodeCount)
+        return 0;
+
+    // the stack never contains more pending nodes than the tree depth
+    if (pTree->m_Depth <= M_CSR_AABB_Tree_Stack_Size)
+        pStack = localStack;
+    else
+    {
+        pStack = (size_t*)malloc(sizeof(size_t) * pTree->m_Depth);
+
+        // succeeded?
+        if (!pStack)
+            return 0;
+    }
+
+    index      = 0;
+    stackCount = 0;
+    result     = 0;
+
+    for (;;)
+    {
+        pNode = &pTree->m_pNodes[index];
+
+        // check if ray intersects the node box
+        if (csrAABBTreeRayBox(pRay, &pNode->m_Box, 0, 0))
+        {
+            // is leaf?
+            if (pNode->m_Count)
+            {
+                // allocate memory for the leaf polygons in the buffer
+                pPolygonBuffer = (CSR_Polygon3*)csrMemoryAlloc(pPolygons->m_pPolygon,
+                                                               sizeof(CSR_Polygon3),
+                                                               pPolygons->m_Count + pNode->m_Count);
+
+                // succeeded?
+                if (!pPolygonBuffer)
+                {
+                    result = 0;
+                    break;
+                }
+
+                pPolygons->m_pPolygon = pPolygonBuffer;
+
+                // copy the polygons content
+                for (i = 0; i < pNode->m_Count; ++i)
+                    if (csrIndexedPolygonToPolygon(&pTree->m_pPolygons[pNode->m_Offset + i],
+                                                   &pPolygons->m_pPolygon[pPolygons->m_Count]))
+                        ++pPolygons->m_Count;
+
+                result = 1;
+            }
+            else
+            {
+                // visit the left child immediately, keep the right one for later
+                pStack[stackCount] = pNode->m_Offset;
+                ++stackCount;
+                ++index;
+                continue;
+            }
+        }
+
+        // no more pending node?
+        if (!stackCount)
+            break;
+
+        --stackCount;
+        index = pStack[stackCount];
+    }
+
+    if (pStack != localStack)
+        free(pStack);
+
+    return result;
+}
+//---------------------------------------------------------------------------
+int csrAABBFlatTreeRayCast(const CSR_Ray3*         pRay,
+                           const CSR_AABBFlatTree* pTree,
+                                 float             maxDistance,
+                                 CSR_AABBTreeHit*  pHit)
+{
+    size_t                     i;
+    size_t                     index;
+    size_t                     stackCount;
+    size_t                     first;
+    size_t                     second;
+    float                      leftNear;
+    float                      rightNear;
+    int                        leftHit;
+    int                        rightHit;
+    int                        result;
+    CSR_AABBFlatTreeStackItem  localStack[M_CSR_AABB_Tree_Stack_Size];
+    CSR_AABBFlatTreeStackItem* pStack;
+    const CSR_AABBFlatNode*    pNode;
+
+    // get infinite value
+    #ifdef _MSC_VER
+        const float inf = INFINITY;
+    #else
+        const float inf = 1.0f / 0.0f;
+    #endif
+
+    // validate the inputs
+    if (!pRay || !pTree || !pHit || !pTree->m_NodeCount)
         return 0;
-    }
 
-    // create the polygon buffers that will contain the divided polygons
-    pLeftPolygons  = csrIndexedPolygonBufferCreate();
-    pRightPolygons = csrIndexedPolygonBufferCreate();
+    // no distance limit?
+    if (maxDistance < 0.0f)
+        maxDistance = inf;
 
-    // succeeded?
-    if (!pLeftPolygons || !pRightPolygons)
-    {
-        csrIndexedPolygonBufferRelease(pLeftPolygons);
-        csrIndexedPolygonBufferRelease(pRightPolygons);
-        csrAABBTreeNodeContentRelease(pNode);
+    // check if the ray intersects the tree
+    if (!csrAABBTreeRayCastBox(pRay, &pTree->m_pNodes[0].m_Box, maxDistance, &leftNear))
         return 0;
-    }
 
-    // iterate through polygons to divide
-    for (i = 0; i < pIPB->m_Count; ++i)
+    // the stack never contains more pending nodes than the tree depth
+    if (pTree->m_Depth <= M_CSR_AABB_Tree_Stack_Size)
+        pStack = localStack;
+    else
     {
-        // using its index, extract the polygon from its vertex buffer
-        csrIndexedPolygonToPolygon(&pIPB->m_pIndexedPolygon[i], &polygon);
+        pStack = (CSR_AABBFlatTreeStackItem*)malloc(sizeof(CSR_AABBFlatTreeStackItem) * pTree->m_Depth);
 
-        // extend the bounding box to include the polygon
-        csrBoxExtendToPolygon(&polygon, pNode->m_pBox, &boxEmpty);
+        // succeeded?
+        if (!pStack)
+            return 0;
     }
 
-    // divide the bounding box in 2 sub-boxes
-    csrBoxCut(pNode->m_pBox, &leftBox, &rightBox);
+    index      = 0;
+    stackCount = 0;
+    result     = 0;
 
-    // iterate again through polygons to divide
-    for (i = 0; i < pIPB->m_Count; ++i)
+    for (;;)
     {
-        // get the concrete polygon (i.e. with physical coordinates, not indexes)
-        csrIndexedPolygonToPolygon(&pIPB->m_pIndexedPolygon[i], &polygon);
+        pNode = &pTree->m_pNodes[index];
 
-        insideLeft  = 0;
-        insideRight = 0;
+        // is leaf?
+        if (pNode->m_Count)
+        {
+            // test all the polygons contained in the leaf, keep the nearest one
+            for (i = 0; i < pNode->m_Count; ++i)
+                result |= csrAABBTreeRayCastPolygon(pRay,
+                                                   &pTree->m_pPolygons[pNode->m_Offset + i],
+                                                   &maxDistance,
+                                                    pHit);
+        }
+        else
+        {
+            // check which children the ray intersects
+            leftHit  = csrAABBTreeRayCastBox(pRay, &pTree->m_pNodes[index + 1].m_Box,         maxDistance, &leftNear);
+            rightHit = csrAABBTreeRayCastBox(pRay, &pTree->m_pNodes[pNode->m_Offset].m_Box, maxDistance, &rightNear);
 
-        // check which box contains the most vertices
-        for (j = 0; j < 3; ++j)
-            // is vertex inside left or right sub-box?
-            if (csrInsideBox(&polygon.m_Vertex[j], &leftBox))
-                ++insideLeft;
-            else
-                ++insideRight;
+            if (leftHit && rightHit)
+            {
+                // visit the nearest child first, keep the farthest one for later
+                if (leftNear <= rightNear)
+                {
+                    first                     = index + 1;
+                    second                    = pNode->m_Offset;
+                    pStack[stackCount].m_Near = rightNear;
+                }
+                else
+                {
+                    first                     = pNode->m_Offset;
+                    second                    = index + 1;
+                    pStack[stackCount].m_Near = leftNear;
+                }
+
+                pStack[stackCount].m_Index = second;
+                ++stackCount;
+                index = first;
+                continue;
+            }
 
-        // check at which sub-box the polygon belongs (and thus to which buffer it should be added)
-        if (insideLeft >= insideRight)
-        {
-            // allocate the memory to add a new polygon in the left polygon buffer
-            pNewPolygons = (CSR_IndexedPolygon*)csrMemoryAlloc(pLeftPolygons->m_pIndexedPolygon,
-                                                               sizeof(CSR_IndexedPolygon),
-                                                               pLeftPolygons->m_Count + 1);
+            if (leftHit)
+            {
+                index = index + 1;
+                continue;
+            }
 
-            // succeeded?
-            if (!pNewPolygons)
+            if (rightHit)
             {
-                csrIndexedPolygonBufferRelease(pLeftPolygons);
-                csrIndexedPolygonBufferRelease(pRightPolygons);
-                csrAABBTreeNodeContentRelease(pNode);
-                return 0;
+                index = pNode->m_Offset;
+                continue;
             }
+        }
 
-            // update the buffer content
-            pLeftPolygons->m_pIndexedPolygon = pNewPolygons;
-            ++pLeftPolygons->m_Count;
+        // get the next pending node, skip those farther than the nearest hit found until now
+        while (stackCount && pStack[stackCount - 1].m_Near > maxDistance)
+            --stackCount;
 
-            // copy the polygon index content in the left buffer
-            pLeftPolygons->m_pIndexedPolygon[pLeftPolygons->m_Count - 1] = pIPB->m_pIndexedPolygon[i];
+        // no more pending node?
+        if (!stackCount)
+            break;
+
+        --stackCount;
+        index = pStack[stackCount].m_Index;
+    }
+
+    if (pStack != localStack)
+        free(pStack);
+
+    return result;
+}
+//---------------------------------------------------------------------------
+int csrAABBFlatTreeRefit(      CSR_AABBFlatTree* pTree,
+                         const CSR_Mesh*         pFromMesh,
+                         const CSR_Mesh*         pToMesh,
+                               int               merge)
+{
+    size_t            i;
+    size_t            j;
+    CSR_Box           box;
+    int               empty;
+    CSR_AABBFlatNode* pNode;
+
+    // validate the inputs
+    if (!pTree || !pFromMesh || !pToMesh)
+        return 0;
+
+    // nothing to do?
+    if (pFromMesh == pToMesh)
+        return 1;
+
+    // both meshes should share the same topology
+    if (!csrAABBTreeRefitCheckMeshes(pFromMesh, pToMesh))
+        return 0;
+
+    // the children are always stored after their parent, so iterating the nodes backward refits
+    // the tree bottom-up
+    for (i = pTree->m_NodeCount; i > 0; --i)
+    {
+        pNode = &pTree->m_pNodes[i - 1];
+
+        // when merging, the new box should also surround the previous one
+        if (merge)
+        {
+            box   = pNode->m_Box;
+            empty = 0;
         }
         else
+            empty = 1;
+
+        // is leaf?
+        if (pNode->m_Count)
         {
-            // allocate the memory to add a new polygon in the left polygon buffer
-            pNewPolygons = (CSR_IndexedPolygon*)csrMemoryAlloc(pRightPolygons->m_pIndexedPolygon,
-                                                               sizeof(CSR_IndexedPolygon),
-                                                               pRightPolygons->m_Count + 1);
+            // surround the leaf polygons
+            for (j = 0; j < pNode->m_Count; ++j)
+                if (!csrAABBTreeRefitPolygon(&pTree->m_pPolygons[pNode->m_Offset + j],
+                                              pFromMesh,
+                                              pToMesh,
+                                              merge,
+                                             &box,
+                                             &empty))
+                    return 0;
+        }
+        else
+        {
+            // surround the children
+            csrAABBTreeBoxMerge(&pTree->m_pNodes[i].m_Box,               &box, &empty);
+            csrAABBTreeBoxMerge(&pTree->m_pNodes[pNode->m_Offset].m_Box, &box, &empty);
+        }
 
-            // succeeded?
-            if (!pNewPolygons)
-            {
-                csrIndexedPolygonBufferRelease(pLeftPolygons);
-                csrIndexedPolygonBufferRelease(pRightPolygons);
-                csrAABBTreeNodeContentRelease(pNode);
-                return 0;
-            }
+        pNode->m_Box = box;
+    }
 
-            // update the buffer content
-            pRightPolygons->m_pIndexedPolygon = pNewPolygons;
-            ++pRightPolygons->m_Count;
+    return 1;
+}
+//---------------------------------------------------------------------------
+// Dynamic Aligned-Axis Bounding Box tree private functions
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeBoxUnion(const CSR_Box* pA, const CSR_Box* pB, CSR_Box* pR)
+{
+    pR->m_Min.m_X = (pA->m_Min.m_X < pB->m_Min.m_X) ? pA->m_Min.m_X : pB->m_Min.m_X;
+    pR->m_Min.m_Y = (pA->m_Min.m_Y < pB->m_Min.m_Y) ? pA->m_Min.m_Y : pB->m_Min.m_Y;
+    pR->m_Min.m_Z = (pA->m_Min.m_Z < pB->m_Min.m_Z) ? pA->m_Min.m_Z : pB->m_Min.m_Z;
+    pR->m_Max.m_X = (pA->m_Max.m_X > pB->m_Max.m_X) ? pA->m_Max.m_X : pB->m_Max.m_X;
+    pR->m_Max.m_Y = (pA->m_Max.m_Y > pB->m_Max.m_Y) ? pA->m_Max.m_Y : pB->m_Max.m_Y;
+    pR->m_Max.m_Z = (pA->m_Max.m_Z > pB->m_Max.m_Z) ? pA->m_Max.m_Z : pB->m_Max.m_Z;
+}
+//---------------------------------------------------------------------------
+int csrAABBDynamicTreeBoxContains(const CSR_Box* pBox, const CSR_Box* pInnerBox)
+{
+    return (pInnerBox->m_Min.m_X >= pBox->m_Min.m_X && pInnerBox->m_Max.m_X <= pBox->m_Max.m_X &&
+            pInnerBox->m_Min.m_Y >= pBox->m_Min.m_Y && pInnerBox->m_Max.m_Y <= pBox->m_Max.m_Y &&
+            pInnerBox->m_Min.m_Z >= pBox->m_Min.m_Z && pInnerBox->m_Max.m_Z <= pBox->m_Max.m_Z);
+}
+//---------------------------------------------------------------------------
+int csrAABBDynamicTreeBoxOverlap(const CSR_Box* pA, const CSR_Box* pB)
+{
+    return (pA->m_Min.m_X <= pB->m_Max.m_X && pA->m_Max.m_X >= pB->m_Min.m_X &&
+            pA->m_Min.m_Y <= pB->m_Max.m_Y && pA->m_Max.m_Y >= pB->m_Min.m_Y &&
+            pA->m_Min.m_Z <= pB->m_Max.m_Z && pA->m_Max.m_Z >= pB->m_Min.m_Z);
+}
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeFatten(const CSR_Box* pBox, float margin, CSR_Box* pR)
+{
+    const float x = (pBox->m_Max.m_X - pBox->m_Min.m_X) * margin;
+    const float y = (pBox->m_Max.m_Y - pBox->m_Min.m_Y) * margin;
+    const float z = (pBox->m_Max.m_Z - pBox->m_Min.m_Z) * margin;
+
+    pR->m_Min.m_X = pBox->m_Min.m_X - x;
+    pR->m_Min.m_Y = pBox->m_Min.m_Y - y;
+    pR->m_Min.m_Z = pBox->m_Min.m_Z - z;
+    pR->m_Max.m_X = pBox->m_Max.m_X + x;
+    pR->m_Max.m_Y = pBox->m_Max.m_Y + y;
+    pR->m_Max.m_Z = pBox->m_Max.m_Z + z;
+}
+//---------------------------------------------------------------------------
+size_t csrAABBDynamicTreeAllocateNode(CSR_AABBDynamicTree* pTree)
+{
+    size_t               i;
+    size_t               index;
+    size_t               count;
+    CSR_AABBDynamicNode* pNodes;
 
-            // copy the polygon content inside its buffer
-            pRightPolygons->m_pIndexedPolygon[pRightPolygons->m_Count - 1] = pIPB->m_pIndexedPolygon[i];
+    // no more free node?
+    if (pTree->m_FreeList == (size_t)M_CSR_Unknown_Index)
+    {
+        // double the node count, thus the nodes are rarely reallocated
+        count = pTree->m_Count ? pTree->m_Count * 2 : 16;
+
+        pNodes = (CSR_AABBDynamicNode*)csrMemoryAlloc(pTree->m_pNodes, sizeof(CSR_AABBDynamicNode), count);
+
+        // succeeded?
+        if (!pNodes)
+            return (size_t)M_CSR_Unknown_Index;
+
+        // link the new nodes in the free list
+        for (i = pTree->m_Count; i < count; ++i)
+        {
+            pNodes[i].m_Parent = (i + 1 < count) ? i + 1 : (size_t)M_CSR_Unknown_Index;
+            pNodes[i].m_Height = -1;
         }
+
+        pTree->m_FreeList = pTree->m_Count;
+        pTree->m_pNodes   = pNodes;
+        pTree->m_Count    = count;
     }
 
-    canResolveLeft  = (pLeftPolygons->m_Count  && pLeftPolygons->m_Count  < pIPB->m_Count);
-    canResolveRight = (pRightPolygons->m_Count && pRightPolygons->m_Count < pIPB->m_Count);
+    // get the next free node
+    index             = pTree->m_FreeList;
+    pTree->m_FreeList = pTree->m_pNodes[index].m_Parent;
 
-    // leaf reached?
-    if (!canResolveLeft && !canResolveRight)
+    // initialize it
+    pTree->m_pNodes[index].m_Parent = (size_t)M_CSR_Unknown_Index;
+    pTree->m_pNodes[index].m_Left   = (size_t)M_CSR_Unknown_Index;
+    pTree->m_pNodes[index].m_Right  = (size_t)M_CSR_Unknown_Index;
+    pTree->m_pNodes[index].m_Item   = 0;
+    pTree->m_pNodes[index].m_Index  = 0;
+    pTree->m_pNodes[index].m_Height = 0;
+
+    return index;
+}
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeFreeNode(size_t index, CSR_AABBDynamicTree* pTree)
+{
+    pTree->m_pNodes[index].m_Parent = pTree->m_FreeList;
+    pTree->m_pNodes[index].m_Height = -1;
+    pTree->m_FreeList               = index;
+}
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeReplaceChild(size_t               parent,
+                                    size_t               oldChild,
+                                    size_t               newChild,
+                                    CSR_AABBDynamicTree* pTree)
+{
+    // is old child the root?
+    if (parent == (size_t)M_CSR_Unknown_Index)
     {
-        // iterate through left polygons to copy to the leaf polygon buffer
-        for (i = 0; i < pLeftPolygons->m_Count; ++i)
-        {
-            // allocate the memory to add a new polygon in the leaf node
-            pNewPolygons = (CSR_IndexedPolygon*)csrMemoryAlloc(pNode->m_pPolygonBuffer->m_pIndexedPolygon,
-                                                               sizeof(CSR_IndexedPolygon),
-                                                               pNode->m_pPolygonBuffer->m_Count + 1);
+        pTree->m_Root = newChild;
+        return;
+    }
 
-            // succeeded?
-            if (!pNewPolygons)
-            {
-                csrIndexedPolygonBufferRelease(pLeftPolygons);
-                csrIndexedPolygonBufferRelease(pRightPolygons);
-                csrAABBTreeNodeContentRelease(pNode);
-                return 0;
-            }
+    if (pTree->m_pNodes[parent].m_Left == oldChild)
+        pTree->m_pNodes[parent].m_Left = newChild;
+    else
+        pTree->m_pNodes[parent].m_Right = newChild;
+}
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeUpdateNode(size_t index, CSR_AABBDynamicTree* pTree)
+{
+    CSR_AABBDynamicNode* pNode  = &pTree->m_pNodes[index];
+    CSR_AABBDynamicNode* pLeft  = &pTree->m_pNodes[pNode->m_Left];
+    CSR_AABBDynamicNode* pRight = &pTree->m_pNodes[pNode->m_Right];
 
-            // update the buffer content
-            pNode->m_pPolygonBuffer->m_pIndexedPolygon = pNewPolygons;
-            ++pNode->m_pPolygonBuffer->m_Count;
+    csrAABBDynamicTreeBoxUnion(&pLeft->m_Box, &pRight->m_Box, &pNode->m_Box);
+    pNode->m_Height = 1 + ((pLeft->m_Height > pRight->m_Height) ? pLeft->m_Height : pRight->m_Height);
+}
+//---------------------------------------------------------------------------
+size_t csrAABBDynamicTreeRotate(size_t index, size_t up, CSR_AABBDynamicTree* pTree)
+{
+    size_t               upLeft;
+    size_t               upRight;
+    size_t               kept;
+    size_t               moved;
+    CSR_AABBDynamicNode* pNodes = pTree->m_pNodes;
+
+    // get the grandchildren
+    upLeft  = pNodes[up].m_Left;
+    upRight = pNodes[up].m_Right;
+
+    // the highest grandchild stays below the child moving up, the other one replaces it below the node
+    if (pNodes[upLeft].m_Height > pNodes[upRight].m_Height)
+    {
+        kept  = upLeft;
+        moved = upRight;
+    }
+    else
+    {
+        kept  = upRight;
+        moved = upLeft;
+    }
 
-            // copy the polygon content inside the polygon buffer
-            pNode->m_pPolygonBuffer->m_pIndexedPolygon[pNode->m_pPolygonBuffer->m_Count - 1] =
-                    pLeftPolygons->m_pIndexedPolygon[i];
-        }
+    // move the child up, in place of the node
+    pNodes[up].m_Parent = pNodes[index].m_Parent;
+    csrAABBDynamicTreeReplaceChild(pNodes[up].m_Parent, index, up, pTree);
 
-        // iterate through right polygons to copy to the leaf polygon buffer
-        for (i = 0; i < pRightPolygons->m_Count; ++i)
-        {
-            // allocate the memory to add a new polygon in the leaf node
-            pNewPolygons = (CSR_IndexedPolygon*)csrMemoryAlloc(pNode->m_pPolygonBuffer->m_pIndexedPolygon,
-                                                               sizeof(CSR_IndexedPolygon),
-                                                               pNode->m_pPolygonBuffer->m_Count + 1);
+    // the node becomes a child of the moved up child
+    pNodes[up].m_Left      = index;
+    pNodes[up].m_Right     = kept;
+    pNodes[index].m_Parent = up;
 
-            // succeeded?
-            if (!pNewPolygons)
-            {
-                csrIndexedPolygonBufferRelease(pLeftPolygons);
-                csrIndexedPolygonBufferRelease(pRightPolygons);
-                csrAABBTreeNodeContentRelease(pNode);
-                return 0;
-            }
+    // the other grandchild replaces the moved up child below the node
+    if (pNodes[index].m_Left == up)
+        pNodes[index].m_Left = moved;
+    else
+        pNodes[index].m_Right = moved;
 
-            // update the buffer content
-            pNode->m_pPolygonBuffer->m_pIndexedPolygon = pNewPolygons;
-            ++pNode->m_pPolygonBuffer->m_Count;
+    pNodes[moved].m_Parent = index;
 
-            // copy the polygon content inside the polygon buffer
-            pNode->m_pPolygonBuffer->m_pIndexedPolygon[pNode->m_pPolygonBuffer->m_Count - 1] =
-                    pRightPolygons->m_pIndexedPolygon[i];
-        }
+    // update the boxes and heights, from the bottom
+    csrAABBDynamicTreeUpdateNode(index, pTree);
+    csrAABBDynamicTreeUpdateNode(up,    pTree);
 
-        // release the left and right polygon buffers, as they will no longer be used
-        csrIndexedPolygonBufferRelease(pLeftPolygons);
-        csrIndexedPolygonBufferRelease(pRightPolygons);
+    return up;
+}
+//---------------------------------------------------------------------------
+size_t csrAABBDynamicTreeBalance(size_t index, CSR_AABBDynamicTree* pTree)
+{
+    int                  balance;
+    CSR_AABBDynamicNode* pNode = &pTree->m_pNodes[index];
+
+    // leaves and small subtrees are always balanced
+    if (pNode->m_Height < 2)
+        return index;
+
+    balance = pTree->m_pNodes[pNode->m_Right].m_Height - pTree->m_pNodes[pNode->m_Left].m_Height;
 
+    // rotate the highest child up if the subtree is unbalanced
+    if (balance > 1)
+        return csrAABBDynamicTreeRotate(index, pNode->m_Right, pTree);
+
+    if (balance < -1)
+        return csrAABBDynamicTreeRotate(index, pNode->m_Left, pTree);
+
+    return index;
+}
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeRefitFrom(size_t index, CSR_AABBDynamicTree* pTree)
+{
+    // walk up to the root, balancing and refitting the nodes
+    while (index != (size_t)M_CSR_Unknown_Index)
+    {
+        index = csrAABBDynamicTreeBalance(index, pTree);
+        csrAABBDynamicTreeUpdateNode(index, pTree);
+        index = pTree->m_pNodes[index].m_Parent;
+    }
+}
+//---------------------------------------------------------------------------
+int csrAABBDynamicTreeInsertLeaf(size_t leaf, CSR_AABBDynamicTree* pTree)
+{
+    size_t  index;
+    size_t  parent;
+    size_t  left;
+    size_t  right;
+    size_t  i;
+    float   area;
+    float   cost;
+    float   inheritedCost;
+    float   childCost[2];
+    CSR_Box leafBox;
+    CSR_Box box;
+
+    // is tree empty?
+    if (pTree->m_Root == (size_t)M_CSR_Unknown_Index)
+    {
+        pTree->m_Root                  = leaf;
+        pTree->m_pNodes[leaf].m_Parent = (size_t)M_CSR_Unknown_Index;
         return 1;
     }
 
-    // do create left node?
-    if (canResolveLeft)
+    leafBox = pTree->m_pNodes[leaf].m_Box;
+    index   = pTree->m_Root;
+
+    // search for the best sibling, by descending to the child whose area grows the least
+    while (pTree->m_pNodes[index].m_Height > 0)
     {
-        // create the left node
-        pNode->m_pLeft = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+        left  = pTree->m_pNodes[index].m_Left;
+        right = pTree->m_pNodes[index].m_Right;
 
-        // populate it
-        result |= csrAABBTreeFromIndexedPolygonBuffer(pLeftPolygons, pNode->m_pLeft);
+        area = csrAABBFlatTreeBoxArea(&pTree->m_pNodes[index].m_Box);
+        csrAABBDynamicTreeBoxUnion(&pTree->m_pNodes[index].m_Box, &leafBox, &box);
 
-        // set node parent. IMPORTANT must be done after the node is populated (because this value
-        // will be reseted while the node is filled by csrAABBTreeFromIndexedPolygonBuffer())
-        pNode->m_pLeft->m_pParent = pNode;
+        // cost of creating a new parent for this node and the leaf
+        cost = 2.0f * csrAABBFlatTreeBoxArea(&box);
 
-        // delete left polygon buffer, as it will no longer be used
-        csrIndexedPolygonBufferRelease(pLeftPolygons);
+        // minimum cost added to the parents if the leaf is pushed further down
+        inheritedCost = 2.0f * (csrAABBFlatTreeBoxArea(&box) - area);
+
+        // cost of descending to each child
+        for (i = 0; i < 2; ++i)
+        {
+            const size_t child = i ? right : left;
+
+            csrAABBDynamicTreeBoxUnion(&pTree->m_pNodes[child].m_Box, &leafBox, &box);
+
+            if (pTree->m_pNodes[child].m_Height > 0)
+                childCost[i] = csrAABBFlatTreeBoxArea(&box) -
+                               csrAABBFlatTreeBoxArea(&pTree->m_pNodes[child].m_Box) + inheritedCost;
+            else
+                childCost[i] = csrAABBFlatTreeBoxArea(&box) + inheritedCost;
+        }
+
+        // is it better to stop here?
+        if (cost < childCost[0] && cost < childCost[1])
+            break;
+
+        index = (childCost[0] < childCost[1]) ? left : right;
     }
 
-    // do create right node?
-    if (canResolveRight)
+    // create a new parent for the sibling and the leaf. NOTE the nodes may be reallocated here
+    parent = csrAABBDynamicTreeAllocateNode(pTree);
+
+    // succeeded?
+    if (parent == (size_t)M_CSR_Unknown_Index)
+        return 0;
+
+    pTree->m_pNodes[parent].m_Parent = pTree->m_pNodes[index].m_Parent;
+    csrAABBDynamicTreeReplaceChild(pTree->m_pNodes[parent].m_Parent, index, parent, pTree);
+
+    pTree->m_pNodes[parent].m_Left  = index;
+    pTree->m_pNodes[parent].m_Right = leaf;
+    pTree->m_pNodes[index].m_Parent = parent;
+    pTree->m_pNodes[leaf].m_Parent  = parent;
+
+    // refit and balance the parents
+    csrAABBDynamicTreeRefitFrom(parent, pTree);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeRemoveLeaf(size_t leaf, CSR_AABBDynamicTree* pTree)
+{
+    size_t parent;
+    size_t grandParent;
+    size_t sibling;
+
+    // is leaf the root?
+    if (leaf == pTree->m_Root)
     {
-        // create the right node
-        pNode->m_pRight = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+        pTree->m_Root = (size_t)M_CSR_Unknown_Index;
+        return;
+    }
 
-        // populate it
-        result |= csrAABBTreeFromIndexedPolygonBuffer(pRightPolygons, pNode->m_pRight);
+    parent      = pTree->m_pNodes[leaf].m_Parent;
+    grandParent = pTree->m_pNodes[parent].m_Parent;
+    sibling     = (pTree->m_pNodes[parent].m_Left == leaf) ? pTree->m_pNodes[parent].m_Right :
+                                                              pTree->m_pNodes[parent].m_Left;
 
-        // set node parent. IMPORTANT must be done after the node is populated (because this value
-        // will be reseted while the node is filled by csrAABBTreeFromIndexedPolygonBuffer())
-        pNode->m_pRight->m_pParent = pNode;
+    // the sibling replaces the parent
+    pTree->m_pNodes[sibling].m_Parent = grandParent;
+    csrAABBDynamicTreeReplaceChild(grandParent, parent, sibling, pTree);
+    csrAABBDynamicTreeFreeNode(parent, pTree);
 
-        // delete right polygon buffer, as it will no longer be used
-        csrIndexedPolygonBufferRelease(pRightPolygons);
-    }
+    pTree->m_pNodes[leaf].m_Parent = (size_t)M_CSR_Unknown_Index;
 
-    return result;
+    // refit and balance the remaining parents
+    csrAABBDynamicTreeRefitFrom(grandParent, pTree);
 }
 //---------------------------------------------------------------------------
-CSR_AABBNode* csrAABBTreeFromMesh(const CSR_Mesh* pMesh)
+int csrAABBDynamicTreeIsLeaf(size_t leaf, const CSR_AABBDynamicTree* pTree)
 {
-    CSR_AABBNode* pRoot;
-    int           success;
+    return (leaf < pTree->m_Count && !pTree->m_pNodes[leaf].m_Height);
+}
+//---------------------------------------------------------------------------
+int csrAABBDynamicTreeQueryBoxNode(const CSR_Box*                    pBox,
+                                   const CSR_AABBDynamicTree*        pTree,
+                                         size_t                      index,
+                                         CSR_fOnAABBDynamicTreeQuery fOnQuery,
+                                         void*                       pContext)
+{
+    const CSR_AABBDynamicNode* pNode = &pTree->m_pNodes[index];
 
-    // get indexed polygon buffer from mesh
-    CSR_IndexedPolygonBuffer* pIPB = csrIndexedPolygonBufferFromMesh(pMesh);
+    // is node out of the query box?
+    if (!csrAABBDynamicTreeBoxOverlap(&pNode->m_Box, pBox))
+        return 1;
 
-    // succeeded?
-    if (!pIPB)
-        return 0;
+    // is leaf?
+    if (!pNode->m_Height)
+        return fOnQuery(pNode, pContext);
 
-    // create the root node
-    pRoot = (CSR_AABBNode*)malloc(sizeof(CSR_AABBNode));
+    return csrAABBDynamicTreeQueryBoxNode(pBox, pTree, pNode->m_Left,  fOnQuery, pContext) &&
+           csrAABBDynamicTreeQueryBoxNode(pBox, pTree, pNode->m_Right, fOnQuery, pContext);
+}
+//---------------------------------------------------------------------------
+int csrAABBDynamicTreeQueryRayNode(const CSR_Ray3*                   pRay,
+                                         int                         line,
+                                         float                       inf,
+                                   const CSR_AABBDynamicTree*        pTree,
+                                         size_t                      index,
+                                         CSR_fOnAABBDynamicTreeQuery fOnQuery,
+                                         void*                       pContext)
+{
+    float                      tNear;
+    const CSR_AABBDynamicNode* pNode = &pTree->m_pNodes[index];
 
-    // succeeded?
-    if (!pRoot)
+    // is node missed by the ray?
+    if (line)
     {
-        csrIndexedPolygonBufferRelease(pIPB);
-        return 0;
+        if (!csrAABBTreeRayBox(pRay, &pNode->m_Box, 0, 0))
+            return 1;
     }
+    else
+    if (!csrAABBTreeRayCastBox(pRay, &pNode->m_Box, inf, &tNear))
+        return 1;
 
-    // populate the AABB tree
-    success = csrAABBTreeFromIndexedPolygonBuffer(pIPB, pRoot);
-
-    // release the polygon buffer
-    csrIndexedPolygonBufferRelease(pIPB);
-
-    // tree was populated successfully?
-    if (!success)
-    {
-        csrAABBTreeNodeRelease(pRoot);
-        return 0;
-    }
+    // is leaf?
+    if (!pNode->m_Height)
+        return fOnQuery(pNode, pContext);
 
-    return pRoot;
+    return csrAABBDynamicTreeQueryRayNode(pRay, line, inf, pTree, pNode->m_Left,  fOnQuery, pContext) &&
+           csrAABBDynamicTreeQueryRayNode(pRay, line, inf, pTree, pNode->m_Right, fOnQuery, pContext);
 }
 //---------------------------------------------------------------------------
-int csrAABBTreeResolve(const CSR_Ray3*           pRay,
-                       const CSR_AABBNode*       pNode,
-                             size_t              deep,
-                             CSR_Polygon3Buffer* pPolygons)
+// Dynamic Aligned-Axis Bounding Box tree functions
+//---------------------------------------------------------------------------
+CSR_AABBDynamicTree* csrAABBDynamicTreeCreate(void)
 {
-    #ifdef _MSC_VER
-        unsigned      i;
-        int           leftResolved   = 0;
-        int           rightResolved  = 0;
-        CSR_Polygon3* pPolygonBuffer = 0;
-        CSR_Figure3   ray            = {0};
-        CSR_Figure3   box            = {0};
-    #else
-        unsigned      i;
-        int           leftResolved  = 0;
-        int           rightResolved = 0;
-        CSR_Polygon3* pPolygonBuffer;
-        CSR_Figure3   ray;
-        CSR_Figure3   box;
-    #endif
+    // create a new dynamic AABB tree
+    CSR_AABBDynamicTree* pTree = (CSR_AABBDynamicTree*)malloc(sizeof(CSR_AABBDynamicTree));
 
-    // no ray?
-    if (!pRay)
+    // succeeded?
+    if (!pTree)
         return 0;
 
-    // no node to resolve?
-    if (!pNode)
-        return 0;
+    // initialize the dynamic AABB tree content
+    csrAABBDynamicTreeInit(pTree);
 
-    // no polygon buffer to contain the result?
-    if (!pPolygons)
-        return 0;
+    return pTree;
+}
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeRelease(CSR_AABBDynamicTree* pTree, int contentOnly)
+{
+    // no tree to release?
+    if (!pTree)
+        return;
 
-    // is the first iteration?
-    if (!deep)
-    {
-        // ensure the polygon buffer is initialized, otherwise this may cause hard-to-debug bugs
-        pPolygons->m_pPolygon = 0;
-        pPolygons->m_Count    = 0;
-    }
+    // free the nodes
+    if (pTree->m_pNodes)
+        free(pTree->m_pNodes);
 
-    // is leaf?
-    if (!pNode->m_pLeft && !pNode->m_pRight)
-    {
-        // iterate through polygons contained in leaf
-        for (i = 0; i < pNode->m_pPolygonBuffer->m_Count; ++i)
-        {
-            // allocate memory for a new polygon in the buffer
-            pPolygonBuffer = (CSR_Polygon3*)csrMemoryAlloc(pPolygons->m_pPolygon,
-                                                           sizeof(CSR_Polygon3),
-                                                           pPolygons->m_Count + 1);
+    // free the tree
+    if (!contentOnly)
+        free(pTree);
+    else
+        csrAABBDynamicTreeInit(pTree);
+}
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeInit(CSR_AABBDynamicTree* pTree)
+{
+    // no tree to initialize?
+    if (!pTree)
+        return;
 
-            // succeeded?
-            if (!pPolygonBuffer)
-                return 0;
+    // initialize the tree
+    pTree->m_pNodes    = 0;
+    pTree->m_Count     = 0;
+    pTree->m_Root      = (size_t)M_CSR_Unknown_Index;
+    pTree->m_FreeList  = (size_t)M_CSR_Unknown_Index;
+    pTree->m_LeafCount = 0;
+    pTree->m_Margin    = 0.0f;
+}
+//---------------------------------------------------------------------------
+size_t csrAABBDynamicTreeInsert(const CSR_Box*             pBox,
+                                      size_t               item,
+                                      size_t               index,
+                                      CSR_AABBDynamicTree* pTree)
+{
+    size_t leaf;
 
-            // update the polygon buffer
-            pPolygons->m_pPolygon = pPolygonBuffer;
-            ++pPolygons->m_Count;
+    // validate the inputs
+    if (!pBox || !pTree)
+        return (size_t)M_CSR_Unknown_Index;
 
-            // copy the polygon content
-            if (!csrIndexedPolygonToPolygon(&pNode->m_pPolygonBuffer->m_pIndexedPolygon[i],
-                                            &pPolygons->m_pPolygon[pPolygons->m_Count - 1]))
-                return 0;
-        }
+    // create the leaf
+    leaf = csrAABBDynamicTreeAllocateNode(pTree);
 
-        return 1;
-    }
+    // succeeded?
+    if (leaf == (size_t)M_CSR_Unknown_Index)
+        return leaf;
 
-    // convert ray to geometric figure
-    ray.m_Type    = CSR_F3_Ray;
-    ray.m_pFigure = pRay;
+    // populate it
+    pTree->m_pNodes[leaf].m_Item  = item;
+    pTree->m_pNodes[leaf].m_Index = index;
+    csrAABBDynamicTreeFatten(pBox, pTree->m_Margin, &pTree->m_pNodes[leaf].m_Box);
 
-    // node contains a left child?
-    if (pNode->m_pLeft)
+    // insert it in the tree
+    if (!csrAABBDynamicTreeInsertLeaf(leaf, pTree))
     {
-        // convert left box to geometric figure
-        box.m_Type    = CSR_F3_Box;
-        box.m_pFigure = pNode->m_pLeft->m_pBox;
-
-        // check if ray intersects the left box
-        if (csrIntersect3(&ray, &box, 0, 0, 0))
-            // resolve left node
-            leftResolved = csrAABBTreeResolve(pRay, pNode->m_pLeft, deep + 1, pPolygons);
+        csrAABBDynamicTreeFreeNode(leaf, pTree);
+        return (size_t)M_CSR_Unknown_Index;
     }
 
-    // node contains a right child?
-    if (pNode->m_pRight)
-    {
-        // convert right box to geometric figure
-        box.m_Type    = CSR_F3_Box;
-        box.m_pFigure = pNode->m_pRight->m_pBox;
+    ++pTree->m_LeafCount;
 
-        // check if ray intersects the right box
-        if (csrIntersect3(&ray, &box, 0, 0, 0))
-            // resolve right node
-            rightResolved = csrAABBTreeResolve(pRay, pNode->m_pRight, deep + 1, pPolygons);
-    }
+    return leaf;
+}
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeRemove(size_t leaf, CSR_AABBDynamicTree* pTree)
+{
+    // validate the inputs
+    if (!pTree || !csrAABBDynamicTreeIsLeaf(leaf, pTree))
+        return;
 
-    return (leftResolved || rightResolved);
+    csrAABBDynamicTreeRemoveLeaf(leaf, pTree);
+    csrAABBDynamicTreeFreeNode(leaf, pTree);
+
+    --pTree->m_LeafCount;
 }
 //---------------------------------------------------------------------------
-void csrAABBTreeNodeContentRelease(CSR_AABBNode* pNode)
+int csrAABBDynamicTreeMove(size_t leaf, const CSR_Box* pBox, CSR_AABBDynamicTree* pTree)
 {
-    // release the bounding box
-    if (pNode->m_pBox)
-    {
-        free(pNode->m_pBox);
-        pNode->m_pBox = 0;
-    }
+    // validate the inputs
+    if (!pBox || !pTree || !csrAABBDynamicTreeIsLeaf(leaf, pTree))
+        return 0;
 
-    // release the polygon buffer
-    if (pNode->m_pPolygonBuffer)
-    {
-        // release the polygon buffer content
-        if (pNode->m_pPolygonBuffer->m_pIndexedPolygon)
-            free(pNode->m_pPolygonBuffer->m_pIndexedPolygon);
+    // leaf box still contains the new box, nothing to do
+    if (csrAABBDynamicTreeBoxContains(&pTree->m_pNodes[leaf].m_Box, pBox))
+        return 0;
 
-        free(pNode->m_pPolygonBuffer);
-        pNode->m_pPolygonBuffer = 0;
-    }
+    // reinsert the leaf with its new box. NOTE the removed parent node is reused by the insertion,
+    // so this cannot fail
+    csrAABBDynamicTreeRemoveLeaf(leaf, pTree);
+    csrAABBDynamicTreeFatten(pBox, pTree->m_Margin, &pTree->m_pNodes[leaf].m_Box);
+    csrAABBDynamicTreeInsertLeaf(leaf, pTree);
+
+    return 1;
 }
 //---------------------------------------------------------------------------
-void csrAABBTreeNodeRelease(CSR_AABBNode* pNode)
+void csrAABBDynamicTreeQueryBox(const CSR_Box*                    pBox,
+                                const CSR_AABBDynamicTree*        pTree,
+                                      CSR_fOnAABBDynamicTreeQuery fOnQuery,
+                                      void*                       pContext)
 {
-    if (!pNode)
+    // validate the inputs
+    if (!pBox || !pTree || !fOnQuery)
         return;
 
-    // release all children on left side
-    if (pNode->m_pLeft)
-        csrAABBTreeNodeRelease(pNode->m_pLeft);
+    // is tree empty?
+    if (pTree->m_Root == (size_t)M_CSR_Unknown_Index)
+        return;
 
-    // release all children on right side
-    if (pNode->m_pRight)
-        csrAABBTreeNodeRelease(pNode->m_pRight);
+    csrAABBDynamicTreeQueryBoxNode(pBox, pTree, pTree->m_Root, fOnQuery, pContext);
+}
+//---------------------------------------------------------------------------
+void csrAABBDynamicTreeQueryRay(const CSR_Ray3*                   pRay,
+                                      int                         line,
+                                const CSR_AABBDynamicTree*        pTree,
+                                      CSR_fOnAABBDynamicTreeQuery fOnQuery,
+                                      void*                       pContext)
+{
+    // get infinite value
+    #ifdef _MSC_VER
+        const float inf = INFINITY;
+    #else
+        const float inf = 1.0f / 0.0f;
+    #endif
 
-    // delete node content
-    csrAABBTreeNodeContentRelease(pNode);
+    // validate the inputs
+    if (!pRay || !pTree || !fOnQuery)
+        return;
 
-    // delete node
-    free(pNode);
+    // is tree empty?
+    if (pTree->m_Root == (size_t)M_CSR_Unknown_Index)
+        return;
+
+    csrAABBDynamicTreeQueryRayNode(pRay, line, inf, pTree, pTree->m_Root, fOnQuery, pContext);
 }
 //---------------------------------------------------------------------------
 // Sliding functions
@@ -577,43 +3495,51 @@ int csrGroundPosY(const CSR_Sphere*   pBoundingSphere,
                         CSR_Polygon3* pGroundPolygon,
                         float*        pR)
 {
-    size_t             i;
-    CSR_Ray3           groundRay;
-    CSR_Vector3        groundPos;
-    CSR_Polygon3Buffer polygonBuffer;
-    int                result;
+    CSR_Ray3        groundRay;
+    CSR_Vector3     groundDir;
+    CSR_Vector3     groundPos;
+    CSR_AABBTreeHit hit;
+    int             result;
 
     // validate the inputs
     if (!pBoundingSphere || !pTree || !pGroundDir)
         return 0;
 
-    result = 0;
+    groundDir = *pGroundDir;
 
     // create the ground ray
-    csrRay3FromPointDir(&pBoundingSphere->m_Center, pGroundDir, &groundRay);
+    csrRay3FromPointDir(&pBoundingSphere->m_Center, &groundDir, &groundRay);
 
-    // using the ground ray, resolve aligned-axis bounding box tree
-    csrAABBTreeResolve(&groundRay, pTree, 0, &polygonBuffer);
+    // search for the nearest ground polygon below the bounding sphere
+    result = csrAABBTreeRayCast(&groundRay, pTree, -1.0f, &hit);
 
-    // initialize the ground position from the bounding sphere center
-    groundPos = pBoundingSphere->m_Center;
+    // not found? Search above, in case the bounding sphere center is already under the ground
+    if (!result)
+    {
+        groundDir.m_X = -groundDir.m_X;
+        groundDir.m_Y = -groundDir.m_Y;
+        groundDir.m_Z = -groundDir.m_Z;
 
-    // iterate through polygons to check
-    for (i = 0; i < polygonBuffer.m_Count; ++i)
-        // check if a ground polygon was found, calculate the ground position if yes
-        if (csrGroundCollision(pBoundingSphere, &polygonBuffer.m_pPolygon[i], pGroundDir, &groundPos))
-        {
-            // copy the ground polygon, if required
-            if (pGroundPolygon)
-                *pGroundPolygon = polygonBuffer.m_pPolygon[i];
+        csrRay3FromPointDir(&pBoundingSphere->m_Center, &groundDir, &groundRay);
 
-            result = 1;
-            break;
-        }
+        result = csrAABBTreeRayCast(&groundRay, pTree, -1.0f, &hit);
+    }
+
+    // initialize the ground position from the bounding sphere center
+    groundPos = pBoundingSphere->m_Center;
 
-    // delete found polygons (no longer needed from now)
-    if (polygonBuffer.m_Count)
-        free(polygonBuffer.m_pPolygon);
+    // found a ground polygon?
+    if (result)
+    {
+        // calculate the ground position, considering the sphere radius
+        groundPos.m_X += (groundDir.m_X * hit.m_Distance) - (pBoundingSphere->m_Radius * pGroundDir->m_X);
+        groundPos.m_Y += (groundDir.m_Y * hit.m_Distance) - (pBoundingSphere->m_Radius * pGroundDir->m_Y);
+        groundPos.m_Z += (groundDir.m_Z * hit.m_Distance) - (pBoundingSphere->m_Radius * pGroundDir->m_Z);
+
+        // copy the ground polygon, if required
+        if (pGroundPolygon)
+            csrIndexedPolygonToPolygon(hit.m_pPolygon, pGroundPolygon);
+    }
 
     // copy the resulting y value
     if (pR)
@@ -622,3 +3548,134 @@ int csrGroundPosY(const CSR_Sphere*   pBoundingSphere,
     return result;
 }
 //---------------------------------------------------------------------------
+size_t csrGroundPosYBatch(const CSR_Sphere*   pBoundingSpheres,
+                                size_t        count,
+                          const CSR_AABBNode* pTree,
+                          const CSR_Vector3*  pGroundDir,
+                                CSR_Polygon3* pGroundPolygons,
+                                float*        pR,
+                                int*          pResults)
+{
+    size_t                 i;
+    size_t                 hitCount;
+    size_t                 missCount;
+    size_t                 missIndex;
+    int*                   pMissResults = 0;
+    CSR_AABBTreeHit*       pMissHits    = 0;
+    CSR_Ray3*              pRays;
+    CSR_AABBTreeHit*       pHits;
+    const CSR_AABBTreeHit* pHit;
+    CSR_Vector3            groundDir;
+    CSR_Vector3            reverseDir;
+    float                  distance;
+    int                    found;
+
+    // validate the inputs
+    if (!pBoundingSpheres || !pTree || !pGroundDir || !pR || !pResults)
+        return 0;
+
+    // nothing to calculate?
+    if (!count)
+        return 0;
+
+    groundDir = *pGroundDir;
+
+    reverseDir.m_X = -groundDir.m_X;
+    reverseDir.m_Y = -groundDir.m_Y;
+    reverseDir.m_Z = -groundDir.m_Z;
+
+    // create the ground rays and their hits
+    pRays = (CSR_Ray3*)       malloc(sizeof(CSR_Ray3)        * count);
+    pHits = (CSR_AABBTreeHit*)malloc(sizeof(CSR_AABBTreeHit) * count);
+
+    // succeeded?
+    if (!pRays || !pHits)
+    {
+        free(pRays);
+        free(pHits);
+        return 0;
+    }
+
+    // create the ground rays
+    for (i = 0; i < count; ++i)
+        csrRay3FromPointDir(&pBoundingSpheres[i].m_Center, &groundDir, &pRays[i]);
+
+    // search for the nearest ground polygons below the bounding spheres
+    hitCount  = csrAABBTreeRayCastBatch(pRays, count, pTree, -1.0f, pHits, pResults);
+    missCount = count - hitCount;
+
+    // some bounding sphere centers may already be under the ground, search above for them
+    if (missCount)
+    {
+        pMissHits    = (CSR_AABBTreeHit*)malloc(sizeof(CSR_AABBTreeHit) * missCount);
+        pMissResults = (int*)            malloc(sizeof(int)             * missCount);
+
+        // succeeded?
+        if (pMissHits && pMissResults)
+        {
+            missIndex = 0;
+
+            // reuse the ray list to cast the reversed rays, in the same order as the spheres
+            for (i = 0; i < count; ++i)
+                if (!pResults[i])
+                {
+                    csrRay3FromPointDir(&pBoundingSpheres[i].m_Center, &reverseDir, &pRays[missIndex]);
+                    ++missIndex;
+                }
+
+            hitCount += csrAABBTreeRayCastBatch(pRays, missCount, pTree, -1.0f, pMissHits, pMissResults);
+        }
+        else
+            missCount = 0;
+    }
+
+    missIndex = 0;
+
+    // calculate the ground positions
+    for (i = 0; i < count; ++i)
+    {
+        // initialize the ground position from the bounding sphere center
+        pR[i] = pBoundingSpheres[i].m_Center.m_Y;
+
+        // get the ground hit, either below or above the bounding sphere
+        if (pResults[i])
+        {
+            pHit     = &pHits[i];
+            distance =  pHit->m_Distance;
+        }
+        else
+        {
+            // no reversed ray was cast
+            if (missIndex >= missCount)
+                continue;
+
+            pHit  = &pMissHits[missIndex];
+            found =  pMissResults[missIndex];
+            ++missIndex;
+
+            // no ground found above the bounding sphere?
+            if (!found)
+                continue;
+
+            pResults[i] = 1;
+
+            // the distance is measured in the reversed direction
+            distance = -pHit->m_Distance;
+        }
+
+        // calculate the ground position, considering the sphere radius
+        pR[i] += (groundDir.m_Y * distance) - (pBoundingSpheres[i].m_Radius * groundDir.m_Y);
+
+        // copy the ground polygon, if required
+        if (pGroundPolygons)
+            csrIndexedPolygonToPolygon(pHit->m_pPolygon, &pGroundPolygons[i]);
+    }
+
+    free(pMissHits);
+    free(pMissResults);
+    free(pRays);
+    free(pHits);
+
+    return hitCount;
+}
+//---------------------------------------------------------------------------
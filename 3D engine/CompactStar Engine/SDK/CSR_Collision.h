@@ -37,6 +37,86 @@ typedef struct CSR_tagAABBNode
            CSR_IndexedPolygonBuffer* m_pPolygonBuffer;
 } CSR_AABBNode;
 
+/**
+* Flat aligned-axis bounding box tree node
+*@note For an internal node, the left child is always the next node in the array, and m_Offset
+*      contains the index of the right child. For a leaf, m_Offset contains the index of the first
+*      polygon in the tree polygon array, and m_Count the number of polygons it contains
+*/
+typedef struct
+{
+    CSR_Box      m_Box;
+    unsigned int m_Offset;
+    unsigned int m_Count;
+} CSR_AABBFlatNode;
+
+/**
+* Flat aligned-axis bounding box tree, nodes are stored in depth-first order in a single array
+*/
+typedef struct
+{
+    CSR_AABBFlatNode*   m_pNodes;
+    size_t              m_NodeCount;
+    CSR_IndexedPolygon* m_pPolygons;
+    size_t              m_PolygonCount;
+    size_t              m_Depth;
+} CSR_AABBFlatTree;
+
+/**
+* Aligned-axis bounding box tree ray or sphere cast hit
+*@note For a flat tree, the hit polygon index is m_pPolygon - pTree->m_pPolygons
+*@note For a sphere cast, the hit point is the point where the sphere touches the polygon, and
+*      the normal is the normal of the plane on which the sphere should slide
+*/
+typedef struct
+{
+    const CSR_IndexedPolygon* m_pPolygon; // hit polygon, belonging to the tree
+          float               m_Distance; // distance between the ray origin and the hit point, in ray direction length units
+          float               m_U;        // hit point barycentric coordinate relative to the polygon second vertex
+          float               m_V;        // hit point barycentric coordinate relative to the polygon third vertex
+          CSR_Vector3         m_Normal;   // hit polygon normal
+} CSR_AABBTreeHit;
+
+/**
+* Dynamic aligned-axis bounding box tree node
+*/
+typedef struct
+{
+    CSR_Box m_Box;    // leaf box extended by the tree margin, or box surrounding both children
+    size_t  m_Parent; // parent node index (or next free node index), M_CSR_Unknown_Index if none
+    size_t  m_Left;   // left child index, M_CSR_Unknown_Index for a leaf
+    size_t  m_Right;  // right child index, M_CSR_Unknown_Index for a leaf
+    size_t  m_Item;   // item identifier, defined by the caller, for a leaf
+    size_t  m_Index;  // index in the item, defined by the caller, for a leaf
+    int     m_Height; // 0 for a leaf, -1 for a free node
+} CSR_AABBDynamicNode;
+
+/**
+* Dynamic aligned-axis bounding box tree, in which the boxes may be inserted, moved and removed
+* one by one, e.g. to find quickly the objects placed in a scene
+*/
+typedef struct
+{
+    CSR_AABBDynamicNode* m_pNodes;
+    size_t               m_Count;    // allocated node count
+    size_t               m_Root;     // root node index, M_CSR_Unknown_Index if the tree is empty
+    size_t               m_FreeList; // first free node index, M_CSR_Unknown_Index if none
+    size_t               m_LeafCount;
+    float                m_Margin;   // margin added around the leaf boxes, relative to their size
+} CSR_AABBDynamicTree;
+
+//---------------------------------------------------------------------------
+// Callbacks
+//---------------------------------------------------------------------------
+
+/**
+* Called when a leaf is found while a dynamic AABB tree is queried
+*@param pNode - found leaf
+*@param pContext - query context
+*@return 1 to continue the query, 0 to stop it
+*/
+typedef int (*CSR_fOnAABBDynamicTreeQuery)(const CSR_AABBDynamicNode* pNode, void* pContext);
+
 #ifdef __cplusplus
     extern "C"
     {
@@ -75,6 +155,122 @@ typedef struct CSR_tagAABBNode
                                      size_t              deep,
                                      CSR_Polygon3Buffer* pPolygons);
 
+        /**
+        * Casts a ray on an AABB tree and gets the nearest hit polygon
+        *@param pRay - ray to cast, only the polygons in front of its origin may be hit
+        *@param pNode - root or parent node to cast on
+        *@param maxDistance - maximum hit distance, in ray direction length units. No limit if negative
+        *@param[out] pHit - nearest hit, unchanged if no polygon was hit
+        *@return 1 if a polygon was hit, otherwise 0
+        *@note The children are visited front-to-back and those beyond the nearest hit are skipped,
+        *      and no memory is allocated, so prefer this function to csrAABBTreeResolve() when only
+        *      the nearest polygon is needed
+        */
+        int csrAABBTreeRayCast(const CSR_Ray3*        pRay,
+                               const CSR_AABBNode*    pNode,
+                                     float            maxDistance,
+                                     CSR_AABBTreeHit* pHit);
+
+        /**
+        * Casts several rays on an AABB tree and gets the nearest hit polygon for each of them
+        *@param pRays - rays to cast, only the polygons in front of their origin may be hit
+        *@param count - ray count
+        *@param pNode - root or parent node to cast on
+        *@param maxDistance - maximum hit distance, in ray direction length units. No limit if negative
+        *@param[out] pHits - nearest hit for each ray, should contain count items
+        *@param[out] pResults - 1 if the matching ray hit a polygon, otherwise 0, should contain
+        *                       count items
+        *@return the number of rays which hit a polygon
+        *@note The rays are traversed together as a stream, each node is visited once for all the
+        *      rays reaching it, which is faster than casting them one by one if they are coherent,
+        *      e.g. the ground rays of many models walking on the same landscape
+        */
+        size_t csrAABBTreeRayCastBatch(const CSR_Ray3*        pRays,
+                                             size_t           count,
+                                       const CSR_AABBNode*    pNode,
+                                             float            maxDistance,
+                                             CSR_AABBTreeHit* pHits,
+                                             int*             pResults);
+
+        /**
+        * Sweeps a sphere along a ray on an AABB tree and gets the first polygon it touches
+        *@param pRay - ray along which the sphere center moves, its direction should be normalized
+        *@param radius - sphere radius
+        *@param pNode - root or parent node to cast on
+        *@param maxDistance - maximum distance the sphere center may move. No limit if negative
+        *@param[out] pHit - first hit, unchanged if no polygon was touched. Its distance is the
+        *                   distance the sphere center moved until it touched the polygon, and its
+        *                   normal points from the touched point to the sphere center
+        *@return 1 if a polygon was touched, otherwise 0
+        *@note If the sphere already intersects a polygon at the ray origin, this polygon is hit at
+        *      a distance of 0
+        *@note As csrAABBTreeRayCast(), the children are visited front-to-back and no memory is
+        *      allocated
+        */
+        int csrAABBTreeSphereCast(const CSR_Ray3*        pRay,
+                                        float            radius,
+                                  const CSR_AABBNode*    pNode,
+                                        float            maxDistance,
+                                        CSR_AABBTreeHit* pHit);
+
+        /**
+        * Refits an AABB tree to another mesh sharing the same topology, e.g. another frame of an
+        * animated model, without rebuilding it
+        *@param[in, out] pNode - root node of the tree to refit
+        *@param pFromMesh - mesh the tree polygons currently reference
+        *@param pToMesh - mesh to refit to, should contain the same vertex buffers layout and the
+        *                 same index buffers as pFromMesh
+        *@param merge - if 1, the boxes are extended to surround both meshes, and the polygons keep
+        *               referencing pFromMesh. This may be used to build a conservative tree
+        *               surrounding all the frames of an animation
+        *@return 1 on success, otherwise 0
+        *@note The boxes are recalculated bottom-up, the tree topology isn't changed. The tree stays
+        *      valid but may become less efficient if the meshes differ a lot
+        */
+        int csrAABBTreeRefit(      CSR_AABBNode* pNode,
+                             const CSR_Mesh*     pFromMesh,
+                             const CSR_Mesh*     pToMesh,
+                                   int           merge);
+
+        /**
+        * Writes an AABB tree in a buffer, thus it may be cached and reloaded without being rebuilt
+        *@param pNode - root node of the tree to write
+        *@param pMesh - mesh the tree was built from
+        *@param[in, out] pBuffer - buffer to write to
+        *@return 1 on success, otherwise 0
+        *@note The tree is written in a flat binary format, keyed by a hash of the mesh vertex
+        *      buffers, at the end of the buffer
+        */
+        int csrAABBTreeToBuffer(const CSR_AABBNode* pNode, const CSR_Mesh* pMesh, CSR_Buffer* pBuffer);
+
+        /**
+        * Reads an AABB tree from a buffer
+        *@param pBuffer - buffer containing the tree, see csrAABBTreeToBuffer()
+        *@param pMesh - mesh the tree was built from, the tree polygons will reference it
+        *@return newly created AABB tree, 0 on error or if the tree was built from another mesh
+        *@note The AABB tree must be released when no longer used, see csrAABBTreeNodeRelease()
+        */
+        CSR_AABBNode* csrAABBTreeFromBuffer(const CSR_Buffer* pBuffer, const CSR_Mesh* pMesh);
+
+        /**
+        * Saves an AABB tree to a file
+        *@param pFileName - file name
+        *@param pNode - root node of the tree to save
+        *@param pMesh - mesh the tree was built from
+        *@return 1 on success, otherwise 0
+        */
+        int csrAABBTreeSave(const char* pFileName, const CSR_AABBNode* pNode, const CSR_Mesh* pMesh);
+
+        /**
+        * Loads an AABB tree from a file
+        *@param pFileName - file name
+        *@param pMesh - mesh the tree was built from, the tree polygons will reference it
+        *@return newly created AABB tree, 0 on error or if the tree was built from another mesh,
+        *        in which case the tree should be rebuilt, see csrAABBTreeFromMesh()
+        *@note The AABB tree must be released when no longer used, see csrAABBTreeNodeRelease()
+        */
+        CSR_AABBNode* csrAABBTreeLoad(const char* pFileName, const CSR_Mesh* pMesh);
+
         /**
         * Releases an AABB tree node content
         *@param[in, out] pNode - node for which content should be released
@@ -88,6 +284,173 @@ typedef struct CSR_tagAABBNode
         */
         void csrAABBTreeNodeRelease(CSR_AABBNode* pNode);
 
+        //-------------------------------------------------------------------
+        // Flat Aligned-Axis Bounding Box tree functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a flat AABB tree
+        *@return newly created flat AABB tree, 0 on error
+        *@note The flat AABB tree must be released when no longer used, see csrAABBFlatTreeRelease()
+        */
+        CSR_AABBFlatTree* csrAABBFlatTreeCreate(void);
+
+        /**
+        * Releases a flat AABB tree
+        *@param[in, out] pTree - flat AABB tree to release
+        *@param contentOnly - if 1, only the tree content will be released
+        */
+        void csrAABBFlatTreeRelease(CSR_AABBFlatTree* pTree, int contentOnly);
+
+        /**
+        * Initializes a flat AABB tree structure
+        *@param[in, out] pTree - flat AABB tree to initialize
+        */
+        void csrAABBFlatTreeInit(CSR_AABBFlatTree* pTree);
+
+        /**
+        * Populates a flat AABB tree from an indexed polygon buffer
+        *@param pIPB - indexed polygon buffer to use to populate the tree
+        *@param[in, out] pTree - flat AABB tree to populate
+        *@return 1 on success, otherwise 0
+        *@note The split positions are chosen using a binned Surface Area Heuristic (SAH)
+        *@note The tree polygons reference the same vertex buffers as the indexed polygon buffer,
+        *      which should be kept alive as long as the tree is used
+        */
+        int csrAABBFlatTreeFromIndexedPolygonBuffer(const CSR_IndexedPolygonBuffer* pIPB,
+                                                          CSR_AABBFlatTree*         pTree);
+
+        /**
+        * Gets a flat AABB tree from a mesh
+        *@param pMesh - mesh
+        *@return flat aligned-axis bounding box tree, 0 on error
+        *@note The flat AABB tree must be released when no longer used, see csrAABBFlatTreeRelease()
+        */
+        CSR_AABBFlatTree* csrAABBFlatTreeFromMesh(const CSR_Mesh* pMesh);
+
+        /**
+        * Resolves a flat AABB tree
+        *@param pRay - ray against which tree items will be tested
+        *@param pTree - flat AABB tree to resolve
+        *@param[out] pPolygons - polygons belonging to boxes hit by ray
+        *@return 1 on success, otherwise 0
+        *@note The polygon buffer content should be released when no longer used
+        */
+        int csrAABBFlatTreeResolve(const CSR_Ray3*           pRay,
+                                   const CSR_AABBFlatTree*   pTree,
+                                         CSR_Polygon3Buffer* pPolygons);
+
+        /**
+        * Casts a ray on a flat AABB tree and gets the nearest hit polygon
+        *@param pRay - ray to cast, only the polygons in front of its origin may be hit
+        *@param pTree - flat AABB tree to cast on
+        *@param maxDistance - maximum hit distance, in ray direction length units. No limit if negative
+        *@param[out] pHit - nearest hit, unchanged if no polygon was hit
+        *@return 1 if a polygon was hit, otherwise 0
+        */
+        int csrAABBFlatTreeRayCast(const CSR_Ray3*         pRay,
+                                   const CSR_AABBFlatTree* pTree,
+                                         float             maxDistance,
+                                         CSR_AABBTreeHit*  pHit);
+
+        /**
+        * Refits a flat AABB tree to another mesh sharing the same topology
+        *@param[in, out] pTree - flat AABB tree to refit
+        *@param pFromMesh - mesh the tree polygons currently reference
+        *@param pToMesh - mesh to refit to, should contain the same vertex buffers layout as pFromMesh
+        *@param merge - if 1, the boxes are extended to surround both meshes, and the polygons keep
+        *               referencing pFromMesh
+        *@return 1 on success, otherwise 0
+        *@note See csrAABBTreeRefit()
+        */
+        int csrAABBFlatTreeRefit(      CSR_AABBFlatTree* pTree,
+                                 const CSR_Mesh*         pFromMesh,
+                                 const CSR_Mesh*         pToMesh,
+                                       int               merge);
+
+        //-------------------------------------------------------------------
+        // Dynamic Aligned-Axis Bounding Box tree functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a dynamic AABB tree
+        *@return newly created dynamic AABB tree, 0 on error
+        *@note The dynamic AABB tree must be released when no longer used, see csrAABBDynamicTreeRelease()
+        */
+        CSR_AABBDynamicTree* csrAABBDynamicTreeCreate(void);
+
+        /**
+        * Releases a dynamic AABB tree
+        *@param[in, out] pTree - dynamic AABB tree to release
+        *@param contentOnly - if 1, only the tree content will be released
+        */
+        void csrAABBDynamicTreeRelease(CSR_AABBDynamicTree* pTree, int contentOnly);
+
+        /**
+        * Initializes a dynamic AABB tree structure
+        *@param[in, out] pTree - dynamic AABB tree to initialize
+        */
+        void csrAABBDynamicTreeInit(CSR_AABBDynamicTree* pTree);
+
+        /**
+        * Inserts a box in a dynamic AABB tree
+        *@param pBox - box to insert
+        *@param item - item identifier to store in the leaf, defined by the caller
+        *@param index - index in the item to store in the leaf, defined by the caller
+        *@param[in, out] pTree - dynamic AABB tree to insert to
+        *@return inserted leaf index, M_CSR_Unknown_Index on error
+        *@note The leaf index doesn't change until the leaf is removed, and may be used to move or
+        *      remove the box later
+        */
+        size_t csrAABBDynamicTreeInsert(const CSR_Box*             pBox,
+                                              size_t               item,
+                                              size_t               index,
+                                              CSR_AABBDynamicTree* pTree);
+
+        /**
+        * Removes a leaf from a dynamic AABB tree
+        *@param leaf - leaf index to remove, as returned by csrAABBDynamicTreeInsert()
+        *@param[in, out] pTree - dynamic AABB tree to remove from
+        */
+        void csrAABBDynamicTreeRemove(size_t leaf, CSR_AABBDynamicTree* pTree);
+
+        /**
+        * Moves a leaf box in a dynamic AABB tree
+        *@param leaf - leaf index to move, as returned by csrAABBDynamicTreeInsert()
+        *@param pBox - new leaf box
+        *@param[in, out] pTree - dynamic AABB tree containing the leaf
+        *@return 1 if the leaf was reinserted, 0 if the leaf box still contains the new box and
+        *        nothing changed, or on error
+        */
+        int csrAABBDynamicTreeMove(size_t leaf, const CSR_Box* pBox, CSR_AABBDynamicTree* pTree);
+
+        /**
+        * Queries all the leaves whose box intersects a box
+        *@param pBox - box to query
+        *@param pTree - dynamic AABB tree to query
+        *@param fOnQuery - callback function notified for each found leaf
+        *@param pContext - context to pass to the callback function
+        */
+        void csrAABBDynamicTreeQueryBox(const CSR_Box*                    pBox,
+                                        const CSR_AABBDynamicTree*        pTree,
+                                              CSR_fOnAABBDynamicTreeQuery fOnQuery,
+                                              void*                       pContext);
+
+        /**
+        * Queries all the leaves whose box is crossed by a ray
+        *@param pRay - ray to query
+        *@param line - if 1, the ray is considered as an infinite line crossing its position, in
+        *              both directions
+        *@param pTree - dynamic AABB tree to query
+        *@param fOnQuery - callback function notified for each found leaf
+        *@param pContext - context to pass to the callback function
+        */
+        void csrAABBDynamicTreeQueryRay(const CSR_Ray3*                   pRay,
+                                              int                         line,
+                                        const CSR_AABBDynamicTree*        pTree,
+                                              CSR_fOnAABBDynamicTreeQuery fOnQuery,
+                                              void*                       pContext);
+
         //-------------------------------------------------------------------
         // Sliding functions
         //-------------------------------------------------------------------
@@ -142,6 +505,29 @@ typedef struct CSR_tagAABBNode
                                 CSR_Polygon3* pGroundPolygon,
                                 float*        pR);
 
+        /**
+        * Calculates the y axis positions where to place several points of view or models to stay
+        * above the ground
+        *@param pBoundingSpheres - spheres surrounding the points of view or models
+        *@param count - bounding sphere count
+        *@param pTree - ground model aligned-axis bounding box tree
+        *@param pGroundDir - ground direction
+        *@param[out] pGroundPolygons - polygons on which the ground was hit, ignored if 0
+        *@param[out] pR - resulting positions on the y axis where to place the points of view or models
+        *@param[out] pResults - 1 if a ground polygon was found for the matching sphere, otherwise 0
+        *@return the number of spheres for which a ground polygon was found
+        *@note All the output arrays should contain count items
+        *@note The result is the same as calling csrGroundPosY() for each sphere, but the ground rays
+        *      are cast together, see csrAABBTreeRayCastBatch()
+        */
+        size_t csrGroundPosYBatch(const CSR_Sphere*   pBoundingSpheres,
+                                        size_t        count,
+                                  const CSR_AABBNode* pTree,
+                                  const CSR_Vector3*  pGroundDir,
+                                        CSR_Polygon3* pGroundPolygons,
+                                        float*        pR,
+                                        int*          pResults);
+
 #ifdef __cplusplus
     }
 #endif
@@ -175,6 +175,105 @@ unsigned csrColorABGRToRGBA(unsigned color)
             ((color >> 24) & 0xFF));
 }
 //---------------------------------------------------------------------------
+// Array private functions
+//---------------------------------------------------------------------------
+size_t csrArrayIndexHash(const void* pData, size_t slotCount)
+{
+    // the data addresses are aligned, so their lowest bits are almost always the same. For that
+    // reason all the bits are mixed before keeping the lowest ones
+    size_t hash = (size_t)pData;
+    hash ^= hash >> 16;
+    hash *= 0x45D9F3B;
+    hash ^= hash >> 16;
+
+    return hash & (slotCount - 1);
+}
+//---------------------------------------------------------------------------
+void csrArrayIndexInsert(size_t index, CSR_Array* pArray)
+{
+    size_t slot = csrArrayIndexHash(pArray->m_pItem[index].m_pData, pArray->m_Index.m_Count);
+
+    // search for the next empty slot
+    while (pArray->m_Index.m_pSlot[slot])
+        slot = (slot + 1) & (pArray->m_Index.m_Count - 1);
+
+    pArray->m_Index.m_pSlot[slot] = index + 1;
+}
+//---------------------------------------------------------------------------
+size_t csrArrayIndexFindSlot(size_t index, const CSR_Array* pArray)
+{
+    size_t slot = csrArrayIndexHash(pArray->m_pItem[index].m_pData, pArray->m_Index.m_Count);
+
+    // search for the slot containing the item index
+    while (pArray->m_Index.m_pSlot[slot])
+    {
+        if (pArray->m_Index.m_pSlot[slot] == index + 1)
+            return slot;
+
+        slot = (slot + 1) & (pArray->m_Index.m_Count - 1);
+    }
+
+    return M_CSR_Unknown_Index;
+}
+//---------------------------------------------------------------------------
+void csrArrayIndexRemoveSlot(size_t slot, CSR_Array* pArray)
+{
+    const size_t mask = pArray->m_Index.m_Count - 1;
+          size_t next = slot;
+          size_t home;
+
+    // empty the slot, then move back the next items of the same cluster which may no longer be
+    // found because of this hole. Thus the index never needs to keep deleted slots
+    pArray->m_Index.m_pSlot[slot] = 0;
+
+    for (;;)
+    {
+        next = (next + 1) & mask;
+
+        // reached the cluster end?
+        if (!pArray->m_Index.m_pSlot[next])
+            return;
+
+        // get the slot in which the item would be ideally placed
+        home = csrArrayIndexHash(pArray->m_pItem[pArray->m_Index.m_pSlot[next] - 1].m_pData,
+                                 pArray->m_Index.m_Count);
+
+        // can the item be moved to the hole? (i.e its ideal slot isn't between the hole and it)
+        if (((next - home) & mask) >= ((next - slot) & mask))
+        {
+            pArray->m_Index.m_pSlot[slot] = pArray->m_Index.m_pSlot[next];
+            pArray->m_Index.m_pSlot[next] = 0;
+            slot                          = next;
+        }
+    }
+}
+//---------------------------------------------------------------------------
+int csrArrayIndexRebuild(size_t slotCount, CSR_Array* pArray)
+{
+    size_t  i;
+    size_t* pSlot;
+
+    // allocate the new slots
+    pSlot = (size_t*)csrMemoryAlloc(0, sizeof(size_t), slotCount);
+
+    // succeeded?
+    if (!pSlot)
+        return 0;
+
+    memset(pSlot, 0, sizeof(size_t) * slotCount);
+
+    // replace the previous slots
+    free(pArray->m_Index.m_pSlot);
+    pArray->m_Index.m_pSlot = pSlot;
+    pArray->m_Index.m_Count = slotCount;
+
+    // index all the existing items
+    for (i = 0; i < pArray->m_Count; ++i)
+        csrArrayIndexInsert(i, pArray);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
 // Array functions
 //---------------------------------------------------------------------------
 CSR_Array* csrArrayCreate(void)
@@ -213,6 +312,10 @@ void csrArrayRelease(CSR_Array* pArray)
         free(pArray->m_pItem);
     }
 
+    // free the array index
+    if (pArray->m_Index.m_pSlot)
+        free(pArray->m_Index.m_pSlot);
+
     // free the array
     free(pArray);
 }
@@ -224,38 +327,90 @@ void csrArrayInit(CSR_Array* pArray)
         return;
 
     // initialize the array content
-    pArray->m_pItem = 0;
-    pArray->m_Count = 0;
+    pArray->m_pItem         = 0;
+    pArray->m_Count         = 0;
+    pArray->m_Capacity      = 0;
+    pArray->m_Index.m_pSlot = 0;
+    pArray->m_Index.m_Count = 0;
 }
 //---------------------------------------------------------------------------
-void csrArrayAdd(void* pData, CSR_Array* pArray, int autoFree)
+int csrArrayReserve(size_t count, CSR_Array* pArray)
 {
-    size_t         index;
     CSR_ArrayItem* pNewItem;
 
-    // validate the inputs
-    if (!pArray || !pData)
-        return;
+    // validate the input
+    if (!pArray)
+        return 0;
 
-    // add an item to the array
-    pNewItem = (CSR_ArrayItem*)csrMemoryAlloc(pArray->m_pItem,
-                                              sizeof(CSR_ArrayItem),
-                                              pArray->m_Count + 1);
+    // is the array already large enough?
+    if (pArray->m_pItem && count <= pArray->m_Capacity)
+        return 1;
+
+    // allocate memory for the items
+    pNewItem = (CSR_ArrayItem*)csrMemoryAlloc(pArray->m_pItem, sizeof(CSR_ArrayItem), count);
 
     // succeeded?
     if (!pNewItem)
+        return 0;
+
+    pArray->m_pItem    = pNewItem;
+    pArray->m_Capacity = count;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrArrayEnableIndex(CSR_Array* pArray)
+{
+    size_t slotCount;
+
+    // validate the input
+    if (!pArray)
+        return 0;
+
+    // index already enabled?
+    if (pArray->m_Index.m_pSlot)
+        return 1;
+
+    slotCount = 16;
+
+    // keep the index at most half full, otherwise the searches would become slow
+    while (slotCount < pArray->m_Count * 2)
+        slotCount *= 2;
+
+    return csrArrayIndexRebuild(slotCount, pArray);
+}
+//---------------------------------------------------------------------------
+void csrArrayAdd(void* pData, CSR_Array* pArray, int autoFree)
+{
+    size_t index;
+
+    // validate the inputs
+    if (!pArray || !pData)
         return;
 
+    // grow the capacity geometrically, thus adding many items doesn't realloc on each of them
+    if (!pArray->m_pItem || pArray->m_Count >= pArray->m_Capacity)
+        if (!csrArrayReserve(pArray->m_Capacity ? pArray->m_Capacity * 2 : 16, pArray))
+            return;
+
+    // is the array indexed and its index becoming too full?
+    if (pArray->m_Index.m_pSlot && (pArray->m_Count + 1) * 2 > pArray->m_Index.m_Count)
+        if (!csrArrayIndexRebuild(pArray->m_Index.m_Count * 2, pArray))
+            return;
+
     // get the new item index
     index = pArray->m_Count;
 
     // update the array
-    pArray->m_pItem = pNewItem;
     ++pArray->m_Count;
 
     // set the data in the newly created item
     pArray->m_pItem[index].m_pData    = pData;
     pArray->m_pItem[index].m_AutoFree = autoFree;
+
+    // index the new item, if required
+    if (pArray->m_Index.m_pSlot)
+        csrArrayIndexInsert(index, pArray);
 }
 //---------------------------------------------------------------------------
 void csrArrayAddUnique(void* pData, CSR_Array* pArray, int autoFree)
@@ -281,11 +436,34 @@ CSR_ArrayItem* csrArrayGetItem(void* pData, const CSR_Array* pArray)
 size_t csrArrayGetIndexFrom(void* pData, size_t startIndex, const CSR_Array* pArray)
 {
     size_t i;
+    size_t slot;
+    size_t index;
 
     // validate the inputs
     if (!pArray || !pData)
         return M_CSR_Unknown_Index;
 
+    // is the array indexed?
+    if (pArray->m_Index.m_pSlot)
+    {
+        index = M_CSR_Unknown_Index;
+        slot  = csrArrayIndexHash(pData, pArray->m_Index.m_Count);
+
+        // search in the whole cluster, because the same data may have been added several times
+        // and the lowest index should be returned in this case
+        while (pArray->m_Index.m_pSlot[slot])
+        {
+            i = pArray->m_Index.m_pSlot[slot] - 1;
+
+            if (pArray->m_pItem[i].m_pData == pData && i >= startIndex && i < index)
+                index = i;
+
+            slot = (slot + 1) & (pArray->m_Index.m_Count - 1);
+        }
+
+        return index;
+    }
+
     // search for data index
     for (i = startIndex; i < pArray->m_Count; ++i)
         if (pArray->m_pItem[i].m_pData == pData)
@@ -308,24 +486,21 @@ CSR_ArrayItem* csrArrayGetItemFrom(void* pData, size_t startIndex, const CSR_Arr
 //---------------------------------------------------------------------------
 void csrArrayDelete(void* pData, CSR_Array* pArray)
 {
-    size_t i;
+    // search for an item matching with the data in the array
+    const size_t index = csrArrayGetIndex(pData, pArray);
 
-    // validate the inputs
-    if (!pArray || !pData)
+    // found it?
+    if (index == (size_t)M_CSR_Unknown_Index)
         return;
 
-    // search for an item matching with the data in the array, delete it if found
-    for (i = 0; i < pArray->m_Count; ++i)
-        if (pArray->m_pItem[i].m_pData == pData)
-        {
-            csrArrayDeleteAt(i, pArray);
-            return;
-        }
+    // delete it
+    csrArrayDeleteAt(index, pArray);
 }
 //---------------------------------------------------------------------------
 void csrArrayDeleteAt(size_t index, CSR_Array* pArray)
 {
-    CSR_ArrayItem* pNewItem;
+    size_t last;
+    size_t slot;
 
     // empty array?
     if (!pArray || !pArray->m_pItem || !pArray->m_Count)
@@ -335,49 +510,41 @@ void csrArrayDeleteAt(size_t index, CSR_Array* pArray)
     if (index >= pArray->m_Count)
         return;
 
-    // was the last item in the array?
-    if (pArray->m_Count == 1)
-    {
-        // free the array
-        if (pArray->m_pItem)
-            free(pArray->m_pItem);
+    // free the array item content, if required
+    if (pArray->m_pItem[index].m_AutoFree && pArray->m_pItem[index].m_pData)
+        free(pArray->m_pItem[index].m_pData);
 
-        // don't recreate nothing
-        pArray->m_pItem = 0;
-        pArray->m_Count = 0;
+    last = pArray->m_Count - 1;
 
-        return;
-    }
+    // is the array indexed?
+    if (pArray->m_Index.m_pSlot)
+    {
+        // remove the item from the index
+        slot = csrArrayIndexFindSlot(index, pArray);
 
-    // create an item list one item smaller than the existing one
-    pNewItem = (CSR_ArrayItem*)csrMemoryAlloc(0, sizeof(CSR_ArrayItem), pArray->m_Count - 1);
+        if (slot != (size_t)M_CSR_Unknown_Index)
+            csrArrayIndexRemoveSlot(slot, pArray);
 
-    // succeeded?
-    if (!pNewItem)
-        return;
+        // move the last item in the freed place, thus the deletion doesn't need to move the
+        // whole array content
+        if (index != last)
+        {
+            slot = csrArrayIndexFindSlot(last, pArray);
 
-    // copy all the remaining items in the new array
-    if (!index)
-        memcpy(pNewItem, pArray->m_pItem + 1, (pArray->m_Count - 1) * sizeof(CSR_ArrayItem));
-    else
-    if (index == (pArray->m_Count - 1))
-        memcpy(pNewItem, pArray->m_pItem, (pArray->m_Count - 1) * sizeof(CSR_ArrayItem));
-    else
-    {
-        memcpy(pNewItem,         pArray->m_pItem,             sizeof(CSR_ArrayItem) *                    index);
-        memcpy(pNewItem + index, pArray->m_pItem + index + 1, sizeof(CSR_ArrayItem) * (pArray->m_Count - index - 1));
-    }
+            pArray->m_pItem[index] = pArray->m_pItem[last];
 
-    // free the array item content, if required
-    if (pArray->m_pItem[index].m_AutoFree && pArray->m_pItem[index].m_pData)
-        free(pArray->m_pItem[index].m_pData);
-
-    // free the current array items
-    if (pArray->m_pItem)
-        free(pArray->m_pItem);
+            if (slot != (size_t)M_CSR_Unknown_Index)
+                pArray->m_Index.m_pSlot[slot] = index + 1;
+        }
+    }
+    else
+    if (index != last)
+        // move all the remaining items, thus the item order is kept
+        memmove(pArray->m_pItem + index,
+                pArray->m_pItem + index + 1,
+                sizeof(CSR_ArrayItem) * (last - index));
 
-    // update the array with the newly recreated items
-    pArray->m_pItem = pNewItem;
+    // update the array, the memory is kept for the next items
     --pArray->m_Count;
 }
 //---------------------------------------------------------------------------
@@ -622,7 +789,7 @@ int csrFileSave(const char* pFileName, const CSR_Buffer* pBuffer)
         return 0;
 
     // write the buffer content
-    bytesWritten = fwrite(pBuffer->m_pData, pBuffer->m_Length, 1, pFile);
+    bytesWritten = fwrite(pBuffer->m_pData, 1, pBuffer->m_Length, pFile);
 
     // close the file
     fclose(pFile);
@@ -65,6 +65,15 @@ typedef struct
     int   m_AutoFree;
 } CSR_ArrayItem;
 
+/**
+* Array index, allows to find an array item from its data in a constant time
+*/
+typedef struct
+{
+    size_t* m_pSlot; // item index + 1 for each slot, 0 if the slot is empty
+    size_t  m_Count; // slot count, always a power of 2
+} CSR_ArrayIndex;
+
 /**
 * Array
 */
@@ -72,6 +81,8 @@ typedef struct
 {
     CSR_ArrayItem* m_pItem;
     size_t         m_Count;
+    size_t         m_Capacity; // allocated item count
+    CSR_ArrayIndex m_Index;    // optional data index, see csrArrayEnableIndex()
 } CSR_Array;
 
 /**
@@ -226,6 +237,26 @@ typedef struct
         */
         void csrArrayInit(CSR_Array* pArray);
 
+        /**
+        * Reserves enough memory in an array to contain a given number of items
+        *@param count - total number of items the array should be able to contain
+        *@param[in, out] pArray - array for which the memory should be reserved
+        *@return 1 on success, otherwise 0
+        *@note The memory is never shrunk, nothing happens if the array is already large enough
+        */
+        int csrArrayReserve(size_t count, CSR_Array* pArray);
+
+        /**
+        * Enables the data index on an array
+        *@param[in, out] pArray - array for which the index should be enabled
+        *@return 1 on success, otherwise 0
+        *@note Once enabled, the items are found from their data in a constant time, which makes
+        *      csrArrayAddUnique(), csrArrayGetIndex() and csrArrayDelete() efficient on large arrays
+        *@note BE CAREFUL, on an indexed array the deleted item is replaced by the last one, so the
+        *      item order isn't kept after a deletion
+        */
+        int csrArrayEnableIndex(CSR_Array* pArray);
+
         /**
         * Adds a data to an array
         *@param pData - data to add
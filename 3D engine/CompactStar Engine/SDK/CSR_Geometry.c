@@ -25,6 +25,14 @@
     #include <math.h>
 #endif
 
+// vectorized math kernels, if available on the target platform
+#if defined(_OS_IOS_) || defined(_OS_ANDROID_) || defined(_OS_WINDOWS_) || defined(CSR_GEOMETRY_NO_SIMD)
+    // the values are processed one by one
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define CSR_GEOMETRY_SSE2
+#endif
+
 //---------------------------------------------------------------------------
 // 2D vector functions
 //---------------------------------------------------------------------------
@@ -242,6 +250,91 @@ void csrVec3Normalize(const CSR_Vector3* pV, CSR_Vector3* pR)
     pR->m_Z = (pV->m_Z / len);
 }
 //---------------------------------------------------------------------------
+#ifdef CSR_GEOMETRY_SSE2
+    void csrVec3NormalizeBatch(const float* pV,
+                                     size_t vStride,
+                                     size_t count,
+                                     float* pR,
+                                     size_t rStride)
+    {
+        size_t       i;
+        size_t       j;
+        float        x[4];
+        float        y[4];
+        float        z[4];
+        const float* pSrc[4];
+        __m128       vx;
+        __m128       vy;
+        __m128       vz;
+        __m128       len;
+        __m128       valid;
+        CSR_Vector3  v;
+
+        const __m128 zero = _mm_setzero_ps();
+
+        // normalize the vectors 4 by 4
+        for (i = 0; i + 4 <= count; i += 4)
+        {
+            for (j = 0; j < 4; ++j)
+                pSrc[j] = &pV[(i + j) * vStride];
+
+            vx = _mm_set_ps(pSrc[3][0], pSrc[2][0], pSrc[1][0], pSrc[0][0]);
+            vy = _mm_set_ps(pSrc[3][1], pSrc[2][1], pSrc[1][1], pSrc[0][1]);
+            vz = _mm_set_ps(pSrc[3][2], pSrc[2][2], pSrc[1][2], pSrc[0][2]);
+
+            // calculate the vector lengths
+            len = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(vx, vx),
+                                                    _mm_mul_ps(vy, vy)),
+                                                    _mm_mul_ps(vz, vz)));
+
+            // the vectors without length are set to 0
+            valid = _mm_cmpneq_ps(len, zero);
+
+            _mm_storeu_ps(x, _mm_and_ps(_mm_div_ps(vx, len), valid));
+            _mm_storeu_ps(y, _mm_and_ps(_mm_div_ps(vy, len), valid));
+            _mm_storeu_ps(z, _mm_and_ps(_mm_div_ps(vz, len), valid));
+
+            for (j = 0; j < 4; ++j)
+            {
+                float* pDst = &pR[(i + j) * rStride];
+
+                pDst[0] = x[j];
+                pDst[1] = y[j];
+                pDst[2] = z[j];
+            }
+        }
+
+        // normalize the remaining vectors
+        for (; i < count; ++i)
+        {
+            v.m_X = pV[i * vStride];
+            v.m_Y = pV[i * vStride + 1];
+            v.m_Z = pV[i * vStride + 2];
+
+            csrVec3Normalize(&v, (CSR_Vector3*)&pR[i * rStride]);
+        }
+    }
+#else
+    void csrVec3NormalizeBatch(const float* pV,
+                                     size_t vStride,
+                                     size_t count,
+                                     float* pR,
+                                     size_t rStride)
+    {
+        size_t      i;
+        CSR_Vector3 v;
+
+        for (i = 0; i < count; ++i)
+        {
+            v.m_X = pV[i * vStride];
+            v.m_Y = pV[i * vStride + 1];
+            v.m_Z = pV[i * vStride + 2];
+
+            csrVec3Normalize(&v, (CSR_Vector3*)&pR[i * rStride]);
+        }
+    }
+#endif
+//---------------------------------------------------------------------------
 void csrVec3Cross(const CSR_Vector3* pV1, const CSR_Vector3* pV2, CSR_Vector3* pR)
 {
     pR->m_X = (pV1->m_Y * pV2->m_Z) - (pV2->m_Y * pV1->m_Z);
@@ -441,17 +534,55 @@ void csrMat4Scale(const CSR_Vector3* pFactor, CSR_Matrix4* pR)
     pR->m_Table[0][3] *= pFactor->m_X; pR->m_Table[1][3] *= pFactor->m_Y; pR->m_Table[2][3] *= pFactor->m_Z;
 }
 //---------------------------------------------------------------------------
-void csrMat4Multiply(const CSR_Matrix4* pM1, const CSR_Matrix4* pM2, CSR_Matrix4* pR)
+#ifdef CSR_GEOMETRY_SSE2
+    void csrMat4Multiply(const CSR_Matrix4* pM1, const CSR_Matrix4* pM2, CSR_Matrix4* pR)
+    {
+        int    i;
+        __m128 row[4];
+
+        const __m128 m2Row0 = _mm_loadu_ps(pM2->m_Table[0]);
+        const __m128 m2Row1 = _mm_loadu_ps(pM2->m_Table[1]);
+        const __m128 m2Row2 = _mm_loadu_ps(pM2->m_Table[2]);
+        const __m128 m2Row3 = _mm_loadu_ps(pM2->m_Table[3]);
+
+        // each result row is the sum of the second matrix rows, weighted by the first matrix row.
+        // NOTE the values are added in the same order as the scalar version, thus the results match
+        for (i = 0; i < 4; ++i)
+        {
+            row[i] =                    _mm_mul_ps(_mm_set1_ps(pM1->m_Table[i][0]), m2Row0);
+            row[i] = _mm_add_ps(row[i], _mm_mul_ps(_mm_set1_ps(pM1->m_Table[i][1]), m2Row1));
+            row[i] = _mm_add_ps(row[i], _mm_mul_ps(_mm_set1_ps(pM1->m_Table[i][2]), m2Row2));
+            row[i] = _mm_add_ps(row[i], _mm_mul_ps(_mm_set1_ps(pM1->m_Table[i][3]), m2Row3));
+        }
+
+        // write the result once all the rows are calculated, thus it may be one of the source matrices
+        for (i = 0; i < 4; ++i)
+            _mm_storeu_ps(pR->m_Table[i], row[i]);
+    }
+#else
+    void csrMat4Multiply(const CSR_Matrix4* pM1, const CSR_Matrix4* pM2, CSR_Matrix4* pR)
+    {
+        int i;
+        int j;
+
+        for (i = 0; i < 4; ++i)
+            for (j = 0; j < 4; ++j)
+                pR->m_Table[i][j] = pM1->m_Table[i][0] * pM2->m_Table[0][j] +
+                                    pM1->m_Table[i][1] * pM2->m_Table[1][j] +
+                                    pM1->m_Table[i][2] * pM2->m_Table[2][j] +
+                                    pM1->m_Table[i][3] * pM2->m_Table[3][j];
+    }
+#endif
+//---------------------------------------------------------------------------
+void csrMat4MultiplyBatch(const CSR_Matrix4* pM1,
+                          const CSR_Matrix4* pM2,
+                                size_t       count,
+                                CSR_Matrix4* pR)
 {
-    int i;
-    int j;
+    size_t i;
 
-    for (i = 0; i < 4; ++i)
-        for (j = 0; j < 4; ++j)
-            pR->m_Table[i][j] = pM1->m_Table[i][0] * pM2->m_Table[0][j] +
-                                pM1->m_Table[i][1] * pM2->m_Table[1][j] +
-                                pM1->m_Table[i][2] * pM2->m_Table[2][j] +
-                                pM1->m_Table[i][3] * pM2->m_Table[3][j];
+    for (i = 0; i < count; ++i)
+        csrMat4Multiply(&pM1[i], &pM2[i], &pR[i]);
 }
 //---------------------------------------------------------------------------
 void csrMat4Transpose(const CSR_Matrix4* pM, CSR_Matrix4* pR)
@@ -464,92 +595,258 @@ void csrMat4Transpose(const CSR_Matrix4* pM, CSR_Matrix4* pR)
             pR->m_Table[j][i] = pM->m_Table[i][j];
 }
 //---------------------------------------------------------------------------
-void csrMat4Inverse(const CSR_Matrix4* pM, CSR_Matrix4* pR, float* pDeterminant)
-{
-    #ifdef _MSC_VER
-        float invDet;
-        float t[3]  = {0};
-        float v[16] = {0};
-        int   i;
-        int   j;
-    #else
-        float invDet;
-        float t[3];
-        float v[16];
-        int   i;
-        int   j;
-    #endif
+#ifdef CSR_GEOMETRY_SSE2
+    __m128 csrMat2MultiplySSE2(__m128 m1, __m128 m2)
+    {
+        // 2x2 row major matrices multiplication m1 * m2
+        return _mm_add_ps(_mm_mul_ps(m1, _mm_shuffle_ps(m2, m2, _MM_SHUFFLE(3, 0, 3, 0))),
+                          _mm_mul_ps(_mm_shuffle_ps(m1, m1, _MM_SHUFFLE(2, 3, 0, 1)),
+                                     _mm_shuffle_ps(m2, m2, _MM_SHUFFLE(1, 2, 1, 2))));
+    }
+    //---------------------------------------------------------------------------
+    __m128 csrMat2AdjMultiplySSE2(__m128 m1, __m128 m2)
+    {
+        // 2x2 row major matrices multiplication adj(m1) * m2
+        return _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(m1, m1, _MM_SHUFFLE(0, 0, 3, 3)), m2),
+                          _mm_mul_ps(_mm_shuffle_ps(m1, m1, _MM_SHUFFLE(2, 2, 1, 1)),
+                                     _mm_shuffle_ps(m2, m2, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+    //---------------------------------------------------------------------------
+    __m128 csrMat2MultiplyAdjSSE2(__m128 m1, __m128 m2)
+    {
+        // 2x2 row major matrices multiplication m1 * adj(m2)
+        return _mm_sub_ps(_mm_mul_ps(m1, _mm_shuffle_ps(m2, m2, _MM_SHUFFLE(0, 3, 0, 3))),
+                          _mm_mul_ps(_mm_shuffle_ps(m1, m1, _MM_SHUFFLE(2, 3, 0, 1)),
+                                     _mm_shuffle_ps(m2, m2, _MM_SHUFFLE(1, 2, 1, 2))));
+    }
+    //---------------------------------------------------------------------------
+    void csrMat4Inverse(const CSR_Matrix4* pM, CSR_Matrix4* pR, float* pDeterminant)
+    {
+        __m128 a;
+        __m128 b;
+        __m128 c;
+        __m128 d;
+        __m128 detSub;
+        __m128 detA;
+        __m128 detB;
+        __m128 detC;
+        __m128 detD;
+        __m128 detM;
+        __m128 adjDC;
+        __m128 adjAB;
+        __m128 x;
+        __m128 y;
+        __m128 z;
+        __m128 w;
+        __m128 trace;
+        __m128 invDet;
+
+        const __m128 row0 = _mm_loadu_ps(pM->m_Table[0]);
+        const __m128 row1 = _mm_loadu_ps(pM->m_Table[1]);
+        const __m128 row2 = _mm_loadu_ps(pM->m_Table[2]);
+        const __m128 row3 = _mm_loadu_ps(pM->m_Table[3]);
+
+        // split the matrix in 4 2x2 sub-matrices, | A B |
+        //                                         | C D |
+        a = _mm_movelh_ps(row0, row1);
+        b = _mm_movehl_ps(row1, row0);
+        c = _mm_movelh_ps(row2, row3);
+        d = _mm_movehl_ps(row3, row2);
+
+        // calculate the sub-matrices determinants, as (|A|, |B|, |C|, |D|)
+        detSub = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(2, 0, 2, 0)),
+                                       _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(3, 1, 3, 1))),
+                            _mm_mul_ps(_mm_shuffle_ps(row0, row2, _MM_SHUFFLE(3, 1, 3, 1)),
+                                       _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(2, 0, 2, 0))));
+
+        detA = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(0, 0, 0, 0));
+        detB = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(1, 1, 1, 1));
+        detC = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(2, 2, 2, 2));
+        detD = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(3, 3, 3, 3));
+
+        adjDC = csrMat2AdjMultiplySSE2(d, c);
+        adjAB = csrMat2AdjMultiplySSE2(a, b);
+
+        // calculate the adjugates of the inverted matrix sub-matrices, | X Y |
+        //                                                              | Z W |
+        x = _mm_sub_ps(_mm_mul_ps(detD, a), csrMat2MultiplySSE2(b, adjDC));
+        w = _mm_sub_ps(_mm_mul_ps(detA, d), csrMat2MultiplySSE2(c, adjAB));
+        y = _mm_sub_ps(_mm_mul_ps(detB, c), csrMat2MultiplyAdjSSE2(d, adjAB));
+        z = _mm_sub_ps(_mm_mul_ps(detC, b), csrMat2MultiplyAdjSSE2(a, adjDC));
+
+        // calculate the trace of adj(A) * B * adj(D) * C
+        trace = _mm_mul_ps(adjAB, _mm_shuffle_ps(adjDC, adjDC, _MM_SHUFFLE(3, 1, 2, 0)));
+        trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(2, 3, 0, 1)));
+        trace = _mm_add_ps(trace, _mm_shuffle_ps(trace, trace, _MM_SHUFFLE(1, 0, 3, 2)));
+
+        // calculate the matrix determinant, as |A| * |D| + |B| * |C| - trace
+        detM = _mm_sub_ps(_mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC)), trace);
+
+        *pDeterminant = _mm_cvtss_f32(detM);
+
+        if (*pDeterminant == 0.0)
+            return;
+
+        // the adjugates signs are applied along with the determinant inversion
+        invDet = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+
+        x = _mm_mul_ps(x, invDet);
+        y = _mm_mul_ps(y, invDet);
+        z = _mm_mul_ps(z, invDet);
+        w = _mm_mul_ps(w, invDet);
+
+        // get the sub-matrices adjugates back and assemble the inverted matrix
+        _mm_storeu_ps(pR->m_Table[0], _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+        _mm_storeu_ps(pR->m_Table[1], _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+        _mm_storeu_ps(pR->m_Table[2], _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+        _mm_storeu_ps(pR->m_Table[3], _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+    }
+#else
+    void csrMat4Inverse(const CSR_Matrix4* pM, CSR_Matrix4* pR, float* pDeterminant)
+    {
+        #ifdef _MSC_VER
+            float invDet;
+            float t[3]  = {0};
+            float v[16] = {0};
+            int   i;
+            int   j;
+        #else
+            float invDet;
+            float t[3];
+            float v[16];
+            int   i;
+            int   j;
+        #endif
 
-    t[0] = pM->m_Table[2][2] * pM->m_Table[3][3] - pM->m_Table[2][3] * pM->m_Table[3][2];
-    t[1] = pM->m_Table[1][2] * pM->m_Table[3][3] - pM->m_Table[1][3] * pM->m_Table[3][2];
-    t[2] = pM->m_Table[1][2] * pM->m_Table[2][3] - pM->m_Table[1][3] * pM->m_Table[2][2];
+        t[0] = pM->m_Table[2][2] * pM->m_Table[3][3] - pM->m_Table[2][3] * pM->m_Table[3][2];
+        t[1] = pM->m_Table[1][2] * pM->m_Table[3][3] - pM->m_Table[1][3] * pM->m_Table[3][2];
+        t[2] = pM->m_Table[1][2] * pM->m_Table[2][3] - pM->m_Table[1][3] * pM->m_Table[2][2];
 
-    v[0] =  pM->m_Table[1][1] * t[0] - pM->m_Table[2][1] * t[1] + pM->m_Table[3][1] * t[2];
-    v[4] = -pM->m_Table[1][0] * t[0] + pM->m_Table[2][0] * t[1] - pM->m_Table[3][0] * t[2];
+        v[0] =  pM->m_Table[1][1] * t[0] - pM->m_Table[2][1] * t[1] + pM->m_Table[3][1] * t[2];
+        v[4] = -pM->m_Table[1][0] * t[0] + pM->m_Table[2][0] * t[1] - pM->m_Table[3][0] * t[2];
 
-    t[0] =  pM->m_Table[1][0] * pM->m_Table[2][1] - pM->m_Table[2][0] * pM->m_Table[1][1];
-    t[1] =  pM->m_Table[1][0] * pM->m_Table[3][1] - pM->m_Table[3][0] * pM->m_Table[1][1];
-    t[2] =  pM->m_Table[2][0] * pM->m_Table[3][1] - pM->m_Table[3][0] * pM->m_Table[2][1];
+        t[0] =  pM->m_Table[1][0] * pM->m_Table[2][1] - pM->m_Table[2][0] * pM->m_Table[1][1];
+        t[1] =  pM->m_Table[1][0] * pM->m_Table[3][1] - pM->m_Table[3][0] * pM->m_Table[1][1];
+        t[2] =  pM->m_Table[2][0] * pM->m_Table[3][1] - pM->m_Table[3][0] * pM->m_Table[2][1];
 
-    v[8]  =  pM->m_Table[3][3] * t[0] - pM->m_Table[2][3] * t[1] + pM->m_Table[1][3] * t[2];
-    v[12] = -pM->m_Table[3][2] * t[0] + pM->m_Table[2][2] * t[1] - pM->m_Table[1][2] * t[2];
+        v[8]  =  pM->m_Table[3][3] * t[0] - pM->m_Table[2][3] * t[1] + pM->m_Table[1][3] * t[2];
+        v[12] = -pM->m_Table[3][2] * t[0] + pM->m_Table[2][2] * t[1] - pM->m_Table[1][2] * t[2];
 
-    *pDeterminant = pM->m_Table[0][0] * v[0] +
-                    pM->m_Table[0][1] * v[4] +
-                    pM->m_Table[0][2] * v[8] +
-                    pM->m_Table[0][3] * v[12];
+        *pDeterminant = pM->m_Table[0][0] * v[0] +
+                        pM->m_Table[0][1] * v[4] +
+                        pM->m_Table[0][2] * v[8] +
+                        pM->m_Table[0][3] * v[12];
 
-    if (*pDeterminant == 0.0)
-        return;
+        if (*pDeterminant == 0.0)
+            return;
+
+        t[0] = pM->m_Table[2][2] * pM->m_Table[3][3] - pM->m_Table[2][3] * pM->m_Table[3][2];
+        t[1] = pM->m_Table[0][2] * pM->m_Table[3][3] - pM->m_Table[0][3] * pM->m_Table[3][2];
+        t[2] = pM->m_Table[0][2] * pM->m_Table[2][3] - pM->m_Table[0][3] * pM->m_Table[2][2];
 
-    t[0] = pM->m_Table[2][2] * pM->m_Table[3][3] - pM->m_Table[2][3] * pM->m_Table[3][2];
-    t[1] = pM->m_Table[0][2] * pM->m_Table[3][3] - pM->m_Table[0][3] * pM->m_Table[3][2];
-    t[2] = pM->m_Table[0][2] * pM->m_Table[2][3] - pM->m_Table[0][3] * pM->m_Table[2][2];
+        v[1] = -pM->m_Table[0][1] * t[0] + pM->m_Table[2][1] * t[1] - pM->m_Table[3][1] * t[2];
+        v[5] =  pM->m_Table[0][0] * t[0] - pM->m_Table[2][0] * t[1] + pM->m_Table[3][0] * t[2];
 
-    v[1] = -pM->m_Table[0][1] * t[0] + pM->m_Table[2][1] * t[1] - pM->m_Table[3][1] * t[2];
-    v[5] =  pM->m_Table[0][0] * t[0] - pM->m_Table[2][0] * t[1] + pM->m_Table[3][0] * t[2];
+        t[0] = pM->m_Table[0][0] * pM->m_Table[2][1] - pM->m_Table[2][0] * pM->m_Table[0][1];
+        t[1] = pM->m_Table[3][0] * pM->m_Table[0][1] - pM->m_Table[0][0] * pM->m_Table[3][1];
+        t[2] = pM->m_Table[2][0] * pM->m_Table[3][1] - pM->m_Table[3][0] * pM->m_Table[2][1];
 
-    t[0] = pM->m_Table[0][0] * pM->m_Table[2][1] - pM->m_Table[2][0] * pM->m_Table[0][1];
-    t[1] = pM->m_Table[3][0] * pM->m_Table[0][1] - pM->m_Table[0][0] * pM->m_Table[3][1];
-    t[2] = pM->m_Table[2][0] * pM->m_Table[3][1] - pM->m_Table[3][0] * pM->m_Table[2][1];
+        v[9]  = -pM->m_Table[3][3] * t[0] - pM->m_Table[2][3] * t[1] - pM->m_Table[0][3] * t[2];
+        v[13] =  pM->m_Table[3][2] * t[0] + pM->m_Table[2][2] * t[1] + pM->m_Table[0][2] * t[2];
 
-    v[9]  = -pM->m_Table[3][3] * t[0] - pM->m_Table[2][3] * t[1] - pM->m_Table[0][3] * t[2];
-    v[13] =  pM->m_Table[3][2] * t[0] + pM->m_Table[2][2] * t[1] + pM->m_Table[0][2] * t[2];
+        t[0] = pM->m_Table[1][2] * pM->m_Table[3][3] - pM->m_Table[1][3] * pM->m_Table[3][2];
+        t[1] = pM->m_Table[0][2] * pM->m_Table[3][3] - pM->m_Table[0][3] * pM->m_Table[3][2];
+        t[2] = pM->m_Table[0][2] * pM->m_Table[1][3] - pM->m_Table[0][3] * pM->m_Table[1][2];
 
-    t[0] = pM->m_Table[1][2] * pM->m_Table[3][3] - pM->m_Table[1][3] * pM->m_Table[3][2];
-    t[1] = pM->m_Table[0][2] * pM->m_Table[3][3] - pM->m_Table[0][3] * pM->m_Table[3][2];
-    t[2] = pM->m_Table[0][2] * pM->m_Table[1][3] - pM->m_Table[0][3] * pM->m_Table[1][2];
+        v[2] =  pM->m_Table[0][1] * t[0] - pM->m_Table[1][1] * t[1] + pM->m_Table[3][1] * t[2];
+        v[6] = -pM->m_Table[0][0] * t[0] + pM->m_Table[1][0] * t[1] - pM->m_Table[3][0] * t[2];
 
-    v[2] =  pM->m_Table[0][1] * t[0] - pM->m_Table[1][1] * t[1] + pM->m_Table[3][1] * t[2];
-    v[6] = -pM->m_Table[0][0] * t[0] + pM->m_Table[1][0] * t[1] - pM->m_Table[3][0] * t[2];
+        t[0] = pM->m_Table[0][0] * pM->m_Table[1][1] - pM->m_Table[1][0] * pM->m_Table[0][1];
+        t[1] = pM->m_Table[3][0] * pM->m_Table[0][1] - pM->m_Table[0][0] * pM->m_Table[3][1];
+        t[2] = pM->m_Table[1][0] * pM->m_Table[3][1] - pM->m_Table[3][0] * pM->m_Table[1][1];
 
-    t[0] = pM->m_Table[0][0] * pM->m_Table[1][1] - pM->m_Table[1][0] * pM->m_Table[0][1];
-    t[1] = pM->m_Table[3][0] * pM->m_Table[0][1] - pM->m_Table[0][0] * pM->m_Table[3][1];
-    t[2] = pM->m_Table[1][0] * pM->m_Table[3][1] - pM->m_Table[3][0] * pM->m_Table[1][1];
+        v[10] =  pM->m_Table[3][3] * t[0] + pM->m_Table[1][3] * t[1] + pM->m_Table[0][3] * t[2];
+        v[14] = -pM->m_Table[3][2] * t[0] - pM->m_Table[1][2] * t[1] - pM->m_Table[0][2] * t[2];
 
-    v[10] =  pM->m_Table[3][3] * t[0] + pM->m_Table[1][3] * t[1] + pM->m_Table[0][3] * t[2];
-    v[14] = -pM->m_Table[3][2] * t[0] - pM->m_Table[1][2] * t[1] - pM->m_Table[0][2] * t[2];
+        t[0] = pM->m_Table[1][2] * pM->m_Table[2][3] - pM->m_Table[1][3] * pM->m_Table[2][2];
+        t[1] = pM->m_Table[0][2] * pM->m_Table[2][3] - pM->m_Table[0][3] * pM->m_Table[2][2];
+        t[2] = pM->m_Table[0][2] * pM->m_Table[1][3] - pM->m_Table[0][3] * pM->m_Table[1][2];
 
-    t[0] = pM->m_Table[1][2] * pM->m_Table[2][3] - pM->m_Table[1][3] * pM->m_Table[2][2];
-    t[1] = pM->m_Table[0][2] * pM->m_Table[2][3] - pM->m_Table[0][3] * pM->m_Table[2][2];
-    t[2] = pM->m_Table[0][2] * pM->m_Table[1][3] - pM->m_Table[0][3] * pM->m_Table[1][2];
+        v[3] = -pM->m_Table[0][1] * t[0] + pM->m_Table[1][1] * t[1] - pM->m_Table[2][1] * t[2];
+        v[7] =  pM->m_Table[0][0] * t[0] - pM->m_Table[1][0] * t[1] + pM->m_Table[2][0] * t[2];
 
-    v[3] = -pM->m_Table[0][1] * t[0] + pM->m_Table[1][1] * t[1] - pM->m_Table[2][1] * t[2];
-    v[7] =  pM->m_Table[0][0] * t[0] - pM->m_Table[1][0] * t[1] + pM->m_Table[2][0] * t[2];
+        v[11] = -pM->m_Table[0][0] * (pM->m_Table[1][1] * pM->m_Table[2][3] - pM->m_Table[1][3] * pM->m_Table[2][1]) +
+                 pM->m_Table[1][0] * (pM->m_Table[0][1] * pM->m_Table[2][3] - pM->m_Table[0][3] * pM->m_Table[2][1]) -
+                 pM->m_Table[2][0] * (pM->m_Table[0][1] * pM->m_Table[1][3] - pM->m_Table[0][3] * pM->m_Table[1][1]);
 
-    v[11] = -pM->m_Table[0][0] * (pM->m_Table[1][1] * pM->m_Table[2][3] - pM->m_Table[1][3] * pM->m_Table[2][1]) +
-             pM->m_Table[1][0] * (pM->m_Table[0][1] * pM->m_Table[2][3] - pM->m_Table[0][3] * pM->m_Table[2][1]) -
-             pM->m_Table[2][0] * (pM->m_Table[0][1] * pM->m_Table[1][3] - pM->m_Table[0][3] * pM->m_Table[1][1]);
+        v[15] = pM->m_Table[0][0] * (pM->m_Table[1][1] * pM->m_Table[2][2] - pM->m_Table[1][2] * pM->m_Table[2][1]) -
+                pM->m_Table[1][0] * (pM->m_Table[0][1] * pM->m_Table[2][2] - pM->m_Table[0][2] * pM->m_Table[2][1]) +
+                pM->m_Table[2][0] * (pM->m_Table[0][1] * pM->m_Table[1][2] - pM->m_Table[0][2] * pM->m_Table[1][1]);
 
-    v[15] = pM->m_Table[0][0] * (pM->m_Table[1][1] * pM->m_Table[2][2] - pM->m_Table[1][2] * pM->m_Table[2][1]) -
-            pM->m_Table[1][0] * (pM->m_Table[0][1] * pM->m_Table[2][2] - pM->m_Table[0][2] * pM->m_Table[2][1]) +
-            pM->m_Table[2][0] * (pM->m_Table[0][1] * pM->m_Table[1][2] - pM->m_Table[0][2] * pM->m_Table[1][1]);
+        invDet = 1.0f / *pDeterminant;
+
+        for (i = 0; i < 4; ++i)
+            for (j = 0; j < 4; ++j)
+                pR->m_Table[i][j] = v[4 * i + j] * invDet;
+    }
+#endif
+//---------------------------------------------------------------------------
+void csrMat4InverseAffine(const CSR_Matrix4* pM, CSR_Matrix4* pR, float* pDeterminant)
+{
+    #ifdef _MSC_VER
+        float invDet;
+        float t[3] = {0};
+        float v[9] = {0};
+        int   i;
+    #else
+        float invDet;
+        float t[3];
+        float v[9];
+        int   i;
+    #endif
+
+    // calculate the cofactors of the first row of the 3x3 rotation and scaling part
+    v[0] = pM->m_Table[1][1] * pM->m_Table[2][2] - pM->m_Table[1][2] * pM->m_Table[2][1];
+    v[3] = pM->m_Table[1][2] * pM->m_Table[2][0] - pM->m_Table[1][0] * pM->m_Table[2][2];
+    v[6] = pM->m_Table[1][0] * pM->m_Table[2][1] - pM->m_Table[1][1] * pM->m_Table[2][0];
+
+    *pDeterminant = pM->m_Table[0][0] * v[0] +
+                    pM->m_Table[0][1] * v[3] +
+                    pM->m_Table[0][2] * v[6];
+
+    if (*pDeterminant == 0.0)
+        return;
+
+    // calculate the remaining cofactors
+    v[1] = pM->m_Table[0][2] * pM->m_Table[2][1] - pM->m_Table[0][1] * pM->m_Table[2][2];
+    v[4] = pM->m_Table[0][0] * pM->m_Table[2][2] - pM->m_Table[0][2] * pM->m_Table[2][0];
+    v[7] = pM->m_Table[0][1] * pM->m_Table[2][0] - pM->m_Table[0][0] * pM->m_Table[2][1];
+    v[2] = pM->m_Table[0][1] * pM->m_Table[1][2] - pM->m_Table[0][2] * pM->m_Table[1][1];
+    v[5] = pM->m_Table[0][2] * pM->m_Table[1][0] - pM->m_Table[0][0] * pM->m_Table[1][2];
+    v[8] = pM->m_Table[0][0] * pM->m_Table[1][1] - pM->m_Table[0][1] * pM->m_Table[1][0];
 
     invDet = 1.0f / *pDeterminant;
 
-    for (i = 0; i < 4; ++i)
-        for (j = 0; j < 4; ++j)
-            pR->m_Table[i][j] = v[4 * i + j] * invDet;
+    for (i = 0; i < 9; ++i)
+        v[i] *= invDet;
+
+    // the translation is inverted by applying the inverted 3x3 part to the opposite translation
+    t[0] = -(pM->m_Table[3][0] * v[0] + pM->m_Table[3][1] * v[3] + pM->m_Table[3][2] * v[6]);
+    t[1] = -(pM->m_Table[3][0] * v[1] + pM->m_Table[3][1] * v[4] + pM->m_Table[3][2] * v[7]);
+    t[2] = -(pM->m_Table[3][0] * v[2] + pM->m_Table[3][1] * v[5] + pM->m_Table[3][2] * v[8]);
+
+    pR->m_Table[3][0] = t[0];
+    pR->m_Table[3][1] = t[1];
+    pR->m_Table[3][2] = t[2];
+    pR->m_Table[3][3] = 1.0f;
+
+    for (i = 0; i < 3; ++i)
+    {
+        pR->m_Table[i][0] = v[i * 3];
+        pR->m_Table[i][1] = v[i * 3 + 1];
+        pR->m_Table[i][2] = v[i * 3 + 2];
+        pR->m_Table[i][3] = 0.0f;
+    }
 }
 //---------------------------------------------------------------------------
 void csrMat4ApplyToVector(const CSR_Matrix4* pM, const CSR_Vector3* pV, CSR_Vector3* pR)
@@ -586,6 +883,165 @@ void csrMat4Transform(const CSR_Matrix4* pM, const CSR_Vector3* pV, CSR_Vector3*
     pR->m_Z /= w;
 }
 //---------------------------------------------------------------------------
+#ifdef CSR_GEOMETRY_SSE2
+    void csrMat4ApplyToVectorBatch(const CSR_Matrix4* pM,
+                                   const float*       pV,
+                                         size_t       vStride,
+                                         size_t       count,
+                                         float*       pR,
+                                         size_t       rStride)
+    {
+        size_t i;
+        __m128 r;
+
+        const __m128 row0 = _mm_loadu_ps(pM->m_Table[0]);
+        const __m128 row1 = _mm_loadu_ps(pM->m_Table[1]);
+        const __m128 row2 = _mm_loadu_ps(pM->m_Table[2]);
+        const __m128 row3 = _mm_loadu_ps(pM->m_Table[3]);
+
+        for (i = 0; i < count; ++i)
+        {
+            const float* pSrc = &pV[i * vStride];
+                  float* pDst = &pR[i * rStride];
+
+            r =               _mm_mul_ps(_mm_set1_ps(pSrc[0]), row0);
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pSrc[1]), row1));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pSrc[2]), row2));
+            r = _mm_add_ps(r, row3);
+
+            // write the x, y and z values only, the destination may contain other vertex data
+            _mm_storel_pi((__m64*)pDst, r);
+            _mm_store_ss(&pDst[2], _mm_movehl_ps(r, r));
+        }
+    }
+    //---------------------------------------------------------------------------
+    void csrMat4ApplyToNormalBatch(const CSR_Matrix4* pM,
+                                   const float*       pN,
+                                         size_t       nStride,
+                                         size_t       count,
+                                         float*       pR,
+                                         size_t       rStride)
+    {
+        size_t i;
+        __m128 r;
+
+        const __m128 row0 = _mm_loadu_ps(pM->m_Table[0]);
+        const __m128 row1 = _mm_loadu_ps(pM->m_Table[1]);
+        const __m128 row2 = _mm_loadu_ps(pM->m_Table[2]);
+
+        for (i = 0; i < count; ++i)
+        {
+            const float* pSrc = &pN[i * nStride];
+                  float* pDst = &pR[i * rStride];
+
+            r =               _mm_mul_ps(_mm_set1_ps(pSrc[0]), row0);
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pSrc[1]), row1));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pSrc[2]), row2));
+
+            _mm_storel_pi((__m64*)pDst, r);
+            _mm_store_ss(&pDst[2], _mm_movehl_ps(r, r));
+        }
+    }
+    //---------------------------------------------------------------------------
+    void csrMat4TransformBatch(const CSR_Matrix4* pM,
+                               const float*       pV,
+                                     size_t       vStride,
+                                     size_t       count,
+                                     float*       pR,
+                                     size_t       rStride)
+    {
+        size_t i;
+        float  w;
+        __m128 r;
+
+        const __m128 row0 = _mm_loadu_ps(pM->m_Table[0]);
+        const __m128 row1 = _mm_loadu_ps(pM->m_Table[1]);
+        const __m128 row2 = _mm_loadu_ps(pM->m_Table[2]);
+        const __m128 row3 = _mm_loadu_ps(pM->m_Table[3]);
+
+        for (i = 0; i < count; ++i)
+        {
+            const float* pSrc = &pV[i * vStride];
+                  float* pDst = &pR[i * rStride];
+
+            // the amplitude is calculated in the 4th value, along with the vector
+            r =               _mm_mul_ps(_mm_set1_ps(pSrc[0]), row0);
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pSrc[1]), row1));
+            r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(pSrc[2]), row2));
+            r = _mm_add_ps(r, row3);
+
+            w = _mm_cvtss_f32(_mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3)));
+
+            // should not happen, unless the matrix is wrong
+            if (w)
+                r = _mm_div_ps(r, _mm_set1_ps(w));
+
+            _mm_storel_pi((__m64*)pDst, r);
+            _mm_store_ss(&pDst[2], _mm_movehl_ps(r, r));
+        }
+    }
+#else
+    void csrMat4ApplyToVectorBatch(const CSR_Matrix4* pM,
+                                   const float*       pV,
+                                         size_t       vStride,
+                                         size_t       count,
+                                         float*       pR,
+                                         size_t       rStride)
+    {
+        size_t      i;
+        CSR_Vector3 v;
+
+        for (i = 0; i < count; ++i)
+        {
+            v.m_X = pV[i * vStride];
+            v.m_Y = pV[i * vStride + 1];
+            v.m_Z = pV[i * vStride + 2];
+
+            csrMat4ApplyToVector(pM, &v, (CSR_Vector3*)&pR[i * rStride]);
+        }
+    }
+    //---------------------------------------------------------------------------
+    void csrMat4ApplyToNormalBatch(const CSR_Matrix4* pM,
+                                   const float*       pN,
+                                         size_t       nStride,
+                                         size_t       count,
+                                         float*       pR,
+                                         size_t       rStride)
+    {
+        size_t      i;
+        CSR_Vector3 n;
+
+        for (i = 0; i < count; ++i)
+        {
+            n.m_X = pN[i * nStride];
+            n.m_Y = pN[i * nStride + 1];
+            n.m_Z = pN[i * nStride + 2];
+
+            csrMat4ApplyToNormal(pM, &n, (CSR_Vector3*)&pR[i * rStride]);
+        }
+    }
+    //---------------------------------------------------------------------------
+    void csrMat4TransformBatch(const CSR_Matrix4* pM,
+                               const float*       pV,
+                                     size_t       vStride,
+                                     size_t       count,
+                                     float*       pR,
+                                     size_t       rStride)
+    {
+        size_t      i;
+        CSR_Vector3 v;
+
+        for (i = 0; i < count; ++i)
+        {
+            v.m_X = pV[i * vStride];
+            v.m_Y = pV[i * vStride + 1];
+            v.m_Z = pV[i * vStride + 2];
+
+            csrMat4Transform(pM, &v, (CSR_Vector3*)&pR[i * rStride]);
+        }
+    }
+#endif
+//---------------------------------------------------------------------------
 void csrMat4Unproject(const CSR_Matrix4* pP, const CSR_Matrix4* pV, CSR_Ray3* pR)
 {
     float       determinant;
@@ -963,8 +1419,9 @@ int csrQuatFromMatrix(const CSR_Matrix4* pM, CSR_Quaternion* pR)
     // calculate the matrix diagonal by adding up it's diagonal indices (also known as "trace")
     diagonal = pM->m_Table[0][0] + pM->m_Table[1][1] + pM->m_Table[2][2] + pM->m_Table[3][3];
 
-    // is diagonal greater than zero?
-    if (diagonal > 0.00000001f)
+    // is diagonal greater than one? NOTE below this value the quaternion W value becomes too small to
+    // calculate the other values accurately, so the highest value in the diagonal is used instead
+    if (diagonal > 1.0f)
     {
         // calculate the diagonal scale
         scale = sqrtf(diagonal) * 2.0f;
@@ -1609,6 +2066,173 @@ void csrBoxCut(const CSR_Box* pBox, CSR_Box* pLeftBox, CSR_Box* pRightBox)
     }
 }
 //---------------------------------------------------------------------------
+void csrBoxTransform(const CSR_Box* pBox, const CSR_Matrix4* pMatrix, CSR_Box* pR)
+{
+    size_t      i;
+    CSR_Vector3 center;
+    CSR_Vector3 extent;
+    CSR_Vector3 newCenter;
+    float       newExtent[3];
+
+    // validate the inputs
+    if (!pBox || !pMatrix || !pR)
+        return;
+
+    // get the box center and half size
+    center.m_X = (pBox->m_Min.m_X + pBox->m_Max.m_X) * 0.5f;
+    center.m_Y = (pBox->m_Min.m_Y + pBox->m_Max.m_Y) * 0.5f;
+    center.m_Z = (pBox->m_Min.m_Z + pBox->m_Max.m_Z) * 0.5f;
+    extent.m_X = (pBox->m_Max.m_X - pBox->m_Min.m_X) * 0.5f;
+    extent.m_Y = (pBox->m_Max.m_Y - pBox->m_Min.m_Y) * 0.5f;
+    extent.m_Z = (pBox->m_Max.m_Z - pBox->m_Min.m_Z) * 0.5f;
+
+    // transform the center
+    csrMat4ApplyToVector(pMatrix, &center, &newCenter);
+
+    // the new half size on each axis is the sum of the half sizes projected on it, this avoids
+    // to transform the 8 box corners
+    for (i = 0; i < 3; ++i)
+        newExtent[i] = (extent.m_X * (float)fabs(pMatrix->m_Table[0][i])) +
+                       (extent.m_Y * (float)fabs(pMatrix->m_Table[1][i])) +
+                       (extent.m_Z * (float)fabs(pMatrix->m_Table[2][i]));
+
+    pR->m_Min.m_X = newCenter.m_X - newExtent[0];
+    pR->m_Min.m_Y = newCenter.m_Y - newExtent[1];
+    pR->m_Min.m_Z = newCenter.m_Z - newExtent[2];
+    pR->m_Max.m_X = newCenter.m_X + newExtent[0];
+    pR->m_Max.m_Y = newCenter.m_Y + newExtent[1];
+    pR->m_Max.m_Z = newCenter.m_Z + newExtent[2];
+}
+//---------------------------------------------------------------------------
+// Frustum functions
+//---------------------------------------------------------------------------
+void csrFrustumFromMatrix(const CSR_Matrix4* pMatrix, CSR_Frustum* pR)
+{
+    size_t i;
+    size_t axis;
+    float  sign;
+    float  length;
+
+    // a point is inside the frustum if -w <= x, y, z <= w in clip space, where each clip coordinate
+    // is the dot product between the point and a matrix column. Each condition provides a plane
+    for (i = 0; i < 6; ++i)
+    {
+        axis = i >> 1;
+        sign = (i & 1) ? -1.0f : 1.0f;
+
+        pR->m_Plane[i].m_A = pMatrix->m_Table[0][3] + sign * pMatrix->m_Table[0][axis];
+        pR->m_Plane[i].m_B = pMatrix->m_Table[1][3] + sign * pMatrix->m_Table[1][axis];
+        pR->m_Plane[i].m_C = pMatrix->m_Table[2][3] + sign * pMatrix->m_Table[2][axis];
+        pR->m_Plane[i].m_D = pMatrix->m_Table[3][3] + sign * pMatrix->m_Table[3][axis];
+
+        length = sqrtf(pR->m_Plane[i].m_A * pR->m_Plane[i].m_A +
+                       pR->m_Plane[i].m_B * pR->m_Plane[i].m_B +
+                       pR->m_Plane[i].m_C * pR->m_Plane[i].m_C);
+
+        // degenerated plane, e.g. the far plane of an infinite projection? (NOTE in this case the
+        // plane is kept as is, it will accept or reject everything depending on its d value)
+        if (length == 0.0f)
+            continue;
+
+        pR->m_Plane[i].m_A /= length;
+        pR->m_Plane[i].m_B /= length;
+        pR->m_Plane[i].m_C /= length;
+        pR->m_Plane[i].m_D /= length;
+    }
+}
+//---------------------------------------------------------------------------
+int csrFrustumBoxVisible(const CSR_Frustum* pFrustum, const CSR_Box* pBox)
+{
+    size_t           i;
+    const CSR_Plane* pPlane;
+
+    for (i = 0; i < 6; ++i)
+    {
+        pPlane = &pFrustum->m_Plane[i];
+
+        // the box is outside if its corner the most advanced in the plane normal direction is
+        // behind the plane
+        if (pPlane->m_A * (pPlane->m_A >= 0.0f ? pBox->m_Max.m_X : pBox->m_Min.m_X) +
+            pPlane->m_B * (pPlane->m_B >= 0.0f ? pBox->m_Max.m_Y : pBox->m_Min.m_Y) +
+            pPlane->m_C * (pPlane->m_C >= 0.0f ? pBox->m_Max.m_Z : pBox->m_Min.m_Z) +
+            pPlane->m_D < 0.0f)
+            return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+#ifdef CSR_GEOMETRY_SSE2
+    void csrFrustumBoxVisibleBatch(const CSR_Frustum* pFrustum,
+                                   const CSR_Box*     pBoxes,
+                                         size_t       count,
+                                         int*         pR)
+    {
+        size_t           i;
+        size_t           j;
+        int              outside;
+        __m128           minX;
+        __m128           minY;
+        __m128           minZ;
+        __m128           maxX;
+        __m128           maxY;
+        __m128           maxZ;
+        __m128           dist;
+        const CSR_Box*   pBox;
+        const CSR_Plane* pPlane;
+
+        const __m128 zero = _mm_setzero_ps();
+
+        // check the boxes 4 by 4
+        for (i = 0; i + 4 <= count; i += 4)
+        {
+            pBox = &pBoxes[i];
+
+            minX = _mm_set_ps(pBox[3].m_Min.m_X, pBox[2].m_Min.m_X, pBox[1].m_Min.m_X, pBox[0].m_Min.m_X);
+            minY = _mm_set_ps(pBox[3].m_Min.m_Y, pBox[2].m_Min.m_Y, pBox[1].m_Min.m_Y, pBox[0].m_Min.m_Y);
+            minZ = _mm_set_ps(pBox[3].m_Min.m_Z, pBox[2].m_Min.m_Z, pBox[1].m_Min.m_Z, pBox[0].m_Min.m_Z);
+            maxX = _mm_set_ps(pBox[3].m_Max.m_X, pBox[2].m_Max.m_X, pBox[1].m_Max.m_X, pBox[0].m_Max.m_X);
+            maxY = _mm_set_ps(pBox[3].m_Max.m_Y, pBox[2].m_Max.m_Y, pBox[1].m_Max.m_Y, pBox[0].m_Max.m_Y);
+            maxZ = _mm_set_ps(pBox[3].m_Max.m_Z, pBox[2].m_Max.m_Z, pBox[1].m_Max.m_Z, pBox[0].m_Max.m_Z);
+
+            outside = 0;
+
+            // stop as soon as the 4 boxes are outside a plane
+            for (j = 0; j < 6 && outside != 0xF; ++j)
+            {
+                pPlane = &pFrustum->m_Plane[j];
+
+                // the corner the most advanced in the plane normal direction is the same for all
+                // the boxes, thus only the plane sign selects it
+                dist =                  _mm_mul_ps(_mm_set1_ps(pPlane->m_A), pPlane->m_A >= 0.0f ? maxX : minX);
+                dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(pPlane->m_B), pPlane->m_B >= 0.0f ? maxY : minY));
+                dist = _mm_add_ps(dist, _mm_mul_ps(_mm_set1_ps(pPlane->m_C), pPlane->m_C >= 0.0f ? maxZ : minZ));
+                dist = _mm_add_ps(dist, _mm_set1_ps(pPlane->m_D));
+
+                outside |= _mm_movemask_ps(_mm_cmplt_ps(dist, zero));
+            }
+
+            for (j = 0; j < 4; ++j)
+                pR[i + j] = !(outside & (1 << j));
+        }
+
+        // check the remaining boxes
+        for (; i < count; ++i)
+            pR[i] = csrFrustumBoxVisible(pFrustum, &pBoxes[i]);
+    }
+#else
+    void csrFrustumBoxVisibleBatch(const CSR_Frustum* pFrustum,
+                                   const CSR_Box*     pBoxes,
+                                         size_t       count,
+                                         int*         pR)
+    {
+        size_t i;
+
+        for (i = 0; i < count; ++i)
+            pR[i] = csrFrustumBoxVisible(pFrustum, &pBoxes[i]);
+    }
+#endif
+//---------------------------------------------------------------------------
 // Inside checks
 //---------------------------------------------------------------------------
 int csrInsidePolygon2(const CSR_Vector2* pP, const CSR_Polygon2* pPo)
@@ -202,6 +202,14 @@ typedef struct
     CSR_Vector3 m_Max;
 } CSR_Box;
 
+/**
+* View frustum, as the planes delimiting the visible space, their normals pointing inside
+*/
+typedef struct
+{
+    CSR_Plane m_Plane[6]; // left, right, bottom, top, near and far planes
+} CSR_Frustum;
+
 /**
 * Capsule
 */
@@ -452,6 +460,21 @@ typedef struct
         */
         void csrVec3Normalize(const CSR_Vector3* pV, CSR_Vector3* pR);
 
+        /**
+        * Normalizes several vectors
+        *@param pV - first vector to normalize, its x, y and z values should be contiguous
+        *@param vStride - distance between 2 vectors in pV, in floats, e.g. a vertex buffer stride
+        *@param count - vector count
+        *@param[out] pR - first normalized vector, may be the same as pV
+        *@param rStride - distance between 2 vectors in pR, in floats
+        *@note The result is the same as calling csrVec3Normalize() for each vector
+        */
+        void csrVec3NormalizeBatch(const float* pV,
+                                         size_t vStride,
+                                         size_t count,
+                                         float* pR,
+                                         size_t rStride);
+
         /**
         * Calculates cross product between 2 vectors
         *@param pV1 - first vector
@@ -595,6 +618,19 @@ typedef struct
         */
         void csrMat4Multiply(const CSR_Matrix4* pM1, const CSR_Matrix4* pM2, CSR_Matrix4* pR);
 
+        /**
+        * Multiplies several matrices by other matrices
+        *@param pM1 - first matrices to multiply
+        *@param pM2 - second matrices to multiply with
+        *@param count - matrix count in each array
+        *@param[out] pR - multiplied matrices, should contain count items
+        *@note The result is the same as calling csrMat4Multiply() for each matrix pair
+        */
+        void csrMat4MultiplyBatch(const CSR_Matrix4* pM1,
+                                  const CSR_Matrix4* pM2,
+                                        size_t       count,
+                                        CSR_Matrix4* pR);
+
         /**
         * Transposes a matrix
         *@param pM - matrix to transpose
@@ -610,6 +646,15 @@ typedef struct
         */
         void csrMat4Inverse(const CSR_Matrix4* pM, CSR_Matrix4* pR, float* pDeterminant);
 
+        /**
+        * Inverses an affine matrix, i.e. a matrix only containing a translation, a rotation and
+        * a scaling, faster than csrMat4Inverse() does
+        *@param pM - matrix to inverse, its last column should be [0, 0, 0, 1]
+        *@param[out] pR - inversed matrix
+        *@param[out] pDeterminant - matrix determinant
+        */
+        void csrMat4InverseAffine(const CSR_Matrix4* pM, CSR_Matrix4* pR, float* pDeterminant);
+
         /**
         * Applies a matrix to a vector
         *@param pM - matrix to apply
@@ -634,6 +679,59 @@ typedef struct
         */
         void csrMat4Transform(const CSR_Matrix4* pM, const CSR_Vector3* pV, CSR_Vector3* pR);
 
+        /**
+        * Applies a matrix to several vectors
+        *@param pM - matrix to apply
+        *@param pV - first vector on which matrix should be applied, its x, y and z values should
+        *            be contiguous
+        *@param vStride - distance between 2 vectors in pV, in floats, e.g. a vertex buffer stride
+        *@param count - vector count
+        *@param[out] pR - first resulting vector, may be the same as pV
+        *@param rStride - distance between 2 vectors in pR, in floats
+        *@note The result is the same as calling csrMat4ApplyToVector() for each vector
+        */
+        void csrMat4ApplyToVectorBatch(const CSR_Matrix4* pM,
+                                       const float*       pV,
+                                             size_t       vStride,
+                                             size_t       count,
+                                             float*       pR,
+                                             size_t       rStride);
+
+        /**
+        * Applies a matrix to several normals
+        *@param pM - matrix to apply
+        *@param pN - first normal on which matrix should be applied, its x, y and z values should
+        *            be contiguous
+        *@param nStride - distance between 2 normals in pN, in floats, e.g. a vertex buffer stride
+        *@param count - normal count
+        *@param[out] pR - first resulting normal, may be the same as pN
+        *@param rStride - distance between 2 normals in pR, in floats
+        *@note The result is the same as calling csrMat4ApplyToNormal() for each normal
+        */
+        void csrMat4ApplyToNormalBatch(const CSR_Matrix4* pM,
+                                       const float*       pN,
+                                             size_t       nStride,
+                                             size_t       count,
+                                             float*       pR,
+                                             size_t       rStride);
+
+        /**
+        * Transforms several vectors by a matrix
+        *@param pM - transform matrix
+        *@param pV - first vector to transform, its x, y and z values should be contiguous
+        *@param vStride - distance between 2 vectors in pV, in floats, e.g. a vertex buffer stride
+        *@param count - vector count
+        *@param[out] pR - first transformed vector, may be the same as pV
+        *@param rStride - distance between 2 vectors in pR, in floats
+        *@note The result is the same as calling csrMat4Transform() for each vector
+        */
+        void csrMat4TransformBatch(const CSR_Matrix4* pM,
+                                   const float*       pV,
+                                         size_t       vStride,
+                                         size_t       count,
+                                         float*       pR,
+                                         size_t       rStride);
+
         /**
         * Unprojects a ray (i.e. transforms it in viewport coordinates)
         *@param pP - projection matrix
@@ -956,6 +1054,50 @@ typedef struct
         */
         void csrBoxCut(const CSR_Box* pBox, CSR_Box* pLeftBox, CSR_Box* pRightBox);
 
+        /**
+        * Transforms a box by a matrix
+        *@param pBox - box to transform
+        *@param pMatrix - matrix to apply, should be an affine transformation
+        *@param[out] pR - resulting box, aligned on the axis and surrounding the transformed box
+        */
+        void csrBoxTransform(const CSR_Box* pBox, const CSR_Matrix4* pMatrix, CSR_Box* pR);
+
+        //-------------------------------------------------------------------
+        // Frustum functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Extracts the view frustum from a matrix
+        *@param pMatrix - matrix from which the frustum should be extracted, e.g. the view matrix
+        *                 multiplied by the projection matrix to get the frustum in world coordinates
+        *@param[out] pR - resulting frustum
+        *@note The planes are normalized, thus they may be used to measure a distance
+        */
+        void csrFrustumFromMatrix(const CSR_Matrix4* pMatrix, CSR_Frustum* pR);
+
+        /**
+        * Checks if a box is visible in a frustum
+        *@param pFrustum - frustum against which the box should be checked
+        *@param pBox - box to check, in the same coordinates system as the frustum
+        *@return 1 if the box is visible, at least partially, otherwise 0
+        *@note This function is conservative, i.e. a box located near a frustum corner may be
+        *      reported as visible even if it isn't
+        */
+        int csrFrustumBoxVisible(const CSR_Frustum* pFrustum, const CSR_Box* pBox);
+
+        /**
+        * Checks if several boxes are visible in a frustum
+        *@param pFrustum - frustum against which the boxes should be checked
+        *@param pBoxes - boxes to check, in the same coordinates system as the frustum
+        *@param count - box count
+        *@param[out] pR - for each box, 1 if the box is visible, at least partially, otherwise 0
+        *@note The result is the same as calling csrFrustumBoxVisible() for each box
+        */
+        void csrFrustumBoxVisibleBatch(const CSR_Frustum* pFrustum,
+                                       const CSR_Box*     pBoxes,
+                                             size_t       count,
+                                             int*         pR);
+
         //-------------------------------------------------------------------
         // Inside checks
         //-------------------------------------------------------------------
@@ -858,6 +858,10 @@ void csrMDLPopulateModel(const CSR_MDLHeader*        pHeader,
         // calculate the vertex stride
         csrVertexFormatCalculateStride(&pModel->m_pMesh[i].m_pVB->m_Format);
 
+        // reserve the memory for all the frame vertices at once
+        if (!csrVertexBufferReserve((size_t)pHeader->m_PolygonCount * 3, pModel->m_pMesh[i].m_pVB))
+            return;
+
         // configure the model texture
         csrTextureInit(&pModel->m_pMesh[i].m_Skin.m_Texture);
         csrTextureInit(&pModel->m_pMesh[i].m_Skin.m_BumpMap);
@@ -913,6 +917,68 @@ void csrMDLPopulateModel(const CSR_MDLHeader*        pHeader,
     }
 }
 //---------------------------------------------------------------------------
+int csrMDLWeldFrames(CSR_MDL* pMDL)
+{
+    size_t             i;
+    size_t             j;
+    size_t             k;
+    size_t             frameCount;
+    size_t             vbCount;
+    CSR_VertexBuffer** ppVB;
+    int                success;
+
+    // no model?
+    if (!pMDL->m_pModel || !pMDL->m_ModelCount || !pMDL->m_pModel[0].m_pMesh || !pMDL->m_pModel[0].m_MeshCount)
+        return 1;
+
+    vbCount    = pMDL->m_pModel[0].m_pMesh[0].m_Count;
+    frameCount = 0;
+
+    // count the frames, all of them should contain the same vertex buffer count
+    for (i = 0; i < pMDL->m_ModelCount; ++i)
+    {
+        // model not populated?
+        if (!pMDL->m_pModel[i].m_pMesh)
+            return 1;
+
+        for (j = 0; j < pMDL->m_pModel[i].m_MeshCount; ++j)
+        {
+            if (!pMDL->m_pModel[i].m_pMesh[j].m_pVB || pMDL->m_pModel[i].m_pMesh[j].m_Count != vbCount)
+                return 1;
+
+            ++frameCount;
+        }
+    }
+
+    // create the list of the matching vertex buffers in each frame
+    ppVB = (CSR_VertexBuffer**)csrMemoryAlloc(0, sizeof(CSR_VertexBuffer*), frameCount);
+
+    // succeeded?
+    if (!ppVB)
+        return 0;
+
+    success = 1;
+
+    // weld each vertex buffer along with the matching ones in all the other frames
+    for (k = 0; k < vbCount && success; ++k)
+    {
+        frameCount = 0;
+
+        for (i = 0; i < pMDL->m_ModelCount; ++i)
+            for (j = 0; j < pMDL->m_pModel[i].m_MeshCount; ++j)
+            {
+                ppVB[frameCount] = &pMDL->m_pModel[i].m_pMesh[j].m_pVB[k];
+                ++frameCount;
+            }
+
+        success = csrVertexBufferWeldFrames(ppVB, frameCount);
+    }
+
+    free(ppVB);
+
+    return success;
+}
+//---------------------------------------------------------------------------
 void csrMDLReleaseObjects(CSR_MDLHeader*       pHeader,
                           CSR_MDLFrameGroup*   pFrameGroup,
                           CSR_MDLSkin*         pSkin,
@@ -1343,6 +1409,10 @@ CSR_MDL* csrMDLCreate(const CSR_Buffer*           pBuffer,
     // release the MDL object used for the loading
     csrMDLReleaseObjects(pHeader, pFrameGroup, pSkin, pTexCoord, pPolygon);
 
+    // share the vertices used by several polygons. NOTE all the frames are welded together, thus
+    // they keep the same topology, and a vertex remains at the same position in each frame
+    csrMDLWeldFrames(pMDL);
+
     return pMDL;
 }
 //---------------------------------------------------------------------------
@@ -1439,9 +1509,14 @@ void csrMDLRelease(CSR_MDL* pMDL, const CSR_fOnDeleteTexture fOnDeleteTexture)
                     {
                         // free the mesh vertex buffer content
                         for (k = 0; k < pMDL->m_pModel[i].m_pMesh[j].m_Count; ++k)
+                        {
                             if (pMDL->m_pModel[i].m_pMesh[j].m_pVB[k].m_pData)
                                 free(pMDL->m_pModel[i].m_pMesh[j].m_pVB[k].m_pData);
 
+                            if (pMDL->m_pModel[i].m_pMesh[j].m_pVB[k].m_Index.m_pData)
+                                free(pMDL->m_pModel[i].m_pMesh[j].m_pVB[k].m_Index.m_pData);
+                        }
+
                         // free the mesh vertex buffer
                         free(pMDL->m_pModel[i].m_pMesh[j].m_pVB);
                     }
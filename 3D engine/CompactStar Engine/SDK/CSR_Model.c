@@ -232,6 +232,13 @@ CSR_Mesh* csrShapeCreateSurface(float                 width,
     // calculate the stride
     csrVertexFormatCalculateStride(&pMesh->m_pVB->m_Format);
 
+    // reserve the memory for all the vertices at once
+    if (!csrVertexBufferReserve(4, pMesh->m_pVB))
+    {
+        csrMeshRelease(pMesh, 0);
+        return 0;
+    }
+
     // iterate through vertex to create
     for (i = 0; i < 4; ++i)
     {
@@ -352,6 +359,13 @@ CSR_Mesh* csrShapeCreateBox(float                 width,
 
         // calculate the stride
         csrVertexFormatCalculateStride(&pMesh->m_pVB[i].m_Format);
+
+        // reserve the memory for all the vertices at once
+        if (!csrVertexBufferReserve(4, &pMesh->m_pVB[i]))
+        {
+            csrMeshRelease(pMesh, 0);
+            return 0;
+        }
     }
 
     // iterate through vertices to create. Vertices are generated as follow:
@@ -606,6 +620,13 @@ CSR_Mesh* csrShapeCreateSphere(float                 radius,
         // calculate the stride
         csrVertexFormatCalculateStride(&pMesh->m_pVB[index].m_Format);
 
+        // reserve the memory for all the vertices at once
+        if (!csrVertexBufferReserve(((size_t)stacks + 1) * 2, &pMesh->m_pVB[index]))
+        {
+            csrMeshRelease(pMesh, 0);
+            return 0;
+        }
+
         // calculate next slice values
         a  = i      * majorStep;
         b  = a      + majorStep;
@@ -746,6 +767,13 @@ CSR_Mesh* csrShapeCreateCylinder(float                 minRadius,
     // calculate the stride
     csrVertexFormatCalculateStride(&pMesh->m_pVB->m_Format);
 
+    // reserve the memory for all the vertices at once
+    if (!csrVertexBufferReserve(((size_t)faces + 1) * 2, pMesh->m_pVB))
+    {
+        csrMeshRelease(pMesh, 0);
+        return 0;
+    }
+
     // calculate step to apply between faces
     step = (float)(2.0 * M_PI) / (float)faces;
 
@@ -978,6 +1006,13 @@ CSR_Mesh* csrShapeCreateCapsule(float                 height,
     // calculate the stride
     csrVertexFormatCalculateStride(&pMesh->m_pVB->m_Format);
 
+    // reserve the memory for all the vertices at once
+    if (!csrVertexBufferReserve((size_t)resolution * (size_t)resolution * 18, pMesh->m_pVB))
+    {
+        csrMeshRelease(pMesh, 0);
+        return 0;
+    }
+
     // iterate through latitude and longitude
     for (i = 0; i < (size_t)resolution; ++i)
         for (j = 0; j < (size_t)resolution; ++j)
@@ -1179,6 +1214,13 @@ CSR_Mesh* csrShapeCreateDisk(float                 centerX,
     // calculate the stride
     csrVertexFormatCalculateStride(&pMesh->m_pVB->m_Format);
 
+    // reserve the memory for all the vertices at once
+    if (!csrVertexBufferReserve((size_t)slices + 2, pMesh->m_pVB))
+    {
+        csrMeshRelease(pMesh, 0);
+        return 0;
+    }
+
     // calculate the slice step
     step = (float)(2.0 * M_PI) / (float)slices;
 
@@ -1320,6 +1362,13 @@ CSR_Mesh* csrShapeCreateRing(float                 centerX,
     // calculate the stride
     csrVertexFormatCalculateStride(&pMesh->m_pVB->m_Format);
 
+    // reserve the memory for all the vertices at once
+    if (!csrVertexBufferReserve(((size_t)slices + 1) * 2, pMesh->m_pVB))
+    {
+        csrMeshRelease(pMesh, 0);
+        return 0;
+    }
+
     // calculate the slice step
     step = (float)(2.0 * M_PI) / (float)slices;
 
@@ -1510,6 +1559,13 @@ CSR_Mesh* csrShapeCreateSpiral(float                 centerX,
         // calculate the stride
         csrVertexFormatCalculateStride(&pMesh->m_pVB[index].m_Format);
 
+        // reserve the memory for all the vertices at once
+        if (!csrVertexBufferReserve(((size_t)slices + 1) * 2, &pMesh->m_pVB[index]))
+        {
+            csrMeshRelease(pMesh, 0);
+            return 0;
+        }
+
         // iterate through spiral slices to create
         for (j = 0; j <= slices; ++j)
         {
@@ -1924,6 +1980,7 @@ void csrSkinWeightsInit(CSR_Skin_Weights* pSkinWeights)
     // initialize the skin weights content
     pSkinWeights->m_pBoneName       = 0;
     pSkinWeights->m_pBone           = 0;
+    pSkinWeights->m_BoneIndex       = M_CSR_Unknown_Index;
     pSkinWeights->m_MeshIndex       = 0;
     pSkinWeights->m_pIndexTable     = 0;
     pSkinWeights->m_IndexTableCount = 0;
@@ -1934,48 +1991,154 @@ void csrSkinWeightsInit(CSR_Skin_Weights* pSkinWeights)
     csrMat4Identity(&pSkinWeights->m_Matrix);
 }
 //---------------------------------------------------------------------------
-// Animation key functions
+// Vertex skin weights functions
 //---------------------------------------------------------------------------
-CSR_AnimationKey* csrAnimKeyCreate(void)
+int csrSkinVertexWeightsFromGroup(const CSR_Skin_Weights_Group*  pGroup,
+                                  const CSR_VertexBuffer*        pVB,
+                                        CSR_Skin_Vertex_Weights* pVertexWeights)
 {
-    // create a new animation key structure
-    CSR_AnimationKey* pAnimationKey = (CSR_AnimationKey*)malloc(sizeof(CSR_AnimationKey));
+    size_t         i;
+    size_t         j;
+    size_t         k;
+    size_t         l;
+    size_t         vertexCount;
+    const size_t   itemSize = M_CSR_Max_Bone_Influences * 2;
+    unsigned char* pInfluenceCount;
+    float*         pTotal;
+
+    // validate the inputs
+    if (!pGroup || !pVB || !pVertexWeights || !pVB->m_Format.m_Stride)
+        return 0;
+
+    // get the vertex count
+    vertexCount = pVB->m_Count / pVB->m_Format.m_Stride;
+
+    // nothing to convert?
+    if (!vertexCount)
+        return 0;
+
+    // create the vertex skin weights, unused influences have a 0 weight
+    pVertexWeights->m_pData = (float*)calloc(vertexCount * itemSize, sizeof(float));
+    pVertexWeights->m_Count = vertexCount;
+
+    // create the working tables
+    pInfluenceCount = (unsigned char*)calloc(vertexCount, sizeof(unsigned char));
+    pTotal          = (float*)calloc(vertexCount, sizeof(float));
 
     // succeeded?
-    if (!pAnimationKey)
+    if (!pVertexWeights->m_pData || !pInfluenceCount || !pTotal)
+    {
+        free(pInfluenceCount);
+        free(pTotal);
+        csrSkinVertexWeightsRelease(pVertexWeights);
         return 0;
+    }
+
+    // iterate through the skin weights, each of them is linked to one bone
+    for (i = 0; i < pGroup->m_Count; ++i)
+        for (j = 0; j < pGroup->m_pSkinWeights[i].m_IndexTableCount; ++j)
+            for (k = 0; k < pGroup->m_pSkinWeights[i].m_pIndexTable[j].m_Count; ++k)
+            {
+                float* pItem;
+                size_t index;
+
+                // get the weight and the vertex it applies to
+                const float  weight = pGroup->m_pSkinWeights[i].m_pWeights[j];
+                const size_t vertex = pGroup->m_pSkinWeights[i].m_pIndexTable[j].m_pData[k] /
+                                      pVB->m_Format.m_Stride;
+
+                // invalid vertex?
+                if (vertex >= vertexCount)
+                    continue;
+
+                pItem           = &pVertexWeights->m_pData[vertex * itemSize];
+                pTotal[vertex] += weight;
+
+                // search if this bone already influences the vertex
+                for (l = 0; l < pInfluenceCount[vertex]; ++l)
+                    if ((size_t)pItem[l] == i)
+                        break;
+
+                // found it?
+                if (l < pInfluenceCount[vertex])
+                {
+                    pItem[M_CSR_Max_Bone_Influences + l] += weight;
+                    continue;
+                }
+
+                // still a free influence?
+                if (pInfluenceCount[vertex] < M_CSR_Max_Bone_Influences)
+                {
+                    index = pInfluenceCount[vertex];
+                    ++pInfluenceCount[vertex];
+                }
+                else
+                {
+                    // no, search for the weakest influence
+                    index = 0;
+
+                    for (l = 1; l < M_CSR_Max_Bone_Influences; ++l)
+                        if (pItem[M_CSR_Max_Bone_Influences + l] < pItem[M_CSR_Max_Bone_Influences + index])
+                            index = l;
+
+                    // ignore the new influence if it's the weakest
+                    if (weight <= pItem[M_CSR_Max_Bone_Influences + index])
+                        continue;
+                }
+
+                // keep the influence
+                pItem[index]                             = (float)i;
+                pItem[M_CSR_Max_Bone_Influences + index] = weight;
+            }
+
+    // scale the kept weights, in case some influences were dropped
+    for (i = 0; i < vertexCount; ++i)
+    {
+        float  sum   = 0.0f;
+        float* pItem = &pVertexWeights->m_pData[i * itemSize];
+
+        // calculate the kept weights sum
+        for (j = 0; j < M_CSR_Max_Bone_Influences; ++j)
+            sum += pItem[M_CSR_Max_Bone_Influences + j];
+
+        // nothing was dropped?
+        if (!sum || sum == pTotal[i])
+            continue;
 
-    // initialize the animation key content
-    csrAnimKeyInit(pAnimationKey);
+        // scale the weights
+        for (j = 0; j < M_CSR_Max_Bone_Influences; ++j)
+            pItem[M_CSR_Max_Bone_Influences + j] *= pTotal[i] / sum;
+    }
+
+    free(pInfluenceCount);
+    free(pTotal);
 
-    return pAnimationKey;
+    return 1;
 }
 //---------------------------------------------------------------------------
-void csrAnimKeyRelease(CSR_AnimationKey* pAnimationKey, int contentOnly)
+void csrSkinVertexWeightsRelease(CSR_Skin_Vertex_Weights* pVertexWeights)
 {
-    // no animation key to release?
-    if (!pAnimationKey)
+    // no vertex skin weights to release?
+    if (!pVertexWeights)
         return;
 
-    // release the values
-    if (pAnimationKey->m_pValues)
-        free(pAnimationKey->m_pValues);
+    // free the vertex skin weights content
+    if (pVertexWeights->m_pData)
+        free(pVertexWeights->m_pData);
 
-    // free the animation key
-    if (!contentOnly)
-        free(pAnimationKey);
+    pVertexWeights->m_pData = 0;
+    pVertexWeights->m_Count = 0;
 }
 //---------------------------------------------------------------------------
-void csrAnimKeyInit(CSR_AnimationKey* pAnimationKey)
+void csrSkinVertexWeightsInit(CSR_Skin_Vertex_Weights* pVertexWeights)
 {
-    // no animation key to initialize?
-    if (!pAnimationKey)
+    // no vertex skin weights to initialize?
+    if (!pVertexWeights)
         return;
 
-    // initialize the animation keys content
-    pAnimationKey->m_Frame   = 0;
-    pAnimationKey->m_pValues = 0;
-    pAnimationKey->m_Count   = 0;
+    // initialize the vertex skin weights content
+    pVertexWeights->m_pData = 0;
+    pVertexWeights->m_Count = 0;
 }
 //---------------------------------------------------------------------------
 // Animation keys functions
@@ -1997,22 +2160,17 @@ CSR_AnimationKeys* csrAnimKeysCreate(void)
 //---------------------------------------------------------------------------
 void csrAnimKeysRelease(CSR_AnimationKeys* pAnimationKeys, int contentOnly)
 {
-    size_t i;
-
     // no animation keys to release?
     if (!pAnimationKeys)
         return;
 
-    // release the keys
-    if (pAnimationKeys->m_pKey)
-    {
-        // release the keys content
-        for (i = 0; i < pAnimationKeys->m_Count; ++i)
-            csrAnimKeyRelease(&pAnimationKeys->m_pKey[i], 1);
+    // free the key frames
+    if (pAnimationKeys->m_pFrames)
+        free(pAnimationKeys->m_pFrames);
 
-        // free the keys container
-        free(pAnimationKeys->m_pKey);
-    }
+    // free the key values
+    if (pAnimationKeys->m_pValues)
+        free(pAnimationKeys->m_pValues);
 
     // free the animation keys
     if (!contentOnly)
@@ -2027,11 +2185,77 @@ void csrAnimKeysInit(CSR_AnimationKeys* pAnimationKeys)
 
     // initialize the animation keys content
     pAnimationKeys->m_Type       = CSR_KT_Unknown;
-    pAnimationKeys->m_pKey       = 0;
+    pAnimationKeys->m_pFrames    = 0;
+    pAnimationKeys->m_pValues    = 0;
+    pAnimationKeys->m_Stride     = 0;
     pAnimationKeys->m_Count      = 0;
     pAnimationKeys->m_ColOverRow = 0;
 }
 //---------------------------------------------------------------------------
+size_t csrAnimKeysFind(const CSR_AnimationKeys* pAnimationKeys, size_t frame)
+{
+    size_t first;
+    size_t last;
+
+    // no keys?
+    if (!pAnimationKeys || !pAnimationKeys->m_Count)
+        return 0;
+
+    first = 0;
+    last  = pAnimationKeys->m_Count - 1;
+
+    // search for the last key starting before or on the frame. NOTE the keys are sorted by frame, and
+    // the first key is used if the frame is before it
+    while (first < last)
+    {
+        const size_t middle = first + ((last - first + 1) / 2);
+
+        if (pAnimationKeys->m_pFrames[middle] <= frame)
+            first = middle;
+        else
+            last = middle - 1;
+    }
+
+    return first;
+}
+//---------------------------------------------------------------------------
+size_t csrAnimKeysFindFromCursor(const CSR_AnimationKeys* pAnimationKeys,
+                                       size_t             frame,
+                                       size_t*            pCursor)
+{
+    size_t cursor;
+
+    // no cursor?
+    if (!pCursor)
+        return csrAnimKeysFind(pAnimationKeys, frame);
+
+    // no keys?
+    if (!pAnimationKeys || !pAnimationKeys->m_Count)
+        return 0;
+
+    cursor = *pCursor;
+
+    // is the frame still on the cursor key, or on the next one? (e.g. the animation is playing forward)
+    if (cursor < pAnimationKeys->m_Count && pAnimationKeys->m_pFrames[cursor] <= frame)
+    {
+        if (cursor + 1 >= pAnimationKeys->m_Count || frame < pAnimationKeys->m_pFrames[cursor + 1])
+            return cursor;
+
+        ++cursor;
+
+        if (cursor + 1 >= pAnimationKeys->m_Count || frame < pAnimationKeys->m_pFrames[cursor + 1])
+        {
+            *pCursor = cursor;
+            return cursor;
+        }
+    }
+
+    // the frame jumped (e.g. the animation looped), search for the key
+    *pCursor = csrAnimKeysFind(pAnimationKeys, frame);
+
+    return *pCursor;
+}
+//---------------------------------------------------------------------------
 // Frame animation functions
 //---------------------------------------------------------------------------
 CSR_Animation_Frame* csrFrameAnimCreate(void)
@@ -2135,8 +2359,6 @@ int csrBoneAnimGetAnimMatrix(const CSR_AnimationSet_Bone* pAnimSet,
                                    CSR_Matrix4*           pMatrix)
 {
     size_t i;
-    size_t j;
-    size_t k;
 
     // no animation set?
     if (!pAnimSet)
@@ -2152,231 +2374,238 @@ int csrBoneAnimGetAnimMatrix(const CSR_AnimationSet_Bone* pAnimSet,
 
     // iterate through animations
     for (i = 0; i < pAnimSet->m_Count; ++i)
-    {
-        #ifdef _MSC_VER
-            size_t         rotFrame;
-            size_t         nextRotFrame;
-            size_t         posFrame;
-            size_t         nextPosFrame;
-            size_t         scaleFrame;
-            size_t         nextScaleFrame;
-            float          frameDelta;
-            float          frameLength;
-            float          interpolation;
-            CSR_Quaternion rotation        = {0};
-            CSR_Quaternion nextRotation    = {0};
-            CSR_Quaternion finalRotation   = {0};
-            CSR_Vector3    position        = {0};
-            CSR_Vector3    nextPosition    = {0};
-            CSR_Vector3    finalPosition   = {0};
-            CSR_Vector3    scaling         = {0};
-            CSR_Vector3    nextScaling     = {0};
-            CSR_Vector3    finalScaling    = {0};
-            CSR_Matrix4    scaleMatrix     = {0};
-            CSR_Matrix4    rotateMatrix    = {0};
-            CSR_Matrix4    translateMatrix = {0};
-            CSR_Matrix4    buildMatrix     = {0};
-        #else
-            size_t         rotFrame;
-            size_t         nextRotFrame;
-            size_t         posFrame;
-            size_t         nextPosFrame;
-            size_t         scaleFrame;
-            size_t         nextScaleFrame;
-            float          frameDelta;
-            float          frameLength;
-            float          interpolation;
-            CSR_Quaternion rotation;
-            CSR_Quaternion nextRotation;
-            CSR_Quaternion finalRotation;
-            CSR_Vector3    position;
-            CSR_Vector3    nextPosition;
-            CSR_Vector3    finalPosition;
-            CSR_Vector3    scaling;
-            CSR_Vector3    nextScaling;
-            CSR_Vector3    finalScaling;
-            CSR_Matrix4    scaleMatrix;
-            CSR_Matrix4    rotateMatrix;
-            CSR_Matrix4    translateMatrix;
-            CSR_Matrix4    buildMatrix;
-        #endif
-
         // found the animation matching with the bone for which the matrix should be get?
-        if (pAnimSet->m_pAnimation[i].m_pBone != pBone)
-            continue;
-
-        rotFrame       = 0;
-        nextRotFrame   = 0;
-        posFrame       = 0;
-        nextPosFrame   = 0;
-        scaleFrame     = 0;
-        nextScaleFrame = 0;
-
-        // iterate through animation keys
-        for (j = 0; j < pAnimSet->m_pAnimation[i].m_Count; ++j)
-        {
-            size_t keyIndex = 0;
-
-            // iterate through animation key items
-            for (k = 0; k < pAnimSet->m_pAnimation[i].m_pKeys[j].m_Count; ++k)
-                if (frame >= pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[k].m_Frame)
-                    keyIndex = k;
-                else
-                    break;
+        if (pAnimSet->m_pAnimation[i].m_pBone == pBone)
+            return csrBoneAnimGetFrameMatrix(&pAnimSet->m_pAnimation[i], frame, 0, pMatrix);
 
-            // search for keys type
-            switch (pAnimSet->m_pAnimation[i].m_pKeys[j].m_Type)
-            {
-                case CSR_KT_Rotation:
-                    if (pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_Count != 4)
-                        return 0;
-
-                    // get the rotation quaternion at index
-                    rotation.m_W = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[0];
-                    rotation.m_X = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[1];
-                    rotation.m_Y = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[2];
-                    rotation.m_Z = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[3];
-                    rotFrame     = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_Frame;
-
-                    // get the next rotation quaternion
-                    if (keyIndex + 1 >= pAnimSet->m_pAnimation[i].m_pKeys[j].m_Count)
-                    {
-                        nextRotation.m_W = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_pValues[0];
-                        nextRotation.m_X = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_pValues[1];
-                        nextRotation.m_Y = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_pValues[2];
-                        nextRotation.m_Z = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_pValues[3];
-                        nextRotFrame     = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_Frame;
-                    }
-                    else
-                    {
-                        nextRotation.m_W = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_pValues[0];
-                        nextRotation.m_X = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_pValues[1];
-                        nextRotation.m_Y = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_pValues[2];
-                        nextRotation.m_Z = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_pValues[3];
-                        nextRotFrame     = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_Frame;
-                    }
+    return 0;
+}
+//---------------------------------------------------------------------------
+int csrBoneAnimGetFrameMatrix(const CSR_Animation_Bone* pAnimation,
+                                    size_t              frame,
+                                    size_t*             pCursors,
+                                    CSR_Matrix4*        pMatrix)
+{
+    size_t j;
+    size_t k;
 
-                    continue;
+    #ifdef _MSC_VER
+        size_t         rotFrame;
+        size_t         nextRotFrame;
+        size_t         posFrame;
+        size_t         nextPosFrame;
+        size_t         scaleFrame;
+        size_t         nextScaleFrame;
+        float          frameDelta;
+        float          frameLength;
+        float          interpolation;
+        CSR_Quaternion rotation        = {0};
+        CSR_Quaternion nextRotation    = {0};
+        CSR_Quaternion finalRotation   = {0};
+        CSR_Vector3    position        = {0};
+        CSR_Vector3    nextPosition    = {0};
+        CSR_Vector3    finalPosition   = {0};
+        CSR_Vector3    scaling         = {0};
+        CSR_Vector3    nextScaling     = {0};
+        CSR_Vector3    finalScaling    = {0};
+        CSR_Matrix4    scaleMatrix     = {0};
+        CSR_Matrix4    rotateMatrix    = {0};
+        CSR_Matrix4    translateMatrix = {0};
+        CSR_Matrix4    buildMatrix     = {0};
+    #else
+        size_t         rotFrame;
+        size_t         nextRotFrame;
+        size_t         posFrame;
+        size_t         nextPosFrame;
+        size_t         scaleFrame;
+        size_t         nextScaleFrame;
+        float          frameDelta;
+        float          frameLength;
+        float          interpolation;
+        CSR_Quaternion rotation;
+        CSR_Quaternion nextRotation;
+        CSR_Quaternion finalRotation;
+        CSR_Vector3    position;
+        CSR_Vector3    nextPosition;
+        CSR_Vector3    finalPosition;
+        CSR_Vector3    scaling;
+        CSR_Vector3    nextScaling;
+        CSR_Vector3    finalScaling;
+        CSR_Matrix4    scaleMatrix;
+        CSR_Matrix4    rotateMatrix;
+        CSR_Matrix4    translateMatrix;
+        CSR_Matrix4    buildMatrix;
+    #endif
 
-                case CSR_KT_Scale:
-                    if (pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_Count != 3)
-                        return 0;
+    // no animation?
+    if (!pAnimation)
+        return 0;
 
-                    // get the scale values at index
-                    scaling.m_X = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[0];
-                    scaling.m_Y = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[1];
-                    scaling.m_Z = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[2];
-                    scaleFrame  = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_Frame;
+    // no output matrix?
+    if (!pMatrix)
+        return 0;
 
-                    // get the next rotation quaternion
-                    if (keyIndex + 1 >= pAnimSet->m_pAnimation[i].m_pKeys[j].m_Count)
-                    {
-                        nextScaling.m_X = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_pValues[0];
-                        nextScaling.m_Y = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_pValues[1];
-                        nextScaling.m_Z = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_pValues[2];
-                        nextScaleFrame  = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_Frame;
-                    }
-                    else
-                    {
-                        nextScaling.m_X = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_pValues[0];
-                        nextScaling.m_Y = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_pValues[1];
-                        nextScaling.m_Z = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_pValues[2];
-                        nextScaleFrame  = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_Frame;
-                    }
+    rotFrame       = 0;
+    nextRotFrame   = 0;
+    posFrame       = 0;
+    nextPosFrame   = 0;
+    scaleFrame     = 0;
+    nextScaleFrame = 0;
+
+    // the bone keeps its default values for the keys the animation doesn't contain
+    rotation.m_X = 0.0f;
+    rotation.m_Y = 0.0f;
+    rotation.m_Z = 0.0f;
+    rotation.m_W = 1.0f;
+    position.m_X = 0.0f;
+    position.m_Y = 0.0f;
+    position.m_Z = 0.0f;
+    scaling.m_X  = 1.0f;
+    scaling.m_Y  = 1.0f;
+    scaling.m_Z  = 1.0f;
+    nextRotation = rotation;
+    nextPosition = position;
+    nextScaling  = scaling;
+
+    // iterate through animation keys
+    for (j = 0; j < pAnimation->m_Count; ++j)
+    {
+        size_t                   keyIndex;
+        size_t                   nextKeyIndex;
+        const float*             pValues;
+        const float*             pNextValues;
+        const CSR_AnimationKeys* pKeys = &pAnimation->m_pKeys[j];
+
+        // no keys?
+        if (!pKeys->m_Count)
+            continue;
 
-                    continue;
+        // search for the key matching with the frame, and for the next one
+        keyIndex     = pCursors ? csrAnimKeysFindFromCursor(pKeys, frame, &pCursors[j]) :
+                                  csrAnimKeysFind(pKeys, frame);
+        nextKeyIndex = (keyIndex + 1 >= pKeys->m_Count) ? 0 : keyIndex + 1;
 
-                case CSR_KT_Position:
-                    if (pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_Count != 3)
-                        return 0;
+        // get the key values
+        pValues     = &pKeys->m_pValues[keyIndex     * pKeys->m_Stride];
+        pNextValues = &pKeys->m_pValues[nextKeyIndex * pKeys->m_Stride];
 
-                    // get the position values at index
-                    position.m_X = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[0];
-                    position.m_Y = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[1];
-                    position.m_Z = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[2];
-                    posFrame     = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_Frame;
+        // search for keys type
+        switch (pKeys->m_Type)
+        {
+            case CSR_KT_Rotation:
+                if (pKeys->m_Stride != 4)
+                    return 0;
+
+                // get the rotation quaternion at index
+                rotation.m_W = pValues[0];
+                rotation.m_X = pValues[1];
+                rotation.m_Y = pValues[2];
+                rotation.m_Z = pValues[3];
+                rotFrame     = pKeys->m_pFrames[keyIndex];
+
+                // get the next rotation quaternion
+                nextRotation.m_W = pNextValues[0];
+                nextRotation.m_X = pNextValues[1];
+                nextRotation.m_Y = pNextValues[2];
+                nextRotation.m_Z = pNextValues[3];
+                nextRotFrame     = pKeys->m_pFrames[nextKeyIndex];
+
+                continue;
+
+            case CSR_KT_Scale:
+                if (pKeys->m_Stride != 3)
+                    return 0;
+
+                // get the scale values at index
+                scaling.m_X = pValues[0];
+                scaling.m_Y = pValues[1];
+                scaling.m_Z = pValues[2];
+                scaleFrame  = pKeys->m_pFrames[keyIndex];
+
+                // get the next scale values
+                nextScaling.m_X = pNextValues[0];
+                nextScaling.m_Y = pNextValues[1];
+                nextScaling.m_Z = pNextValues[2];
+                nextScaleFrame  = pKeys->m_pFrames[nextKeyIndex];
+
+                continue;
+
+            case CSR_KT_Position:
+                if (pKeys->m_Stride != 3)
+                    return 0;
+
+                // get the position values at index
+                position.m_X = pValues[0];
+                position.m_Y = pValues[1];
+                position.m_Z = pValues[2];
+                posFrame     = pKeys->m_pFrames[keyIndex];
+
+                // get the next position values
+                nextPosition.m_X = pNextValues[0];
+                nextPosition.m_Y = pNextValues[1];
+                nextPosition.m_Z = pNextValues[2];
+                nextPosFrame     = pKeys->m_pFrames[nextKeyIndex];
+
+                continue;
+
+            case CSR_KT_Matrix:
+            {
+                if (pKeys->m_Stride != 16)
+                    return 0;
 
-                    // get the next rotation quaternion
-                    if (keyIndex + 1 >= pAnimSet->m_pAnimation[i].m_pKeys[j].m_Count)
-                    {
-                        nextPosition.m_X = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_pValues[0];
-                        nextPosition.m_Y = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_pValues[1];
-                        nextPosition.m_Z = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_pValues[2];
-                        nextPosFrame     = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[0].m_Frame;
-                    }
+                // get the key matrix
+                for (k = 0; k < 16; ++k)
+                    if (pKeys->m_ColOverRow)
+                        pMatrix->m_Table[k % 4][k / 4] = pValues[k];
                     else
-                    {
-                        nextPosition.m_X = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_pValues[0];
-                        nextPosition.m_Y = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_pValues[1];
-                        nextPosition.m_Z = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_pValues[2];
-                        nextPosFrame     = pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex + 1].m_Frame;
-                    }
-
-                    continue;
-
-                case CSR_KT_Matrix:
-                {
-                    if (pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_Count != 16)
-                        return 0;
-
-                    // get the key matrix
-                    for (k = 0; k < 16; ++k)
-                        if (pAnimSet->m_pAnimation[i].m_pKeys[j].m_ColOverRow)
-                            pMatrix->m_Table[k % 4][k / 4] =
-                                    pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[k];
-                        else
-                            pMatrix->m_Table[k / 4][k % 4] =
-                                    pAnimSet->m_pAnimation[i].m_pKeys[j].m_pKey[keyIndex].m_pValues[k];
-
-                    return 1;
-                }
+                        pMatrix->m_Table[k / 4][k % 4] = pValues[k];
 
-                default:
-                    continue;
+                return 1;
             }
-        }
 
-        // calculate the frame delta, the frame length and the interpolation for the rotation
-        frameDelta    = (float)(frame        - rotFrame);
-        frameLength   = (float)(nextRotFrame - rotFrame);
-        interpolation = frameDelta / frameLength;
+            default:
+                continue;
+        }
+    }
 
-        // interpolate the rotation
-        csrQuatSlerp(&rotation, &nextRotation, interpolation, &finalRotation);
+    // calculate the frame delta, the frame length and the interpolation for the rotation
+    frameDelta    = (float)(frame        - rotFrame);
+    frameLength   = (float)(nextRotFrame - rotFrame);
+    interpolation = frameLength ? (frameDelta / frameLength) : 0.0f;
 
-        // calculate the frame delta, the frame length and the interpolation for the scaling
-        frameDelta    = (float)(frame          - scaleFrame);
-        frameLength   = (float)(nextScaleFrame - scaleFrame);
-        interpolation = frameDelta / frameLength;
+    // interpolate the rotation
+    csrQuatSlerp(&rotation, &nextRotation, interpolation, &finalRotation);
 
-        // interpolate the scaling
-        finalScaling.m_X = scaling.m_X + ((nextScaling.m_X - scaling.m_X) * interpolation);
-        finalScaling.m_Y = scaling.m_Y + ((nextScaling.m_Y - scaling.m_Y) * interpolation);
-        finalScaling.m_Z = scaling.m_Z + ((nextScaling.m_Z - scaling.m_Z) * interpolation);
+    // calculate the frame delta, the frame length and the interpolation for the scaling
+    frameDelta    = (float)(frame          - scaleFrame);
+    frameLength   = (float)(nextScaleFrame - scaleFrame);
+    interpolation = frameLength ? (frameDelta / frameLength) : 0.0f;
 
-        // calculate the frame delta, the frame length and the interpolation for the rotation
-        frameDelta    = (float)(frame        - posFrame);
-        frameLength   = (float)(nextPosFrame - posFrame);
-        interpolation = frameDelta / frameLength;
+    // interpolate the scaling
+    finalScaling.m_X = scaling.m_X + ((nextScaling.m_X - scaling.m_X) * interpolation);
+    finalScaling.m_Y = scaling.m_Y + ((nextScaling.m_Y - scaling.m_Y) * interpolation);
+    finalScaling.m_Z = scaling.m_Z + ((nextScaling.m_Z - scaling.m_Z) * interpolation);
 
-        // interpolate the position
-        finalPosition.m_X = position.m_X + ((nextPosition.m_X - position.m_X) * interpolation);
-        finalPosition.m_Y = position.m_Y + ((nextPosition.m_Y - position.m_Y) * interpolation);
-        finalPosition.m_Z = position.m_Z + ((nextPosition.m_Z - position.m_Z) * interpolation);
+    // calculate the frame delta, the frame length and the interpolation for the rotation
+    frameDelta    = (float)(frame        - posFrame);
+    frameLength   = (float)(nextPosFrame - posFrame);
+    interpolation = frameLength ? (frameDelta / frameLength) : 0.0f;
 
-        // get the rotation quaternion and the scale and translate vectors
-        csrMat4Scale(&finalScaling, &scaleMatrix);
-        csrQuatToMatrix(&finalRotation, &rotateMatrix);
-        csrMat4Translate(&finalPosition, &translateMatrix);
+    // interpolate the position
+    finalPosition.m_X = position.m_X + ((nextPosition.m_X - position.m_X) * interpolation);
+    finalPosition.m_Y = position.m_Y + ((nextPosition.m_Y - position.m_Y) * interpolation);
+    finalPosition.m_Z = position.m_Z + ((nextPosition.m_Z - position.m_Z) * interpolation);
 
-        // build the final matrix
-        csrMat4Multiply(&scaleMatrix, &rotateMatrix,    &buildMatrix);
-        csrMat4Multiply(&buildMatrix, &translateMatrix, pMatrix);
+    // get the rotation quaternion and the scale and translate vectors
+    csrMat4Scale(&finalScaling, &scaleMatrix);
+    csrQuatToMatrix(&finalRotation, &rotateMatrix);
+    csrMat4Translate(&finalPosition, &translateMatrix);
 
-        return 1;
-    }
+    // build the final matrix
+    csrMat4Multiply(&scaleMatrix, &rotateMatrix,    &buildMatrix);
+    csrMat4Multiply(&buildMatrix, &translateMatrix, pMatrix);
 
-    return 0;
+    return 1;
 }
 //---------------------------------------------------------------------------
 // Bone animation set functions
@@ -2431,78 +2660,898 @@ void csrBoneAnimSetInit(CSR_AnimationSet_Bone* pAnimationSet)
     pAnimationSet->m_Count      = 0;
 }
 //---------------------------------------------------------------------------
-// Model functions
-//---------------------------------------------------------------------------
-CSR_Model* csrModelCreate(void)
+size_t csrBoneAnimSetGetFrameCount(const CSR_AnimationSet_Bone* pAnimationSet)
 {
-    // create a new model
-    CSR_Model* pModel = (CSR_Model*)malloc(sizeof(CSR_Model));
+    size_t i;
+    size_t j;
+    size_t frameCount = 0;
 
-    // succeeded?
-    if (!pModel)
+    // no animation set?
+    if (!pAnimationSet)
         return 0;
 
-    // initialize the model content
-    csrModelInit(pModel);
+    // search for the highest key frame. NOTE the keys are sorted by frame, so the last one is the highest
+    for (i = 0; i < pAnimationSet->m_Count; ++i)
+        for (j = 0; j < pAnimationSet->m_pAnimation[i].m_Count; ++j)
+        {
+            const CSR_AnimationKeys* pKeys = &pAnimationSet->m_pAnimation[i].m_pKeys[j];
 
-    return pModel;
+            if (pKeys->m_Count && pKeys->m_pFrames[pKeys->m_Count - 1] + 1 > frameCount)
+                frameCount = pKeys->m_pFrames[pKeys->m_Count - 1] + 1;
+        }
+
+    return frameCount;
 }
 //---------------------------------------------------------------------------
-void csrModelRelease(CSR_Model* pModel, const CSR_fOnDeleteTexture fOnDeleteTexture)
+// Bone pose private functions
+//---------------------------------------------------------------------------
+size_t csrBonePoseCountBones(const CSR_Bone* pBone)
 {
     size_t i;
-    size_t j;
+    size_t count = 1;
 
-    // no model to release?
-    if (!pModel)
-        return;
+    // count the bone and all its children
+    for (i = 0; i < pBone->m_ChildrenCount; ++i)
+        count += csrBonePoseCountBones(&pBone->m_pChildren[i]);
 
-    // do free the meshes content?
-    if (pModel->m_pMesh)
-    {
-        // iterate through meshes to free
-        for (i = 0; i < pModel->m_MeshCount; ++i)
-        {
-            // delete the skin
-            csrSkinContentRelease(&pModel->m_pMesh[i].m_Skin, fOnDeleteTexture);
+    return count;
+}
+//---------------------------------------------------------------------------
+void csrBonePoseAddBones(const CSR_Bone* pBone, size_t parentIndex, CSR_Bone_Pose* pPose)
+{
+    size_t       i;
+    const size_t index = pPose->m_Count;
 
-            // do free the mesh vertex buffer?
-            if (pModel->m_pMesh[i].m_pVB)
-            {
-                // free the mesh vertex buffer content
-                for (j = 0; j < pModel->m_pMesh[i].m_Count; ++j)
-                    if (pModel->m_pMesh[i].m_pVB[j].m_pData)
-                        free(pModel->m_pMesh[i].m_pVB[j].m_pData);
+    // add the bone, before its children
+    pPose->m_pBones[index]       = pBone;
+    pPose->m_pParentIndex[index] = parentIndex;
+    ++pPose->m_Count;
 
-                // free the mesh vertex buffer
-                free(pModel->m_pMesh[i].m_pVB);
-            }
-        }
+    // add the bone children
+    for (i = 0; i < pBone->m_ChildrenCount; ++i)
+        csrBonePoseAddBones(&pBone->m_pChildren[i], index, pPose);
+}
+//---------------------------------------------------------------------------
+// Bone pose functions
+//---------------------------------------------------------------------------
+CSR_Bone_Pose* csrBonePoseCreate(void)
+{
+    // create a new bone pose
+    CSR_Bone_Pose* pPose = (CSR_Bone_Pose*)malloc(sizeof(CSR_Bone_Pose));
 
-        // free the meshes
-        free(pModel->m_pMesh);
-    }
+    // succeeded?
+    if (!pPose)
+        return 0;
 
-    // free the model
-    free(pModel);
+    // initialize the bone pose content
+    csrBonePoseInit(pPose);
+
+    return pPose;
 }
 //---------------------------------------------------------------------------
-void csrModelInit(CSR_Model* pModel)
+void csrBonePoseRelease(CSR_Bone_Pose* pPose, int contentOnly)
 {
-    // no model to initialize?
-    if (!pModel)
+    // no bone pose to release?
+    if (!pPose)
         return;
 
-    // initialize the model content
-    pModel->m_pMesh     = 0;
-    pModel->m_MeshCount = 0;
-    pModel->m_Time      = 0.0;
+    // free the bone pose content
+    free((void*)pPose->m_pBones);
+    free(pPose->m_pParentIndex);
+    free((void*)pPose->m_pAnimations);
+    free(pPose->m_pCursors);
+    free(pPose->m_pMatrices);
+
+    // free the bone pose
+    if (!contentOnly)
+        free(pPose);
 }
 //---------------------------------------------------------------------------
-// Landscape creation functions
-//---------------------------------------------------------------------------
-int csrLandscapeGenerateVertices(const CSR_PixelBuffer* pPixelBuffer,
-                                       float            height,
+void csrBonePoseInit(CSR_Bone_Pose* pPose)
+{
+    // no bone pose to initialize?
+    if (!pPose)
+        return;
+
+    // initialize the bone pose content
+    pPose->m_pBones       = 0;
+    pPose->m_pParentIndex = 0;
+    pPose->m_pAnimations  = 0;
+    pPose->m_AnimSetCount = 0;
+    pPose->m_pCursors     = 0;
+    pPose->m_CursorCount  = 0;
+    pPose->m_pMatrices    = 0;
+    pPose->m_Count        = 0;
+}
+//---------------------------------------------------------------------------
+int csrBonePoseAddSkeleton(const CSR_Bone* pRoot, CSR_Bone_Pose* pPose)
+{
+    size_t           count;
+    const CSR_Bone** pBones;
+    size_t*          pParentIndex;
+    CSR_Matrix4*     pMatrices;
+
+    // validate the inputs
+    if (!pRoot || !pPose)
+        return 0;
+
+    // skeleton already added?
+    if (csrBonePoseGetIndex(pPose, pRoot) != (size_t)M_CSR_Unknown_Index)
+        return 1;
+
+    // get the new bone count
+    count = pPose->m_Count + csrBonePoseCountBones(pRoot);
+
+    // add memory for the new bones
+    pBones = (const CSR_Bone**)csrMemoryAlloc((void*)pPose->m_pBones, sizeof(CSR_Bone*), count);
+
+    // succeeded?
+    if (!pBones)
+        return 0;
+
+    pPose->m_pBones = pBones;
+
+    // add memory for the new bone parent indices
+    pParentIndex = (size_t*)csrMemoryAlloc(pPose->m_pParentIndex, sizeof(size_t), count);
+
+    // succeeded?
+    if (!pParentIndex)
+        return 0;
+
+    pPose->m_pParentIndex = pParentIndex;
+
+    // add memory for the new bone matrices
+    pMatrices = (CSR_Matrix4*)csrMemoryAlloc(pPose->m_pMatrices, sizeof(CSR_Matrix4), count);
+
+    // succeeded?
+    if (!pMatrices)
+        return 0;
+
+    pPose->m_pMatrices = pMatrices;
+
+    // add the bones, the parents are always added before their children
+    csrBonePoseAddBones(pRoot, M_CSR_Unknown_Index, pPose);
+
+    // the animations are no longer matching with the bones
+    free((void*)pPose->m_pAnimations);
+    free(pPose->m_pCursors);
+    pPose->m_pAnimations  = 0;
+    pPose->m_AnimSetCount = 0;
+    pPose->m_pCursors     = 0;
+    pPose->m_CursorCount  = 0;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrBonePoseLinkAnimSets(const CSR_AnimationSet_Bone* pAnimSet,
+                                  size_t                 count,
+                                  CSR_Bone_Pose*         pPose)
+{
+    size_t i;
+    size_t j;
+    size_t k;
+
+    // validate the inputs
+    if (!pPose)
+        return 0;
+
+    // release the previously linked animations
+    free((void*)pPose->m_pAnimations);
+    free(pPose->m_pCursors);
+    pPose->m_pAnimations  = 0;
+    pPose->m_AnimSetCount = 0;
+    pPose->m_pCursors     = 0;
+    pPose->m_CursorCount  = 0;
+
+    // nothing to link?
+    if (!pAnimSet || !count || !pPose->m_Count)
+        return 1;
+
+    // create the animation table
+    pPose->m_pAnimations =
+            (const CSR_Animation_Bone**)calloc(count * pPose->m_Count, sizeof(CSR_Animation_Bone*));
+
+    // succeeded?
+    if (!pPose->m_pAnimations)
+        return 0;
+
+    pPose->m_AnimSetCount = count;
+
+    // find the animation matching with each bone, in each animation set
+    for (i = 0; i < count; ++i)
+        for (j = 0; j < pAnimSet[i].m_Count; ++j)
+            for (k = 0; k < pPose->m_Count; ++k)
+                if (pAnimSet[i].m_pAnimation[j].m_pBone == pPose->m_pBones[k])
+                {
+                    // keep the first animation found for the bone, as csrBoneAnimGetAnimMatrix() does
+                    if (!pPose->m_pAnimations[(i * pPose->m_Count) + k])
+                    {
+                        pPose->m_pAnimations[(i * pPose->m_Count) + k] = &pAnimSet[i].m_pAnimation[j];
+
+                        // each bone needs a playback cursor for each of its animation key lists
+                        if (pAnimSet[i].m_pAnimation[j].m_Count > pPose->m_CursorCount)
+                            pPose->m_CursorCount = pAnimSet[i].m_pAnimation[j].m_Count;
+                    }
+
+                    break;
+                }
+
+    // no playback cursor to create?
+    if (!pPose->m_CursorCount)
+        return 1;
+
+    // create the playback cursors
+    pPose->m_pCursors = (size_t*)calloc(pPose->m_Count * pPose->m_CursorCount, sizeof(size_t));
+
+    // succeeded?
+    if (!pPose->m_pCursors)
+    {
+        pPose->m_CursorCount = 0;
+        return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+size_t csrBonePoseGetIndex(const CSR_Bone_Pose* pPose, const CSR_Bone* pBone)
+{
+    size_t i;
+
+    // validate the inputs
+    if (!pPose || !pBone)
+        return M_CSR_Unknown_Index;
+
+    // search for the bone
+    for (i = 0; i < pPose->m_Count; ++i)
+        if (pPose->m_pBones[i] == pBone)
+            return i;
+
+    return M_CSR_Unknown_Index;
+}
+//---------------------------------------------------------------------------
+int csrBonePoseUpdate(      CSR_Bone_Pose* pPose,
+                            size_t         animSetIndex,
+                            size_t         frameIndex,
+                      const CSR_Matrix4*   pInitialMatrix)
+{
+    size_t                     i;
+    const CSR_Animation_Bone** pAnimations;
+
+    // validate the inputs
+    if (!pPose || !pPose->m_Count)
+        return 0;
+
+    // get the animations to apply, if any
+    if (pPose->m_pAnimations && animSetIndex < pPose->m_AnimSetCount)
+        pAnimations = &pPose->m_pAnimations[animSetIndex * pPose->m_Count];
+    else
+        pAnimations = 0;
+
+    // iterate through bones, each parent is calculated before its children
+    for (i = 0; i < pPose->m_Count; ++i)
+    {
+        CSR_Matrix4  animMatrix;
+        size_t*      pCursors    = pPose->m_pCursors ? &pPose->m_pCursors[i * pPose->m_CursorCount] : 0;
+        const size_t parentIndex = pPose->m_pParentIndex[i];
+
+        // get the animated bone matrix matching with frame. If not found use the default one
+        if (!pAnimations || !csrBoneAnimGetFrameMatrix(pAnimations[i], frameIndex, pCursors, &animMatrix))
+            animMatrix = pPose->m_pBones[i]->m_Matrix;
+
+        // stack the bone matrix with its parent one, or with the initial one for a root bone
+        if (parentIndex != (size_t)M_CSR_Unknown_Index)
+            csrMat4Multiply(&animMatrix, &pPose->m_pMatrices[parentIndex], &pPose->m_pMatrices[i]);
+        else
+        if (pInitialMatrix)
+            csrMat4Multiply(&animMatrix, pInitialMatrix, &pPose->m_pMatrices[i]);
+        else
+            pPose->m_pMatrices[i] = animMatrix;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrBonePoseGetSkinMatrices(const CSR_Bone_Pose*          pPose,
+                               const CSR_Skin_Weights_Group* pGroup,
+                                     CSR_Matrix4*            pMatrices)
+{
+    size_t i;
+
+    // validate the inputs
+    if (!pPose || !pGroup || !pMatrices)
+        return 0;
+
+    // iterate through skin weights
+    for (i = 0; i < pGroup->m_Count; ++i)
+    {
+        const size_t boneIndex = pGroup->m_pSkinWeights[i].m_BoneIndex;
+
+        // the skin weights should be linked to a bone of the pose
+        if (boneIndex >= pPose->m_Count)
+            return 0;
+
+        // get the final matrix, which transforms the vertices to the bone space, then applies the bone
+        csrMat4Multiply(&pGroup->m_pSkinWeights[i].m_Matrix, &pPose->m_pMatrices[boneIndex], &pMatrices[i]);
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+// Bone clip private functions
+//---------------------------------------------------------------------------
+unsigned short csrBoneClipQuantize(float value, float min, float range)
+{
+    // all the values are identical?
+    if (range <= 0.0f)
+        return 0;
+
+    // get the value in the [0, 1] range
+    value = (value - min) / range;
+
+    if (value < 0.0f)
+        value = 0.0f;
+    else
+    if (value > 1.0f)
+        value = 1.0f;
+
+    return (unsigned short)((value * 65535.0f) + 0.5f);
+}
+//---------------------------------------------------------------------------
+float csrBoneClipDequantize(unsigned short value, float min, float range)
+{
+    return min + ((range * (float)value) / 65535.0f);
+}
+//---------------------------------------------------------------------------
+void csrBoneClipDecompose(const CSR_Matrix4*    pMatrix,
+                                CSR_Quaternion* pRotation,
+                                CSR_Vector3*    pPosition,
+                                CSR_Vector3*    pScaling)
+{
+    size_t i;
+    size_t j;
+    float  scaling[3];
+    float  determinant;
+
+    #ifdef _MSC_VER
+        CSR_Matrix4 rotateMatrix = {0};
+    #else
+        CSR_Matrix4 rotateMatrix;
+    #endif
+
+    csrMat4Identity(&rotateMatrix);
+
+    // the scaling is the length of each matrix axis, and the rotation is the normalized axis
+    for (i = 0; i < 3; ++i)
+    {
+        scaling[i] = sqrtf((pMatrix->m_Table[i][0] * pMatrix->m_Table[i][0]) +
+                           (pMatrix->m_Table[i][1] * pMatrix->m_Table[i][1]) +
+                           (pMatrix->m_Table[i][2] * pMatrix->m_Table[i][2]));
+
+        if (scaling[i])
+            for (j = 0; j < 3; ++j)
+                rotateMatrix.m_Table[i][j] = pMatrix->m_Table[i][j] / scaling[i];
+    }
+
+    // calculate the axes determinant
+    determinant = rotateMatrix.m_Table[0][0] * ((rotateMatrix.m_Table[1][1] * rotateMatrix.m_Table[2][2]) -
+                                                (rotateMatrix.m_Table[1][2] * rotateMatrix.m_Table[2][1])) -
+                  rotateMatrix.m_Table[0][1] * ((rotateMatrix.m_Table[1][0] * rotateMatrix.m_Table[2][2]) -
+                                                (rotateMatrix.m_Table[1][2] * rotateMatrix.m_Table[2][0])) +
+                  rotateMatrix.m_Table[0][2] * ((rotateMatrix.m_Table[1][0] * rotateMatrix.m_Table[2][1]) -
+                                                (rotateMatrix.m_Table[1][1] * rotateMatrix.m_Table[2][0]));
+
+    // is the matrix mirrored? In this case the axes aren't a rotation, so negate the x axis and keep
+    // the mirror as a negative x scaling, which csrBoneClipCompose() will restore
+    if (determinant < 0.0f)
+    {
+        scaling[0] = -scaling[0];
+
+        for (j = 0; j < 3; ++j)
+            rotateMatrix.m_Table[0][j] = -rotateMatrix.m_Table[0][j];
+    }
+
+    // get the rotation. NOTE csrQuatFromMatrix() returns the inverse of the rotation csrQuatToMatrix() builds,
+    // and the quaternion should be normalized, because a sheared matrix doesn't contain a pure rotation
+    csrQuatFromMatrix(&rotateMatrix, pRotation);
+    csrQuatConjugate(pRotation, pRotation);
+    csrQuatNormalize(pRotation, pRotation);
+
+    pScaling->m_X = scaling[0];
+    pScaling->m_Y = scaling[1];
+    pScaling->m_Z = scaling[2];
+
+    pPosition->m_X = pMatrix->m_Table[3][0];
+    pPosition->m_Y = pMatrix->m_Table[3][1];
+    pPosition->m_Z = pMatrix->m_Table[3][2];
+}
+//---------------------------------------------------------------------------
+void csrBoneClipCompose(const CSR_Quaternion* pRotation,
+                        const CSR_Vector3*    pPosition,
+                        const CSR_Vector3*    pScaling,
+                              CSR_Matrix4*    pMatrix)
+{
+    size_t i;
+
+    // build the rotation matrix, then scale each axis and apply the translation
+    csrQuatToMatrix(pRotation, pMatrix);
+
+    for (i = 0; i < 3; ++i)
+    {
+        pMatrix->m_Table[0][i] *= pScaling->m_X;
+        pMatrix->m_Table[1][i] *= pScaling->m_Y;
+        pMatrix->m_Table[2][i] *= pScaling->m_Z;
+    }
+
+    pMatrix->m_Table[3][0] = pPosition->m_X;
+    pMatrix->m_Table[3][1] = pPosition->m_Y;
+    pMatrix->m_Table[3][2] = pPosition->m_Z;
+}
+//---------------------------------------------------------------------------
+void csrBoneClipReadQuantized(const CSR_Bone_Clip*  pClip,
+                                    size_t          index,
+                                    CSR_Quaternion* pRotation,
+                                    CSR_Vector3*    pPosition,
+                                    CSR_Vector3*    pScaling)
+{
+    const unsigned short* pValues = &pClip->m_pQuantized[index * M_CSR_Quantized_Bone_Size];
+
+    // read the rotation, each quaternion value is between -1 and 1
+    pRotation->m_X = csrBoneClipDequantize(pValues[0], -1.0f, 2.0f);
+    pRotation->m_Y = csrBoneClipDequantize(pValues[1], -1.0f, 2.0f);
+    pRotation->m_Z = csrBoneClipDequantize(pValues[2], -1.0f, 2.0f);
+    pRotation->m_W = csrBoneClipDequantize(pValues[3], -1.0f, 2.0f);
+    csrQuatNormalize(pRotation, pRotation);
+
+    // read the translation
+    pPosition->m_X = csrBoneClipDequantize(pValues[4], pClip->m_PosMin.m_X, pClip->m_PosRange.m_X);
+    pPosition->m_Y = csrBoneClipDequantize(pValues[5], pClip->m_PosMin.m_Y, pClip->m_PosRange.m_Y);
+    pPosition->m_Z = csrBoneClipDequantize(pValues[6], pClip->m_PosMin.m_Z, pClip->m_PosRange.m_Z);
+
+    // read the scaling
+    pScaling->m_X = csrBoneClipDequantize(pValues[7], pClip->m_ScaleMin.m_X, pClip->m_ScaleRange.m_X);
+    pScaling->m_Y = csrBoneClipDequantize(pValues[8], pClip->m_ScaleMin.m_Y, pClip->m_ScaleRange.m_Y);
+    pScaling->m_Z = csrBoneClipDequantize(pValues[9], pClip->m_ScaleMin.m_Z, pClip->m_ScaleRange.m_Z);
+}
+//---------------------------------------------------------------------------
+void csrBoneClipBlend(const CSR_Quaternion* pRotation,
+                      const CSR_Vector3*    pPosition,
+                      const CSR_Vector3*    pScaling,
+                      const CSR_Quaternion* pNextRotation,
+                      const CSR_Vector3*    pNextPosition,
+                      const CSR_Vector3*    pNextScaling,
+                            float           interpolation,
+                            CSR_Matrix4*    pMatrix)
+{
+    #ifdef _MSC_VER
+        CSR_Quaternion rotation = {0};
+        CSR_Vector3    position = {0};
+        CSR_Vector3    scaling  = {0};
+    #else
+        CSR_Quaternion rotation;
+        CSR_Vector3    position;
+        CSR_Vector3    scaling;
+    #endif
+
+    // slerp the rotation, and lerp the translation and scaling
+    csrQuatSlerp(pRotation, pNextRotation, interpolation, &rotation);
+    position.m_X = pPosition->m_X + ((pNextPosition->m_X - pPosition->m_X) * interpolation);
+    position.m_Y = pPosition->m_Y + ((pNextPosition->m_Y - pPosition->m_Y) * interpolation);
+    position.m_Z = pPosition->m_Z + ((pNextPosition->m_Z - pPosition->m_Z) * interpolation);
+    scaling.m_X  = pScaling->m_X  + ((pNextScaling->m_X  - pScaling->m_X)  * interpolation);
+    scaling.m_Y  = pScaling->m_Y  + ((pNextScaling->m_Y  - pScaling->m_Y)  * interpolation);
+    scaling.m_Z  = pScaling->m_Z  + ((pNextScaling->m_Z  - pScaling->m_Z)  * interpolation);
+
+    // build the bone matrix
+    csrBoneClipCompose(&rotation, &position, &scaling, pMatrix);
+}
+//---------------------------------------------------------------------------
+int csrBoneClipQuantizeMatrices(const CSR_Matrix4* pMatrices, size_t count, CSR_Bone_Clip* pClip)
+{
+    size_t i;
+
+    #ifdef _MSC_VER
+        CSR_Quaternion rotation = {0};
+        CSR_Vector3    position = {0};
+        CSR_Vector3    scaling  = {0};
+        CSR_Vector3    posMax   = {0};
+        CSR_Vector3    scaleMax = {0};
+    #else
+        CSR_Quaternion rotation;
+        CSR_Vector3    position;
+        CSR_Vector3    scaling;
+        CSR_Vector3    posMax;
+        CSR_Vector3    scaleMax;
+    #endif
+
+    // nothing to quantize?
+    if (!count)
+        return 0;
+
+    // allocate memory for the quantized bones
+    pClip->m_pQuantized =
+            (unsigned short*)malloc(count * M_CSR_Quantized_Bone_Size * sizeof(unsigned short));
+
+    // succeeded?
+    if (!pClip->m_pQuantized)
+        return 0;
+
+    // calculate the translation and scaling bounds, starting from the first bone
+    csrBoneClipDecompose(&pMatrices[0], &rotation, &position, &scaling);
+
+    pClip->m_PosMin   = position;
+    posMax            = position;
+    pClip->m_ScaleMin = scaling;
+    scaleMax          = scaling;
+
+    for (i = 1; i < count; ++i)
+    {
+        csrBoneClipDecompose(&pMatrices[i], &rotation, &position, &scaling);
+
+        pClip->m_PosMin.m_X   = position.m_X < pClip->m_PosMin.m_X   ? position.m_X : pClip->m_PosMin.m_X;
+        pClip->m_PosMin.m_Y   = position.m_Y < pClip->m_PosMin.m_Y   ? position.m_Y : pClip->m_PosMin.m_Y;
+        pClip->m_PosMin.m_Z   = position.m_Z < pClip->m_PosMin.m_Z   ? position.m_Z : pClip->m_PosMin.m_Z;
+        posMax.m_X            = position.m_X > posMax.m_X            ? position.m_X : posMax.m_X;
+        posMax.m_Y            = position.m_Y > posMax.m_Y            ? position.m_Y : posMax.m_Y;
+        posMax.m_Z            = position.m_Z > posMax.m_Z            ? position.m_Z : posMax.m_Z;
+        pClip->m_ScaleMin.m_X = scaling.m_X  < pClip->m_ScaleMin.m_X ? scaling.m_X  : pClip->m_ScaleMin.m_X;
+        pClip->m_ScaleMin.m_Y = scaling.m_Y  < pClip->m_ScaleMin.m_Y ? scaling.m_Y  : pClip->m_ScaleMin.m_Y;
+        pClip->m_ScaleMin.m_Z = scaling.m_Z  < pClip->m_ScaleMin.m_Z ? scaling.m_Z  : pClip->m_ScaleMin.m_Z;
+        scaleMax.m_X          = scaling.m_X  > scaleMax.m_X          ? scaling.m_X  : scaleMax.m_X;
+        scaleMax.m_Y          = scaling.m_Y  > scaleMax.m_Y          ? scaling.m_Y  : scaleMax.m_Y;
+        scaleMax.m_Z          = scaling.m_Z  > scaleMax.m_Z          ? scaling.m_Z  : scaleMax.m_Z;
+    }
+
+    csrVec3Sub(&posMax,   &pClip->m_PosMin,   &pClip->m_PosRange);
+    csrVec3Sub(&scaleMax, &pClip->m_ScaleMin, &pClip->m_ScaleRange);
+
+    // quantize the bones
+    for (i = 0; i < count; ++i)
+    {
+        unsigned short* pValues = &pClip->m_pQuantized[i * M_CSR_Quantized_Bone_Size];
+
+        csrBoneClipDecompose(&pMatrices[i], &rotation, &position, &scaling);
+
+        pValues[0] = csrBoneClipQuantize(rotation.m_X, -1.0f, 2.0f);
+        pValues[1] = csrBoneClipQuantize(rotation.m_Y, -1.0f, 2.0f);
+        pValues[2] = csrBoneClipQuantize(rotation.m_Z, -1.0f, 2.0f);
+        pValues[3] = csrBoneClipQuantize(rotation.m_W, -1.0f, 2.0f);
+        pValues[4] = csrBoneClipQuantize(position.m_X, pClip->m_PosMin.m_X,   pClip->m_PosRange.m_X);
+        pValues[5] = csrBoneClipQuantize(position.m_Y, pClip->m_PosMin.m_Y,   pClip->m_PosRange.m_Y);
+        pValues[6] = csrBoneClipQuantize(position.m_Z, pClip->m_PosMin.m_Z,   pClip->m_PosRange.m_Z);
+        pValues[7] = csrBoneClipQuantize(scaling.m_X,  pClip->m_ScaleMin.m_X, pClip->m_ScaleRange.m_X);
+        pValues[8] = csrBoneClipQuantize(scaling.m_Y,  pClip->m_ScaleMin.m_Y, pClip->m_ScaleRange.m_Y);
+        pValues[9] = csrBoneClipQuantize(scaling.m_Z,  pClip->m_ScaleMin.m_Z, pClip->m_ScaleRange.m_Z);
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+// Bone clip functions
+//---------------------------------------------------------------------------
+CSR_Bone_Clip* csrBoneClipCreate(void)
+{
+    // create a new bone clip
+    CSR_Bone_Clip* pClip = (CSR_Bone_Clip*)malloc(sizeof(CSR_Bone_Clip));
+
+    // succeeded?
+    if (!pClip)
+        return 0;
+
+    // initialize the bone clip content
+    csrBoneClipInit(pClip);
+
+    return pClip;
+}
+//---------------------------------------------------------------------------
+void csrBoneClipRelease(CSR_Bone_Clip* pClip, int contentOnly)
+{
+    // no bone clip to release?
+    if (!pClip)
+        return;
+
+    // free the bone clip content
+    free(pClip->m_pMatrices);
+    free(pClip->m_pQuantized);
+
+    // free the bone clip
+    if (!contentOnly)
+        free(pClip);
+}
+//---------------------------------------------------------------------------
+void csrBoneClipInit(CSR_Bone_Clip* pClip)
+{
+    // no bone clip to initialize?
+    if (!pClip)
+        return;
+
+    // initialize the bone clip content
+    pClip->m_pMatrices      = 0;
+    pClip->m_pQuantized     = 0;
+    pClip->m_PosMin.m_X     = 0.0f;
+    pClip->m_PosMin.m_Y     = 0.0f;
+    pClip->m_PosMin.m_Z     = 0.0f;
+    pClip->m_PosRange.m_X   = 0.0f;
+    pClip->m_PosRange.m_Y   = 0.0f;
+    pClip->m_PosRange.m_Z   = 0.0f;
+    pClip->m_ScaleMin.m_X   = 0.0f;
+    pClip->m_ScaleMin.m_Y   = 0.0f;
+    pClip->m_ScaleMin.m_Z   = 0.0f;
+    pClip->m_ScaleRange.m_X = 0.0f;
+    pClip->m_ScaleRange.m_Y = 0.0f;
+    pClip->m_ScaleRange.m_Z = 0.0f;
+    pClip->m_BoneCount      = 0;
+    pClip->m_SampleCount    = 0;
+    pClip->m_FrameStep      = 0;
+}
+//---------------------------------------------------------------------------
+int csrBoneClipBake(      CSR_Bone_Pose* pPose,
+                          size_t         animSetIndex,
+                          size_t         frameCount,
+                          size_t         frameStep,
+                    const CSR_Matrix4*   pInitialMatrix,
+                          int            quantize,
+                          CSR_Bone_Clip* pClip)
+{
+    size_t       i;
+    size_t       sampleCount;
+    CSR_Matrix4* pMatrices;
+
+    // validate the inputs
+    if (!pPose || !pPose->m_Count || !frameCount || !frameStep || !pClip)
+        return 0;
+
+    // the animation set should be linked to the pose
+    if (!pPose->m_pAnimations || animSetIndex >= pPose->m_AnimSetCount)
+        return 0;
+
+    // get the sample count
+    sampleCount = (frameCount + frameStep - 1) / frameStep;
+
+    // allocate memory for the sampled bones
+    pMatrices = (CSR_Matrix4*)malloc(sampleCount * pPose->m_Count * sizeof(CSR_Matrix4));
+
+    // succeeded?
+    if (!pMatrices)
+        return 0;
+
+    // sample the animation
+    for (i = 0; i < sampleCount; ++i)
+    {
+        if (!csrBonePoseUpdate(pPose, animSetIndex, i * frameStep, pInitialMatrix))
+        {
+            free(pMatrices);
+            return 0;
+        }
+
+        memcpy(&pMatrices[i * pPose->m_Count], pPose->m_pMatrices, pPose->m_Count * sizeof(CSR_Matrix4));
+    }
+
+    // replace the previous clip content, if any
+    csrBoneClipRelease(pClip, 1);
+    csrBoneClipInit(pClip);
+
+    pClip->m_BoneCount   = pPose->m_Count;
+    pClip->m_SampleCount = sampleCount;
+    pClip->m_FrameStep   = frameStep;
+
+    // keep the matrices as is?
+    if (!quantize)
+    {
+        pClip->m_pMatrices = pMatrices;
+        return 1;
+    }
+
+    // quantize the sampled bones
+    if (!csrBoneClipQuantizeMatrices(pMatrices, sampleCount * pPose->m_Count, pClip))
+    {
+        free(pMatrices);
+        csrBoneClipInit(pClip);
+        return 0;
+    }
+
+    free(pMatrices);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrBoneClipGetPose(const CSR_Bone_Clip* pClip, float frame, CSR_Bone_Pose* pPose)
+{
+    size_t i;
+    size_t sample;
+    size_t nextSample;
+    float  length;
+    float  position;
+    float  interpolation;
+
+    // validate the inputs
+    if (!pClip || !pPose || !pClip->m_SampleCount || !pClip->m_FrameStep)
+        return 0;
+
+    // the clip should be baked from the same skeleton
+    if (pClip->m_BoneCount != pPose->m_Count)
+        return 0;
+
+    // get the frame in the clip, which loops after its last sample
+    length = (float)(pClip->m_SampleCount * pClip->m_FrameStep);
+    frame  = fmodf(frame, length);
+
+    if (frame < 0.0f)
+        frame += length;
+
+    // get the samples surrounding the frame, and the interpolation between them
+    position      = frame / (float)pClip->m_FrameStep;
+    sample        = (size_t)position;
+    sample        = sample < pClip->m_SampleCount ? sample : pClip->m_SampleCount - 1;
+    nextSample    = (sample + 1) % pClip->m_SampleCount;
+    interpolation = position - (float)sample;
+
+    // are the bones stored as matrices?
+    if (pClip->m_pMatrices)
+    {
+        const CSR_Matrix4* pMatrices     = &pClip->m_pMatrices[sample     * pClip->m_BoneCount];
+        const CSR_Matrix4* pNextMatrices = &pClip->m_pMatrices[nextSample * pClip->m_BoneCount];
+
+        // is the frame exactly on the sample?
+        if (!interpolation)
+        {
+            memcpy(pPose->m_pMatrices, pMatrices, pClip->m_BoneCount * sizeof(CSR_Matrix4));
+            return 1;
+        }
+
+        // blend the 2 samples
+        for (i = 0; i < pClip->m_BoneCount; ++i)
+        {
+            #ifdef _MSC_VER
+                CSR_Quaternion rotation     = {0};
+                CSR_Quaternion nextRotation = {0};
+                CSR_Vector3    position     = {0};
+                CSR_Vector3    nextPosition = {0};
+                CSR_Vector3    scaling      = {0};
+                CSR_Vector3    nextScaling  = {0};
+            #else
+                CSR_Quaternion rotation;
+                CSR_Quaternion nextRotation;
+                CSR_Vector3    position;
+                CSR_Vector3    nextPosition;
+                CSR_Vector3    scaling;
+                CSR_Vector3    nextScaling;
+            #endif
+
+            // decompose the bone from the 2 samples, blending the raw matrices would shrink the rotations
+            csrBoneClipDecompose(&pMatrices[i],     &rotation,     &position,     &scaling);
+            csrBoneClipDecompose(&pNextMatrices[i], &nextRotation, &nextPosition, &nextScaling);
+
+            csrBoneClipBlend(&rotation,
+                             &position,
+                             &scaling,
+                             &nextRotation,
+                             &nextPosition,
+                             &nextScaling,
+                              interpolation,
+                             &pPose->m_pMatrices[i]);
+        }
+
+        return 1;
+    }
+
+    // no bones?
+    if (!pClip->m_pQuantized)
+        return 0;
+
+    // iterate through bones to restore
+    for (i = 0; i < pClip->m_BoneCount; ++i)
+    {
+        #ifdef _MSC_VER
+            CSR_Quaternion rotation     = {0};
+            CSR_Quaternion nextRotation = {0};
+            CSR_Vector3    position     = {0};
+            CSR_Vector3    nextPosition = {0};
+            CSR_Vector3    scaling      = {0};
+            CSR_Vector3    nextScaling  = {0};
+        #else
+            CSR_Quaternion rotation;
+            CSR_Quaternion nextRotation;
+            CSR_Vector3    position;
+            CSR_Vector3    nextPosition;
+            CSR_Vector3    scaling;
+            CSR_Vector3    nextScaling;
+        #endif
+
+        // read the bone from the 2 samples
+        csrBoneClipReadQuantized(pClip, (sample     * pClip->m_BoneCount) + i, &rotation,     &position,     &scaling);
+        csrBoneClipReadQuantized(pClip, (nextSample * pClip->m_BoneCount) + i, &nextRotation, &nextPosition, &nextScaling);
+
+        // blend them and build the bone matrix
+        csrBoneClipBlend(&rotation,
+                         &position,
+                         &scaling,
+                         &nextRotation,
+                         &nextPosition,
+                         &nextScaling,
+                          interpolation,
+                         &pPose->m_pMatrices[i]);
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+// Model functions
+//---------------------------------------------------------------------------
+CSR_Model* csrModelCreate(void)
+{
+    // create a new model
+    CSR_Model* pModel = (CSR_Model*)malloc(sizeof(CSR_Model));
+
+    // succeeded?
+    if (!pModel)
+        return 0;
+
+    // initialize the model content
+    csrModelInit(pModel);
+
+    return pModel;
+}
+//---------------------------------------------------------------------------
+void csrModelRelease(CSR_Model* pModel, const CSR_fOnDeleteTexture fOnDeleteTexture)
+{
+    size_t i;
+    size_t j;
+
+    // no model to release?
+    if (!pModel)
+        return;
+
+    // do free the meshes content?
+    if (pModel->m_pMesh)
+    {
+        // iterate through meshes to free
+        for (i = 0; i < pModel->m_MeshCount; ++i)
+        {
+            // delete the skin
+            csrSkinContentRelease(&pModel->m_pMesh[i].m_Skin, fOnDeleteTexture);
+
+            // do free the mesh vertex buffer?
+            if (pModel->m_pMesh[i].m_pVB)
+            {
+                // free the mesh vertex buffer content
+                for (j = 0; j < pModel->m_pMesh[i].m_Count; ++j)
+                {
+                    if (pModel->m_pMesh[i].m_pVB[j].m_pData)
+                        free(pModel->m_pMesh[i].m_pVB[j].m_pData);
+
+                    if (pModel->m_pMesh[i].m_pVB[j].m_Index.m_pData)
+                        free(pModel->m_pMesh[i].m_pVB[j].m_Index.m_pData);
+                }
+
+                // free the mesh vertex buffer
+                free(pModel->m_pMesh[i].m_pVB);
+            }
+        }
+
+        // free the meshes
+        free(pModel->m_pMesh);
+    }
+
+    // free the model
+    free(pModel);
+}
+//---------------------------------------------------------------------------
+void csrModelInit(CSR_Model* pModel)
+{
+    // no model to initialize?
+    if (!pModel)
+        return;
+
+    // initialize the model content
+    pModel->m_pMesh     = 0;
+    pModel->m_MeshCount = 0;
+    pModel->m_Time      = 0.0;
+}
+//---------------------------------------------------------------------------
+// Landscape creation functions
+//---------------------------------------------------------------------------
+int csrLandscapeGenerateVertices(const CSR_PixelBuffer* pPixelBuffer,
+                                       float            height,
                                        float            scale,
                                        CSR_Buffer*      pVertices)
 {
@@ -2639,6 +3688,13 @@ CSR_Mesh* csrLandscapeCreate(const CSR_PixelBuffer*      pPixelBuffer,
     // calculate the stride
     csrVertexFormatCalculateStride(&pMesh->m_pVB->m_Format);
 
+    // reserve the memory for all the vertices at once
+    if (!csrVertexBufferReserve((size_t)(pPixelBuffer->m_Width - 1) * (size_t)(pPixelBuffer->m_Height - 1) * 6, pMesh->m_pVB))
+    {
+        csrMeshRelease(pMesh, 0);
+        return 0;
+    }
+
     // generate landscape XYZ vertex from grayscale image
     if (!csrLandscapeGenerateVertices(pPixelBuffer, height, scale, &vertices))
     {
@@ -2779,6 +3835,13 @@ CSR_Mesh* csrLandscapeCreate(const CSR_PixelBuffer*      pPixelBuffer,
     if (vertices.m_Length)
         free(vertices.m_pData);
 
+    // share the vertices used by several polygons
+    if (!csrMeshWeld(pMesh))
+    {
+        csrMeshRelease(pMesh, 0);
+        return 0;
+    }
+
     return pMesh;
 }
 //---------------------------------------------------------------------------
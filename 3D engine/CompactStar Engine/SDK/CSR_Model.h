@@ -22,6 +22,12 @@
 #include "CSR_Vertex.h"
 #include "CSR_Texture.h"
 
+//---------------------------------------------------------------------------
+// Global defines
+//---------------------------------------------------------------------------
+#define M_CSR_Max_Bone_Influences 4
+#define M_CSR_Quantized_Bone_Size 10
+
 //---------------------------------------------------------------------------
 // Enumerators
 //---------------------------------------------------------------------------
@@ -91,6 +97,7 @@ typedef struct
 {
     char*                        m_pBoneName;       // linked bone name
     CSR_Bone*                    m_pBone;           // linked bone
+    size_t                       m_BoneIndex;       // linked bone index in the model bone pose
     CSR_Matrix4                  m_Matrix;          // matrix to transform the mesh vertices to the bone space
     size_t                       m_MeshIndex;       // source mesh index
     CSR_Skin_Weight_Index_Table* m_pIndexTable;     // table containing the indices of the vertices to modify in the source mesh
@@ -100,34 +107,41 @@ typedef struct
 } CSR_Skin_Weights;
 
 /**
-* Skin weights group
-*@note Generally used to contain all skin weights belonging to a mesh
+* Vertex skin weights, it's the skin weights converted per vertex, i.e. for each vertex the bones
+* influencing it and their weights, in a format which may be sent as is to a vertex shader
 */
 typedef struct
 {
-    CSR_Skin_Weights* m_pSkinWeights; // skin weights list
-    size_t            m_Count;        // skin weights count
-} CSR_Skin_Weights_Group;
+    float* m_pData; // for each vertex, M_CSR_Max_Bone_Influences bone indices followed by their weights
+    size_t m_Count; // vertex count
+} CSR_Skin_Vertex_Weights;
 
 /**
-* Animation key, may be a rotation, a translation, a scale, a matrix, ...
+* Skin weights group
+*@note Generally used to contain all skin weights belonging to a mesh
 */
 typedef struct
 {
-    size_t m_Frame;
-    float* m_pValues;
-    size_t m_Count;
-} CSR_AnimationKey;
+    CSR_Skin_Weights*       m_pSkinWeights;  // skin weights list
+    size_t                  m_Count;         // skin weights count
+    CSR_Skin_Vertex_Weights m_VertexWeights; // same skin weights, converted per vertex
+    CSR_Matrix4*            m_pMatrices;     // final matrix of each skin weights, for the frame to draw
+    CSR_VertexBuffer        m_SkinnedVB;     // mesh vertices with the skin weights applied by the CPU, empty if unused
+} CSR_Skin_Weights_Group;
 
 /**
-* Animation key list
+* Animation key list, each key may be a rotation, a translation, a scale, a matrix, ...
+*@note The key frames and values are stored in 2 contiguous arrays, the values of the key at index i
+*      begin at m_pValues[i * m_Stride]
 */
 typedef struct
 {
-    CSR_EAnimKeyType  m_Type;
-    CSR_AnimationKey* m_pKey;
-    size_t            m_Count;
-    int               m_ColOverRow;
+    CSR_EAnimKeyType m_Type;
+    size_t*          m_pFrames;    // key frames, sorted in ascending order
+    float*           m_pValues;    // key values
+    size_t           m_Stride;     // value count per key
+    size_t           m_Count;      // key count
+    int              m_ColOverRow;
 } CSR_AnimationKeys;
 
 /**
@@ -160,6 +174,39 @@ typedef struct
     size_t              m_Count;
 } CSR_AnimationSet_Bone;
 
+/**
+* Bone pose, it's the final matrix of each bone composing a skeleton, calculated at once for a frame
+*/
+typedef struct
+{
+    const CSR_Bone**           m_pBones;       // bones, each parent is always placed before its children
+    size_t*                    m_pParentIndex; // parent index for each bone, M_CSR_Unknown_Index for a root bone
+    const CSR_Animation_Bone** m_pAnimations;  // for each animation set and each bone, the bone animation, 0 if none
+    size_t                     m_AnimSetCount; // animation set count
+    size_t*                    m_pCursors;     // for each bone, the playback cursor of each animation key list
+    size_t                     m_CursorCount;  // playback cursor count per bone
+    CSR_Matrix4*               m_pMatrices;    // final matrix for each bone, calculated for the last updated frame
+    size_t                     m_Count;        // bone count
+} CSR_Bone_Pose;
+
+/**
+* Baked bone animation clip, contains the bone pose matrices sampled at a fixed rate from an animation set
+*@note If quantized, each bone of each sample is stored as a rotation quaternion, a translation and a
+*      scaling, each value on 16 bits, in this order
+*/
+typedef struct
+{
+    CSR_Matrix4*    m_pMatrices;    // sampled bone matrices, m_BoneCount per sample, 0 if quantized
+    unsigned short* m_pQuantized;   // quantized bones, M_CSR_Quantized_Bone_Size values per bone, 0 if not quantized
+    CSR_Vector3     m_PosMin;       // min translation of the quantized bones
+    CSR_Vector3     m_PosRange;     // translation range of the quantized bones
+    CSR_Vector3     m_ScaleMin;     // min scaling of the quantized bones
+    CSR_Vector3     m_ScaleRange;   // scaling range of the quantized bones
+    size_t          m_BoneCount;    // bone count, should match with the bone pose one
+    size_t          m_SampleCount;  // sample count
+    size_t          m_FrameStep;    // animation frame count between 2 samples
+} CSR_Bone_Clip;
+
 /**
 * Model, it's a collection of meshes, each of them represent a frame. The model may be animated, by
 * showing each frame, one after the other
@@ -497,28 +544,36 @@ typedef void (*CSR_fOnApplySkin)(size_t index, const CSR_Skin* pSkin, int* pCanR
         void csrSkinWeightsInit(CSR_Skin_Weights* pSkinWeights);
 
         //-------------------------------------------------------------------
-        // Animation key functions
+        // Vertex skin weights functions
         //-------------------------------------------------------------------
 
         /**
-        * Creates an animation key
-        *@return newly created animation key, 0 on error
-        *@note The animation key must be released when no longer used, see csrAnimationKeyRelease()
+        * Converts a skin weights group to vertex skin weights
+        *@param pGroup - skin weights group to convert
+        *@param pVB - vertex buffer the skin weights group applies to
+        *@param[in, out] pVertexWeights - vertex skin weights to populate
+        *@return 1 on success, otherwise 0
+        *@note The bone indices are the skin weights indices in the group
+        *@note If more than M_CSR_Max_Bone_Influences bones influence a vertex, only the strongest are
+        *      kept, and their weights are scaled to keep the same total
+        *@note The vertex skin weights content must be released when no longer used, see
+        *      csrSkinVertexWeightsRelease()
         */
-        CSR_AnimationKey* csrAnimKeyCreate(void);
+        int csrSkinVertexWeightsFromGroup(const CSR_Skin_Weights_Group*  pGroup,
+                                          const CSR_VertexBuffer*        pVB,
+                                                CSR_Skin_Vertex_Weights* pVertexWeights);
 
         /**
-        * Releases an animation key
-        *@param[in, out] pAnimationKey - animation key to release
-        *@param contentOnly - if 1, the key content will be released, but not the key itself
+        * Releases a vertex skin weights content
+        *@param[in, out] pVertexWeights - vertex skin weights for which the content should be released
         */
-        void csrAnimKeyRelease(CSR_AnimationKey* pAnimationKey, int contentOnly);
+        void csrSkinVertexWeightsRelease(CSR_Skin_Vertex_Weights* pVertexWeights);
 
         /**
-        * Initializes an animation key structure
-        *@param[in, out] pAnimationKey - animation key to initialize
+        * Initializes a vertex skin weights structure
+        *@param[in, out] pVertexWeights - vertex skin weights to initialize
         */
-        void csrAnimKeyInit(CSR_AnimationKey* pAnimationKey);
+        void csrSkinVertexWeightsInit(CSR_Skin_Vertex_Weights* pVertexWeights);
 
         //-------------------------------------------------------------------
         // Animation keys functions
@@ -544,6 +599,29 @@ typedef void (*CSR_fOnApplySkin)(size_t index, const CSR_Skin* pSkin, int* pCanR
         */
         void csrAnimKeysInit(CSR_AnimationKeys* pAnimationKeys);
 
+        /**
+        * Finds the key to use for a frame
+        *@param pAnimationKeys - animation keys
+        *@param frame - frame for which the key should be found
+        *@return the last key index starting before or on the frame, 0 if the frame is before the
+        *        first key or if there is no key
+        */
+        size_t csrAnimKeysFind(const CSR_AnimationKeys* pAnimationKeys, size_t frame);
+
+        /**
+        * Finds the key to use for a frame, starting from a playback cursor
+        *@param pAnimationKeys - animation keys
+        *@param frame - frame for which the key should be found
+        *@param[in, out] pCursor - playback cursor, containing the key index found for the previous frame
+        *@return the last key index starting before or on the frame, 0 if the frame is before the
+        *        first key or if there is no key
+        *@note The same result as csrAnimKeysFind() is returned, but the keys are only searched if the
+        *      frame isn't on the cursor key or on the next one, so advancing the frame costs O(1)
+        */
+        size_t csrAnimKeysFindFromCursor(const CSR_AnimationKeys* pAnimationKeys,
+                                               size_t             frame,
+                                               size_t*            pCursor);
+
         //-------------------------------------------------------------------
         // Frame animation functions
         //-------------------------------------------------------------------
@@ -604,6 +682,19 @@ typedef void (*CSR_fOnApplySkin)(size_t index, const CSR_Skin* pSkin, int* pCanR
                                            size_t                 frame,
                                            CSR_Matrix4*           pMatrix);
 
+        /**
+        * Gets the animation matrix of a bone animation
+        *@param pAnimation - bone animation
+        *@param frame - animation frame
+        *@param[in, out] pCursors - playback cursor for each animation key list, ignored if 0
+        *@param[out] pMatrix - animation matrix
+        *@return 1 on success, otherwise 0
+        */
+        int csrBoneAnimGetFrameMatrix(const CSR_Animation_Bone* pAnimation,
+                                            size_t              frame,
+                                            size_t*             pCursors,
+                                            CSR_Matrix4*        pMatrix);
+
         //-------------------------------------------------------------------
         // Bone animation set functions
         //-------------------------------------------------------------------
@@ -628,6 +719,151 @@ typedef void (*CSR_fOnApplySkin)(size_t index, const CSR_Skin* pSkin, int* pCanR
         */
         void csrBoneAnimSetInit(CSR_AnimationSet_Bone* pAnimationSet);
 
+        /**
+        * Gets the frame count of an animation set
+        *@param pAnimationSet - animation set
+        *@return frame count, i.e. the highest key frame + 1, 0 if the set contains no key
+        */
+        size_t csrBoneAnimSetGetFrameCount(const CSR_AnimationSet_Bone* pAnimationSet);
+
+        //-------------------------------------------------------------------
+        // Bone pose functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a bone pose
+        *@return newly created bone pose, 0 on error
+        *@note The bone pose must be released when no longer used, see csrBonePoseRelease()
+        */
+        CSR_Bone_Pose* csrBonePoseCreate(void);
+
+        /**
+        * Releases a bone pose
+        *@param[in, out] pPose - bone pose to release
+        *@param contentOnly - if 1, the bone pose content will be released, but not the pose itself
+        *@note The bones and animations are only referenced by the pose, they are not released
+        */
+        void csrBonePoseRelease(CSR_Bone_Pose* pPose, int contentOnly);
+
+        /**
+        * Initializes a bone pose structure
+        *@param[in, out] pPose - bone pose to initialize
+        */
+        void csrBonePoseInit(CSR_Bone_Pose* pPose);
+
+        /**
+        * Adds a skeleton to a bone pose
+        *@param pRoot - skeleton root bone
+        *@param[in, out] pPose - bone pose to add to
+        *@return 1 on success, otherwise 0
+        *@note Nothing is added if the root bone already belongs to the pose
+        *@note The animation sets should be linked again after a skeleton was added
+        */
+        int csrBonePoseAddSkeleton(const CSR_Bone* pRoot, CSR_Bone_Pose* pPose);
+
+        /**
+        * Links the animation sets to a bone pose, i.e. finds once the animation of each bone
+        *@param pAnimSet - animation set array
+        *@param count - animation set count
+        *@param[in, out] pPose - bone pose to link to
+        *@return 1 on success, otherwise 0
+        */
+        int csrBonePoseLinkAnimSets(const CSR_AnimationSet_Bone* pAnimSet,
+                                          size_t                 count,
+                                          CSR_Bone_Pose*         pPose);
+
+        /**
+        * Gets the index of a bone in a bone pose
+        *@param pPose - bone pose
+        *@param pBone - bone for which the index should be get
+        *@return bone index, M_CSR_Unknown_Index if not found or on error
+        */
+        size_t csrBonePoseGetIndex(const CSR_Bone_Pose* pPose, const CSR_Bone* pBone);
+
+        /**
+        * Calculates the final matrix of all the bones for an animation frame
+        *@param[in, out] pPose - bone pose to update
+        *@param animSetIndex - animation set index, if out of bounds (e.g. M_CSR_Unknown_Index) the
+        *                      bones take their default pose
+        *@param frameIndex - frame index
+        *@param pInitialMatrix - initial matrix from which the bone matrices should be get, ignored if 0
+        *@return 1 on success, otherwise 0
+        *@note The matrices are the same as the ones got with csrBoneGetAnimMatrix() or
+        *      csrBoneGetMatrix(), but each bone is calculated only once, from its parent matrix
+        */
+        int csrBonePoseUpdate(      CSR_Bone_Pose* pPose,
+                                    size_t         animSetIndex,
+                                    size_t         frameIndex,
+                              const CSR_Matrix4*   pInitialMatrix);
+
+        /**
+        * Gets the matrices to apply to the vertices for each skin weights of a group
+        *@param pPose - bone pose, should be updated for the frame to draw
+        *@param pGroup - skin weights group
+        *@param[out] pMatrices - matrices, should contain at least one matrix per skin weights
+        *@return 1 on success, otherwise 0
+        */
+        int csrBonePoseGetSkinMatrices(const CSR_Bone_Pose*          pPose,
+                                       const CSR_Skin_Weights_Group* pGroup,
+                                             CSR_Matrix4*            pMatrices);
+
+        //-------------------------------------------------------------------
+        // Bone clip functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a bone clip
+        *@return newly created bone clip, 0 on error
+        *@note The bone clip must be released when no longer used, see csrBoneClipRelease()
+        */
+        CSR_Bone_Clip* csrBoneClipCreate(void);
+
+        /**
+        * Releases a bone clip
+        *@param[in, out] pClip - bone clip to release
+        *@param contentOnly - if 1, the bone clip content will be released, but not the clip itself
+        */
+        void csrBoneClipRelease(CSR_Bone_Clip* pClip, int contentOnly);
+
+        /**
+        * Initializes a bone clip structure
+        *@param[in, out] pClip - bone clip to initialize
+        */
+        void csrBoneClipInit(CSR_Bone_Clip* pClip);
+
+        /**
+        * Bakes an animation set into a bone clip
+        *@param[in, out] pPose - bone pose, linked to the animation set to bake
+        *@param animSetIndex - animation set index to bake
+        *@param frameCount - animation frame count to bake, starting from the frame 0
+        *@param frameStep - animation frame count between 2 samples
+        *@param pInitialMatrix - initial matrix from which the bone matrices should be get, ignored if 0
+        *@param quantize - if 1, the bones will be quantized on 16 bits, which takes about 3 times less
+        *                  memory, but is slower to restore
+        *@param[in, out] pClip - bone clip which will contain the baked animation
+        *@return 1 on success, otherwise 0
+        *@note The pose matrices are overwritten while the animation is baked
+        *@note The quantization is lossy, a bone containing a shear will not be restored. A mirrored
+        *      bone is kept as a negative x scaling
+        */
+        int csrBoneClipBake(      CSR_Bone_Pose* pPose,
+                                  size_t         animSetIndex,
+                                  size_t         frameCount,
+                                  size_t         frameStep,
+                            const CSR_Matrix4*   pInitialMatrix,
+                                  int            quantize,
+                                  CSR_Bone_Clip* pClip);
+
+        /**
+        * Gets the bone pose matching with a frame from a bone clip
+        *@param pClip - bone clip
+        *@param frame - animation frame, may be between 2 frames
+        *@param[in, out] pPose - bone pose which will receive the bone matrices
+        *@return 1 on success, otherwise 0
+        *@note The 2 samples surrounding the frame are blended, the clip loops after its last sample
+        */
+        int csrBoneClipGetPose(const CSR_Bone_Clip* pClip, float frame, CSR_Bone_Pose* pPose);
+
         //-------------------------------------------------------------------
         // Model functions
         //-------------------------------------------------------------------
@@ -97,10 +97,11 @@ void csrDrawLine(const CSR_Line* pLine, const void* pShader)
 //---------------------------------------------------------------------------
 void csrDrawVertexBuffer(const CSR_VertexBuffer* pVB,
                          const void*             pShader,
-                         const CSR_Array*        pMatrixArray)
+                         const CSR_Array*        pMatrixArray,
+                         const CSR_fOnGetID      fOnGetID)
 {
     #ifdef CSR_USE_OPENGL
-        csrOpenGLDrawVertexBuffer(pVB, (CSR_OpenGLShader*)pShader, pMatrixArray);
+        csrOpenGLDrawVertexBuffer(pVB, (CSR_OpenGLShader*)pShader, pMatrixArray, fOnGetID);
     #elif defined(CSR_USE_METAL)
         csrMetalDrawVertexBuffer(pVB, pShader, pMatrixArray);
     #else
@@ -116,11 +116,13 @@ typedef void* (*CSR_fOnGetID)(const void* pKey);
         *@param pShader - shader to use to draw the vertex buffer
         *@param pMatrixArray - matrices to use, one for each vertex buffer drawing. If 0, the model
         *                      matrix currently connected in the shader will be used
+        *@param fOnGetID - callback function to get the OpenGL identifier matching with a key
         *@note The shader must be first enabled with the csrShaderEnable() function
         */
         void csrDrawVertexBuffer(const CSR_VertexBuffer* pVB,
                                  const void*             pShader,
-                                 const CSR_Array*        pMatrixArray);
+                                 const CSR_Array*        pMatrixArray,
+                                 const CSR_fOnGetID      fOnGetID);
 
         /**
         * Draws a mesh in a scene
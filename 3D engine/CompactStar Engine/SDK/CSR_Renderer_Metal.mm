@@ -186,6 +186,7 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
 @interface CSR_MetalBasicRenderer()
 {
     IVerticesDict            m_VerticesDict;
+    IVerticesDict            m_IndicesDict;
     ITexturesDict            m_TexturesDict;
     IUniformDict             m_UniformsDict;
     IUniformBuffers          m_SkyboxUniform;
@@ -198,7 +199,7 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
 * Draws a vertex array
 *@param pRenderEncoder - render encoder to use to draw the vertex array
 *@param pVB - vertex buffer containing the vertex array to draw
-*@param vertexCount - vertex count
+*@param vertexCount - vertex count, or index count if the vertex buffer is indexed
 *@param pUniformKey - uniform key
 */
 - (void) csrMetalDrawArray :(id<MTLRenderCommandEncoder>)pRenderEncoder
@@ -321,7 +322,7 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
     [m_pRenderEncoder setDepthStencilState:m_pDepthState];
 
     // calculate the vertex count
-    const size_t vertexCount = pVB->m_Count / pVB->m_Format.m_Stride;
+    const size_t vertexCount = csrVertexBufferGetVertexCount(pVB);
 
     // do draw the vertex buffer several times?
     if (pMatrixArray && pMatrixArray->m_Count)
@@ -542,6 +543,9 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
                 continue;
             }
 
+            // initialize the local vertex buffer
+            csrVertexBufferInit(pLocalMesh->m_pVB);
+
             // bind the source vertex buffer to the local one
             pLocalMesh->m_pVB->m_Format   = pMesh->m_pVB->m_Format;
             pLocalMesh->m_pVB->m_Culling  = pMesh->m_pVB->m_Culling;
@@ -549,8 +553,9 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
             pLocalMesh->m_pVB->m_Time     = pMesh->m_pVB->m_Time;
 
             // allocate memory for the vertex buffer data
-            pLocalMesh->m_pVB->m_pData = (float*)calloc(pMesh->m_pVB->m_Count, sizeof(float));
-            pLocalMesh->m_pVB->m_Count = pMesh->m_pVB->m_Count;
+            pLocalMesh->m_pVB->m_pData    = (float*)calloc(pMesh->m_pVB->m_Count, sizeof(float));
+            pLocalMesh->m_pVB->m_Count    = pMesh->m_pVB->m_Count;
+            pLocalMesh->m_pVB->m_Capacity = pMesh->m_pVB->m_Count;
 
             if (!pLocalMesh->m_pVB->m_pData || !pLocalMesh->m_pVB->m_Count)
             {
@@ -686,7 +691,8 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
             if (pLocalMatrixArray->m_pItem)
             {
                 // update array count
-                pLocalMatrixArray->m_Count = pMatrixArray->m_Count;
+                pLocalMatrixArray->m_Count    = pMatrixArray->m_Count;
+                pLocalMatrixArray->m_Capacity = pMatrixArray->m_Count;
 
                 // iterate through source model matrices
                 for (j = 0; j < pMatrixArray->m_Count; ++j)
@@ -818,6 +824,9 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
                 continue;
             }
 
+            // initialize the local vertex buffer
+            csrVertexBufferInit(pLocalMesh->m_pVB);
+
             // bind the source vertex buffer to the local one
             pLocalMesh->m_pVB->m_Format   = pMesh->m_pVB->m_Format;
             pLocalMesh->m_pVB->m_Culling  = pMesh->m_pVB->m_Culling;
@@ -825,8 +834,9 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
             pLocalMesh->m_pVB->m_Time     = pMesh->m_pVB->m_Time;
 
             // allocate memory for the vertex buffer data
-            pLocalMesh->m_pVB->m_pData = (float*)calloc(pMesh->m_pVB->m_Count, sizeof(float));
-            pLocalMesh->m_pVB->m_Count = pMesh->m_pVB->m_Count;
+            pLocalMesh->m_pVB->m_pData    = (float*)calloc(pMesh->m_pVB->m_Count, sizeof(float));
+            pLocalMesh->m_pVB->m_Count    = pMesh->m_pVB->m_Count;
+            pLocalMesh->m_pVB->m_Capacity = pMesh->m_pVB->m_Count;
 
             if (!pLocalMesh->m_pVB->m_pData || !pLocalMesh->m_pVB->m_Count)
             {
@@ -967,7 +977,8 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
             if (pLocalMatrixArray->m_pItem)
             {
                 // update array count
-                pLocalMatrixArray->m_Count = pMatrixArray->m_Count;
+                pLocalMatrixArray->m_Count    = pMatrixArray->m_Count;
+                pLocalMatrixArray->m_Capacity = pMatrixArray->m_Count;
 
                 // iterate through source model matrices
                 for (j = 0; j < pMatrixArray->m_Count; ++j)
@@ -1079,6 +1090,21 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
 
     // keep the newly created vertex buffer reference in the vertices dictionary
     m_VerticesDict[pVB] = pVertexBuffer;
+
+    // is vertex buffer indexed?
+    if (!pVB->m_Index.m_pData)
+        return;
+
+    // get the index size
+    const size_t indexSize = (pVB->m_Index.m_Format == CSR_IF_16Bit) ? sizeof(unsigned short) : sizeof(unsigned);
+
+    // create a metal index buffer from the vertex buffer indices
+    id<MTLBuffer> pIndexBuffer = [m_pDevice newBufferWithBytes:pVB->m_Index.m_pData
+                                                        length:pVB->m_Index.m_Count * indexSize
+                                                       options:vbOptions];
+
+    // keep the newly created index buffer reference in the indices dictionary
+    m_IndicesDict[pVB] = pIndexBuffer;
 }
 //---------------------------------------------------------------------------
 - (bool) CreateTexture :(void* _Nullable)pKey :(nonnull NSURL*)pUrl
@@ -1343,6 +1369,45 @@ typedef std::map<std::string,                       id<MTLRenderPipelineState>>
     else
         return;
 
+    // is vertex buffer indexed?
+    if (pVB->m_Index.m_pData)
+    {
+        IVerticesDict::const_iterator itIndex = m_IndicesDict.find(pVB);
+
+        if (itIndex == m_IndicesDict.end())
+            return;
+
+        // get the index type
+        const MTLIndexType indexType =
+                (pVB->m_Index.m_Format == CSR_IF_16Bit) ? MTLIndexTypeUInt16 : MTLIndexTypeUInt32;
+
+        // search for array type to draw
+        switch (pVB->m_Format.m_Type)
+        {
+            case CSR_VT_Triangles:
+                [pRenderEncoder drawIndexedPrimitives:MTLPrimitiveTypeTriangle
+                                           indexCount:vertexCount
+                                            indexType:indexType
+                                          indexBuffer:itIndex->second
+                                    indexBufferOffset:0];
+                return;
+
+            case CSR_VT_TriangleStrip:
+                [pRenderEncoder drawIndexedPrimitives:MTLPrimitiveTypeTriangleStrip
+                                           indexCount:vertexCount
+                                            indexType:indexType
+                                          indexBuffer:itIndex->second
+                                    indexBufferOffset:0];
+                return;
+
+            case CSR_VT_TriangleFan:
+                @throw @"Unsupported format type - CSR_VT_TriangleFan";
+
+            default:
+                return;
+        }
+    }
+
     // search for array type to draw
     switch (pVB->m_Format.m_Type)
     {
@@ -286,17 +286,24 @@ void csrOpenGLShaderInit(CSR_OpenGLShader* pShader)
         return;
 
     // initialize the shader content
-    pShader->m_ProgramID    =  0;
-    pShader->m_VertexID     =  0;
-    pShader->m_FragmentID   =  0;
-    pShader->m_VertexSlot   = -1;
-    pShader->m_NormalSlot   = -1;
-    pShader->m_TexCoordSlot = -1;
-    pShader->m_TextureSlot  = -1;
-    pShader->m_BumpMapSlot  = -1;
-    pShader->m_CubemapSlot  = -1;
-    pShader->m_ColorSlot    = -1;
-    pShader->m_ModelSlot    = -1;
+    pShader->m_ProgramID         =  0;
+    pShader->m_VertexID          =  0;
+    pShader->m_FragmentID        =  0;
+    pShader->m_VertexSlot        = -1;
+    pShader->m_NormalSlot        = -1;
+    pShader->m_TexCoordSlot      = -1;
+    pShader->m_TextureSlot       = -1;
+    pShader->m_BumpMapSlot       = -1;
+    pShader->m_CubemapSlot       = -1;
+    pShader->m_ColorSlot         = -1;
+    pShader->m_ModelSlot         = -1;
+    pShader->m_ProjectionSlot    = -1;
+    pShader->m_ViewSlot          = -1;
+    pShader->m_InstanceModelSlot = -1;
+    pShader->m_BoneSlot          = -1;
+    pShader->m_BoneIndexSlot     = -1;
+    pShader->m_BoneWeightSlot    = -1;
+    pShader->m_BoneCount         =  0;
 }
 //---------------------------------------------------------------------------
 CSR_OpenGLShader* csrOpenGLShaderLoadFromFile(const char*               pVertex,
@@ -525,6 +532,46 @@ int csrOpenGLShaderLink(CSR_OpenGLShader* pShader)
     if (success == GL_FALSE)
         return 0;
 
+    // get the matrix slots, they will not change until the shader is linked again
+    pShader->m_ModelSlot         = glGetUniformLocation(pShader->m_ProgramID, "csr_uModel");
+    pShader->m_ProjectionSlot    = glGetUniformLocation(pShader->m_ProgramID, "csr_uProjection");
+    pShader->m_ViewSlot          = glGetUniformLocation(pShader->m_ProgramID, "csr_uView");
+    pShader->m_InstanceModelSlot = glGetAttribLocation (pShader->m_ProgramID, "csr_aModel");
+
+    // get the skinning slots
+    pShader->m_BoneSlot       = glGetUniformLocation(pShader->m_ProgramID, "csr_uBones");
+    pShader->m_BoneIndexSlot  = glGetAttribLocation (pShader->m_ProgramID, "csr_aBoneIndices");
+    pShader->m_BoneWeightSlot = glGetAttribLocation (pShader->m_ProgramID, "csr_aBoneWeights");
+    pShader->m_BoneCount      = 0;
+
+    // found the bone matrices?
+    if (pShader->m_BoneSlot >= 0)
+    {
+        GLint i;
+        GLint uniformCount;
+
+        glGetProgramiv(pShader->m_ProgramID, GL_ACTIVE_UNIFORMS, &uniformCount);
+
+        // search for the bone matrix array size
+        for (i = 0; i < uniformCount; ++i)
+        {
+            GLchar  name[32];
+            GLsizei length;
+            GLint   size;
+            GLenum  type;
+
+            glGetActiveUniform(pShader->m_ProgramID, i, sizeof(name), &length, &size, &type, name);
+
+            // found the bone matrices? NOTE depending on the driver, the array name may be
+            // suffixed by [0]
+            if (!strcmp(name, "csr_uBones") || !strcmp(name, "csr_uBones[0]"))
+            {
+                pShader->m_BoneCount = (size_t)size;
+                break;
+            }
+        }
+    }
+
     return 1;
 }
 //---------------------------------------------------------------------------
@@ -545,27 +592,17 @@ void csrOpenGLShaderEnable(const CSR_OpenGLShader* pShader)
 void csrOpenGLShaderConnectProjectionMatrix(const CSR_OpenGLShader* pShader,
                                             const CSR_Matrix4*      pMatrix)
 {
-    GLint slot;
-
-    // get the projection matrix slot from shader
-    slot = glGetUniformLocation(pShader->m_ProgramID, "csr_uProjection");
-
     // connect the projection matrix to the shader
-    if (slot >= 0)
-        glUniformMatrix4fv(slot, 1, 0, &pMatrix->m_Table[0][0]);
+    if (pShader->m_ProjectionSlot >= 0)
+        glUniformMatrix4fv(pShader->m_ProjectionSlot, 1, 0, &pMatrix->m_Table[0][0]);
 }
 //---------------------------------------------------------------------------
 void csrOpenGLShaderConnectViewMatrix(const CSR_OpenGLShader* pShader,
                                       const CSR_Matrix4*      pMatrix)
 {
-    GLint slot;
-
-    // get the view matrix slot from shader
-    slot = glGetUniformLocation(pShader->m_ProgramID, "csr_uView");
-
     // connect the view matrix to the shader
-    if (slot >= 0)
-        glUniformMatrix4fv(slot, 1, 0, &pMatrix->m_Table[0][0]);
+    if (pShader->m_ViewSlot >= 0)
+        glUniformMatrix4fv(pShader->m_ViewSlot, 1, 0, &pMatrix->m_Table[0][0]);
 }
 //---------------------------------------------------------------------------
 // Static buffer functions
@@ -636,6 +673,304 @@ void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
     pSB->m_Stride   = 0;
 }
 //---------------------------------------------------------------------------
+// Static vertex buffer private functions
+//---------------------------------------------------------------------------
+void csrOpenGLVertexBufferLinkSlots(const CSR_VertexBuffer* pVB,
+                                    const CSR_OpenGLShader* pShader,
+                                    const float*            pData)
+{
+    size_t        offset;
+    const GLsizei stride = (GLsizei)(pVB->m_Format.m_Stride * sizeof(float));
+
+    // enable vertex slot
+    glEnableVertexAttribArray(pShader->m_VertexSlot);
+
+    // enable normal slot
+    if (pVB->m_Format.m_HasNormal)
+        glEnableVertexAttribArray(pShader->m_NormalSlot);
+
+    // enable texture slot
+    if (pVB->m_Format.m_HasTexCoords)
+        glEnableVertexAttribArray(pShader->m_TexCoordSlot);
+
+    // enable color slot
+    if (pVB->m_Format.m_HasPerVertexColor)
+        glEnableVertexAttribArray(pShader->m_ColorSlot);
+
+    offset = 0;
+
+    // send vertices to shader. NOTE if no data is provided, the offsets are relative to the
+    // currently bound GPU vertex buffer
+    glVertexAttribPointer(pShader->m_VertexSlot,
+                          3,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          stride,
+                          pData ? (const GLvoid*)&pData[offset] : (const GLvoid*)(offset * sizeof(float)));
+
+    offset += 3;
+
+    // vertices have normals?
+    if (pVB->m_Format.m_HasNormal)
+    {
+        // send normals to shader
+        glVertexAttribPointer(pShader->m_NormalSlot,
+                              3,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              stride,
+                              pData ? (const GLvoid*)&pData[offset] : (const GLvoid*)(offset * sizeof(float)));
+
+        offset += 3;
+    }
+
+    // vertices have UV texture coordinates?
+    if (pVB->m_Format.m_HasTexCoords)
+    {
+        // send textures to shader
+        glVertexAttribPointer(pShader->m_TexCoordSlot,
+                              2,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              stride,
+                              pData ? (const GLvoid*)&pData[offset] : (const GLvoid*)(offset * sizeof(float)));
+
+        offset += 2;
+    }
+
+    // vertices have per-vertex color?
+    if (pVB->m_Format.m_HasPerVertexColor)
+        // send colors to shader
+        glVertexAttribPointer(pShader->m_ColorSlot,
+                              4,
+                              GL_FLOAT,
+                              GL_FALSE,
+                              stride,
+                              pData ? (const GLvoid*)&pData[offset] : (const GLvoid*)(offset * sizeof(float)));
+}
+//---------------------------------------------------------------------------
+void csrOpenGLVertexBufferUnlinkSlots(const CSR_VertexBuffer* pVB, const CSR_OpenGLShader* pShader)
+{
+    // disable vertices slots from shader
+    glDisableVertexAttribArray(pShader->m_VertexSlot);
+
+    // disable normal slot
+    if (pVB->m_Format.m_HasNormal)
+        glDisableVertexAttribArray(pShader->m_NormalSlot);
+
+    // disable texture slot
+    if (pVB->m_Format.m_HasTexCoords)
+        glDisableVertexAttribArray(pShader->m_TexCoordSlot);
+
+    // disable color slot
+    if (pVB->m_Format.m_HasPerVertexColor)
+        glDisableVertexAttribArray(pShader->m_ColorSlot);
+}
+//---------------------------------------------------------------------------
+// Static vertex buffer functions
+//---------------------------------------------------------------------------
+CSR_OpenGLStaticVB* csrOpenGLStaticVBCreate(void)
+{
+    // create a new static vertex buffer
+    CSR_OpenGLStaticVB* pSVB = (CSR_OpenGLStaticVB*)malloc(sizeof(CSR_OpenGLStaticVB));
+
+    // succeeded?
+    if (!pSVB)
+        return 0;
+
+    // initialize the static vertex buffer content
+    csrOpenGLStaticVBInit(pSVB);
+
+    return pSVB;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStaticVBRelease(CSR_OpenGLStaticVB* pSVB)
+{
+    // no static vertex buffer to release?
+    if (!pSVB)
+        return;
+
+    // free the static vertex buffer content
+    csrOpenGLStaticVBContentRelease(pSVB);
+
+    // free the static vertex buffer
+    free(pSVB);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStaticVBContentRelease(CSR_OpenGLStaticVB* pSVB)
+{
+    // no static vertex buffer content to release?
+    if (!pSVB)
+        return;
+
+    #ifndef CSR_OPENGL_2_ONLY
+        // delete the vertex array object
+        if (pSVB->m_ArrayID != M_CSR_Error_Code)
+            glDeleteVertexArrays(1, &pSVB->m_ArrayID);
+    #endif
+
+    // delete the instance buffer
+    if (pSVB->m_InstanceBufferID != M_CSR_Error_Code)
+        glDeleteBuffers(1, &pSVB->m_InstanceBufferID);
+
+    // delete the skin buffer
+    if (pSVB->m_SkinBufferID != M_CSR_Error_Code)
+        glDeleteBuffers(1, &pSVB->m_SkinBufferID);
+
+    // delete the index buffer
+    if (pSVB->m_IndexBufferID != M_CSR_Error_Code)
+        glDeleteBuffers(1, &pSVB->m_IndexBufferID);
+
+    // delete the vertex buffer
+    if (pSVB->m_BufferID != M_CSR_Error_Code)
+        glDeleteBuffers(1, &pSVB->m_BufferID);
+
+    pSVB->m_BufferID         = M_CSR_Error_Code;
+    pSVB->m_IndexBufferID    = M_CSR_Error_Code;
+    pSVB->m_ArrayID          = M_CSR_Error_Code;
+    pSVB->m_InstanceBufferID = M_CSR_Error_Code;
+    pSVB->m_InstanceCapacity = 0;
+    pSVB->m_SkinBufferID     = M_CSR_Error_Code;
+    pSVB->m_pSkinData        = 0;
+    pSVB->m_pShader          = 0;
+    pSVB->m_pData            = 0;
+    pSVB->m_Count            = 0;
+    pSVB->m_IndexCount       = 0;
+}
+//---------------------------------------------------------------------------
+void csrOpenGLStaticVBInit(CSR_OpenGLStaticVB* pSVB)
+{
+    // no static vertex buffer to initialize?
+    if (!pSVB)
+        return;
+
+    // initialize the static vertex buffer content
+    pSVB->m_pKey             = 0;
+    pSVB->m_UseCount         = 0;
+    pSVB->m_BufferID         = M_CSR_Error_Code;
+    pSVB->m_IndexBufferID    = M_CSR_Error_Code;
+    pSVB->m_ArrayID          = M_CSR_Error_Code;
+    pSVB->m_InstanceBufferID = M_CSR_Error_Code;
+    pSVB->m_InstanceCapacity = 0;
+    pSVB->m_SkinBufferID     = M_CSR_Error_Code;
+    pSVB->m_pSkinData        = 0;
+    pSVB->m_pShader          = 0;
+    pSVB->m_pData            = 0;
+    pSVB->m_Count            = 0;
+    pSVB->m_IndexCount       = 0;
+    pSVB->m_Dirty            = 0;
+}
+//---------------------------------------------------------------------------
+int csrOpenGLStaticVBUpdate(const CSR_VertexBuffer*   pVB,
+                            const CSR_OpenGLShader*   pShader,
+                                  CSR_OpenGLStaticVB* pSVB)
+{
+    int upload;
+
+    // validate the inputs
+    if (!pVB || !pShader || !pSVB)
+        return 0;
+
+    // nothing to copy on the GPU side?
+    if (!pVB->m_pData || !pVB->m_Count || !pVB->m_Format.m_Stride)
+        return 0;
+
+    // check if the vertex buffer content should be copied (again) on the GPU side
+    upload = pSVB->m_Dirty                                ||
+             pSVB->m_BufferID   == M_CSR_Error_Code       ||
+             pSVB->m_pData      != pVB->m_pData           ||
+             pSVB->m_Count      != pVB->m_Count           ||
+             pSVB->m_IndexCount != pVB->m_Index.m_Count;
+
+    if (upload)
+    {
+        // create the Vertex Buffer Object (VBO) on the GPU side, if still not exists
+        if (pSVB->m_BufferID == M_CSR_Error_Code)
+            glGenBuffers(1, &pSVB->m_BufferID);
+
+        // bind the VBO
+        glBindBuffer(GL_ARRAY_BUFFER, pSVB->m_BufferID);
+
+        // copy the vertex buffer data content in the VBO. If the size didn't change, the existing
+        // GPU storage is simply overwritten, otherwise it's reallocated. A buffer which is uploaded
+        // more than once is considered as animated
+        if (pSVB->m_Count == pVB->m_Count)
+            glBufferSubData(GL_ARRAY_BUFFER, 0, pVB->m_Count * sizeof(float), pVB->m_pData);
+        else
+            glBufferData(GL_ARRAY_BUFFER,
+                         pVB->m_Count * sizeof(float),
+                         pVB->m_pData,
+                         pSVB->m_Count ? GL_DYNAMIC_DRAW : GL_STATIC_DRAW);
+
+        // unbind the VBO
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
+
+        // is vertex buffer indexed?
+        if (pVB->m_Index.m_pData && pVB->m_Index.m_Count)
+        {
+            // get the index size
+            const size_t indexSize =
+                    (pVB->m_Index.m_Format == CSR_IF_16Bit) ? sizeof(unsigned short) : sizeof(unsigned);
+
+            // create the index buffer on the GPU side, if still not exists
+            if (pSVB->m_IndexBufferID == M_CSR_Error_Code)
+                glGenBuffers(1, &pSVB->m_IndexBufferID);
+
+            // copy the indices in the index buffer
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pSVB->m_IndexBufferID);
+            glBufferData(GL_ELEMENT_ARRAY_BUFFER,
+                         pVB->m_Index.m_Count * indexSize,
+                         pVB->m_Index.m_pData,
+                         GL_STATIC_DRAW);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+        }
+        else
+        if (pSVB->m_IndexBufferID != M_CSR_Error_Code)
+        {
+            // the vertex buffer is no longer indexed, delete the previous index buffer
+            glDeleteBuffers(1, &pSVB->m_IndexBufferID);
+            pSVB->m_IndexBufferID = M_CSR_Error_Code;
+        }
+
+        // keep the uploaded content state
+        pSVB->m_pData      = pVB->m_pData;
+        pSVB->m_Count      = pVB->m_Count;
+        pSVB->m_IndexCount = pVB->m_Index.m_Count;
+        pSVB->m_Dirty      = 0;
+    }
+
+    #ifndef CSR_OPENGL_2_ONLY
+        // the Vertex Array Object (VAO) keeps the shader slots linked to the VBO, so it should be
+        // built again if the content or the shader changed
+        if (upload || pSVB->m_pShader != pShader || pSVB->m_ArrayID == M_CSR_Error_Code)
+        {
+            // delete the previous VAO, if any
+            if (pSVB->m_ArrayID != M_CSR_Error_Code)
+                glDeleteVertexArrays(1, &pSVB->m_ArrayID);
+
+            // create and bind a new VAO
+            glGenVertexArrays(1, &pSVB->m_ArrayID);
+            glBindVertexArray(pSVB->m_ArrayID);
+
+            // link the VBO content to the shader slots
+            glBindBuffer(GL_ARRAY_BUFFER, pSVB->m_BufferID);
+            csrOpenGLVertexBufferLinkSlots(pVB, pShader, 0);
+
+            // bind the index buffer, if any
+            if (pSVB->m_IndexBufferID != M_CSR_Error_Code)
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pSVB->m_IndexBufferID);
+
+            // unbind the VAO and the VBO
+            glBindVertexArray(0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        }
+    #endif
+
+    pSVB->m_pShader = pShader;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
 // Multisample antialiasing shader
 //---------------------------------------------------------------------------
 #ifndef CSR_OPENGL_2_ONLY
@@ -1055,8 +1390,25 @@ void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB)
 //---------------------------------------------------------------------------
 // Draw private functions
 //---------------------------------------------------------------------------
-void csrOpenGLDrawArray(const CSR_VertexBuffer* pVB, size_t vertexCount)
+void csrOpenGLDrawArray(const CSR_VertexBuffer* pVB, size_t vertexCount, const GLvoid* pIndices)
 {
+    // is vertex buffer indexed?
+    if (pVB->m_Index.m_pData)
+    {
+        // get the index type
+        const GLenum indexType =
+                (pVB->m_Index.m_Format == CSR_IF_16Bit) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
+
+        // search for array type to draw
+        switch (pVB->m_Format.m_Type)
+        {
+            case CSR_VT_Triangles:     glDrawElements(GL_TRIANGLES,      (GLsizei)vertexCount, indexType, pIndices);             return;
+            case CSR_VT_TriangleStrip: glDrawElements(GL_TRIANGLE_STRIP, (GLsizei)vertexCount, indexType, pIndices);             return;
+            case CSR_VT_TriangleFan:   glDrawElements(GL_TRIANGLE_FAN,   (GLsizei)vertexCount, indexType, pIndices);             return;
+            default:                                                                                                           return;
+        }
+    }
+
     // search for array type to draw
     switch (pVB->m_Format.m_Type)
     {
@@ -1067,144 +1419,260 @@ void csrOpenGLDrawArray(const CSR_VertexBuffer* pVB, size_t vertexCount)
     }
 }
 //---------------------------------------------------------------------------
-// Draw functions
-//---------------------------------------------------------------------------
-void csrOpenGLDrawBegin(const CSR_Color* pColor)
-{
-    // no background color?
-    if (!pColor)
-        return;
+#ifndef CSR_OPENGL_2_ONLY
+    void csrOpenGLDrawArrayInstanced(const CSR_VertexBuffer* pVB,
+                                           size_t            vertexCount,
+                                     const GLvoid*           pIndices,
+                                           size_t            instanceCount)
+    {
+        // is vertex buffer indexed?
+        if (pVB->m_Index.m_pData)
+        {
+            // get the index type
+            const GLenum indexType =
+                    (pVB->m_Index.m_Format == CSR_IF_16Bit) ? GL_UNSIGNED_SHORT : GL_UNSIGNED_INT;
 
-    // clear background and depth buffer
-    glClearColor(pColor->m_R, pColor->m_G, pColor->m_B, pColor->m_A);
-    glClearDepthf(1.0f);
-    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            // search for array type to draw
+            switch (pVB->m_Format.m_Type)
+            {
+                case CSR_VT_Triangles:
+                    glDrawElementsInstanced(GL_TRIANGLES,
+                                            (GLsizei)vertexCount,
+                                            indexType,
+                                            pIndices,
+                                            (GLsizei)instanceCount);
+                    return;
+
+                case CSR_VT_TriangleStrip:
+                    glDrawElementsInstanced(GL_TRIANGLE_STRIP,
+                                            (GLsizei)vertexCount,
+                                            indexType,
+                                            pIndices,
+                                            (GLsizei)instanceCount);
+                    return;
+
+                case CSR_VT_TriangleFan:
+                    glDrawElementsInstanced(GL_TRIANGLE_FAN,
+                                            (GLsizei)vertexCount,
+                                            indexType,
+                                            pIndices,
+                                            (GLsizei)instanceCount);
+                    return;
+
+                default:
+                    return;
+            }
+        }
 
-    // configure the OpenGL depth testing
-    glEnable(GL_DEPTH_TEST);
-    glDepthMask(GL_TRUE);
-    glDepthFunc(GL_LEQUAL);
-    glDepthRangef(0.0f, 1.0f);
-}
-//---------------------------------------------------------------------------
-void csrOpenGLDrawEnd(void)
-{}
+        // search for array type to draw
+        switch (pVB->m_Format.m_Type)
+        {
+            case CSR_VT_Triangles:     glDrawArraysInstanced(GL_TRIANGLES,      0, (GLsizei)vertexCount, (GLsizei)instanceCount); return;
+            case CSR_VT_TriangleStrip: glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, (GLsizei)vertexCount, (GLsizei)instanceCount); return;
+            case CSR_VT_TriangleFan:   glDrawArraysInstanced(GL_TRIANGLE_FAN,   0, (GLsizei)vertexCount, (GLsizei)instanceCount); return;
+            default:                                                                                                               return;
+        }
+    }
+#endif
 //---------------------------------------------------------------------------
-void csrOpenGLDrawLine(const CSR_Line* pLine, const CSR_OpenGLShader* pShader)
-{
-    #ifdef _MSC_VER
-        GLint  slot;
-        size_t stride;
-        float  lineVertex[14] = {0};
-    #else
-        GLint  slot;
-        size_t stride;
-        float  lineVertex[14];
-    #endif
+#ifndef CSR_OPENGL_2_ONLY
+    int csrOpenGLDrawLinkInstances(const CSR_Array*          pMatrixArray,
+                                   const CSR_OpenGLShader*   pShader,
+                                         CSR_OpenGLStaticVB* pSVB)
+    {
+        size_t i;
+        GLint  j;
+        float* pMatrices;
 
-    // validate the inputs
-    if (!pLine || !pShader || pLine->m_Width <= 0.0f)
-        return;
+        // create the instance buffer, if still not exists
+        if (pSVB->m_InstanceBufferID == M_CSR_Error_Code)
+        {
+            glGenBuffers(1, &pSVB->m_InstanceBufferID);
+            pSVB->m_InstanceCapacity = 0;
+        }
 
-    // set the line width to use
-    glLineWidth(pLine->m_Width);
+        // bind the instance buffer
+        glBindBuffer(GL_ARRAY_BUFFER, pSVB->m_InstanceBufferID);
 
-    #ifndef CSR_OPENGL_2_ONLY
-        // do draw smooth lines?
-        if (pLine->m_Smooth)
+        // grow the instance buffer if required. NOTE the GPU storage is never shrunk, because the
+        // matrix arrays are usually reused on each frame with a similar size
+        if (pMatrixArray->m_Count > pSVB->m_InstanceCapacity)
         {
-            // enabled the line smoothing mode
-            glEnable(GL_LINE_SMOOTH);
-            glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+            glBufferData(GL_ARRAY_BUFFER,
+                         pMatrixArray->m_Count * sizeof(CSR_Matrix4),
+                         0,
+                         GL_STREAM_DRAW);
+
+            pSVB->m_InstanceCapacity = pMatrixArray->m_Count;
         }
-    #endif
 
-    // bind shader program
-    csrOpenGLShaderEnable(pShader);
+        // map the instance buffer, discarding its previous content
+        pMatrices = (float*)glMapBufferRange(GL_ARRAY_BUFFER,
+                                             0,
+                                             pMatrixArray->m_Count * sizeof(CSR_Matrix4),
+                                             GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
 
-    // do use a default model matrix?
-    if (!pLine->m_CustomModelMat)
-    {
-        // get the model matrix slot from shader
-        slot = glGetUniformLocation(pShader->m_ProgramID, "csr_uModel");
+        // succeeded?
+        if (!pMatrices)
+        {
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            return 0;
+        }
 
-        // found it?
-        if (slot >= 0)
+        // copy the model matrices in the instance buffer
+        for (i = 0; i < pMatrixArray->m_Count; ++i)
+            memcpy(&pMatrices[i * 16],
+                   &((CSR_Matrix4*)pMatrixArray->m_pItem[i].m_pData)->m_Table[0][0],
+                   sizeof(CSR_Matrix4));
+
+        // unmap the instance buffer. NOTE the content may be lost in rare cases (e.g. when the
+        // screen mode changes), in this case the draw is simply skipped
+        if (glUnmapBuffer(GL_ARRAY_BUFFER) == GL_FALSE)
         {
-            CSR_Matrix4 matrix;
-            csrMat4Identity(&matrix);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+            return 0;
+        }
 
-            // connect default model matrix to shader
-            glUniformMatrix4fv(slot, 1, GL_FALSE, &matrix.m_Table[0][0]);
+        // link each matrix column to its shader slot, and advance it once per instance
+        for (j = 0; j < 4; ++j)
+        {
+            glEnableVertexAttribArray(pShader->m_InstanceModelSlot + j);
+            glVertexAttribPointer(pShader->m_InstanceModelSlot + j,
+                                  4,
+                                  GL_FLOAT,
+                                  GL_FALSE,
+                                  sizeof(CSR_Matrix4),
+                                  (const GLvoid*)(j * 4 * sizeof(float)));
+            glVertexAttribDivisor(pShader->m_InstanceModelSlot + j, 1);
         }
-    }
 
-    // generate the line vertex buffer
-    lineVertex[0]  = pLine->m_Start.m_X;
-    lineVertex[1]  = pLine->m_Start.m_Y;
-    lineVertex[2]  = pLine->m_Start.m_Z;
-    lineVertex[3]  = pLine->m_StartColor.m_R;
-    lineVertex[4]  = pLine->m_StartColor.m_G;
-    lineVertex[5]  = pLine->m_StartColor.m_B;
-    lineVertex[6]  = pLine->m_StartColor.m_A;
-    lineVertex[7]  = pLine->m_End.m_X;
-    lineVertex[8]  = pLine->m_End.m_Y;
-    lineVertex[9]  = pLine->m_End.m_Z;
-    lineVertex[10] = pLine->m_EndColor.m_R;
-    lineVertex[11] = pLine->m_EndColor.m_G;
-    lineVertex[12] = pLine->m_EndColor.m_B;
-    lineVertex[13] = pLine->m_EndColor.m_A;
+        // unbind the instance buffer, the slots remain linked to it
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    stride = 7;
+        return 1;
+    }
+#endif
+//---------------------------------------------------------------------------
+#ifndef CSR_OPENGL_2_ONLY
+    void csrOpenGLDrawUnlinkInstances(const CSR_OpenGLShader* pShader)
+    {
+        GLint i;
 
-    // found it?
-    if (pShader->m_VertexSlot < 0)
-        return;
+        // unlink the matrix columns from the instance buffer
+        for (i = 0; i < 4; ++i)
+        {
+            glVertexAttribDivisor(pShader->m_InstanceModelSlot + i, 0);
+            glDisableVertexAttribArray(pShader->m_InstanceModelSlot + i);
+        }
+    }
+#endif
+//---------------------------------------------------------------------------
+void csrOpenGLDrawConnectModelMatrix(const CSR_OpenGLShader* pShader, const CSR_Matrix4* pMatrix)
+{
+    // connect the model matrix to the shader
+    if (pShader->m_ModelSlot >= 0)
+        glUniformMatrix4fv(pShader->m_ModelSlot, 1, 0, &pMatrix->m_Table[0][0]);
 
-    // found it?
-    if (pShader->m_ColorSlot < 0)
-        return;
+    // the shader reads the model matrix from an attribute instead?
+    if (pShader->m_InstanceModelSlot >= 0)
+    {
+        // connect each matrix column as a constant attribute value
+        glVertexAttrib4fv(pShader->m_InstanceModelSlot,     pMatrix->m_Table[0]);
+        glVertexAttrib4fv(pShader->m_InstanceModelSlot + 1, pMatrix->m_Table[1]);
+        glVertexAttrib4fv(pShader->m_InstanceModelSlot + 2, pMatrix->m_Table[2]);
+        glVertexAttrib4fv(pShader->m_InstanceModelSlot + 3, pMatrix->m_Table[3]);
+    }
+}
+//---------------------------------------------------------------------------
+int csrOpenGLDrawCanSkin(const CSR_Skin_Weights_Group* pGroup, const CSR_OpenGLShader* pShader)
+{
+    // the shader should declare the skinning slots, and be able to receive all the bone matrices
+    return pShader                                &&
+           pShader->m_BoneSlot       >= 0         &&
+           pShader->m_BoneIndexSlot  >= 0         &&
+           pShader->m_BoneWeightSlot >= 0         &&
+           pGroup->m_VertexWeights.m_pData        &&
+           pGroup->m_Count <= pShader->m_BoneCount;
+}
+//---------------------------------------------------------------------------
+int csrOpenGLDrawLinkSkin(const CSR_VertexBuffer*        pVB,
+                          const CSR_OpenGLShader*        pShader,
+                          const CSR_Skin_Vertex_Weights* pVertexWeights,
+                                CSR_OpenGLStaticVB*      pSVB)
+{
+    const float*  pData;
+    const size_t  dataSize = pVertexWeights->m_Count * M_CSR_Max_Bone_Influences * 2 * sizeof(float);
+    const GLsizei stride   = (GLsizei)(M_CSR_Max_Bone_Influences * 2 * sizeof(float));
 
-    // enable shader slots
-    glEnableVertexAttribArray(pShader->m_VertexSlot);
-    glEnableVertexAttribArray(pShader->m_ColorSlot);
+    // the vertex skin weights should match with the vertex buffer
+    if (!pVertexWeights->m_pData || pVertexWeights->m_Count != pVB->m_Count / pVB->m_Format.m_Stride)
+        return 0;
 
-    // link the line buffer to the shader
-    glVertexAttribPointer(pShader->m_VertexSlot,
-                          3,
+    // is vertex buffer on the GPU side?
+    if (pSVB)
+    {
+        // create the skin buffer on the GPU side, if still not exists
+        if (pSVB->m_SkinBufferID == M_CSR_Error_Code)
+            glGenBuffers(1, &pSVB->m_SkinBufferID);
+
+        glBindBuffer(GL_ARRAY_BUFFER, pSVB->m_SkinBufferID);
+
+        // copy the vertex skin weights on the GPU side, if not already done. NOTE they never
+        // change while the model is animated, only the bone matrices do
+        if (pSVB->m_pSkinData != pVertexWeights->m_pData)
+        {
+            glBufferData(GL_ARRAY_BUFFER, dataSize, pVertexWeights->m_pData, GL_STATIC_DRAW);
+            pSVB->m_pSkinData = pVertexWeights->m_pData;
+        }
+
+        // the offsets are relative to the bound skin buffer
+        pData = 0;
+    }
+    else
+        pData = pVertexWeights->m_pData;
+
+    glEnableVertexAttribArray(pShader->m_BoneIndexSlot);
+    glEnableVertexAttribArray(pShader->m_BoneWeightSlot);
+
+    // send the bone indices and their weights to the shader
+    glVertexAttribPointer(pShader->m_BoneIndexSlot,
+                          M_CSR_Max_Bone_Influences,
                           GL_FLOAT,
                           GL_FALSE,
-                          (GLsizei)(stride * sizeof(float)),
-                          &lineVertex[0]);
-    glVertexAttribPointer(pShader->m_ColorSlot,
-                          4,
+                          stride,
+                          pData);
+    glVertexAttribPointer(pShader->m_BoneWeightSlot,
+                          M_CSR_Max_Bone_Influences,
                           GL_FLOAT,
                           GL_FALSE,
-                          (GLsizei)(stride * sizeof(float)),
-                          &lineVertex[3]);
+                          stride,
+                          pData ? (const GLvoid*)&pData[M_CSR_Max_Bone_Influences] :
+                                  (const GLvoid*)(M_CSR_Max_Bone_Influences * sizeof(float)));
 
-    // draw the line
-    glDrawArrays(GL_LINES, 0, 2);
+    // unbind the skin buffer, the shader slots remain linked to it
+    if (pSVB)
+        glBindBuffer(GL_ARRAY_BUFFER, 0);
 
-    // disable shader slots
-    glDisableVertexAttribArray(pShader->m_VertexSlot);
-    glDisableVertexAttribArray(pShader->m_ColorSlot);
-
-    // unbind shader program
-    csrOpenGLShaderEnable(0);
+    return 1;
 }
 //---------------------------------------------------------------------------
-void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
-                               const CSR_OpenGLShader* pShader,
-                               const CSR_Array*        pMatrixArray)
+void csrOpenGLDrawUnlinkSkin(const CSR_OpenGLShader* pShader)
 {
-    GLvoid* pCoords;
-    GLvoid* pNormals;
-    GLvoid* pTexCoords;
-    GLvoid* pColors;
-    size_t  i;
-    size_t  offset;
-    size_t  vertexCount;
+    glDisableVertexAttribArray(pShader->m_BoneIndexSlot);
+    glDisableVertexAttribArray(pShader->m_BoneWeightSlot);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLDrawSkinnedVertexBuffer(const CSR_VertexBuffer*        pVB,
+                                      const CSR_OpenGLShader*        pShader,
+                                      const CSR_Array*               pMatrixArray,
+                                      const CSR_Skin_Vertex_Weights* pVertexWeights,
+                                      const CSR_fOnGetID             fOnGetID)
+{
+    size_t              i;
+    size_t              vertexCount;
+    int                 useSkin;
+    const GLvoid*       pIndices;
+    CSR_OpenGLStaticVB* pStaticVB;
 
     // no vertex buffer to draw?
     if (!pVB)
@@ -1253,78 +1721,52 @@ void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
             glPolygonMode(GL_FRONT_AND_BACK, GL_FILL);
     #endif
 
-    // enable vertex slot
-    glEnableVertexAttribArray(pShader->m_VertexSlot);
-
-    // enable normal slot
-    if (pVB->m_Format.m_HasNormal)
-        glEnableVertexAttribArray(pShader->m_NormalSlot);
-
-    // enable texture slot
-    if (pVB->m_Format.m_HasTexCoords)
-        glEnableVertexAttribArray(pShader->m_TexCoordSlot);
-
-    // enable color slot
-    if (pVB->m_Format.m_HasPerVertexColor)
-        glEnableVertexAttribArray(pShader->m_ColorSlot);
-
-    offset = 0;
-
-    // send vertices to shader
-    pCoords = &pVB->m_pData[offset];
-    glVertexAttribPointer(pShader->m_VertexSlot,
-                          3,
-                          GL_FLOAT,
-                          GL_FALSE,
-                          pVB->m_Format.m_Stride * sizeof(float),
-                          pCoords);
+    // get the static vertex buffer matching with this vertex buffer, if any
+    if (fOnGetID)
+        pStaticVB = (CSR_OpenGLStaticVB*)fOnGetID(pVB);
+    else
+        pStaticVB = 0;
 
-    offset += 3;
+    // copy the vertex buffer on the GPU side if not already done, or if it changed. On failure the
+    // vertex buffer will be sent to the GPU as usual
+    if (pStaticVB && !csrOpenGLStaticVBUpdate(pVB, pShader, pStaticVB))
+        pStaticVB = 0;
 
-    // vertices have normals?
-    if (pVB->m_Format.m_HasNormal)
+    // found a static vertex buffer?
+    if (pStaticVB)
     {
-        // send normals to shader
-        pNormals = &pVB->m_pData[offset];
-        glVertexAttribPointer(pShader->m_NormalSlot,
-                              3,
-                              GL_FLOAT,
-                              GL_FALSE,
-                              pVB->m_Format.m_Stride * sizeof(float),
-                              pNormals);
+        #ifndef CSR_OPENGL_2_ONLY
+            // bind the VAO, which already links the vertex buffer content to the shader slots
+            glBindVertexArray(pStaticVB->m_ArrayID);
+        #else
+            // bind the VBO and link its content to the shader slots
+            glBindBuffer(GL_ARRAY_BUFFER, pStaticVB->m_BufferID);
+            csrOpenGLVertexBufferLinkSlots(pVB, pShader, 0);
 
-        offset += 3;
-    }
+            // bind the index buffer, if any
+            if (pStaticVB->m_IndexBufferID != M_CSR_Error_Code)
+                glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, pStaticVB->m_IndexBufferID);
+        #endif
 
-    // vertices have UV texture coordinates?
-    if (pVB->m_Format.m_HasTexCoords)
+        // the indices are read from the bound index buffer
+        pIndices = 0;
+    }
+    else
     {
-        // send textures to shader
-        pTexCoords = &pVB->m_pData[offset];
-        glVertexAttribPointer(pShader->m_TexCoordSlot,
-                              2,
-                              GL_FLOAT,
-                              GL_FALSE,
-                              pVB->m_Format.m_Stride * sizeof(float),
-                              pTexCoords);
+        // send the vertex buffer content to the shader
+        csrOpenGLVertexBufferLinkSlots(pVB, pShader, pVB->m_pData);
 
-        offset += 2;
+        pIndices = pVB->m_Index.m_pData;
     }
 
-    // vertices have per-vertex color?
-    if (pVB->m_Format.m_HasPerVertexColor)
-    {
-        // send colors to shader
-        pColors = &pVB->m_pData[offset];
-        glVertexAttribPointer(pShader->m_ColorSlot,
-                              4,
-                              GL_FLOAT,
-                              GL_FALSE,
-                              pVB->m_Format.m_Stride * sizeof(float),
-                              pColors);
-    }
+    // link the vertex skin weights to the shader, if any
+    if (pVertexWeights)
+        useSkin = csrOpenGLDrawLinkSkin(pVB, pShader, pVertexWeights, pStaticVB);
     else
-    if (pShader->m_ColorSlot != -1)
+        useSkin = 0;
+
+    // vertices have no per-vertex color?
+    if (!pVB->m_Format.m_HasPerVertexColor && pShader->m_ColorSlot != -1)
     {
         // get the color component values
         const float r = (float)((pVB->m_Material.m_Color >> 24) & 0xFF) / 255.0f;
@@ -1337,53 +1779,70 @@ void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
     }
 
     // calculate the vertex count
-    vertexCount = pVB->m_Count / pVB->m_Format.m_Stride;
+    vertexCount = csrVertexBufferGetVertexCount(pVB);
 
     // do draw the vertex buffer several times?
     if (pMatrixArray && pMatrixArray->m_Count)
     {
-        // get the model matrix slot from shader
-        const GLint slot = glGetUniformLocation(pShader->m_ProgramID, "csr_uModel");
+        #ifndef CSR_OPENGL_2_ONLY
+            // can draw all the matrices at once? NOTE the matrices are read from a GPU buffer, for
+            // that reason this is only possible if the vertex buffer itself is on the GPU side
+            if (pStaticVB                            &&
+                pShader->m_InstanceModelSlot >= 0    &&
+                csrOpenGLDrawLinkInstances(pMatrixArray, pShader, pStaticVB))
+            {
+                // draw all the vertex buffer instances in a single call
+                csrOpenGLDrawArrayInstanced(pVB, vertexCount, pIndices, pMatrixArray->m_Count);
 
-        // found it?
-        if (slot >= 0)
+                // unlink the instance buffer
+                csrOpenGLDrawUnlinkInstances(pShader);
+            }
+            else
+        #endif
+        // found the model matrix slot?
+        if (pShader->m_ModelSlot >= 0 || pShader->m_InstanceModelSlot >= 0)
             // yes, iterate through each matrix to use to draw the vertex buffer
             for (i = 0; i < pMatrixArray->m_Count; ++i)
             {
                 // connect the model matrix to the shader
-                glUniformMatrix4fv(slot,
-                                   1,
-                                   0,
-                                   &((CSR_Matrix4*)pMatrixArray->m_pItem[i].m_pData)->m_Table[0][0]);
+                csrOpenGLDrawConnectModelMatrix(pShader,
+                                                (CSR_Matrix4*)pMatrixArray->m_pItem[i].m_pData);
 
                 // draw the next buffer
-                csrOpenGLDrawArray(pVB, vertexCount);
+                csrOpenGLDrawArray(pVB, vertexCount, pIndices);
             }
     }
     else
         // no, simply draw the buffer without worrying about the model matrix
-        csrOpenGLDrawArray(pVB, vertexCount);
-
-    // disable vertices slots from shader
-    glDisableVertexAttribArray(pShader->m_VertexSlot);
+        csrOpenGLDrawArray(pVB, vertexCount, pIndices);
 
-    // disable normal slot
-    if (pVB->m_Format.m_HasNormal)
-        glDisableVertexAttribArray(pShader->m_NormalSlot);
+    // unlink the vertex skin weights
+    if (useSkin)
+        csrOpenGLDrawUnlinkSkin(pShader);
 
-    // disable texture slot
-    if (pVB->m_Format.m_HasTexCoords)
-        glDisableVertexAttribArray(pShader->m_TexCoordSlot);
-
-    // disable color slot
-    if (pVB->m_Format.m_HasPerVertexColor)
-        glDisableVertexAttribArray(pShader->m_ColorSlot);
+    // was a static vertex buffer used?
+    if (pStaticVB)
+    {
+        #ifndef CSR_OPENGL_2_ONLY
+            // unbind the VAO
+            glBindVertexArray(0);
+        #else
+            // unlink the shader slots and unbind the buffers
+            csrOpenGLVertexBufferUnlinkSlots(pVB, pShader);
+            glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, 0);
+            glBindBuffer(GL_ARRAY_BUFFER, 0);
+        #endif
+    }
+    else
+        // unlink the shader slots
+        csrOpenGLVertexBufferUnlinkSlots(pVB, pShader);
 }
 //---------------------------------------------------------------------------
-void csrOpenGLDrawMesh(const CSR_Mesh*         pMesh,
-                       const CSR_OpenGLShader* pShader,
-                       const CSR_Array*        pMatrixArray,
-                       const CSR_fOnGetID      fOnGetID)
+void csrOpenGLDrawSkinnedMesh(const CSR_Mesh*                pMesh,
+                              const CSR_OpenGLShader*        pShader,
+                              const CSR_Array*               pMatrixArray,
+                              const CSR_Skin_Vertex_Weights* pVertexWeights,
+                              const CSR_fOnGetID             fOnGetID)
 {
     size_t i;
 
@@ -1453,11 +1912,154 @@ void csrOpenGLDrawMesh(const CSR_Mesh*         pMesh,
             }
         }
 
-        // draw the next mesh vertex buffer
-        csrOpenGLDrawVertexBuffer(&pMesh->m_pVB[i], pShader, pMatrixArray);
+        // draw the next mesh vertex buffer. NOTE the vertex skin weights can only match with a mesh
+        // containing one vertex buffer
+        csrOpenGLDrawSkinnedVertexBuffer(&pMesh->m_pVB[i],
+                                         pShader,
+                                         pMatrixArray,
+                                         pMesh->m_Count == 1 ? pVertexWeights : 0,
+                                         fOnGetID);
     }
 }
 //---------------------------------------------------------------------------
+// Draw functions
+//---------------------------------------------------------------------------
+void csrOpenGLDrawBegin(const CSR_Color* pColor)
+{
+    // no background color?
+    if (!pColor)
+        return;
+
+    // clear background and depth buffer
+    glClearColor(pColor->m_R, pColor->m_G, pColor->m_B, pColor->m_A);
+    glClearDepthf(1.0f);
+    glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+    // configure the OpenGL depth testing
+    glEnable(GL_DEPTH_TEST);
+    glDepthMask(GL_TRUE);
+    glDepthFunc(GL_LEQUAL);
+    glDepthRangef(0.0f, 1.0f);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLDrawEnd(void)
+{}
+//---------------------------------------------------------------------------
+void csrOpenGLDrawLine(const CSR_Line* pLine, const CSR_OpenGLShader* pShader)
+{
+    #ifdef _MSC_VER
+        size_t stride;
+        float  lineVertex[14] = {0};
+    #else
+        size_t stride;
+        float  lineVertex[14];
+    #endif
+
+    // validate the inputs
+    if (!pLine || !pShader || pLine->m_Width <= 0.0f)
+        return;
+
+    // set the line width to use
+    glLineWidth(pLine->m_Width);
+
+    #ifndef CSR_OPENGL_2_ONLY
+        // do draw smooth lines?
+        if (pLine->m_Smooth)
+        {
+            // enabled the line smoothing mode
+            glEnable(GL_LINE_SMOOTH);
+            glHint(GL_LINE_SMOOTH_HINT, GL_NICEST);
+        }
+    #endif
+
+    // bind shader program
+    csrOpenGLShaderEnable(pShader);
+
+    // do use a default model matrix?
+    if (!pLine->m_CustomModelMat)
+    {
+        // found the model matrix slot?
+        if (pShader->m_ModelSlot >= 0)
+        {
+            CSR_Matrix4 matrix;
+            csrMat4Identity(&matrix);
+
+            // connect default model matrix to shader
+            glUniformMatrix4fv(pShader->m_ModelSlot, 1, GL_FALSE, &matrix.m_Table[0][0]);
+        }
+    }
+
+    // generate the line vertex buffer
+    lineVertex[0]  = pLine->m_Start.m_X;
+    lineVertex[1]  = pLine->m_Start.m_Y;
+    lineVertex[2]  = pLine->m_Start.m_Z;
+    lineVertex[3]  = pLine->m_StartColor.m_R;
+    lineVertex[4]  = pLine->m_StartColor.m_G;
+    lineVertex[5]  = pLine->m_StartColor.m_B;
+    lineVertex[6]  = pLine->m_StartColor.m_A;
+    lineVertex[7]  = pLine->m_End.m_X;
+    lineVertex[8]  = pLine->m_End.m_Y;
+    lineVertex[9]  = pLine->m_End.m_Z;
+    lineVertex[10] = pLine->m_EndColor.m_R;
+    lineVertex[11] = pLine->m_EndColor.m_G;
+    lineVertex[12] = pLine->m_EndColor.m_B;
+    lineVertex[13] = pLine->m_EndColor.m_A;
+
+    stride = 7;
+
+    // found it?
+    if (pShader->m_VertexSlot < 0)
+        return;
+
+    // found it?
+    if (pShader->m_ColorSlot < 0)
+        return;
+
+    // enable shader slots
+    glEnableVertexAttribArray(pShader->m_VertexSlot);
+    glEnableVertexAttribArray(pShader->m_ColorSlot);
+
+    // link the line buffer to the shader
+    glVertexAttribPointer(pShader->m_VertexSlot,
+                          3,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          (GLsizei)(stride * sizeof(float)),
+                          &lineVertex[0]);
+    glVertexAttribPointer(pShader->m_ColorSlot,
+                          4,
+                          GL_FLOAT,
+                          GL_FALSE,
+                          (GLsizei)(stride * sizeof(float)),
+                          &lineVertex[3]);
+
+    // draw the line
+    glDrawArrays(GL_LINES, 0, 2);
+
+    // disable shader slots
+    glDisableVertexAttribArray(pShader->m_VertexSlot);
+    glDisableVertexAttribArray(pShader->m_ColorSlot);
+
+    // unbind shader program
+    csrOpenGLShaderEnable(0);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
+                               const CSR_OpenGLShader* pShader,
+                               const CSR_Array*        pMatrixArray,
+                               const CSR_fOnGetID      fOnGetID)
+{
+    csrOpenGLDrawSkinnedVertexBuffer(pVB, pShader, pMatrixArray, 0, fOnGetID);
+}
+//---------------------------------------------------------------------------
+void csrOpenGLDrawMesh(const CSR_Mesh*         pMesh,
+                       const CSR_OpenGLShader* pShader,
+                       const CSR_Array*        pMatrixArray,
+                       const CSR_fOnGetID      fOnGetID)
+{
+    csrOpenGLDrawSkinnedMesh(pMesh, pShader, pMatrixArray, 0, fOnGetID);
+}
+//---------------------------------------------------------------------------
 void csrOpenGLDrawModel(const CSR_Model*        pModel,
                               size_t            index,
                         const CSR_OpenGLShader* pShader,
@@ -1545,14 +2147,30 @@ void csrOpenGLDrawX(const CSR_X*            pX,
         return;
     }
 
+    // get all the bone matrices for the frame to draw, from the baked clip if any, otherwise calculate
+    // them, each bone is calculated only once
+    if (pX->m_PoseOnly || !pX->m_pClips || animSetIndex >= pX->m_AnimationSetCount ||
+        !csrBoneClipGetPose(&pX->m_pClips[animSetIndex], (float)frameIndex, pX->m_pPose))
+        csrBonePoseUpdate(pX->m_pPose,
+                          pX->m_PoseOnly ? (size_t)M_CSR_Unknown_Index : animSetIndex,
+                          frameIndex,
+                          0);
+
     // iterate through the meshes to draw
     for (i = 0; i < pX->m_MeshCount; ++i)
     {
-        int        useLocalMatrixArray;
-        int        useSourceBuffer;
-        CSR_Mesh*  pMesh;
-        CSR_Mesh*  pLocalMesh;
-        CSR_Array* pLocalMatrixArray;
+        int                     useLocalMatrixArray;
+        int                     useGPUSkinning;
+        CSR_Mesh*               pMesh;
+        CSR_Array*              pLocalMatrixArray;
+        CSR_Skin_Weights_Group* pGroup;
+        CSR_VertexBuffer*       pSkinnedVB;
+
+        #ifdef _MSC_VER
+            CSR_Mesh localMesh = {0};
+        #else
+            CSR_Mesh localMesh;
+        #endif
 
         // if mesh has no skeleton, perform a simple draw
         if (!pX->m_pSkeleton)
@@ -1575,87 +2193,64 @@ void csrOpenGLDrawX(const CSR_X*            pX,
             // exists, a custom version of this function should also be written for it)
             continue;
 
-        // create a local mesh to contain the processed frame to draw
-        pLocalMesh = csrMeshCreate();
-
-        if (!pLocalMesh)
-            continue;
+        // bind the source mesh to a local one, which will contain the processed frame to draw. Don't
+        // need to take care of copy the pointers, because the source mesh will remain valid during the
+        // whole local mesh lifetime
+        csrMeshInit(&localMesh);
+        localMesh.m_Skin  = pMesh->m_Skin;
+        localMesh.m_pVB   = pMesh->m_pVB;
+        localMesh.m_Count = pMesh->m_Count;
+        localMesh.m_Time  = pMesh->m_Time;
 
-        // bind the source mesh to the local one. Don't need to take care of copy the pointers, because
-        // the source mesh will remain valid during the whole local mesh lifetime. Just don't delete
-        // them on the loop end
-        pLocalMesh->m_Skin = pMesh->m_Skin;
-        pLocalMesh->m_Time = pMesh->m_Time;
+        // get the mesh skin weights
+        pGroup = &pX->m_pMeshWeights[i];
 
         // mesh contains skin weights?
-        if (pX->m_pMeshWeights[i].m_pSkinWeights)
+        if (pGroup->m_pSkinWeights)
         {
-            useSourceBuffer = 0;
-
-            // allocate memory for the final vertex buffer to draw
-            pLocalMesh->m_pVB   = (CSR_VertexBuffer*)malloc(pMesh->m_Count * sizeof(CSR_VertexBuffer));
-            pLocalMesh->m_Count = pMesh->m_Count;
-
-            if (!pLocalMesh->m_pVB || !pLocalMesh->m_Count)
-            {
-                free(pLocalMesh);
+            // get the final matrices from the bone pose calculated for this frame. NOTE the matrices
+            // are allocated with the model, thus they are reused by each frame
+            if (!pGroup->m_pMatrices || !csrBonePoseGetSkinMatrices(pX->m_pPose, pGroup, pGroup->m_pMatrices))
                 continue;
-            }
 
-            // bind the source vertex buffer to the local one
-            pLocalMesh->m_pVB->m_Format   = pMesh->m_pVB->m_Format;
-            pLocalMesh->m_pVB->m_Culling  = pMesh->m_pVB->m_Culling;
-            pLocalMesh->m_pVB->m_Material = pMesh->m_pVB->m_Material;
-            pLocalMesh->m_pVB->m_Time     = pMesh->m_pVB->m_Time;
+            // can the skin weights be applied by the GPU?
+            useGPUSkinning = csrOpenGLDrawCanSkin(pGroup, pShader);
+        }
+        else
+            useGPUSkinning = 0;
 
-            // allocate memory for the vertex buffer data
-            pLocalMesh->m_pVB->m_pData = (float*)calloc(pMesh->m_pVB->m_Count, sizeof(float));
-            pLocalMesh->m_pVB->m_Count = pMesh->m_pVB->m_Count;
+        // do apply the skin weights on the CPU side? (otherwise the source vertex buffer is drawn, and
+        // the skin weights, if any, are applied by the shader)
+        if (!useGPUSkinning && pGroup->m_pSkinWeights)
+        {
+            pSkinnedVB = &pGroup->m_SkinnedVB;
 
-            if (!pLocalMesh->m_pVB->m_pData || !pLocalMesh->m_pVB->m_Count)
+            // allocate the skinned vertex buffer on the first draw, the next ones will reuse it
+            if (!pSkinnedVB->m_pData)
             {
-                free(pLocalMesh->m_pVB);
-                free(pLocalMesh);
-                continue;
-            }
+                pSkinnedVB->m_pData = (float*)malloc(pMesh->m_pVB->m_Count * sizeof(float));
 
-            // do copy the texture file name? NOTE the texture file name may be used as a key
-            // to retrieve the associated texture in the resources
-           if (pMesh->m_Skin.m_Texture.m_pFileName)
-            {
-                // measure the file name length and allocate memory for file name in local mesh
-                const size_t fileNameLen                 = strlen(pMesh->m_Skin.m_Texture.m_pFileName);
-                pLocalMesh->m_Skin.m_Texture.m_pFileName = (char*)calloc(fileNameLen + 1, sizeof(char));
+                if (!pSkinnedVB->m_pData)
+                    continue;
 
-                // copy the file name
-                if (pLocalMesh->m_Skin.m_Texture.m_pFileName)
-                    memcpy(pLocalMesh->m_Skin.m_Texture.m_pFileName, pMesh->m_Skin.m_Texture.m_pFileName, fileNameLen);
+                pSkinnedVB->m_Count    = pMesh->m_pVB->m_Count;
+                pSkinnedVB->m_Capacity = pMesh->m_pVB->m_Count;
             }
 
-            // iterate through mesh skin weights
-            for (j = 0; j < pX->m_pMeshWeights[i].m_Count; ++j)
-            {
-                CSR_Matrix4 boneMatrix;
-                CSR_Matrix4 finalMatrix;
-
-                // get the bone matrix
-                if (pX->m_PoseOnly)
-                    csrBoneGetMatrix(pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pBone, 0, &boneMatrix);
-                else
-                    csrBoneGetAnimMatrix(pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pBone,
-                                        &pX->m_pAnimationSet[animSetIndex],
-                                         frameIndex,
-                                         0,
-                                        &boneMatrix);
-
-                // get the final matrix after bones transform
-                csrMat4Multiply(&pX->m_pMeshWeights[i].m_pSkinWeights[j].m_Matrix,
-                                &boneMatrix,
-                                &finalMatrix);
+            // bind the source vertex buffer properties to the skinned one
+            pSkinnedVB->m_Format   = pMesh->m_pVB->m_Format;
+            pSkinnedVB->m_Culling  = pMesh->m_pVB->m_Culling;
+            pSkinnedVB->m_Material = pMesh->m_pVB->m_Material;
+            pSkinnedVB->m_Time     = pMesh->m_pVB->m_Time;
+
+            // the skin weights are added to an empty vertex buffer
+            memset(pSkinnedVB->m_pData, 0, pSkinnedVB->m_Count * sizeof(float));
 
+            // iterate through mesh skin weights
+            for (j = 0; j < pGroup->m_Count; ++j)
                 // apply the bone and its skin weights to each vertices
-                for (k = 0; k < pX->m_pMeshWeights[i].m_pSkinWeights[j].m_IndexTableCount; ++k)
-                    for (l = 0; l < pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pIndexTable[k].m_Count; ++l)
+                for (k = 0; k < pGroup->m_pSkinWeights[j].m_IndexTableCount; ++k)
+                    for (l = 0; l < pGroup->m_pSkinWeights[j].m_pIndexTable[k].m_Count; ++l)
                     {
                         #ifdef _MSC_VER
                             size_t      iX;
@@ -1672,9 +2267,9 @@ void csrOpenGLDrawX(const CSR_X*            pX,
                         #endif
 
                         // get the next vertex to which the next skin weight should be applied
-                        iX = pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pIndexTable[k].m_pData[l];
-                        iY = pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pIndexTable[k].m_pData[l] + 1;
-                        iZ = pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pIndexTable[k].m_pData[l] + 2;
+                        iX = pGroup->m_pSkinWeights[j].m_pIndexTable[k].m_pData[l];
+                        iY = pGroup->m_pSkinWeights[j].m_pIndexTable[k].m_pData[l] + 1;
+                        iZ = pGroup->m_pSkinWeights[j].m_pIndexTable[k].m_pData[l] + 2;
 
                         // get input vertex
                         inputVertex.m_X = pMesh->m_pVB->m_pData[iX];
@@ -1682,32 +2277,26 @@ void csrOpenGLDrawX(const CSR_X*            pX,
                         inputVertex.m_Z = pMesh->m_pVB->m_pData[iZ];
 
                         // apply bone transformation to vertex
-                        csrMat4Transform(&finalMatrix, &inputVertex, &outputVertex);
+                        csrMat4Transform(&pGroup->m_pMatrices[j], &inputVertex, &outputVertex);
 
                         // apply the skin weights and calculate the final output vertex
-                        pLocalMesh->m_pVB->m_pData[iX] += (outputVertex.m_X * pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pWeights[k]);
-                        pLocalMesh->m_pVB->m_pData[iY] += (outputVertex.m_Y * pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pWeights[k]);
-                        pLocalMesh->m_pVB->m_pData[iZ] += (outputVertex.m_Z * pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pWeights[k]);
+                        pSkinnedVB->m_pData[iX] += (outputVertex.m_X * pGroup->m_pSkinWeights[j].m_pWeights[k]);
+                        pSkinnedVB->m_pData[iY] += (outputVertex.m_Y * pGroup->m_pSkinWeights[j].m_pWeights[k]);
+                        pSkinnedVB->m_pData[iZ] += (outputVertex.m_Z * pGroup->m_pSkinWeights[j].m_pWeights[k]);
 
                         // copy the remaining vertex data
                         if (pMesh->m_pVB->m_Format.m_Stride > 3)
                         {
                             const size_t copyIndex = iZ + 1;
 
-                            memcpy(&pLocalMesh->m_pVB->m_pData[copyIndex],
+                            memcpy(&pSkinnedVB->m_pData[copyIndex],
                                    &pMesh->m_pVB->m_pData[copyIndex],
                                     ((size_t)pMesh->m_pVB->m_Format.m_Stride - 3) * sizeof(float));
                         }
                     }
-            }
-        }
-        else
-        {
-            useSourceBuffer = 1;
 
-            // no weights, just use the existing vertex buffer
-            pLocalMesh->m_pVB   = pMesh->m_pVB;
-            pLocalMesh->m_Count = pMesh->m_Count;
+            // draw the skinned vertex buffer
+            localMesh.m_pVB = pSkinnedVB;
         }
 
         useLocalMatrixArray = 0;
@@ -1728,7 +2317,8 @@ void csrOpenGLDrawX(const CSR_X*            pX,
             if (pLocalMatrixArray->m_pItem)
             {
                 // update array count
-                pLocalMatrixArray->m_Count = pMatrixArray->m_Count;
+                pLocalMatrixArray->m_Count    = pMatrixArray->m_Count;
+                pLocalMatrixArray->m_Capacity = pMatrixArray->m_Count;
 
                 // iterate through source model matrices
                 for (j = 0; j < pMatrixArray->m_Count; ++j)
@@ -1748,22 +2338,26 @@ void csrOpenGLDrawX(const CSR_X*            pX,
             // no matrix array or no bone, keep the original array
             pLocalMatrixArray = (CSR_Array*)pMatrixArray;
 
-        // draw the model mesh
-        csrOpenGLDrawMesh(pLocalMesh, pShader, pLocalMatrixArray, fOnGetID);
-
-        // delete the local vertex buffer
-        if (!useSourceBuffer)
+        // do apply the skin weights on the GPU side?
+        if (useGPUSkinning)
         {
-            free(pLocalMesh->m_pVB->m_pData);
-            free(pLocalMesh->m_pVB);
-        }
-
-        // delete the local mesh texture file name
-        if (pLocalMesh->m_Skin.m_Texture.m_pFileName)
-            free(pLocalMesh->m_Skin.m_Texture.m_pFileName);
+            // enable the shader and connect the bone matrices to it
+            csrOpenGLShaderEnable(pShader);
+            glUniformMatrix4fv(pShader->m_BoneSlot,
+                               (GLsizei)pGroup->m_Count,
+                               0,
+                               &pGroup->m_pMatrices[0].m_Table[0][0]);
 
-        // delete the local mesh
-        free(pLocalMesh);
+            // draw the model mesh
+            csrOpenGLDrawSkinnedMesh(&localMesh,
+                                     pShader,
+                                     pLocalMatrixArray,
+                                     &pGroup->m_VertexWeights,
+                                     fOnGetID);
+        }
+        else
+            // draw the model mesh
+            csrOpenGLDrawMesh(&localMesh, pShader, pLocalMatrixArray, fOnGetID);
 
         // release the transformed matrix list
         if (useLocalMatrixArray)
@@ -1798,14 +2392,30 @@ void csrOpenGLDrawCollada(const CSR_Collada*      pCollada,
         return;
     }
 
+    // get all the bone matrices for the frame to draw, from the baked clip if any, otherwise calculate
+    // them, each bone is calculated only once
+    if (pCollada->m_PoseOnly || !pCollada->m_pClips || animSetIndex >= pCollada->m_AnimationSetCount ||
+        !csrBoneClipGetPose(&pCollada->m_pClips[animSetIndex], (float)frameIndex, pCollada->m_pPose))
+        csrBonePoseUpdate(pCollada->m_pPose,
+                          pCollada->m_PoseOnly ? (size_t)M_CSR_Unknown_Index : animSetIndex,
+                          frameIndex,
+                          pCollada->m_pSkeletons ? &pCollada->m_pSkeletons->m_InitialMatrix : 0);
+
     // iterate through the meshes to draw
     for (i = 0; i < pCollada->m_MeshCount; ++i)
     {
-        int        useLocalMatrixArray;
-        int        useSourceBuffer;
-        CSR_Mesh*  pMesh;
-        CSR_Mesh*  pLocalMesh;
-        CSR_Array* pLocalMatrixArray;
+        int                     useLocalMatrixArray;
+        int                     useGPUSkinning;
+        CSR_Mesh*               pMesh;
+        CSR_Array*              pLocalMatrixArray;
+        CSR_Skin_Weights_Group* pGroup;
+        CSR_VertexBuffer*       pSkinnedVB;
+
+        #ifdef _MSC_VER
+            CSR_Mesh localMesh = {0};
+        #else
+            CSR_Mesh localMesh;
+        #endif
 
         // if mesh has no skeleton, perform a simple draw
         if (!pCollada->m_pSkeletons)
@@ -1828,89 +2438,64 @@ void csrOpenGLDrawCollada(const CSR_Collada*      pCollada,
             // exists, a custom version of this function should also be written for it)
             continue;
 
-        // create a local mesh to contain the processed frame to draw
-        pLocalMesh = csrMeshCreate();
-
-        if (!pLocalMesh)
-            continue;
+        // bind the source mesh to a local one, which will contain the processed frame to draw. Don't
+        // need to take care of copy the pointers, because the source mesh will remain valid during the
+        // whole local mesh lifetime
+        csrMeshInit(&localMesh);
+        localMesh.m_Skin  = pMesh->m_Skin;
+        localMesh.m_pVB   = pMesh->m_pVB;
+        localMesh.m_Count = pMesh->m_Count;
+        localMesh.m_Time  = pMesh->m_Time;
 
-        // bind the source mesh to the local one. Don't need to take care of copy the pointers, because
-        // the source mesh will remain valid during the whole local mesh lifetime. Just don't delete
-        // them on the loop end
-        pLocalMesh->m_Skin = pMesh->m_Skin;
-        pLocalMesh->m_Time = pMesh->m_Time;
+        // get the mesh skin weights
+        pGroup = &pCollada->m_pMeshWeights[i];
 
         // mesh contains skin weights?
-        if (pCollada->m_pMeshWeights[i].m_pSkinWeights)
+        if (pGroup->m_pSkinWeights)
         {
-            useSourceBuffer = 0;
-
-            // allocate memory for the final vertex buffer to draw
-            pLocalMesh->m_pVB   = (CSR_VertexBuffer*)malloc(pMesh->m_Count * sizeof(CSR_VertexBuffer));
-            pLocalMesh->m_Count = pMesh->m_Count;
-
-            if (!pLocalMesh->m_pVB || !pLocalMesh->m_Count)
-            {
-                free(pLocalMesh);
+            // get the final matrices from the bone pose calculated for this frame. NOTE the matrices
+            // are allocated with the model, thus they are reused by each frame
+            if (!pGroup->m_pMatrices || !csrBonePoseGetSkinMatrices(pCollada->m_pPose, pGroup, pGroup->m_pMatrices))
                 continue;
-            }
 
-            // bind the source vertex buffer to the local one
-            pLocalMesh->m_pVB->m_Format   = pMesh->m_pVB->m_Format;
-            pLocalMesh->m_pVB->m_Culling  = pMesh->m_pVB->m_Culling;
-            pLocalMesh->m_pVB->m_Material = pMesh->m_pVB->m_Material;
-            pLocalMesh->m_pVB->m_Time     = pMesh->m_pVB->m_Time;
+            // can the skin weights be applied by the GPU?
+            useGPUSkinning = csrOpenGLDrawCanSkin(pGroup, pShader);
+        }
+        else
+            useGPUSkinning = 0;
 
-            // allocate memory for the vertex buffer data
-            pLocalMesh->m_pVB->m_pData = (float*)calloc(pMesh->m_pVB->m_Count, sizeof(float));
-            pLocalMesh->m_pVB->m_Count = pMesh->m_pVB->m_Count;
+        // do apply the skin weights on the CPU side? (otherwise the source vertex buffer is drawn, and
+        // the skin weights, if any, are applied by the shader)
+        if (!useGPUSkinning && pGroup->m_pSkinWeights)
+        {
+            pSkinnedVB = &pGroup->m_SkinnedVB;
 
-            if (!pLocalMesh->m_pVB->m_pData || !pLocalMesh->m_pVB->m_Count)
+            // allocate the skinned vertex buffer on the first draw, the next ones will reuse it
+            if (!pSkinnedVB->m_pData)
             {
-                free(pLocalMesh->m_pVB);
-                free(pLocalMesh);
-                continue;
-            }
+                pSkinnedVB->m_pData = (float*)malloc(pMesh->m_pVB->m_Count * sizeof(float));
 
-            // do copy the texture file name? NOTE the texture file name may be used as a key
-            // to retrieve the associated texture in the resources
-           if (pMesh->m_Skin.m_Texture.m_pFileName)
-            {
-                // measure the file name length and allocate memory for file name in local mesh
-                const size_t fileNameLen                 = strlen(pMesh->m_Skin.m_Texture.m_pFileName);
-                pLocalMesh->m_Skin.m_Texture.m_pFileName = (char*)calloc(fileNameLen + 1, sizeof(char));
+                if (!pSkinnedVB->m_pData)
+                    continue;
 
-                // copy the file name
-                if (pLocalMesh->m_Skin.m_Texture.m_pFileName)
-                    memcpy(pLocalMesh->m_Skin.m_Texture.m_pFileName, pMesh->m_Skin.m_Texture.m_pFileName, fileNameLen);
+                pSkinnedVB->m_Count    = pMesh->m_pVB->m_Count;
+                pSkinnedVB->m_Capacity = pMesh->m_pVB->m_Count;
             }
 
-            // iterate through mesh skin weights
-            for (j = 0; j < pCollada->m_pMeshWeights[i].m_Count; ++j)
-            {
-                CSR_Matrix4 boneMatrix;
-                CSR_Matrix4 finalMatrix;
-
-                // get the bone matrix
-                if (pCollada->m_PoseOnly)
-                    csrBoneGetMatrix(pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_pBone,
-                                    &pCollada->m_pSkeletons->m_InitialMatrix,
-                                    &boneMatrix);
-                else
-                    csrBoneGetAnimMatrix(pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_pBone,
-                                        &pCollada->m_pAnimationSet[animSetIndex],
-                                         frameIndex,
-                                        &pCollada->m_pSkeletons->m_InitialMatrix,
-                                        &boneMatrix);
-
-                // get the final matrix after bones transform
-                csrMat4Multiply(&pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_Matrix,
-                                &boneMatrix,
-                                &finalMatrix);
+            // bind the source vertex buffer properties to the skinned one
+            pSkinnedVB->m_Format   = pMesh->m_pVB->m_Format;
+            pSkinnedVB->m_Culling  = pMesh->m_pVB->m_Culling;
+            pSkinnedVB->m_Material = pMesh->m_pVB->m_Material;
+            pSkinnedVB->m_Time     = pMesh->m_pVB->m_Time;
+
+            // the skin weights are added to an empty vertex buffer
+            memset(pSkinnedVB->m_pData, 0, pSkinnedVB->m_Count * sizeof(float));
 
+            // iterate through mesh skin weights
+            for (j = 0; j < pGroup->m_Count; ++j)
                 // apply the bone and its skin weights to each vertices
-                for (k = 0; k < pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_IndexTableCount; ++k)
-                    for (l = 0; l < pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_pIndexTable[k].m_Count; ++l)
+                for (k = 0; k < pGroup->m_pSkinWeights[j].m_IndexTableCount; ++k)
+                    for (l = 0; l < pGroup->m_pSkinWeights[j].m_pIndexTable[k].m_Count; ++l)
                     {
                         #ifdef _MSC_VER
                             size_t      iX;
@@ -1927,9 +2512,9 @@ void csrOpenGLDrawCollada(const CSR_Collada*      pCollada,
                         #endif
 
                         // get the next vertex to which the next skin weight should be applied
-                        iX = pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_pIndexTable[k].m_pData[l];
-                        iY = pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_pIndexTable[k].m_pData[l] + 1;
-                        iZ = pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_pIndexTable[k].m_pData[l] + 2;
+                        iX = pGroup->m_pSkinWeights[j].m_pIndexTable[k].m_pData[l];
+                        iY = pGroup->m_pSkinWeights[j].m_pIndexTable[k].m_pData[l] + 1;
+                        iZ = pGroup->m_pSkinWeights[j].m_pIndexTable[k].m_pData[l] + 2;
 
                         // get input vertex
                         inputVertex.m_X = pMesh->m_pVB->m_pData[iX];
@@ -1937,32 +2522,26 @@ void csrOpenGLDrawCollada(const CSR_Collada*      pCollada,
                         inputVertex.m_Z = pMesh->m_pVB->m_pData[iZ];
 
                         // apply bone transformation to vertex
-                        csrMat4Transform(&finalMatrix, &inputVertex, &outputVertex);
+                        csrMat4Transform(&pGroup->m_pMatrices[j], &inputVertex, &outputVertex);
 
                         // apply the skin weights and calculate the final output vertex
-                        pLocalMesh->m_pVB->m_pData[iX] += (outputVertex.m_X * pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_pWeights[k]);
-                        pLocalMesh->m_pVB->m_pData[iY] += (outputVertex.m_Y * pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_pWeights[k]);
-                        pLocalMesh->m_pVB->m_pData[iZ] += (outputVertex.m_Z * pCollada->m_pMeshWeights[i].m_pSkinWeights[j].m_pWeights[k]);
+                        pSkinnedVB->m_pData[iX] += (outputVertex.m_X * pGroup->m_pSkinWeights[j].m_pWeights[k]);
+                        pSkinnedVB->m_pData[iY] += (outputVertex.m_Y * pGroup->m_pSkinWeights[j].m_pWeights[k]);
+                        pSkinnedVB->m_pData[iZ] += (outputVertex.m_Z * pGroup->m_pSkinWeights[j].m_pWeights[k]);
 
                         // copy the remaining vertex data
                         if (pMesh->m_pVB->m_Format.m_Stride > 3)
                         {
                             const size_t copyIndex = iZ + 1;
 
-                            memcpy(&pLocalMesh->m_pVB->m_pData[copyIndex],
+                            memcpy(&pSkinnedVB->m_pData[copyIndex],
                                    &pMesh->m_pVB->m_pData[copyIndex],
                                     ((size_t)pMesh->m_pVB->m_Format.m_Stride - 3) * sizeof(float));
                         }
                     }
-            }
-        }
-        else
-        {
-            useSourceBuffer = 1;
 
-            // no weights, just use the existing vertex buffer
-            pLocalMesh->m_pVB   = pMesh->m_pVB;
-            pLocalMesh->m_Count = pMesh->m_Count;
+            // draw the skinned vertex buffer
+            localMesh.m_pVB = pSkinnedVB;
         }
 
         useLocalMatrixArray = 0;
@@ -1986,7 +2565,8 @@ void csrOpenGLDrawCollada(const CSR_Collada*      pCollada,
             if (pLocalMatrixArray->m_pItem)
             {
                 // update array count
-                pLocalMatrixArray->m_Count = pMatrixArray->m_Count;
+                pLocalMatrixArray->m_Count    = pMatrixArray->m_Count;
+                pLocalMatrixArray->m_Capacity = pMatrixArray->m_Count;
 
                 // iterate through source model matrices
                 for (j = 0; j < pMatrixArray->m_Count; ++j)
@@ -2006,22 +2586,26 @@ void csrOpenGLDrawCollada(const CSR_Collada*      pCollada,
             // no matrix array or no bone, keep the original array
             pLocalMatrixArray = (CSR_Array*)pMatrixArray;
 
-        // draw the model mesh
-        csrOpenGLDrawMesh(pLocalMesh, pShader, pLocalMatrixArray, fOnGetID);
-
-        // delete the local vertex buffer
-        if (!useSourceBuffer)
+        // do apply the skin weights on the GPU side?
+        if (useGPUSkinning)
         {
-            free(pLocalMesh->m_pVB->m_pData);
-            free(pLocalMesh->m_pVB);
-        }
+            // enable the shader and connect the bone matrices to it
+            csrOpenGLShaderEnable(pShader);
+            glUniformMatrix4fv(pShader->m_BoneSlot,
+                               (GLsizei)pGroup->m_Count,
+                               0,
+                               &pGroup->m_pMatrices[0].m_Table[0][0]);
 
-        // delete the local mesh texture file name
-        if (pLocalMesh->m_Skin.m_Texture.m_pFileName)
-            free(pLocalMesh->m_Skin.m_Texture.m_pFileName);
-
-        // delete the local mesh
-        free(pLocalMesh);
+            // draw the model mesh
+            csrOpenGLDrawSkinnedMesh(&localMesh,
+                                     pShader,
+                                     pLocalMatrixArray,
+                                     &pGroup->m_VertexWeights,
+                                     fOnGetID);
+        }
+        else
+            // draw the model mesh
+            csrOpenGLDrawMesh(&localMesh, pShader, pLocalMatrixArray, fOnGetID);
 
         // release the transformed matrix list
         if (useLocalMatrixArray)
@@ -74,6 +74,13 @@ typedef struct
     GLint  m_CubemapSlot;
     GLint  m_ColorSlot;
     GLint  m_ModelSlot;
+    GLint  m_ProjectionSlot;
+    GLint  m_ViewSlot;
+    GLint  m_InstanceModelSlot;
+    GLint  m_BoneSlot;
+    GLint  m_BoneIndexSlot;
+    GLint  m_BoneWeightSlot;
+    size_t m_BoneCount;
 } CSR_OpenGLShader;
 
 /**
@@ -85,6 +92,28 @@ typedef struct
     size_t m_Stride;
 } CSR_OpenGLStaticBuffer;
 
+/**
+* Static vertex buffer, it's a vertex buffer which the content was copied on the GPU side, and which
+* may be drawn without being sent again on each frame
+*/
+typedef struct
+{
+    void*                   m_pKey;
+    size_t                  m_UseCount;
+    GLuint                  m_BufferID;
+    GLuint                  m_IndexBufferID;
+    GLuint                  m_ArrayID;
+    GLuint                  m_InstanceBufferID;
+    size_t                  m_InstanceCapacity;
+    GLuint                  m_SkinBufferID;
+    const float*            m_pSkinData;
+    const CSR_OpenGLShader* m_pShader;
+    const float*            m_pData;
+    size_t                  m_Count;
+    size_t                  m_IndexCount;
+    int                     m_Dirty;
+} CSR_OpenGLStaticVB;
+
 /**
 * Multisampling antialiasing
 */
@@ -249,6 +278,10 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         * Links the shader
         *@param[in, out] pShader - shader to link, linked shader if function ends with success
         *@return 1 on success, otherwise 0
+        *@note On success the csr_uModel, csr_uProjection and csr_uView uniform slots, as well as the
+        *      csr_aModel instance attribute slot, are read from the shader and kept in it
+        *@note If the shader declares a mat4 csr_uBones[] uniform array and the vec4 csr_aBoneIndices
+        *      and csr_aBoneWeights attributes, the skinned models are animated by the GPU
         */
         int csrOpenGLShaderLink(CSR_OpenGLShader* pShader);
 
@@ -302,6 +335,50 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         */
         void csrOpenGLStaticBufferInit(CSR_OpenGLStaticBuffer* pSB);
 
+        //-------------------------------------------------------------------
+        // Static vertex buffer functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a static vertex buffer
+        *@return newly created static vertex buffer, 0 on error
+        *@note The static vertex buffer must be released when no longer used, see
+        *      csrOpenGLStaticVBRelease()
+        */
+        CSR_OpenGLStaticVB* csrOpenGLStaticVBCreate(void);
+
+        /**
+        * Releases a static vertex buffer
+        *@param[in, out] pSVB - static vertex buffer to release
+        */
+        void csrOpenGLStaticVBRelease(CSR_OpenGLStaticVB* pSVB);
+
+        /**
+        * Releases the static vertex buffer content, i.e. the GPU side objects it owns
+        *@param[in, out] pSVB - static vertex buffer for which the content should be released
+        */
+        void csrOpenGLStaticVBContentRelease(CSR_OpenGLStaticVB* pSVB);
+
+        /**
+        * Initializes a static vertex buffer structure
+        *@param[in, out] pSVB - static vertex buffer to initialize
+        */
+        void csrOpenGLStaticVBInit(CSR_OpenGLStaticVB* pSVB);
+
+        /**
+        * Copies a vertex buffer content on the GPU side, if not already done or if it changed
+        *@param pVB - source vertex buffer
+        *@param pShader - shader to which the vertex buffer slots should be linked
+        *@param[in, out] pSVB - static vertex buffer to update
+        *@return 1 on success, otherwise 0
+        *@note The content is uploaded again only if the m_Dirty flag is set, or if the source vertex
+        *      buffer data pointer, vertex count or index count changed since the last upload. A vertex
+        *      buffer modified in place should therefore be marked as dirty by the caller
+        */
+        int csrOpenGLStaticVBUpdate(const CSR_VertexBuffer*   pVB,
+                                    const CSR_OpenGLShader*   pShader,
+                                          CSR_OpenGLStaticVB* pSVB);
+
         //-------------------------------------------------------------------
         // Multisampling antialiasing functions
         //-------------------------------------------------------------------
@@ -394,11 +471,17 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         *@param pShader - shader to use to draw the vertex buffer
         *@param pMatrixArray - matrices to use, one for each vertex buffer drawing. If 0, the model
         *                      matrix currently connected in the shader will be used
+        *@param fOnGetID - callback function to get the OpenGL identifier matching with a key
         *@note The shader must be first enabled with the csrShaderEnable() function
+        *@note If fOnGetID returns a CSR_OpenGLStaticVB for the vertex buffer key, the vertex buffer
+        *      is drawn from the GPU memory, otherwise its content is sent to the GPU on each call
+        *@note If the shader declares a mat4 csr_aModel attribute and the vertex buffer is drawn from
+        *      the GPU memory, the whole matrix array is drawn in a single instanced call
         */
         void csrOpenGLDrawVertexBuffer(const CSR_VertexBuffer* pVB,
                                        const CSR_OpenGLShader* pShader,
-                                       const CSR_Array*        pMatrixArray);
+                                       const CSR_Array*        pMatrixArray,
+                                       const CSR_fOnGetID      fOnGetID);
 
         /**
         * Draws a mesh in a scene
@@ -456,6 +539,8 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         *@param animSetIndex - animation set index, ignored if model isn't animated
         *@param frameIndex - frame index, ignored if model isn't animated
         *@param fOnGetID - callback function to get the OpenGL identifier matching with a key
+        *@note If the shader supports it, the bone matrices are sent to the shader and the skin weights
+        *      are applied by the GPU, otherwise they are applied on the CPU side on each frame
         */
         void csrOpenGLDrawX(const CSR_X*            pX,
                             const CSR_OpenGLShader* pShader,
@@ -473,6 +558,8 @@ typedef void (*CSR_fOnLinkStaticVB)(const CSR_OpenGLShader* pShader, const void*
         *@param animSetIndex - animation set index, ignored if model isn't animated
         *@param frameIndex - frame index, ignored if model isn't animated
         *@param fOnGetID - callback function to get the OpenGL identifier matching with a key
+        *@note If the shader supports it, the bone matrices are sent to the shader and the skin weights
+        *      are applied by the GPU, otherwise they are applied on the CPU side on each frame
         */
         void csrOpenGLDrawCollada(const CSR_Collada*      pCollada,
                                   const CSR_OpenGLShader* pShader,
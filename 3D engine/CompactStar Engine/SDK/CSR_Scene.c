@@ -26,6 +26,36 @@
     #include <math.h>
 #endif
 
+//---------------------------------------------------------------------------
+// Global defines
+//---------------------------------------------------------------------------
+#define M_CSR_Scene_Broadphase_Margin 0.1f
+//---------------------------------------------------------------------------
+// Scene private structures
+//---------------------------------------------------------------------------
+
+/**
+* Broadphase candidate, i.e. a model instance found while the broadphase is queried
+*/
+typedef struct
+{
+    size_t m_Item;
+    size_t m_Index;
+    int    m_Collision; // collision types for which the instance should be checked
+} CSR_SceneCandidate;
+
+/**
+* Broadphase query context
+*/
+typedef struct
+{
+    CSR_SceneCandidate* m_pCandidate;
+    size_t              m_Count;
+    size_t              m_Capacity;
+    int                 m_Collision; // collision type being queried
+    int                 m_Success;
+} CSR_SceneBroadphaseQuery;
+
 //---------------------------------------------------------------------------
 // Hit model functions
 //---------------------------------------------------------------------------
@@ -68,6 +98,13 @@ void csrHitModelInit(CSR_HitModel* pHitModel)
     pHitModel->m_pModel              = 0;
     pHitModel->m_Type                = CSR_MT_Mesh;
     pHitModel->m_pAABBTree           = 0;
+    pHitModel->m_Hit.m_pPolygon      = 0;
+    pHitModel->m_Hit.m_Distance      = 0.0f;
+    pHitModel->m_Hit.m_U             = 0.0f;
+    pHitModel->m_Hit.m_V             = 0.0f;
+    pHitModel->m_Hit.m_Normal.m_X    = 0.0f;
+    pHitModel->m_Hit.m_Normal.m_Y    = 0.0f;
+    pHitModel->m_Hit.m_Normal.m_Z    = 0.0f;
     pHitModel->m_Polygons.m_pPolygon = 0;
     pHitModel->m_Polygons.m_Count    = 0;
 
@@ -180,6 +217,7 @@ void csrCollisionOutputInit(CSR_CollisionOutput* pCO)
     pCO->m_CollisionPlane.m_B = 0.0f;
     pCO->m_CollisionPlane.m_C = 0.0f;
     pCO->m_CollisionPlane.m_D = 0.0f;
+    pCO->m_CollisionTime      = 1.0f;
     pCO->m_GroundPlane.m_A    = 0.0f;
     pCO->m_GroundPlane.m_B    = 0.0f;
     pCO->m_GroundPlane.m_C    = 0.0f;
@@ -252,120 +290,475 @@ CSR_SceneItem* csrSceneItemDeleteModelFrom(CSR_SceneItem*       pItem,
     return pNewItem;
 }
 //---------------------------------------------------------------------------
-// Scene item functions
+int csrSceneItemLocalBox(const CSR_SceneItem* pSceneItem, CSR_Box* pBox)
+{
+    size_t         i;
+    int            found = 0;
+    const CSR_Box* pTreeBox;
+
+    // iterate through the item trees, thus the box stays valid whatever the tree used to detect
+    // the collisions
+    for (i = 0; i < pSceneItem->m_AABBTreeCount; ++i)
+    {
+        pTreeBox = pSceneItem->m_pAABBTree[i].m_pBox;
+
+        if (!pTreeBox)
+            continue;
+
+        // first box?
+        if (!found)
+        {
+            *pBox = *pTreeBox;
+            found = 1;
+            continue;
+        }
+
+        // merge the tree box
+        pBox->m_Min.m_X = pTreeBox->m_Min.m_X < pBox->m_Min.m_X ? pTreeBox->m_Min.m_X : pBox->m_Min.m_X;
+        pBox->m_Min.m_Y = pTreeBox->m_Min.m_Y < pBox->m_Min.m_Y ? pTreeBox->m_Min.m_Y : pBox->m_Min.m_Y;
+        pBox->m_Min.m_Z = pTreeBox->m_Min.m_Z < pBox->m_Min.m_Z ? pTreeBox->m_Min.m_Z : pBox->m_Min.m_Z;
+        pBox->m_Max.m_X = pTreeBox->m_Max.m_X > pBox->m_Max.m_X ? pTreeBox->m_Max.m_X : pBox->m_Max.m_X;
+        pBox->m_Max.m_Y = pTreeBox->m_Max.m_Y > pBox->m_Max.m_Y ? pTreeBox->m_Max.m_Y : pBox->m_Max.m_Y;
+        pBox->m_Max.m_Z = pTreeBox->m_Max.m_Z > pBox->m_Max.m_Z ? pTreeBox->m_Max.m_Z : pBox->m_Max.m_Z;
+    }
+
+    return found;
+}
 //---------------------------------------------------------------------------
-CSR_SceneItem* csrSceneItemCreate(void)
+void csrSceneInstanceUpdateMatrices(CSR_SceneInstance* pInstance, const CSR_Matrix4* pMatrix)
 {
-    // create a new scene item
-    CSR_SceneItem* pSceneItem = (CSR_SceneItem*)malloc(sizeof(CSR_SceneItem));
+    float determinant;
 
-    // succeeded?
-    if (!pSceneItem)
-        return 0;
+    // keep the matrix value, thus its changes may be detected later
+    pInstance->m_Matrix = *pMatrix;
 
-    // initialize the scene item content
-    csrSceneItemInit(pSceneItem);
+    // is an affine matrix? (NOTE the model matrices almost always are)
+    if (pMatrix->m_Table[0][3] == 0.0f &&
+        pMatrix->m_Table[1][3] == 0.0f &&
+        pMatrix->m_Table[2][3] == 0.0f &&
+        pMatrix->m_Table[3][3] == 1.0f)
+        csrMat4InverseAffine(pMatrix, &pInstance->m_InvMatrix, &determinant);
+    else
+        csrMat4Inverse(pMatrix, &pInstance->m_InvMatrix, &determinant);
 
-    return pSceneItem;
+    // matrix cannot be inverted?
+    if (determinant == 0.0f)
+        csrMat4Identity(&pInstance->m_InvMatrix);
+
+    csrMat4Transpose(&pInstance->m_InvMatrix, &pInstance->m_NormalMatrix);
 }
 //---------------------------------------------------------------------------
-void csrSceneItemContentRelease(CSR_SceneItem*       pSceneItem,
-                          const CSR_fOnDeleteTexture fOnDeleteTexture)
+const CSR_SceneInstance* csrSceneItemGetInstance(const CSR_SceneItem*     pSceneItem,
+                                                       size_t             index,
+                                                       CSR_SceneInstance* pDefault)
 {
-    // no scene item to release?
-    if (!pSceneItem)
-        return;
+    CSR_SceneInstance* pInstance;
+    const CSR_Matrix4* pMatrix = (CSR_Matrix4*)pSceneItem->m_pMatrixArray->m_pItem[index].m_pData;
 
-    // release the model
-    if (pSceneItem->m_pModel)
-        switch (pSceneItem->m_Type)
+    // no instance data? (e.g. the item isn't owned by a scene)
+    if (!pSceneItem->m_pInstance)
+    {
+        csrSceneInstanceUpdateMatrices(pDefault, pMatrix);
+        return pDefault;
+    }
+
+    pInstance = &pSceneItem->m_pInstance[index];
+
+    // recalculate the cached matrices if the model matrix was modified since
+    if (memcmp(&pInstance->m_Matrix, pMatrix, sizeof(CSR_Matrix4)))
+        csrSceneInstanceUpdateMatrices(pInstance, pMatrix);
+
+    return pInstance;
+}
+//---------------------------------------------------------------------------
+int csrSceneItemUpdateInstance(CSR_SceneItem*       pSceneItem,
+                               size_t               item,
+                               size_t               index,
+                               CSR_AABBDynamicTree* pBroadphase)
+{
+    CSR_Box            box;
+    CSR_SceneInstance* pInstance = &pSceneItem->m_pInstance[index];
+
+    // update the cached matrices
+    csrSceneInstanceUpdateMatrices(pInstance,
+                                   (CSR_Matrix4*)pSceneItem->m_pMatrixArray->m_pItem[index].m_pData);
+
+    // no tree to get the model bounds from? (NOTE such a model cannot collide, except with a
+    // custom detection, which doesn't use the broadphase)
+    if (!csrSceneItemLocalBox(pSceneItem, &box))
+    {
+        // remove the instance from the broadphase, if required
+        if (pBroadphase && pInstance->m_Proxy != (size_t)M_CSR_Unknown_Index)
         {
-            case CSR_MT_Line:    free             ((CSR_Line*)pSceneItem->m_pModel);        break;
-            case CSR_MT_Mesh:    csrMeshRelease   (pSceneItem->m_pModel, fOnDeleteTexture); break;
-            case CSR_MT_Model:   csrModelRelease  (pSceneItem->m_pModel, fOnDeleteTexture); break;
-            case CSR_MT_MDL:     csrMDLRelease    (pSceneItem->m_pModel, fOnDeleteTexture); break;
-            case CSR_MT_X:       csrXRelease      (pSceneItem->m_pModel, fOnDeleteTexture); break;
-            case CSR_MT_Collada: csrColladaRelease(pSceneItem->m_pModel, fOnDeleteTexture); break;
+            csrAABBDynamicTreeRemove(pInstance->m_Proxy, pBroadphase);
+            pInstance->m_Proxy = (size_t)M_CSR_Unknown_Index;
         }
 
-    // release the aligned-axis bounding box tree
-    if (pSceneItem->m_pAABBTree)
+        return 1;
+    }
+
+    // put the model box into the scene coordinate system
+    csrBoxTransform(&box, &pInstance->m_Matrix, &pInstance->m_Box);
+
+    // no broadphase to update?
+    if (!pBroadphase)
+        return 1;
+
+    // is instance already in the broadphase?
+    if (pInstance->m_Proxy != (size_t)M_CSR_Unknown_Index)
     {
-        size_t i;
+        csrAABBDynamicTreeMove(pInstance->m_Proxy, &pInstance->m_Box, pBroadphase);
+        return 1;
+    }
 
-        // release all the tree content
-        for (i = 0; i < pSceneItem->m_AABBTreeCount; ++i)
-        {
-            // get the AABB tree root node
-            CSR_AABBNode* pNode = &pSceneItem->m_pAABBTree[i];
+    // add the instance in the broadphase
+    pInstance->m_Proxy = csrAABBDynamicTreeInsert(&pInstance->m_Box, item, index, pBroadphase);
 
-            // release all children on left side
-            if (pNode->m_pLeft)
-                csrAABBTreeNodeRelease(pNode->m_pLeft);
+    return (pInstance->m_Proxy != (size_t)M_CSR_Unknown_Index);
+}
+//---------------------------------------------------------------------------
+void csrSceneItemDeleteInstance(CSR_SceneItem*       pSceneItem,
+                                size_t               index,
+                                CSR_AABBDynamicTree* pBroadphase)
+{
+    size_t i;
+    size_t last;
+    int    indexed;
 
-            // release all children on right side
-            if (pNode->m_pRight)
-                csrAABBTreeNodeRelease(pNode->m_pRight);
+    last    = pSceneItem->m_pMatrixArray->m_Count - 1;
+    indexed = (pSceneItem->m_pMatrixArray->m_Index.m_pSlot != 0);
 
-            // delete node content
-            csrAABBTreeNodeContentRelease(pNode);
-        }
+    // delete the matrix
+    csrArrayDeleteAt(index, pSceneItem->m_pMatrixArray);
 
-        // free the tree container
-        free(pSceneItem->m_pAABBTree);
+    // no instance data?
+    if (!pSceneItem->m_pInstance)
+        return;
+
+    // remove the instance from the broadphase
+    if (pBroadphase && pSceneItem->m_pInstance[index].m_Proxy != (size_t)M_CSR_Unknown_Index)
+        csrAABBDynamicTreeRemove(pSceneItem->m_pInstance[index].m_Proxy, pBroadphase);
+
+    // nothing to move?
+    if (index == last)
+        return;
+
+    // move the instances the same way as the matrix array moved the matrices
+    if (indexed)
+    {
+        pSceneItem->m_pInstance[index] = pSceneItem->m_pInstance[last];
+        last                           = index + 1;
     }
+    else
+        memmove(pSceneItem->m_pInstance + index,
+                pSceneItem->m_pInstance + index + 1,
+                sizeof(CSR_SceneInstance) * (last - index));
 
-    // release the matrix array
-    csrArrayRelease(pSceneItem->m_pMatrixArray);
+    // no broadphase to update?
+    if (!pBroadphase)
+        return;
 
-    // NOTE don't release the shader, as it's just linked with the item, not owned
+    // update the index of the moved instances in the broadphase
+    for (i = index; i < last; ++i)
+        if (pSceneItem->m_pInstance[i].m_Proxy != (size_t)M_CSR_Unknown_Index)
+            pBroadphase->m_pNodes[pSceneItem->m_pInstance[i].m_Proxy].m_Index = i;
 }
 //---------------------------------------------------------------------------
-void csrSceneItemInit(CSR_SceneItem* pSceneItem)
+void csrSceneItemDetectInstanceCollision(const CSR_Scene*           pScene,
+                                         const CSR_SceneItem*       pSceneItem,
+                                         const CSR_SceneInstance*   pInstance,
+                                               int                  collisionType,
+                                         const CSR_CollisionInput*  pCollisionInput,
+                                               CSR_CollisionOutput* pCollisionOutput)
 {
-    // no scene item to initialize?
-    if (!pSceneItem)
-        return;
+    #ifdef _MSC_VER
+        CSR_Vector3 rayPos  = {0};
+        CSR_Vector3 rayDir  = {0};
+        CSR_Vector3 rayDirN = {0};
+        CSR_Sphere  sphere  = {0};
+    #else
+        CSR_Vector3 rayPos;
+        CSR_Vector3 rayDir;
+        CSR_Vector3 rayDirN;
+        CSR_Sphere  sphere;
+    #endif
 
-    // initialize the scene item
-    pSceneItem->m_pModel        = 0;
-    pSceneItem->m_Type          = CSR_MT_Model;
-    pSceneItem->m_CollisionType = CSR_CO_None;
-    pSceneItem->m_pMatrixArray  = 0;
-    pSceneItem->m_pAABBTree     = 0;
-    pSceneItem->m_AABBTreeCount = 0;
-    pSceneItem->m_AABBTreeIndex = 0;
+    // put the bounding sphere into the model coordinate system (at the location where the
+    // collision should be checked)
+    sphere.m_Radius = pCollisionInput->m_BoundingSphere.m_Radius;
+    csrMat4Transform(&pInstance->m_InvMatrix, &pCollisionInput->m_CheckPos, &sphere.m_Center);
+
+    // do detect the ground collision on this model?
+    if (collisionType & CSR_CO_Ground)
+    {
+        CSR_Polygon3 groundPolygon;
+        float        posY;
+
+        // calculate the y position where to place the point of view
+        if (csrGroundPosY(&sphere,
+                          &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
+                          &pScene->m_GroundDir,
+                          &groundPolygon,
+                          &posY))
+        {
+            CSR_Plane polygonPlane;
+
+            // notify that a ground collision happened
+            pCollisionOutput->m_Collision |= CSR_CO_Ground;
+
+            // set the new ground position
+            pCollisionOutput->m_GroundPos = posY;
+
+            // calculate and set the new ground plane
+            csrPlaneFromPoints(&groundPolygon.m_Vertex[0],
+                               &groundPolygon.m_Vertex[1],
+                               &groundPolygon.m_Vertex[2],
+                               &polygonPlane);
+            csrPlaneTransform(&polygonPlane, &pInstance->m_NormalMatrix, &pCollisionOutput->m_GroundPlane);
+        }
+    }
+
+    // do detect the edge collision on this model?
+    if (collisionType & CSR_CO_Edge)
+    {
+        CSR_Vector3     motionDir;
+        CSR_Vector3     contact;
+        CSR_Ray3        motionRay;
+        CSR_AABBTreeHit hit;
+        CSR_Plane       plane;
+        CSR_Plane       sceneSlidingPlane;
+        float           motionLength;
+        float           radius;
+        float           scale;
+        float           time;
+        float           length;
+        int             i;
+
+        // calculate the sphere motion and put it into the model coordinate system
+        csrVec3Sub(&pCollisionInput->m_CheckPos, &pCollisionInput->m_BoundingSphere.m_Center, &motionDir);
+        csrMat4ApplyToVector(&pInstance->m_InvMatrix, &pCollisionInput->m_BoundingSphere.m_Center, &rayPos);
+        csrMat4ApplyToNormal(&pInstance->m_InvMatrix, &motionDir, &rayDir);
+        csrVec3Length(&rayDir, &motionLength);
+
+        // put the sphere radius into the model coordinate system. NOTE a non-uniform scaling would
+        // deform the sphere, in this case the smallest radius is kept, thus the sphere never
+        // collides farther than its radius in the scene
+        for (i = 0; i < 3; ++i)
+        {
+            scale = (float)sqrt(pInstance->m_InvMatrix.m_Table[0][i] * pInstance->m_InvMatrix.m_Table[0][i] +
+                                pInstance->m_InvMatrix.m_Table[1][i] * pInstance->m_InvMatrix.m_Table[1][i] +
+                                pInstance->m_InvMatrix.m_Table[2][i] * pInstance->m_InvMatrix.m_Table[2][i]);
+
+            if (!i || scale < radius)
+                radius = scale;
+        }
+
+        radius *= pCollisionInput->m_BoundingSphere.m_Radius;
+
+        // is the sphere moving? If not, only check if it intersects the model
+        if (motionLength > 0.0f)
+            csrVec3DivVal(&rayDir, motionLength, &rayDirN);
+        else
+        {
+            rayDirN.m_X = 0.0f;
+            rayDirN.m_Y = 0.0f;
+            rayDirN.m_Z = 1.0f;
+        }
+
+        csrRay3FromPointDir(&rayPos, &rayDirN, &motionRay);
+
+        // sweep the sphere along its motion, and search for the first touched polygon
+        if (csrAABBTreeSphereCast(&motionRay,
+                                   radius,
+                                  &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
+                                   motionLength,
+                                  &hit))
+        {
+            // the motion part done before the collision is the same in any coordinate system
+            time = motionLength > 0.0f ? hit.m_Distance / motionLength : 0.0f;
+
+            // keep only the first collision happening in the scene
+            if (!(pCollisionOutput->m_Collision & CSR_CO_Edge) || time < pCollisionOutput->m_CollisionTime)
+            {
+                // calculate the touched point, the sliding plane passes through it
+                contact.m_X = rayPos.m_X + rayDirN.m_X * hit.m_Distance - hit.m_Normal.m_X * radius;
+                contact.m_Y = rayPos.m_Y + rayDirN.m_Y * hit.m_Distance - hit.m_Normal.m_Y * radius;
+                contact.m_Z = rayPos.m_Z + rayDirN.m_Z * hit.m_Distance - hit.m_Normal.m_Z * radius;
+                csrPlaneFromPointNormal(&contact, &hit.m_Normal, &plane);
+
+                // put the sliding plane into the scene coordinate system, and normalize it again
+                // in case the model is scaled
+                csrPlaneTransform(&plane, &pInstance->m_NormalMatrix, &sceneSlidingPlane);
+
+                length = (float)sqrt(sceneSlidingPlane.m_A * sceneSlidingPlane.m_A +
+                                     sceneSlidingPlane.m_B * sceneSlidingPlane.m_B +
+                                     sceneSlidingPlane.m_C * sceneSlidingPlane.m_C);
+
+                if (length)
+                {
+                    sceneSlidingPlane.m_A /= length;
+                    sceneSlidingPlane.m_B /= length;
+                    sceneSlidingPlane.m_C /= length;
+                    sceneSlidingPlane.m_D /= length;
+                }
+
+                // notify that an edge collision happened
+                pCollisionOutput->m_Collision      |= CSR_CO_Edge;
+                pCollisionOutput->m_CollisionPlane  = sceneSlidingPlane;
+                pCollisionOutput->m_CollisionTime   = time;
+            }
+        }
+    }
+
+    // do detect the mouse collision on this model?
+    if (collisionType & CSR_CO_Mouse)
+    {
+        CSR_Ray3      mouseRay;
+        CSR_HitModel* pHitModel;
+
+        // put the mouse ray into the model coordinate system
+        csrMat4ApplyToVector(&pInstance->m_InvMatrix, &pCollisionInput->m_MouseRay.m_Pos, &rayPos);
+        csrMat4ApplyToNormal(&pInstance->m_InvMatrix, &pCollisionInput->m_MouseRay.m_Dir, &rayDir);
+        csrVec3Normalize(&rayDir, &rayDirN);
+        csrRay3FromPointDir(&rayPos, &rayDirN, &mouseRay);
+
+        // create a new hit model container, if required
+        if (!pCollisionOutput->m_pHitModel)
+            pCollisionOutput->m_pHitModel = csrArrayCreate();
+
+        // create a new hit model
+        pHitModel = csrHitModelCreate();
+
+        // succeeded?
+        if (!pHitModel)
+            return;
+
+        // using the mouse ray, search for the nearest polygon hit in the model
+        if (csrAABBTreeRayCast(&mouseRay,
+                               &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
+                               -1.0f,
+                               &pHitModel->m_Hit))
+        {
+            // copy the hit polygon
+            pHitModel->m_Polygons.m_pPolygon = (CSR_Polygon3*)malloc(sizeof(CSR_Polygon3));
+
+            if (pHitModel->m_Polygons.m_pPolygon)
+            {
+                pHitModel->m_Polygons.m_Count = 1;
+                csrIndexedPolygonToPolygon(pHitModel->m_Hit.m_pPolygon, pHitModel->m_Polygons.m_pPolygon);
+            }
+        }
+
+        // found a collision with the mouse ray?
+        if (pHitModel->m_Polygons.m_Count)
+        {
+            // notify that a mouse collision happened
+            pCollisionOutput->m_Collision |= CSR_CO_Mouse;
+
+            // populate the hit model structure
+            pHitModel->m_pModel    = pSceneItem->m_pModel;
+            pHitModel->m_Type      = pSceneItem->m_Type;
+            pHitModel->m_Matrix    = pInstance->m_Matrix;
+            pHitModel->m_pAABBTree = &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex];
+
+            // add the hit model structure in the array
+            csrArrayAdd(pHitModel, pCollisionOutput->m_pHitModel, 0);
+        }
+        else
+        {
+            // no found collision, release the hit model
+            csrHitModelRelease(pHitModel);
+        }
+    }
 }
 //---------------------------------------------------------------------------
-void csrSceneItemDraw(const CSR_Scene*        pScene,
-                      const CSR_SceneContext* pContext,
-                      const CSR_SceneItem*    pItem)
+int csrSceneItemCull(const CSR_SceneItem*       pSceneItem,
+                     const CSR_Frustum*         pFrustum,
+                     const CSR_OcclusionBuffer* pOcclusion,
+                           CSR_Array*           pVisibleArray,
+                     const CSR_Array**          ppMatrixArray)
 {
-    void* pShader;
+    size_t  i;
+    size_t  j;
+    size_t  count;
+    size_t  boxCount;
+    int     visible[4];
+    CSR_Box localBox;
+    CSR_Box boxes[4];
+
+    *ppMatrixArray = pSceneItem->m_pMatrixArray;
+
+    // no bounds to cull the item with? (NOTE the models without aligned-axis bounding box trees
+    // are always drawn)
+    if (!csrSceneItemLocalBox(pSceneItem, &localBox))
+        return 1;
+
+    // no model matrix? (NOTE in this case the model is drawn once, in its own coordinates system)
+    if (!pSceneItem->m_pMatrixArray || !pSceneItem->m_pMatrixArray->m_Count)
+        return (csrFrustumBoxVisible(pFrustum, &localBox) &&
+                csrOcclusionBufferBoxVisible(pOcclusion, &localBox));
+
+    count = 0;
+
+    // iterate through the item instances and keep the visible ones. NOTE the box is calculated
+    // from the current tree and matrix values, because both may have changed since the instance
+    // data was updated, e.g. by a refitted tree
+    for (i = 0; i < pSceneItem->m_pMatrixArray->m_Count; i += boxCount)
+    {
+        boxCount = pSceneItem->m_pMatrixArray->m_Count - i;
 
-    // validate the inputs
-    if (!pScene || !pContext || !pItem)
-        return;
+        // the instances are checked against the frustum 4 by 4
+        if (boxCount > 4)
+            boxCount = 4;
 
-    pShader = 0;
+        for (j = 0; j < boxCount; ++j)
+            csrBoxTransform(&localBox,
+                            (CSR_Matrix4*)pSceneItem->m_pMatrixArray->m_pItem[i + j].m_pData,
+                            &boxes[j]);
 
-    // get the shader to use with the model
-    if (pContext->m_fOnGetShader)
-        pShader = pContext->m_fOnGetShader(pItem->m_pModel, pItem->m_Type);
+        csrFrustumBoxVisibleBatch(pFrustum, boxes, boxCount, visible);
 
-    // found one?
-    if (!pShader)
-        return;
+        for (j = 0; j < boxCount; ++j)
+        {
+            if (!visible[j])
+                continue;
 
-    // enable the item shader
-    csrShaderEnable(pShader);
+            // is the instance hidden by the occluders?
+            if (!csrOcclusionBufferBoxVisible(pOcclusion, &boxes[j]))
+                continue;
 
-    // connect the projection matrix to shader
-    csrShaderConnectProjectionMatrix(pShader, &pScene->m_ProjectionMatrix);
+            // keep the visible matrix, if the item provides the space to do that
+            if (pSceneItem->m_pVisible)
+                pSceneItem->m_pVisible[count] = pSceneItem->m_pMatrixArray->m_pItem[i + j];
 
-    // connect the view matrix to shader
-    csrShaderConnectViewMatrix(pShader, &pScene->m_ViewMatrix);
+            ++count;
+        }
+    }
+
+    // no visible instance? (NOTE don't draw an empty matrix array, because the model would be
+    // drawn once without matrix in this case)
+    if (!count)
+        return 0;
+
+    // all the instances are visible, or the visible matrices cannot be kept?
+    if (count == pSceneItem->m_pMatrixArray->m_Count || !pSceneItem->m_pVisible)
+        return 1;
 
+    // draw only the visible instances. NOTE the array just borrows the item buffer, it should not
+    // be released
+    pVisibleArray->m_pItem    = pSceneItem->m_pVisible;
+    pVisibleArray->m_Count    = count;
+    pVisibleArray->m_Capacity = count;
+    *ppMatrixArray            = pVisibleArray;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrSceneItemDrawModel(const CSR_SceneContext* pContext,
+                           const CSR_SceneItem*    pItem,
+                                 void*             pShader,
+                           const CSR_Array*        pMatrixArray)
+{
     // draw the model
     switch (pItem->m_Type)
     {
@@ -378,7 +771,7 @@ void csrSceneItemDraw(const CSR_Scene*        pScene,
             // draw the mesh
             csrDrawMesh((const CSR_Mesh*)pItem->m_pModel,
                                          pShader,
-                                         pItem->m_pMatrixArray,
+                                         pMatrixArray,
                                          pContext->m_fOnGetID);
 
             break;
@@ -395,7 +788,7 @@ void csrSceneItemDraw(const CSR_Scene*        pScene,
             csrDrawModel((const CSR_Model*)pItem->m_pModel,
                                            index,
                                            pShader,
-                                           pItem->m_pMatrixArray,
+                                           pMatrixArray,
                                            pContext->m_fOnGetID);
 
             break;
@@ -417,7 +810,7 @@ void csrSceneItemDraw(const CSR_Scene*        pScene,
             // draw the MDL model
             csrDrawMDL((const CSR_MDL*)pItem->m_pModel,
                                        pShader,
-                                       pItem->m_pMatrixArray,
+                                       pMatrixArray,
                                        skinIndex,
                                        modelIndex,
                                        meshIndex,
@@ -438,7 +831,7 @@ void csrSceneItemDraw(const CSR_Scene*        pScene,
             // draw the X model
             csrDrawX((const CSR_X*)pItem->m_pModel,
                                    pShader,
-                                   pItem->m_pMatrixArray,
+                                   pMatrixArray,
                                    animSetIndex,
                                    frameIndex,
                                    pContext->m_fOnGetID);
@@ -458,7 +851,7 @@ void csrSceneItemDraw(const CSR_Scene*        pScene,
             // draw the Collada model
             csrDrawCollada((const CSR_Collada*)pItem->m_pModel,
                                                pShader,
-                                               pItem->m_pMatrixArray,
+                                               pMatrixArray,
                                                animSetIndex,
                                                frameIndex,
                                                pContext->m_fOnGetID);
@@ -466,200 +859,891 @@ void csrSceneItemDraw(const CSR_Scene*        pScene,
             break;
         }
     }
+}
+//---------------------------------------------------------------------------
+void csrSceneItemDrawVisible(const CSR_Scene*           pScene,
+                             const CSR_SceneContext*    pContext,
+                             const CSR_SceneItem*       pItem,
+                             const CSR_Frustum*         pFrustum,
+                             const CSR_OcclusionBuffer* pOcclusion)
+{
+    void*            pShader;
+    const CSR_Array* pMatrixArray;
+    CSR_Array        visibleArray;
+
+    csrArrayInit(&visibleArray);
+
+    // is the item out of the camera view, or hidden?
+    if (!csrSceneItemCull(pItem, pFrustum, pOcclusion, &visibleArray, &pMatrixArray))
+        return;
+
+    pShader = 0;
+
+    // get the shader to use with the model
+    if (pContext->m_fOnGetShader)
+        pShader = pContext->m_fOnGetShader(pItem->m_pModel, pItem->m_Type);
+
+    // found one?
+    if (!pShader)
+        return;
+
+    // enable the item shader
+    csrShaderEnable(pShader);
+
+    // connect the projection matrix to shader
+    csrShaderConnectProjectionMatrix(pShader, &pScene->m_ProjectionMatrix);
+
+    // connect the view matrix to shader
+    csrShaderConnectViewMatrix(pShader, &pScene->m_ViewMatrix);
+
+    // draw the model
+    csrSceneItemDrawModel(pContext, pItem, pShader, pMatrixArray);
 
     // disable the item shader
     csrShaderEnable(0);
 }
 //---------------------------------------------------------------------------
-void csrSceneItemDetectCollision(const CSR_Scene*                   pScene,
-                                 const CSR_SceneItem*               pSceneItem,
-                                 const CSR_CollisionInput*          pCollisionInput,
-                                       CSR_CollisionOutput*         pCollisionOutput,
-                                       CSR_fOnCustomDetectCollision fOnCustomDetectCollision)
+// Scene item functions
+//---------------------------------------------------------------------------
+CSR_SceneItem* csrSceneItemCreate(void)
+{
+    // create a new scene item
+    CSR_SceneItem* pSceneItem = (CSR_SceneItem*)malloc(sizeof(CSR_SceneItem));
+
+    // succeeded?
+    if (!pSceneItem)
+        return 0;
+
+    // initialize the scene item content
+    csrSceneItemInit(pSceneItem);
+
+    return pSceneItem;
+}
+//---------------------------------------------------------------------------
+void csrSceneItemContentRelease(CSR_SceneItem*       pSceneItem,
+                          const CSR_fOnDeleteTexture fOnDeleteTexture)
+{
+    // no scene item to release?
+    if (!pSceneItem)
+        return;
+
+    // release the model
+    if (pSceneItem->m_pModel)
+        switch (pSceneItem->m_Type)
+        {
+            case CSR_MT_Line:    free             ((CSR_Line*)pSceneItem->m_pModel);        break;
+            case CSR_MT_Mesh:    csrMeshRelease   (pSceneItem->m_pModel, fOnDeleteTexture); break;
+            case CSR_MT_Model:   csrModelRelease  (pSceneItem->m_pModel, fOnDeleteTexture); break;
+            case CSR_MT_MDL:     csrMDLRelease    (pSceneItem->m_pModel, fOnDeleteTexture); break;
+            case CSR_MT_X:       csrXRelease      (pSceneItem->m_pModel, fOnDeleteTexture); break;
+            case CSR_MT_Collada: csrColladaRelease(pSceneItem->m_pModel, fOnDeleteTexture); break;
+        }
+
+    // release the aligned-axis bounding box tree
+    if (pSceneItem->m_pAABBTree)
+    {
+        size_t i;
+
+        // release all the tree content
+        for (i = 0; i < pSceneItem->m_AABBTreeCount; ++i)
+        {
+            // get the AABB tree root node
+            CSR_AABBNode* pNode = &pSceneItem->m_pAABBTree[i];
+
+            // release all children on left side
+            if (pNode->m_pLeft)
+                csrAABBTreeNodeRelease(pNode->m_pLeft);
+
+            // release all children on right side
+            if (pNode->m_pRight)
+                csrAABBTreeNodeRelease(pNode->m_pRight);
+
+            // delete node content
+            csrAABBTreeNodeContentRelease(pNode);
+        }
+
+        // free the tree container
+        free(pSceneItem->m_pAABBTree);
+    }
+
+    // release the matrix array
+    csrArrayRelease(pSceneItem->m_pMatrixArray);
+
+    // release the instance data
+    free(pSceneItem->m_pInstance);
+
+    // release the visible matrix buffer
+    free(pSceneItem->m_pVisible);
+
+    // NOTE don't release the shader, as it's just linked with the item, not owned
+}
+//---------------------------------------------------------------------------
+void csrSceneItemInit(CSR_SceneItem* pSceneItem)
+{
+    // no scene item to initialize?
+    if (!pSceneItem)
+        return;
+
+    // initialize the scene item
+    pSceneItem->m_pModel        = 0;
+    pSceneItem->m_Type          = CSR_MT_Model;
+    pSceneItem->m_CollisionType = CSR_CO_None;
+    pSceneItem->m_pMatrixArray  = 0;
+    pSceneItem->m_pInstance     = 0;
+    pSceneItem->m_pVisible      = 0;
+    pSceneItem->m_pShader       = 0;
+    pSceneItem->m_pAABBTree     = 0;
+    pSceneItem->m_AABBTreeCount = 0;
+    pSceneItem->m_AABBTreeIndex = 0;
+    pSceneItem->m_pAABBTreeMesh = 0;
+    pSceneItem->m_Occluder      = 0;
+}
+//---------------------------------------------------------------------------
+int csrSceneItemRefitAABBTree(CSR_SceneItem* pSceneItem, const CSR_Mesh* pMesh)
+{
+    // validate the inputs
+    if (!pSceneItem || !pMesh)
+        return 0;
+
+    // is tree refittable?
+    if (!pSceneItem->m_pAABBTree || !pSceneItem->m_pAABBTreeMesh)
+        return 0;
+
+    // tree already surrounds the mesh?
+    if (pSceneItem->m_pAABBTreeMesh == pMesh)
+        return 1;
+
+    // refit the tree
+    if (!csrAABBTreeRefit(pSceneItem->m_pAABBTree, pSceneItem->m_pAABBTreeMesh, pMesh, 0))
+        return 0;
+
+    pSceneItem->m_pAABBTreeMesh = pMesh;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneItemAddAABBTree(CSR_SceneItem* pSceneItem, CSR_AABBNode* pAABBTree)
+{
+    CSR_AABBNode* pAABBTrees;
+
+    // validate the inputs
+    if (!pSceneItem || !pAABBTree)
+        return 0;
+
+    // add space for the new tree
+    pAABBTrees = (CSR_AABBNode*)csrMemoryAlloc(pSceneItem->m_pAABBTree,
+                                               sizeof(CSR_AABBNode),
+                                               pSceneItem->m_AABBTreeCount + 1);
+
+    // succeeded?
+    if (!pAABBTrees)
+        return 0;
+
+    // copy the tree content
+    memcpy(&pAABBTrees[pSceneItem->m_AABBTreeCount], pAABBTree, sizeof(CSR_AABBNode));
+
+    pSceneItem->m_pAABBTree = pAABBTrees;
+    ++pSceneItem->m_AABBTreeCount;
+
+    // release the source tree (NOTE reset its value before, otherwise the copied tree content will
+    // also be released, which will corrupt the tree)
+    pAABBTree->m_pParent        = 0;
+    pAABBTree->m_pLeft          = 0;
+    pAABBTree->m_pRight         = 0;
+    pAABBTree->m_pBox           = 0;
+    pAABBTree->m_pPolygonBuffer = 0;
+    csrAABBTreeNodeRelease(pAABBTree);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrSceneItemDraw(const CSR_Scene*        pScene,
+                      const CSR_SceneContext* pContext,
+                      const CSR_SceneItem*    pItem)
+{
+    CSR_Matrix4 viewProjMatrix;
+    CSR_Frustum frustum;
+
+    // validate the inputs
+    if (!pScene || !pContext || !pItem)
+        return;
+
+    // get the camera frustum in the scene coordinates system
+    csrMat4Multiply(&pScene->m_ViewMatrix, &pScene->m_ProjectionMatrix, &viewProjMatrix);
+    csrFrustumFromMatrix(&viewProjMatrix, &frustum);
+
+    // draw the item
+    csrSceneItemDrawVisible(pScene, pContext, pItem, &frustum, 0);
+}
+//---------------------------------------------------------------------------
+void csrSceneItemDetectCollision(const CSR_Scene*                   pScene,
+                                 const CSR_SceneItem*               pSceneItem,
+                                 const CSR_CollisionInput*          pCollisionInput,
+                                       CSR_CollisionOutput*         pCollisionOutput,
+                                       CSR_fOnCustomDetectCollision fOnCustomDetectCollision)
+{
+    size_t                   i;
+    const CSR_SceneInstance* pInstance;
+    CSR_SceneInstance        instance;
+
+    // validate the inputs
+    if (!pScene || !pSceneItem || !pCollisionInput || !pCollisionOutput)
+        return;
+
+    // can detect collision on this model?
+    if (!(pSceneItem->m_CollisionType & CSR_CO_Custom) &&
+         (pSceneItem->m_CollisionType == CSR_CO_None   ||
+         !pSceneItem->m_pMatrixArray                   ||
+         !pSceneItem->m_pMatrixArray->m_Count          ||
+         !pSceneItem->m_AABBTreeCount                  ||
+          pSceneItem->m_AABBTreeIndex >= pSceneItem->m_AABBTreeCount))
+        return;
+
+    // iterate through each model position
+    for (i = 0; i < pSceneItem->m_pMatrixArray->m_Count; ++i)
+    {
+        // get the instance, containing the inverse of the model matrix
+        pInstance = csrSceneItemGetInstance(pSceneItem, i, &instance);
+
+        // let the caller process custom collisions if required
+        if (fOnCustomDetectCollision && pSceneItem->m_CollisionType & CSR_CO_Custom)
+        {
+            if (fOnCustomDetectCollision(pScene,
+                                         pSceneItem,
+                                         i,
+                                        &pInstance->m_InvMatrix,
+                                         pCollisionInput,
+                                         pCollisionOutput))
+                continue;
+
+            // because not checked above, to prevent that stupid things happen...
+            if (!pSceneItem->m_AABBTreeCount || pSceneItem->m_AABBTreeIndex >= pSceneItem->m_AABBTreeCount)
+                continue;
+        }
+
+        // detect the collisions on this model instance
+        csrSceneItemDetectInstanceCollision(pScene,
+                                            pSceneItem,
+                                            pInstance,
+                                            pSceneItem->m_CollisionType,
+                                            pCollisionInput,
+                                            pCollisionOutput);
+    }
+}
+//---------------------------------------------------------------------------
+// Scene private functions
+//---------------------------------------------------------------------------
+CSR_AABBDynamicTree* csrSceneGetBroadphase(const CSR_Scene*     pScene,
+                                           const CSR_SceneItem* pSceneItem,
+                                                 size_t*        pItem)
+{
+    // is a standard item?
+    if (pScene->m_pItem                  &&
+        pSceneItem >= pScene->m_pItem    &&
+        pSceneItem <  pScene->m_pItem + pScene->m_ItemCount)
+    {
+        *pItem = (size_t)(pSceneItem - pScene->m_pItem);
+        return pScene->m_pBroadphase;
+    }
+
+    // is a transparent item?
+    if (pScene->m_pTransparentItem                                &&
+        pSceneItem >= pScene->m_pTransparentItem                  &&
+        pSceneItem <  pScene->m_pTransparentItem + pScene->m_TransparentItemCount)
+    {
+        *pItem = (size_t)(pSceneItem - pScene->m_pTransparentItem);
+        return pScene->m_pTransparentBroadphase;
+    }
+
+    *pItem = (size_t)M_CSR_Unknown_Index;
+    return 0;
+}
+//---------------------------------------------------------------------------
+int csrSceneUpdateItemsBroadphase(CSR_SceneItem*       pItems,
+                                  size_t               count,
+                                  CSR_AABBDynamicTree* pBroadphase)
+{
+    size_t i;
+    size_t j;
+    int    success = 1;
+
+    // iterate through the items instances and update each of them
+    for (i = 0; i < count; ++i)
+        if (pItems[i].m_pMatrixArray && pItems[i].m_pInstance)
+            for (j = 0; j < pItems[i].m_pMatrixArray->m_Count; ++j)
+                success &= csrSceneItemUpdateInstance(&pItems[i], i, j, pBroadphase);
+
+    return success;
+}
+//---------------------------------------------------------------------------
+void csrSceneResetItemsBroadphase(CSR_SceneItem* pItems, size_t count)
+{
+    size_t i;
+    size_t j;
+
+    // iterate through the items instances and unlink them from the broadphase
+    for (i = 0; i < count; ++i)
+        if (pItems[i].m_pMatrixArray && pItems[i].m_pInstance)
+            for (j = 0; j < pItems[i].m_pMatrixArray->m_Count; ++j)
+                pItems[i].m_pInstance[j].m_Proxy = (size_t)M_CSR_Unknown_Index;
+}
+//---------------------------------------------------------------------------
+void csrSceneRemoveItemBroadphase(CSR_SceneItem* pSceneItem, CSR_AABBDynamicTree* pBroadphase)
+{
+    size_t i;
+
+    // no broadphase or nothing to remove?
+    if (!pBroadphase || !pSceneItem->m_pMatrixArray || !pSceneItem->m_pInstance)
+        return;
+
+    // remove all the item instances from the broadphase
+    for (i = 0; i < pSceneItem->m_pMatrixArray->m_Count; ++i)
+        if (pSceneItem->m_pInstance[i].m_Proxy != (size_t)M_CSR_Unknown_Index)
+        {
+            csrAABBDynamicTreeRemove(pSceneItem->m_pInstance[i].m_Proxy, pBroadphase);
+            pSceneItem->m_pInstance[i].m_Proxy = (size_t)M_CSR_Unknown_Index;
+        }
+}
+//---------------------------------------------------------------------------
+void csrSceneReindexItemsBroadphase(CSR_SceneItem*       pItems,
+                                    size_t               first,
+                                    size_t               count,
+                                    CSR_AABBDynamicTree* pBroadphase)
+{
+    size_t i;
+    size_t j;
+
+    // no broadphase to update?
+    if (!pItems || !pBroadphase)
+        return;
+
+    // the items were moved in the list, update their index in the broadphase leaves
+    for (i = first; i < count; ++i)
+        if (pItems[i].m_pMatrixArray && pItems[i].m_pInstance)
+            for (j = 0; j < pItems[i].m_pMatrixArray->m_Count; ++j)
+                if (pItems[i].m_pInstance[j].m_Proxy != (size_t)M_CSR_Unknown_Index)
+                    pBroadphase->m_pNodes[pItems[i].m_pInstance[j].m_Proxy].m_Item = i;
+}
+//---------------------------------------------------------------------------
+int csrSceneOnBroadphaseQuery(const CSR_AABBDynamicNode* pNode, void* pContext)
+{
+    size_t                    capacity;
+    CSR_SceneCandidate*       pCandidate;
+    CSR_SceneBroadphaseQuery* pQuery = (CSR_SceneBroadphaseQuery*)pContext;
+
+    // no more space for the candidate?
+    if (pQuery->m_Count >= pQuery->m_Capacity)
+    {
+        capacity   = pQuery->m_Capacity ? pQuery->m_Capacity * 2 : 16;
+        pCandidate = (CSR_SceneCandidate*)csrMemoryAlloc(pQuery->m_pCandidate,
+                                                         sizeof(CSR_SceneCandidate),
+                                                         capacity);
+
+        // succeeded?
+        if (!pCandidate)
+        {
+            pQuery->m_Success = 0;
+            return 0;
+        }
+
+        pQuery->m_pCandidate = pCandidate;
+        pQuery->m_Capacity   = capacity;
+    }
+
+    // add the candidate
+    pCandidate              = &pQuery->m_pCandidate[pQuery->m_Count];
+    pCandidate->m_Item      = pNode->m_Item;
+    pCandidate->m_Index     = pNode->m_Index;
+    pCandidate->m_Collision = pQuery->m_Collision;
+    ++pQuery->m_Count;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneCompareCandidates(const void* pLeft, const void* pRight)
+{
+    const CSR_SceneCandidate* pL = (const CSR_SceneCandidate*)pLeft;
+    const CSR_SceneCandidate* pR = (const CSR_SceneCandidate*)pRight;
+
+    if (pL->m_Item != pR->m_Item)
+        return (pL->m_Item < pR->m_Item) ? -1 : 1;
+
+    if (pL->m_Index != pR->m_Index)
+        return (pL->m_Index < pR->m_Index) ? -1 : 1;
+
+    return 0;
+}
+//---------------------------------------------------------------------------
+void csrSceneDetectItemsCollision(const CSR_Scene*                   pScene,
+                                  const CSR_SceneItem*               pItems,
+                                        size_t                       count,
+                                  const CSR_AABBDynamicTree*         pBroadphase,
+                                  const CSR_CollisionInput*          pCollisionInput,
+                                        CSR_CollisionOutput*         pCollisionOutput,
+                                        CSR_fOnCustomDetectCollision fOnCustomDetectCollision)
+{
+    size_t                   i;
+    size_t                   j;
+    size_t                   index;
+    int                      collision;
+    float                    radius;
+    CSR_Box                  motionBox;
+    CSR_Ray3                 ray;
+    CSR_SceneBroadphaseQuery query;
+    CSR_SceneInstance        instance;
+    const CSR_Vector3*       pStart;
+    const CSR_Vector3*       pEnd;
+
+    query.m_pCandidate = 0;
+    query.m_Count      = 0;
+    query.m_Capacity   = 0;
+    query.m_Success    = 1;
+
+    if (pBroadphase)
+    {
+        // search the instances crossed by the ground line
+        csrRay3FromPointDir(&pCollisionInput->m_CheckPos, &pScene->m_GroundDir, &ray);
+        query.m_Collision = CSR_CO_Ground;
+        csrAABBDynamicTreeQueryRay(&ray, 1, pBroadphase, csrSceneOnBroadphaseQuery, &query);
+
+        // search the instances reached by the bounding sphere while it moves
+        pStart = &pCollisionInput->m_BoundingSphere.m_Center;
+        pEnd   = &pCollisionInput->m_CheckPos;
+        radius =  pCollisionInput->m_BoundingSphere.m_Radius;
+
+        motionBox.m_Min.m_X = (pStart->m_X < pEnd->m_X ? pStart->m_X : pEnd->m_X) - radius;
+        motionBox.m_Min.m_Y = (pStart->m_Y < pEnd->m_Y ? pStart->m_Y : pEnd->m_Y) - radius;
+        motionBox.m_Min.m_Z = (pStart->m_Z < pEnd->m_Z ? pStart->m_Z : pEnd->m_Z) - radius;
+        motionBox.m_Max.m_X = (pStart->m_X > pEnd->m_X ? pStart->m_X : pEnd->m_X) + radius;
+        motionBox.m_Max.m_Y = (pStart->m_Y > pEnd->m_Y ? pStart->m_Y : pEnd->m_Y) + radius;
+        motionBox.m_Max.m_Z = (pStart->m_Z > pEnd->m_Z ? pStart->m_Z : pEnd->m_Z) + radius;
+
+        query.m_Collision = CSR_CO_Edge;
+        csrAABBDynamicTreeQueryBox(&motionBox, pBroadphase, csrSceneOnBroadphaseQuery, &query);
+
+        // search the instances crossed by the mouse ray
+        csrRay3FromPointDir(&pCollisionInput->m_MouseRay.m_Pos, &pCollisionInput->m_MouseRay.m_Dir, &ray);
+        query.m_Collision = CSR_CO_Mouse;
+        csrAABBDynamicTreeQueryRay(&ray, 0, pBroadphase, csrSceneOnBroadphaseQuery, &query);
+    }
+
+    // no broadphase, or failed to query it? Check all the instances
+    if (!pBroadphase || !query.m_Success)
+    {
+        free(query.m_pCandidate);
+
+        for (i = 0; i < count; ++i)
+            csrSceneItemDetectCollision(pScene,
+                                       &pItems[i],
+                                        pCollisionInput,
+                                        pCollisionOutput,
+                                        fOnCustomDetectCollision);
+
+        return;
+    }
+
+    // sort the candidates by item and instance, thus the collisions are found in the same order
+    // as if all the instances were checked
+    if (query.m_Count > 1)
+        qsort(query.m_pCandidate, query.m_Count, sizeof(CSR_SceneCandidate), csrSceneCompareCandidates);
+
+    j = 0;
+
+    // iterate through the items
+    for (i = 0; i < count; ++i)
+    {
+        // the custom collisions may happen anywhere, so check all the item instances
+        if (pItems[i].m_CollisionType & CSR_CO_Custom)
+        {
+            csrSceneItemDetectCollision(pScene,
+                                       &pItems[i],
+                                        pCollisionInput,
+                                        pCollisionOutput,
+                                        fOnCustomDetectCollision);
+
+            // skip the item candidates
+            while (j < query.m_Count && query.m_pCandidate[j].m_Item == i)
+                ++j;
+
+            continue;
+        }
+
+        // iterate through the item candidates
+        while (j < query.m_Count && query.m_pCandidate[j].m_Item == i)
+        {
+            index     = query.m_pCandidate[j].m_Index;
+            collision = query.m_pCandidate[j].m_Collision;
+
+            // merge the candidates found by several queries
+            for (++j; j < query.m_Count && query.m_pCandidate[j].m_Item == i && query.m_pCandidate[j].m_Index == index; ++j)
+                collision |= query.m_pCandidate[j].m_Collision;
+
+            // keep only the collisions the model supports
+            collision &= pItems[i].m_CollisionType;
+
+            // can detect collision on this instance?
+            if (!collision                                             ||
+                !pItems[i].m_pMatrixArray                              ||
+                 index >= pItems[i].m_pMatrixArray->m_Count            ||
+                 pItems[i].m_AABBTreeIndex >= pItems[i].m_AABBTreeCount)
+                continue;
+
+            // detect the collisions on this model instance
+            csrSceneItemDetectInstanceCollision(pScene,
+                                               &pItems[i],
+                                                csrSceneItemGetInstance(&pItems[i], index, &instance),
+                                                collision,
+                                                pCollisionInput,
+                                                pCollisionOutput);
+        }
+    }
+
+    free(query.m_pCandidate);
+}
+//---------------------------------------------------------------------------
+CSR_SceneDrawQueue* csrSceneDrawQueueCreate(void)
+{
+    // create a new draw queue
+    CSR_SceneDrawQueue* pQueue = (CSR_SceneDrawQueue*)malloc(sizeof(CSR_SceneDrawQueue));
+
+    // succeeded?
+    if (!pQueue)
+        return 0;
+
+    // initialize the draw queue content
+    pQueue->m_pPacket        = 0;
+    pQueue->m_PacketCapacity = 0;
+    csrArrayInit(&pQueue->m_Matrices);
+
+    return pQueue;
+}
+//---------------------------------------------------------------------------
+void csrSceneDrawQueueRelease(CSR_SceneDrawQueue* pQueue)
+{
+    // no draw queue to release?
+    if (!pQueue)
+        return;
+
+    // free the packets
+    if (pQueue->m_pPacket)
+        free(pQueue->m_pPacket);
+
+    // free the matrices (NOTE they are only copies, their data belongs to the scene items)
+    if (pQueue->m_Matrices.m_pItem)
+        free(pQueue->m_Matrices.m_pItem);
+
+    // free the draw queue
+    free(pQueue);
+}
+//---------------------------------------------------------------------------
+int csrSceneDrawQueueReserve(size_t packetCount, size_t matrixCount, CSR_SceneDrawQueue* pQueue)
+{
+    size_t               capacity;
+    CSR_SceneDrawPacket* pNewPacket;
+
+    // validate the input
+    if (!pQueue)
+        return 0;
+
+    // grow the capacities geometrically, thus a growing scene doesn't realloc on each frame
+    if (!pQueue->m_pPacket || packetCount > pQueue->m_PacketCapacity)
+    {
+        capacity = pQueue->m_PacketCapacity ? pQueue->m_PacketCapacity : 16;
+
+        while (capacity < packetCount)
+            capacity *= 2;
+
+        // allocate memory for the packets
+        pNewPacket = (CSR_SceneDrawPacket*)csrMemoryAlloc(pQueue->m_pPacket,
+                                                          sizeof(CSR_SceneDrawPacket),
+                                                          capacity);
+
+        // succeeded?
+        if (!pNewPacket)
+            return 0;
+
+        pQueue->m_pPacket        = pNewPacket;
+        pQueue->m_PacketCapacity = capacity;
+    }
+
+    if (!pQueue->m_Matrices.m_pItem || matrixCount > pQueue->m_Matrices.m_Capacity)
+    {
+        capacity = pQueue->m_Matrices.m_Capacity ? pQueue->m_Matrices.m_Capacity : 16;
+
+        while (capacity < matrixCount)
+            capacity *= 2;
+
+        // allocate memory for the matrices
+        if (!csrArrayReserve(capacity, &pQueue->m_Matrices))
+            return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+size_t csrSceneQueueItems(      CSR_SceneItem*       pItems,
+                                size_t               count,
+                          const CSR_Frustum*         pFrustum,
+                          const CSR_OcclusionBuffer* pOcclusion,
+                          const CSR_Vector3*         pCamera,
+                                CSR_SceneDrawPacket* pPacket)
+{
+    size_t           i;
+    size_t           j;
+    size_t           packetCount;
+    const CSR_Array* pMatrixArray;
+    CSR_Array        visibleArray;
+    CSR_Box          box;
+    CSR_Vector3      center;
+    CSR_Vector3      pos;
+    CSR_Vector3      dir;
+
+    packetCount = 0;
+
+    for (i = 0; i < count; ++i)
+    {
+        csrArrayInit(&visibleArray);
+
+        // is the item out of the camera view, or hidden?
+        if (!csrSceneItemCull(&pItems[i], pFrustum, pOcclusion, &visibleArray, &pMatrixArray))
+            continue;
+
+        // get the model center, from which the transparent instances will be sorted
+        if (pCamera && csrSceneItemLocalBox(&pItems[i], &box))
+        {
+            center.m_X = (box.m_Min.m_X + box.m_Max.m_X) * 0.5f;
+            center.m_Y = (box.m_Min.m_Y + box.m_Max.m_Y) * 0.5f;
+            center.m_Z = (box.m_Min.m_Z + box.m_Max.m_Z) * 0.5f;
+        }
+        else
+        {
+            center.m_X = 0.0f;
+            center.m_Y = 0.0f;
+            center.m_Z = 0.0f;
+        }
+
+        // no model matrix, or opaque item? (NOTE the opaque instances are drawn together, the
+        // transparent ones are sorted individually)
+        if (!pMatrixArray || !pMatrixArray->m_Count || !pCamera)
+        {
+            pPacket[packetCount].m_pItem       = &pItems[i];
+            pPacket[packetCount].m_pMatrix     = pMatrixArray ? pMatrixArray->m_pItem : 0;
+            pPacket[packetCount].m_MatrixCount = pMatrixArray ? pMatrixArray->m_Count : 0;
+            pPacket[packetCount].m_Depth       = 0.0f;
+            pPacket[packetCount].m_Order       = packetCount;
+
+            // calculate the model depth
+            if (pCamera)
+            {
+                csrVec3Sub(&center, pCamera, &dir);
+                csrVec3Dot(&dir, &dir, &pPacket[packetCount].m_Depth);
+            }
+
+            ++packetCount;
+            continue;
+        }
+
+        // queue the visible instances one by one, with their depth
+        for (j = 0; j < pMatrixArray->m_Count; ++j)
+        {
+            csrMat4ApplyToVector((CSR_Matrix4*)pMatrixArray->m_pItem[j].m_pData, &center, &pos);
+            csrVec3Sub(&pos, pCamera, &dir);
+
+            pPacket[packetCount].m_pItem       = &pItems[i];
+            pPacket[packetCount].m_pMatrix     = &pMatrixArray->m_pItem[j];
+            pPacket[packetCount].m_MatrixCount = 1;
+            pPacket[packetCount].m_Order       = packetCount;
+            csrVec3Dot(&dir, &dir, &pPacket[packetCount].m_Depth);
+
+            ++packetCount;
+        }
+    }
+
+    return packetCount;
+}
+//---------------------------------------------------------------------------
+int csrSceneComparePackets(const void* pLeft, const void* pRight)
+{
+    const CSR_SceneDrawPacket* pL = (const CSR_SceneDrawPacket*)pLeft;
+    const CSR_SceneDrawPacket* pR = (const CSR_SceneDrawPacket*)pRight;
+
+    // group the items by shader, thus each shader is enabled once. NOTE the shader the item was
+    // drawn with the last time is used, because the shader callback should only be called while
+    // the item is drawn
+    if (pL->m_pItem->m_pShader != pR->m_pItem->m_pShader)
+        return ((size_t)pL->m_pItem->m_pShader < (size_t)pR->m_pItem->m_pShader) ? -1 : 1;
+
+    if (pL->m_Order != pR->m_Order)
+        return (pL->m_Order < pR->m_Order) ? -1 : 1;
+
+    return 0;
+}
+//---------------------------------------------------------------------------
+int csrSceneCompareTransparentPackets(const void* pLeft, const void* pRight)
+{
+    const CSR_SceneDrawPacket* pL = (const CSR_SceneDrawPacket*)pLeft;
+    const CSR_SceneDrawPacket* pR = (const CSR_SceneDrawPacket*)pRight;
+
+    // draw from back to front
+    if (pL->m_Depth != pR->m_Depth)
+        return (pL->m_Depth > pR->m_Depth) ? -1 : 1;
+
+    if (pL->m_Order != pR->m_Order)
+        return (pL->m_Order < pR->m_Order) ? -1 : 1;
+
+    return 0;
+}
+//---------------------------------------------------------------------------
+void csrSceneDrawPackets(const CSR_Scene*           pScene,
+                         const CSR_SceneContext*    pContext,
+                         const CSR_SceneDrawPacket* pPacket,
+                               size_t               count,
+                               CSR_ArrayItem*       pMatrices)
 {
-    #ifdef _MSC_VER
-        size_t      i;
-        CSR_Vector3 rayPos  = {0};
-        CSR_Vector3 rayDir  = {0};
-        CSR_Vector3 rayDirN = {0};
-        CSR_Sphere  sphere  = {0};
-    #else
-        size_t      i;
-        CSR_Vector3 rayPos;
-        CSR_Vector3 rayDir;
-        CSR_Vector3 rayDirN;
-        CSR_Sphere  sphere;
-    #endif
-
-    // validate the inputs
-    if (!pScene || !pSceneItem || !pCollisionInput || !pCollisionOutput)
-        return;
+    size_t         i;
+    size_t         j;
+    void*          pShader;
+    void*          pCurrentShader;
+    CSR_SceneItem* pItem;
+    CSR_Array      matrixArray;
 
-    // can detect collision on this model?
-    if (!(pSceneItem->m_CollisionType & CSR_CO_Custom) &&
-         (pSceneItem->m_CollisionType == CSR_CO_None   ||
-         !pSceneItem->m_pMatrixArray                   ||
-         !pSceneItem->m_pMatrixArray->m_Count          ||
-         !pSceneItem->m_AABBTreeCount                  ||
-          pSceneItem->m_AABBTreeIndex >= pSceneItem->m_AABBTreeCount))
-        return;
+    csrArrayInit(&matrixArray);
 
-    // copy the sphere radius
-    sphere.m_Radius = pCollisionInput->m_BoundingSphere.m_Radius;
+    pCurrentShader = 0;
 
-    // iterate through each model position
-    for (i = 0; i < pSceneItem->m_pMatrixArray->m_Count; ++i)
+    for (i = 0; i < count; i = j)
     {
-        CSR_Matrix4 invertMatrix;
-        float       determinant;
-
-        // inverse the model matrix
-        csrMat4Inverse(&((CSR_Matrix4*)pSceneItem->m_pMatrixArray->m_pItem->m_pData)[i],
-                       &invertMatrix,
-                       &determinant);
+        pItem = pPacket[i].m_pItem;
+        j     = i + 1;
 
-        // let the caller process custom collisions if required
-        if (fOnCustomDetectCollision && pSceneItem->m_CollisionType & CSR_CO_Custom)
+        // merge the following instances of the same item, if any, to draw them together
+        if (pMatrices && pPacket[i].m_MatrixCount == 1)
         {
-            if (fOnCustomDetectCollision(pScene,
-                                         pSceneItem,
-                                         i,
-                                        &invertMatrix,
-                                         pCollisionInput,
-                                         pCollisionOutput))
-                continue;
+            pMatrices[0]        = *pPacket[i].m_pMatrix;
+            matrixArray.m_Count = 1;
 
-            // because not checked above, to prevent that stupid things happen...
-            if (!pSceneItem->m_AABBTreeCount || pSceneItem->m_AABBTreeIndex >= pSceneItem->m_AABBTreeCount)
-                continue;
+            while (j < count && pPacket[j].m_pItem == pItem && pPacket[j].m_MatrixCount == 1)
+            {
+                pMatrices[matrixArray.m_Count] = *pPacket[j].m_pMatrix;
+                ++matrixArray.m_Count;
+                ++j;
+            }
+
+            matrixArray.m_pItem = pMatrices;
+        }
+        else
+        {
+            matrixArray.m_pItem = pPacket[i].m_pMatrix;
+            matrixArray.m_Count = pPacket[i].m_MatrixCount;
         }
 
-        // put the bounding sphere into the model coordinate system (at the location where the
-        // collision should be checked)
-        csrMat4Transform(&invertMatrix, &pCollisionInput->m_CheckPos, &sphere.m_Center);
+        matrixArray.m_Capacity = matrixArray.m_Count;
+
+        pShader = 0;
+
+        // get the shader to use with the model
+        if (pContext->m_fOnGetShader)
+            pShader = pContext->m_fOnGetShader(pItem->m_pModel, pItem->m_Type);
+
+        // keep it to sort the items the next time
+        pItem->m_pShader = pShader;
 
-        // do detect the ground collision on this model?
-        if (pSceneItem->m_CollisionType & CSR_CO_Ground)
+        // found one?
+        if (!pShader)
+            continue;
+
+        // enable the shader and connect the scene matrices to it, if not already done by the
+        // previous item
+        if (pShader != pCurrentShader)
         {
-            CSR_Polygon3 groundPolygon;
-            float        posY;
-
-            // calculate the y position where to place the point of view
-            if (csrGroundPosY(&sphere,
-                              &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
-                              &pScene->m_GroundDir,
-                              &groundPolygon,
-                              &posY))
-            {
-                CSR_Plane   polygonPlane;
-                CSR_Matrix4 transposedMatrix;
-
-                // notify that a ground collision happened
-                pCollisionOutput->m_Collision |= CSR_CO_Ground;
-
-                // set the new ground position
-                pCollisionOutput->m_GroundPos = posY;
-
-                // calculate and set the new ground plane
-                csrPlaneFromPoints(&groundPolygon.m_Vertex[0],
-                                   &groundPolygon.m_Vertex[1],
-                                   &groundPolygon.m_Vertex[2],
-                                   &polygonPlane);
-                csrMat4Transpose(&invertMatrix, &transposedMatrix);
-                csrPlaneTransform(&polygonPlane, &transposedMatrix, &pCollisionOutput->m_GroundPlane);
-            }
+            csrShaderEnable(pShader);
+            csrShaderConnectProjectionMatrix(pShader, &pScene->m_ProjectionMatrix);
+            csrShaderConnectViewMatrix(pShader, &pScene->m_ViewMatrix);
+
+            pCurrentShader = pShader;
         }
 
-        // do detect the edge collision on this model?
-        if (pSceneItem->m_CollisionType & CSR_CO_Edge)
-        {
-            CSR_Vector3 motionDir;
-            CSR_Vector3 motionDirN;
-            CSR_Ray3    motionRay;
-
-            // calculate the motion ray and put it into the model coordinate system
-            csrVec3Sub(&pCollisionInput->m_CheckPos, &pCollisionInput->m_BoundingSphere.m_Center, &motionDir);
-            csrVec3Normalize(&motionDir, &motionDirN);
-            csrMat4ApplyToVector(&invertMatrix, &pCollisionInput->m_BoundingSphere.m_Center, &rayPos);
-            csrMat4ApplyToNormal(&invertMatrix, &motionDir, &rayDir);
-            csrVec3Normalize(&rayDir, &rayDirN);
-            csrRay3FromPointDir(&rayPos, &rayDirN, &motionRay);
-
-            // 1. detect if the motion ray intersects one of the polygon. If yes the detection is terminated
-            // 2. detect if the sphere intersects one of the polygon
-
-            /*
-            CSR_Polygon3Buffer polygonBuffer;
-
-            // check for collision
-            if (csrAABBTreeResolve(&transformedRay,
-                                   &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
-                                    0,
-                                   &polygonBuffer))
-            {
-                // found at least 1 collision
-                pCollisionInfo->m_Collision = 1;
+        // draw the model. NOTE an empty matrix array draws the model once, without matrix
+        csrSceneItemDrawModel(pContext, pItem, pShader, &matrixArray);
 
-                // FIXME calculate the resulting sliding plane
-            }
+        // the lines disable their shader once drawn, thus it should be enabled again for the next item
+        if (pItem->m_Type == CSR_MT_Line)
+            pCurrentShader = 0;
+    }
 
-            // delete found polygons (no longer needed from now)
-            if (polygonBuffer.m_Count)
-                free(polygonBuffer.m_pPolygon);
-            */
-        }
+    // disable the last shader
+    if (pCurrentShader)
+        csrShaderEnable(0);
+}
+//---------------------------------------------------------------------------
+int csrSceneDrawOccluders(const CSR_Scene*   pScene,
+                          const CSR_Frustum* pFrustum,
+                          const CSR_Matrix4* pViewProjMatrix)
+{
+    size_t               i;
+    size_t               j;
+    size_t               k;
+    const CSR_SceneItem* pItem;
+    const CSR_Mesh*      pMesh;
+    const CSR_Array*     pMatrixArray;
+    CSR_Array            visibleArray;
+
+    // clear the occlusion buffer
+    if (!csrOcclusionBufferBegin(pScene->m_pOcclusion, pViewProjMatrix))
+        return 0;
 
-        // do detect the mouse collision on this model?
-        if (pSceneItem->m_CollisionType & CSR_CO_Mouse)
-        {
-            CSR_Ray3      mouseRay;
-            CSR_HitModel* pHitModel;
+    csrArrayInit(&visibleArray);
 
-            // put the mouse ray into the model coordinate system
-            csrMat4ApplyToVector(&invertMatrix, &pCollisionInput->m_MouseRay.m_Pos, &rayPos);
-            csrMat4ApplyToNormal(&invertMatrix, &pCollisionInput->m_MouseRay.m_Dir, &rayDir);
-            csrVec3Normalize(&rayDir, &rayDirN);
-            csrRay3FromPointDir(&rayPos, &rayDirN, &mouseRay);
+    // draw the opaque occluders. NOTE the transparent items never hide anything
+    for (i = 0; i < pScene->m_ItemCount; ++i)
+    {
+        pItem = &pScene->m_pItem[i];
 
-            // create a new hit model container, if required
-            if (!pCollisionOutput->m_pHitModel)
-                pCollisionOutput->m_pHitModel = csrArrayCreate();
+        // not an occluder?
+        if (!pItem->m_Occluder)
+            continue;
 
-            // create a new hit model
-            pHitModel = csrHitModelCreate();
+        // get the mesh to draw. NOTE only the first frame of an animated model is drawn, the model
+        // index callback is not called here because it may animate the model
+        switch (pItem->m_Type)
+        {
+            case CSR_MT_Mesh:
+                pMesh = (const CSR_Mesh*)pItem->m_pModel;
+                break;
 
-            // succeeded?
-            if (!pHitModel)
-                continue;
+            case CSR_MT_Model:
+                if (!pItem->m_pModel || !((const CSR_Model*)pItem->m_pModel)->m_MeshCount)
+                    continue;
 
-            // using the mouse ray, resolve aligned-axis bounding box tree
-            csrAABBTreeResolve(&mouseRay,
-                               &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex],
-                                0,
-                               &pHitModel->m_Polygons);
+                pMesh = ((const CSR_Model*)pItem->m_pModel)->m_pMesh;
+                break;
 
-            // found a collision with the mouse ray?
-            if (pHitModel->m_Polygons.m_Count)
-            {
-                // notify that a mouse collision happened
-                pCollisionOutput->m_Collision |= CSR_CO_Mouse;
+            default:
+                continue;
+        }
 
-                // populate the hit model structure
-                pHitModel->m_pModel    = pSceneItem->m_pModel;
-                pHitModel->m_Type      = pSceneItem->m_Type;
-                pHitModel->m_Matrix    = ((CSR_Matrix4*)pSceneItem->m_pMatrixArray->m_pItem->m_pData)[i];
-                pHitModel->m_pAABBTree = &pSceneItem->m_pAABBTree[pSceneItem->m_AABBTreeIndex];
+        if (!pMesh)
+            continue;
 
-                // add the hit model structure in the array
-                csrArrayAdd(pHitModel, pCollisionOutput->m_pHitModel, 0);
-            }
+        // is the occluder out of the camera view?
+        if (!csrSceneItemCull(pItem, pFrustum, 0, &visibleArray, &pMatrixArray))
+            continue;
+
+        // draw each mesh vertex buffer, once per visible instance
+        for (j = 0; j < pMesh->m_Count; ++j)
+            if (!pMatrixArray || !pMatrixArray->m_Count)
+                csrOcclusionBufferDraw(pScene->m_pOcclusion, 0, &pMesh->m_pVB[j]);
             else
-            {
-                // no found collision, release the hit model
-                csrHitModelRelease(pHitModel);
-            }
-        }
+                for (k = 0; k < pMatrixArray->m_Count; ++k)
+                    csrOcclusionBufferDraw(pScene->m_pOcclusion,
+                                           (const CSR_Matrix4*)pMatrixArray->m_pItem[k].m_pData,
+                                           &pMesh->m_pVB[j]);
     }
+
+    // build the hierarchical depth levels
+    csrOcclusionBufferEnd(pScene->m_pOcclusion);
+
+    return 1;
 }
 //---------------------------------------------------------------------------
 // Scene functions
@@ -676,6 +1760,16 @@ CSR_Scene* csrSceneCreate(void)
     // initialize the scene content
     csrSceneInit(pScene);
 
+    // create the queue in which the visible items will be sorted before being drawn
+    pScene->m_pDrawQueue = csrSceneDrawQueueCreate();
+
+    // succeeded?
+    if (!pScene->m_pDrawQueue)
+    {
+        free(pScene);
+        return 0;
+    }
+
     return pScene;
 }
 //---------------------------------------------------------------------------
@@ -713,6 +1807,16 @@ void csrSceneRelease(CSR_Scene* pScene, const CSR_fOnDeleteTexture fOnDeleteText
         free(pScene->m_pTransparentItem);
     }
 
+    // free the broadphases
+    csrAABBDynamicTreeRelease(pScene->m_pBroadphase,            0);
+    csrAABBDynamicTreeRelease(pScene->m_pTransparentBroadphase, 0);
+
+    // free the occlusion buffer
+    csrOcclusionBufferRelease(pScene->m_pOcclusion);
+
+    // free the draw queue
+    csrSceneDrawQueueRelease(pScene->m_pDrawQueue);
+
     // free the scene
     free(pScene);
 }
@@ -724,18 +1828,22 @@ void csrSceneInit(CSR_Scene* pScene)
         return;
 
     // initialize the scene
-    pScene->m_Color.m_R            =  0.0f;
-    pScene->m_Color.m_G            =  0.0f;
-    pScene->m_Color.m_B            =  0.0f;
-    pScene->m_Color.m_A            =  1.0f;
-    pScene->m_GroundDir.m_X        =  0.0f;
-    pScene->m_GroundDir.m_Y        = -1.0f;
-    pScene->m_GroundDir.m_Z        =  0.0f;
-    pScene->m_pSkybox              =  0;
-    pScene->m_pItem                =  0;
-    pScene->m_ItemCount            =  0;
-    pScene->m_pTransparentItem     =  0;
-    pScene->m_TransparentItemCount =  0;
+    pScene->m_Color.m_R              =  0.0f;
+    pScene->m_Color.m_G              =  0.0f;
+    pScene->m_Color.m_B              =  0.0f;
+    pScene->m_Color.m_A              =  1.0f;
+    pScene->m_GroundDir.m_X          =  0.0f;
+    pScene->m_GroundDir.m_Y          = -1.0f;
+    pScene->m_GroundDir.m_Z          =  0.0f;
+    pScene->m_pSkybox                =  0;
+    pScene->m_pItem                  =  0;
+    pScene->m_ItemCount              =  0;
+    pScene->m_pTransparentItem       =  0;
+    pScene->m_TransparentItemCount   =  0;
+    pScene->m_pBroadphase            =  0;
+    pScene->m_pTransparentBroadphase =  0;
+    pScene->m_pOcclusion             =  0;
+    pScene->m_pDrawQueue             =  0;
 
     // set the default item matrix to identity
     csrMat4Identity(&pScene->m_ViewMatrix);
@@ -1093,13 +2201,63 @@ CSR_SceneItem* csrSceneAddMDL(CSR_Scene* pScene, CSR_MDL* pMDL, int transparent,
     pItem[index].m_pModel = pMDL;
     pItem[index].m_Type   = CSR_MT_MDL;
 
-    // generate the aligned-axis bounding box tree for this model
+    // generate a single aligned-axis bounding box tree for all the model frames?
+    if (aabb == CSR_MA_Refit || aabb == CSR_MA_Union)
+    {
+        size_t          i;
+        size_t          j;
+        const CSR_Mesh* pFirstMesh = csrMDLGetMesh(pMDL, 0, 0);
+        int             success    = 0;
+
+        // the tree topology is built once, from the first frame
+        if (pFirstMesh)
+            pItem[index].m_pAABBTree = csrAABBTreeFromMesh(pFirstMesh);
+
+        // succeeded?
+        if (pItem[index].m_pAABBTree)
+        {
+            success = 1;
+
+            // extend the tree to surround all the frames, or keep it refittable
+            if (aabb == CSR_MA_Union)
+            {
+                for (i = 0; i < pMDL->m_ModelCount && success; ++i)
+                    for (j = 0; j < pMDL->m_pModel[i].m_MeshCount && success; ++j)
+                        success = csrAABBTreeRefit(pItem[index].m_pAABBTree,
+                                                   pFirstMesh,
+                                                  &pMDL->m_pModel[i].m_pMesh[j],
+                                                   1);
+            }
+            else
+                pItem[index].m_pAABBTreeMesh = pFirstMesh;
+        }
+
+        if (!success)
+        {
+            csrAABBTreeNodeRelease(pItem[index].m_pAABBTree);
+
+            // realloc to the previous size, thus the latest added item will be freed
+            if (transparent)
+                pScene->m_pTransparentItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                            sizeof(CSR_SceneItem),
+                                                                            pScene->m_TransparentItemCount);
+            else
+                pScene->m_pItem = (CSR_SceneItem*)csrMemoryAlloc(pItem,
+                                                                 sizeof(CSR_SceneItem),
+                                                                 pScene->m_ItemCount);
+
+            return 0;
+        }
+
+        pItem[index].m_AABBTreeCount = 1;
+    }
+    else
     if (aabb)
     {
         size_t i;
         size_t j;
 
-        // reserve memory for all the AABB trees to create
+        // reserve memory for the AABB trees to create, one for each model frame
         pItem[index].m_AABBTreeCount = pMDL->m_ModelCount * pMDL->m_pModel->m_MeshCount;
         pItem[index].m_pAABBTree     = (CSR_AABBNode*)csrMemoryAlloc(0,
                                                                      sizeof(CSR_AABBNode),
@@ -1146,7 +2304,9 @@ CSR_SceneItem* csrSceneAddMDL(CSR_Scene* pScene, CSR_MDL* pMDL, int transparent,
                 }
 
                 // copy the tree content
-                memcpy(&pItem[index].m_pAABBTree[i], pAABBTree, sizeof(CSR_AABBNode));
+                memcpy(&pItem[index].m_pAABBTree[(i * pMDL->m_pModel->m_MeshCount) + j],
+                        pAABBTree,
+                        sizeof(CSR_AABBNode));
 
                 // release the source tree (NOTE reset its value before, otherwise the copied tree
                 // content will also be released, which will corrupt the tree)
@@ -1446,7 +2606,13 @@ CSR_SceneItem* csrSceneAddCollada(CSR_Scene* pScene, CSR_Collada* pCollada, int
 //---------------------------------------------------------------------------
 CSR_SceneItem* csrSceneAddModelMatrix(CSR_Scene* pScene, const void* pModel, CSR_Matrix4* pMatrix)
 {
-    CSR_SceneItem* pSceneItem;
+    size_t               item;
+    size_t               count;
+    size_t               capacity;
+    CSR_SceneItem*       pSceneItem;
+    CSR_SceneInstance*   pInstance;
+    CSR_ArrayItem*       pVisible;
+    CSR_AABBDynamicTree* pBroadphase;
 
     // validate inputs
     if (!pScene || !pModel || !pMatrix)
@@ -1471,18 +2637,69 @@ CSR_SceneItem* csrSceneAddModelMatrix(CSR_Scene* pScene, const void* pModel, CSR
 
         // initialize the array content
         csrArrayInit(pSceneItem->m_pMatrixArray);
+
+        // index the matrices, thus they may be found quickly even if thousands of them are added.
+        // If the index cannot be created, the matrices will be searched linearly
+        csrArrayEnableIndex(pSceneItem->m_pMatrixArray);
     }
 
+    count    = pSceneItem->m_pMatrixArray->m_Count;
+    capacity = pSceneItem->m_pMatrixArray->m_Capacity;
+
     // add the matrix to the array
     csrArrayAddUnique(pMatrix, pSceneItem->m_pMatrixArray, 0);
 
+    // matrix already exists, or wasn't added?
+    if (pSceneItem->m_pMatrixArray->m_Count == count)
+        return pSceneItem;
+
+    // keep the instance data as large as the matrix array
+    if (!pSceneItem->m_pInstance || pSceneItem->m_pMatrixArray->m_Capacity != capacity)
+    {
+        pInstance = (CSR_SceneInstance*)csrMemoryAlloc(pSceneItem->m_pInstance,
+                                                       sizeof(CSR_SceneInstance),
+                                                       pSceneItem->m_pMatrixArray->m_Capacity);
+
+        // succeeded?
+        if (!pInstance)
+        {
+            // remove the matrix, otherwise the matrices and their instance data will mismatch
+            csrArrayDeleteAt(count, pSceneItem->m_pMatrixArray);
+            return 0;
+        }
+
+        pSceneItem->m_pInstance = pInstance;
+    }
+
+    // keep the visible matrix buffer as large as the matrix array (NOTE on failure the item
+    // instances will just no longer be culled individually)
+    if (!pSceneItem->m_pVisible || pSceneItem->m_pMatrixArray->m_Capacity != capacity)
+    {
+        pVisible = (CSR_ArrayItem*)csrMemoryAlloc(pSceneItem->m_pVisible,
+                                                  sizeof(CSR_ArrayItem),
+                                                  pSceneItem->m_pMatrixArray->m_Capacity);
+
+        // succeeded?
+        if (!pVisible)
+            free(pSceneItem->m_pVisible);
+
+        pSceneItem->m_pVisible = pVisible;
+    }
+
+    // initialize the instance
+    memset(&pSceneItem->m_pInstance[count], 0, sizeof(CSR_SceneInstance));
+    pSceneItem->m_pInstance[count].m_Proxy = (size_t)M_CSR_Unknown_Index;
+
+    // calculate the instance matrices and bounding box, and add it to the broadphase if enabled
+    pBroadphase = csrSceneGetBroadphase(pScene, pSceneItem, &item);
+    csrSceneItemUpdateInstance(pSceneItem, item, count, pBroadphase);
+
     return pSceneItem;
 }
 //---------------------------------------------------------------------------
 CSR_SceneItem* csrSceneGetItem(const CSR_Scene* pScene, const void* pKey)
 {
     size_t i;
-    size_t j;
 
     // validate inputs
     if (!pScene || !pKey)
@@ -1496,10 +2713,8 @@ CSR_SceneItem* csrSceneGetItem(const CSR_Scene* pScene, const void* pKey)
             return &pScene->m_pItem[i];
 
         // check also if the key is a known matrix
-        if (pScene->m_pItem[i].m_pMatrixArray)
-            for (j = 0; j < pScene->m_pItem[i].m_pMatrixArray->m_Count; ++j)
-                if (&pScene->m_pItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
-                    return &pScene->m_pItem[i];
+        if (csrArrayGetIndex((void*)pKey, pScene->m_pItem[i].m_pMatrixArray) != (size_t)M_CSR_Unknown_Index)
+            return &pScene->m_pItem[i];
     }
 
     // then search in the transparent models
@@ -1510,10 +2725,8 @@ CSR_SceneItem* csrSceneGetItem(const CSR_Scene* pScene, const void* pKey)
             return &pScene->m_pTransparentItem[i];
 
         // check also if the key is a known matrix
-        if (pScene->m_pTransparentItem[i].m_pMatrixArray)
-            for (j = 0; j < pScene->m_pTransparentItem[i].m_pMatrixArray->m_Count; ++j)
-                if (&pScene->m_pTransparentItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
-                    return &pScene->m_pTransparentItem[i];
+        if (csrArrayGetIndex((void*)pKey, pScene->m_pTransparentItem[i].m_pMatrixArray) != (size_t)M_CSR_Unknown_Index)
+            return &pScene->m_pTransparentItem[i];
     }
 
     // not found
@@ -1538,6 +2751,9 @@ void csrSceneDeleteFrom(      CSR_Scene*           pScene,
         // found a matching model?
         if (pScene->m_pItem[i].m_pModel == pKey)
         {
+            // remove the item instances from the broadphase
+            csrSceneRemoveItemBroadphase(&pScene->m_pItem[i], pScene->m_pBroadphase);
+
             // delete the item from the list
             pSceneItem = csrSceneItemDeleteModelFrom(pScene->m_pItem,
                                                      i,
@@ -1549,18 +2765,21 @@ void csrSceneDeleteFrom(      CSR_Scene*           pScene,
             pScene->m_pItem = pSceneItem;
             --pScene->m_ItemCount;
 
+            // the next items moved in the list
+            csrSceneReindexItemsBroadphase(pScene->m_pItem, i, pScene->m_ItemCount, pScene->m_pBroadphase);
+
             return;
         }
 
         // check also if the key is a known matrix
-        if (pScene->m_pItem[i].m_pMatrixArray)
-            for (j = 0; j < pScene->m_pItem[i].m_pMatrixArray->m_Count; ++j)
-                if (pScene->m_pItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
-                {
-                    // delete the matrix
-                    csrArrayDeleteAt(j, pScene->m_pItem[i].m_pMatrixArray);
-                    return;
-                }
+        j = csrArrayGetIndex((void*)pKey, pScene->m_pItem[i].m_pMatrixArray);
+
+        if (j != (size_t)M_CSR_Unknown_Index)
+        {
+            // delete the matrix
+            csrSceneItemDeleteInstance(&pScene->m_pItem[i], j, pScene->m_pBroadphase);
+            return;
+        }
     }
 
     // then search in the transparent models
@@ -1569,6 +2788,9 @@ void csrSceneDeleteFrom(      CSR_Scene*           pScene,
         // found a matching model?
         if (pScene->m_pTransparentItem[i].m_pModel == pKey)
         {
+            // remove the item instances from the broadphase
+            csrSceneRemoveItemBroadphase(&pScene->m_pTransparentItem[i], pScene->m_pTransparentBroadphase);
+
             // delete the item from the list
             pSceneItem = csrSceneItemDeleteModelFrom(pScene->m_pTransparentItem,
                                                      i,
@@ -1580,24 +2802,158 @@ void csrSceneDeleteFrom(      CSR_Scene*           pScene,
             pScene->m_pTransparentItem = pSceneItem;
             --pScene->m_TransparentItemCount;
 
+            // the next items moved in the list
+            csrSceneReindexItemsBroadphase(pScene->m_pTransparentItem, i, pScene->m_TransparentItemCount, pScene->m_pTransparentBroadphase);
+
             return;
         }
 
         // check also if the key is a known matrix
-        if (pScene->m_pTransparentItem[i].m_pMatrixArray)
-            for (j = 0; j < pScene->m_pTransparentItem[i].m_pMatrixArray->m_Count; ++j)
-                if (pScene->m_pTransparentItem[i].m_pMatrixArray->m_pItem[j].m_pData == pKey)
-                {
-                    // delete the matrix
-                    csrArrayDeleteAt(j, pScene->m_pItem[i].m_pMatrixArray);
-                    return;
-                }
+        j = csrArrayGetIndex((void*)pKey, pScene->m_pTransparentItem[i].m_pMatrixArray);
+
+        if (j != (size_t)M_CSR_Unknown_Index)
+        {
+            // delete the matrix
+            csrSceneItemDeleteInstance(&pScene->m_pTransparentItem[i], j, pScene->m_pTransparentBroadphase);
+            return;
+        }
+    }
+}
+//---------------------------------------------------------------------------
+int csrSceneEnableBroadphase(CSR_Scene* pScene, int enable)
+{
+    // validate the input
+    if (!pScene)
+        return 0;
+
+    // do disable the broadphase?
+    if (!enable)
+    {
+        // release the broadphases
+        csrAABBDynamicTreeRelease(pScene->m_pBroadphase,            0);
+        csrAABBDynamicTreeRelease(pScene->m_pTransparentBroadphase, 0);
+        pScene->m_pBroadphase            = 0;
+        pScene->m_pTransparentBroadphase = 0;
+
+        // unlink the instances
+        csrSceneResetItemsBroadphase(pScene->m_pItem,            pScene->m_ItemCount);
+        csrSceneResetItemsBroadphase(pScene->m_pTransparentItem, pScene->m_TransparentItemCount);
+
+        return 1;
+    }
+
+    // broadphase already enabled?
+    if (pScene->m_pBroadphase)
+        return 1;
+
+    // create the broadphases
+    pScene->m_pBroadphase            = csrAABBDynamicTreeCreate();
+    pScene->m_pTransparentBroadphase = csrAABBDynamicTreeCreate();
+
+    // succeeded?
+    if (!pScene->m_pBroadphase || !pScene->m_pTransparentBroadphase)
+    {
+        csrSceneEnableBroadphase(pScene, 0);
+        return 0;
+    }
+
+    // fatten the instance boxes, thus the slightly moving instances don't need to be reinserted
+    pScene->m_pBroadphase->m_Margin            = M_CSR_Scene_Broadphase_Margin;
+    pScene->m_pTransparentBroadphase->m_Margin = M_CSR_Scene_Broadphase_Margin;
+
+    // add all the existing instances
+    if (!csrSceneUpdateBroadphase(pScene))
+    {
+        csrSceneEnableBroadphase(pScene, 0);
+        return 0;
     }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrSceneUpdateBroadphase(CSR_Scene* pScene)
+{
+    int success;
+
+    // validate the input
+    if (!pScene || !pScene->m_pBroadphase || !pScene->m_pTransparentBroadphase)
+        return 0;
+
+    // update the standard and transparent instances
+    success  = csrSceneUpdateItemsBroadphase(pScene->m_pItem,
+                                             pScene->m_ItemCount,
+                                             pScene->m_pBroadphase);
+    success &= csrSceneUpdateItemsBroadphase(pScene->m_pTransparentItem,
+                                             pScene->m_TransparentItemCount,
+                                             pScene->m_pTransparentBroadphase);
+
+    return success;
+}
+//---------------------------------------------------------------------------
+int csrSceneEnableOcclusion(CSR_Scene* pScene, size_t width, size_t height)
+{
+    // validate the input
+    if (!pScene)
+        return 0;
+
+    // release the previous occlusion buffer, if any
+    csrOcclusionBufferRelease(pScene->m_pOcclusion);
+    pScene->m_pOcclusion = 0;
+
+    // do disable the occlusion culling?
+    if (!width || !height)
+        return 1;
+
+    // create the occlusion buffer
+    pScene->m_pOcclusion = csrOcclusionBufferCreate(width, height);
+
+    return (pScene->m_pOcclusion != 0);
+}
+//---------------------------------------------------------------------------
+int csrSceneMatrixChanged(CSR_Scene* pScene, const CSR_Matrix4* pMatrix)
+{
+    size_t               item;
+    size_t               index;
+    CSR_SceneItem*       pSceneItem;
+    CSR_AABBDynamicTree* pBroadphase;
+
+    // validate the inputs
+    if (!pScene || !pMatrix)
+        return 0;
+
+    // get the scene item owning the matrix
+    pSceneItem = csrSceneGetItem(pScene, pMatrix);
+
+    // found it?
+    if (!pSceneItem || !pSceneItem->m_pInstance)
+        return 0;
+
+    // get the matrix index
+    index = csrArrayGetIndex((void*)pMatrix, pSceneItem->m_pMatrixArray);
+
+    // found it?
+    if (index == (size_t)M_CSR_Unknown_Index)
+        return 0;
+
+    // update the instance
+    pBroadphase = csrSceneGetBroadphase(pScene, pSceneItem, &item);
+
+    return csrSceneItemUpdateInstance(pSceneItem, item, index, pBroadphase);
 }
 //---------------------------------------------------------------------------
 void csrSceneDraw(const CSR_Scene* pScene, const CSR_SceneContext* pContext)
 {
-    size_t i;
+    size_t               i;
+    size_t               packetCount;
+    size_t               transparentCount;
+    float                determinant;
+    CSR_Matrix4          viewProjMatrix;
+    CSR_Matrix4          invViewMatrix;
+    CSR_Frustum          frustum;
+    CSR_Vector3          camera;
+    CSR_SceneDrawPacket* pPacket;
+    CSR_ArrayItem*       pMatrices;
+    CSR_OcclusionBuffer* pOcclusion;
 
     // no scene to draw?
     if (!pScene)
@@ -1658,25 +3014,101 @@ void csrSceneDraw(const CSR_Scene* pScene, const CSR_SceneContext* pContext)
         }
     }
 
+    // get the camera frustum in the scene coordinates system, to cull the models out of view
+    csrMat4Multiply(&pScene->m_ViewMatrix, &pScene->m_ProjectionMatrix, &viewProjMatrix);
+    csrFrustumFromMatrix(&viewProjMatrix, &frustum);
+
+    // draw the occluders, to cull the models they hide
+    if (pScene->m_pOcclusion && csrSceneDrawOccluders(pScene, &frustum, &viewProjMatrix))
+        pOcclusion = pScene->m_pOcclusion;
+    else
+        pOcclusion = 0;
+
+    // get the camera position, from which the transparent models will be sorted
+    csrMat4Inverse(&pScene->m_ViewMatrix, &invViewMatrix, &determinant);
+    camera.m_X = invViewMatrix.m_Table[3][0];
+    camera.m_Y = invViewMatrix.m_Table[3][1];
+    camera.m_Z = invViewMatrix.m_Table[3][2];
+
+    // count the transparent instances, which are queued one by one
+    transparentCount = 0;
+
+    for (i = 0; i < pScene->m_TransparentItemCount; ++i)
+        if (pScene->m_pTransparentItem[i].m_pMatrixArray &&
+            pScene->m_pTransparentItem[i].m_pMatrixArray->m_Count)
+            transparentCount += pScene->m_pTransparentItem[i].m_pMatrixArray->m_Count;
+        else
+            ++transparentCount;
+
+    // get the render queue, growing it if the scene became larger since the previous frame
+    if (csrSceneDrawQueueReserve(pScene->m_ItemCount + transparentCount,
+                                 transparentCount,
+                                 pScene->m_pDrawQueue))
+    {
+        pPacket   = pScene->m_pDrawQueue->m_pPacket;
+        pMatrices = pScene->m_pDrawQueue->m_Matrices.m_pItem;
+    }
+    else
+    {
+        pPacket   = 0;
+        pMatrices = 0;
+    }
+
     // prepare the scene to draw common models
     if (pContext->m_fOnPrepareDraw)
         pContext->m_fOnPrepareDraw(pScene, pContext);
 
     // first draw the standard models
-    for (i = 0; i < pScene->m_ItemCount; ++i)
-        csrSceneItemDraw(pScene,
-                         pContext,
-                        &pScene->m_pItem[i]);
+    if (pPacket && pMatrices)
+    {
+        // queue the visible models, and sort them to minimize the shader changes
+        packetCount = csrSceneQueueItems(pScene->m_pItem,
+                                         pScene->m_ItemCount,
+                                        &frustum,
+                                         pOcclusion,
+                                         0,
+                                         pPacket);
+        qsort(pPacket, packetCount, sizeof(CSR_SceneDrawPacket), csrSceneComparePackets);
+
+        // draw them
+        csrSceneDrawPackets(pScene, pContext, pPacket, packetCount, 0);
+    }
+    else
+        // not enough memory to queue the models, draw them in the scene order
+        for (i = 0; i < pScene->m_ItemCount; ++i)
+            csrSceneItemDrawVisible(pScene,
+                                    pContext,
+                                   &pScene->m_pItem[i],
+                                   &frustum,
+                                    pOcclusion);
 
     // prepare the scene to draw transparent models
     if (pContext->m_fOnPrepareTransparentDraw)
         pContext->m_fOnPrepareTransparentDraw(pScene, pContext);
 
     // then draw the transparent models
-    for (i = 0; i < pScene->m_TransparentItemCount; ++i)
-        csrSceneItemDraw(pScene,
-                         pContext,
-                        &pScene->m_pTransparentItem[i]);
+    if (pPacket && pMatrices)
+    {
+        // queue the visible instances, and sort them from back to front
+        packetCount = csrSceneQueueItems(pScene->m_pTransparentItem,
+                                         pScene->m_TransparentItemCount,
+                                        &frustum,
+                                         pOcclusion,
+                                        &camera,
+                                         pPacket);
+        qsort(pPacket, packetCount, sizeof(CSR_SceneDrawPacket), csrSceneCompareTransparentPackets);
+
+        // draw them, the consecutive instances of the same model together
+        csrSceneDrawPackets(pScene, pContext, pPacket, packetCount, pMatrices);
+    }
+    else
+        // not enough memory to queue the models, draw them in the scene order
+        for (i = 0; i < pScene->m_TransparentItemCount; ++i)
+            csrSceneItemDrawVisible(pScene,
+                                    pContext,
+                                   &pScene->m_pTransparentItem[i],
+                                   &frustum,
+                                    pOcclusion);
 
     // end the scene drawing
     if (pContext->m_fOnSceneEnd)
@@ -1856,8 +3288,6 @@ void csrSceneDetectCollision(const CSR_Scene*                   pScene,
                                    CSR_CollisionOutput*         pCollisionOutput,
                                    CSR_fOnCustomDetectCollision fOnCustomDetectCollision)
 {
-    size_t i;
-
     // validate the inputs
     if (!pScene || !pCollisionInput || !pCollisionOutput)
         return;
@@ -1865,21 +3295,23 @@ void csrSceneDetectCollision(const CSR_Scene*                   pScene,
     // initialize the collision output
     csrCollisionOutputInit(pCollisionOutput);
 
-    // iterate through the scene items
-    for (i = 0; i < pScene->m_ItemCount; ++i)
-        csrSceneItemDetectCollision(pScene,
-                                   &pScene->m_pItem[i],
-                                    pCollisionInput,
-                                    pCollisionOutput,
-                                    fOnCustomDetectCollision);
-
-    // iterate through the scene transparent items
-    for (i = 0; i < pScene->m_TransparentItemCount; ++i)
-        csrSceneItemDetectCollision(pScene,
-                                   &pScene->m_pTransparentItem[i],
-                                    pCollisionInput,
-                                    pCollisionOutput,
-                                    fOnCustomDetectCollision);
+    // detect the collisions on the scene items
+    csrSceneDetectItemsCollision(pScene,
+                                 pScene->m_pItem,
+                                 pScene->m_ItemCount,
+                                 pScene->m_pBroadphase,
+                                 pCollisionInput,
+                                 pCollisionOutput,
+                                 fOnCustomDetectCollision);
+
+    // detect the collisions on the scene transparent items
+    csrSceneDetectItemsCollision(pScene,
+                                 pScene->m_pTransparentItem,
+                                 pScene->m_TransparentItemCount,
+                                 pScene->m_pTransparentBroadphase,
+                                 pCollisionInput,
+                                 pCollisionOutput,
+                                 fOnCustomDetectCollision);
 }
 //---------------------------------------------------------------------------
 void csrSceneTouchPosToViewportPos(const CSR_Vector2* pTouchPos,
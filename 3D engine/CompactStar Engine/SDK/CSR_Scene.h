@@ -22,6 +22,7 @@
 #include "CSR_Collision.h"
 #include "CSR_Model.h"
 #include "CSR_Renderer.h"
+#include "CSR_SoftwareRaster.h"
 
 // visual studio specific code
 #ifdef _MSC_VER
@@ -67,6 +68,17 @@ typedef enum
     CSR_CO_Custom = 0x8
 } CSR_ECollisionType;
 
+/**
+* MDL model aligned-axis bounding box tree mode
+*/
+typedef enum
+{
+    CSR_MA_None     = 0, // no tree is generated
+    CSR_MA_PerFrame = 1, // a tree is generated for each frame mesh
+    CSR_MA_Refit    = 2, // a single tree is generated, and refit to the current frame mesh
+    CSR_MA_Union    = 3  // a single tree surrounding all the frames is generated
+} CSR_EMDLAABBTreeMode;
+
 /**
 * Matrix combination type
 */
@@ -91,6 +103,18 @@ typedef struct CSR_SceneContext CSR_SceneContext;
 // Structures
 //---------------------------------------------------------------------------
 
+/**
+* Scene item instance, i.e. the data linked to each model matrix of a scene item
+*/
+typedef struct
+{
+    CSR_Box     m_Box;          // instance bounding box, in the scene coordinates system
+    size_t      m_Proxy;        // instance leaf in the scene broadphase, M_CSR_Unknown_Index if none
+    CSR_Matrix4 m_Matrix;       // model matrix value from which the cached matrices were calculated
+    CSR_Matrix4 m_InvMatrix;    // cached inverse of the model matrix
+    CSR_Matrix4 m_NormalMatrix; // cached transposed inverse of the model matrix, to transform the planes
+} CSR_SceneInstance;
+
 /**
 * Scene item
 */
@@ -100,25 +124,57 @@ typedef struct
     CSR_EModelType     m_Type;          // model type (a simple mesh, a model or a complex MDL model)
     CSR_ECollisionType m_CollisionType; // collision type to apply to model
     CSR_Array*         m_pMatrixArray;  // matrices sharing the same model, e.g. all the walls of a room
+    CSR_SceneInstance* m_pInstance;     // instance data, in the same order as the matrices
+    CSR_ArrayItem*     m_pVisible;      // matrices found visible while the item is drawn, as large as the matrix array
+    void*              m_pShader;       // shader the item was drawn with the last time, to group the items by shader
     CSR_AABBNode*      m_pAABBTree;     // aligned-axis bounding box trees owned by the model
     size_t             m_AABBTreeCount; // aligned-axis bounding box tree count
     size_t             m_AABBTreeIndex; // aligned-axis bounding box tree index to use for the collision detection
+    const CSR_Mesh*    m_pAABBTreeMesh; // mesh the refittable tree currently surrounds, 0 if the tree isn't refittable
+    int                m_Occluder;      // if 1, the item hides the items behind it, see csrSceneEnableOcclusion()
 } CSR_SceneItem;
 
+/**
+* Scene draw packet, i.e. a scene item, or a part of its instances, to draw
+*/
+typedef struct
+{
+    CSR_SceneItem* m_pItem;
+    CSR_ArrayItem* m_pMatrix;      // first matrix to draw, 0 if the model has no matrix
+    size_t         m_MatrixCount;
+    float          m_Depth;        // squared distance from the camera, only for the transparent packets
+    size_t         m_Order;        // position in the scene, to keep the drawing order stable
+} CSR_SceneDrawPacket;
+
+/**
+* Scene draw queue, i.e. the buffers in which the visible items are queued while the scene is drawn
+*@note The buffers are kept from a frame to the next, and only grow when the scene does
+*/
+typedef struct
+{
+    CSR_SceneDrawPacket* m_pPacket;
+    size_t               m_PacketCapacity;
+    CSR_Array            m_Matrices;       // consecutive transparent instances merged to be drawn together
+} CSR_SceneDrawQueue;
+
 /**
 * Scene
 */
 typedef struct
 {
-    CSR_Color        m_Color;                // the scene background color
-    CSR_Matrix4      m_ProjectionMatrix;     // the scene projection matrix
-    CSR_Matrix4      m_ViewMatrix;           // the scene view matrix
-    CSR_Vector3      m_GroundDir;            // the ground direction in the whole scene
-    CSR_Mesh*        m_pSkybox;              // skybox geometry (because there is only one skybox per scene)
-    CSR_SceneItem*   m_pItem;                // the items in this list will be drawn in the scene
-    size_t           m_ItemCount;            // number of items
-    CSR_SceneItem*   m_pTransparentItem;     // the items in this list will be drawn on the scene end, allowing transparency
-    size_t           m_TransparentItemCount; // number of transparent items
+    CSR_Color            m_Color;                  // the scene background color
+    CSR_Matrix4          m_ProjectionMatrix;       // the scene projection matrix
+    CSR_Matrix4          m_ViewMatrix;             // the scene view matrix
+    CSR_Vector3          m_GroundDir;              // the ground direction in the whole scene
+    CSR_Mesh*            m_pSkybox;                // skybox geometry (because there is only one skybox per scene)
+    CSR_SceneItem*       m_pItem;                  // the items in this list will be drawn in the scene
+    size_t               m_ItemCount;              // number of items
+    CSR_SceneItem*       m_pTransparentItem;       // the items in this list will be drawn on the scene end, allowing transparency
+    size_t               m_TransparentItemCount;   // number of transparent items
+    CSR_AABBDynamicTree* m_pBroadphase;            // broadphase over the item instances, 0 if disabled
+    CSR_AABBDynamicTree* m_pTransparentBroadphase; // broadphase over the transparent item instances, 0 if disabled
+    CSR_OcclusionBuffer* m_pOcclusion;             // buffer in which the occluders are drawn to cull the hidden items, 0 if disabled
+    CSR_SceneDrawQueue*  m_pDrawQueue;             // queue in which the visible items are sorted before being drawn
 } CSR_Scene;
 
 /**
@@ -153,7 +209,8 @@ typedef struct
     CSR_EModelType     m_Type;      // model type (a simple mesh, a model or a complex MDL model)
     CSR_Matrix4        m_Matrix;    // model matrix
     CSR_AABBNode*      m_pAABBTree; // aligned-axis bounding box tree in which the collision was found
-    CSR_Polygon3Buffer m_Polygons;  // hit polygons in the model
+    CSR_AABBTreeHit    m_Hit;       // nearest hit, in the model coordinates system
+    CSR_Polygon3Buffer m_Polygons;  // nearest hit polygon in the model
 } CSR_HitModel;
 
 /**
@@ -177,6 +234,7 @@ typedef struct
     CSR_ECollisionType m_Collision;      // found collision type in the scene
     float              m_GroundPos;      // the ground position on the y axis, M_CSR_NoGround if no ground was found
     CSR_Plane          m_CollisionPlane; // the collision plane, in case a collision was found
+    float              m_CollisionTime;  // bounding sphere motion part done before the collision, between 0 and 1
     CSR_Plane          m_GroundPlane;    // the ground plane, in case a ground was found
     CSR_Array*         m_pHitModel;      // models hit by the mouse ray
 } CSR_CollisionOutput;
@@ -407,11 +465,35 @@ struct CSR_SceneContext
         */
         void csrSceneItemInit(CSR_SceneItem* pSI);
 
+        /**
+        * Refits a scene item refittable AABB tree to a mesh
+        *@param[in, out] pSI - scene item containing the tree to refit
+        *@param pMesh - mesh to refit to, e.g. the current MDL frame mesh, see csrMDLGetMesh()
+        *@return 1 on success, otherwise 0
+        *@note Nothing is done if the tree already surrounds the mesh
+        */
+        int csrSceneItemRefitAABBTree(CSR_SceneItem* pSI, const CSR_Mesh* pMesh);
+
+        /**
+        * Adds an existing AABB tree to a scene item, e.g. a tree loaded from a cache file instead
+        * of being rebuilt, see csrAABBTreeLoad()
+        *@param[in, out] pSI - scene item to add to
+        *@param pAABBTree - AABB tree to add, the scene item takes its ownership on success
+        *@return 1 on success, otherwise 0
+        *@note The trees are used in the order they are added, see m_AABBTreeIndex. The item should
+        *      be added to the scene without generating its own trees, e.g. csrSceneAddModel() with
+        *      aabb set to 0
+        *@note On success the pAABBTree pointer is released and should no longer be used
+        */
+        int csrSceneItemAddAABBTree(CSR_SceneItem* pSI, CSR_AABBNode* pAABBTree);
+
         /**
         * Draws a scene item
         *@param pScene - scene at which the item belongs
         *@param pContext - scene context
         *@param pItem - scene item to draw
+        *@note The item instances out of the camera view are not drawn. Only the items owning
+        *      aligned-axis bounding box trees can be culled, the other ones are always drawn
         */
         void csrSceneItemDraw(const CSR_Scene*        pScene,
                               const CSR_SceneContext* pContext,
@@ -452,6 +534,8 @@ struct CSR_SceneContext
         /**
         * Initializes a scene structure
         *@param[in, out] pScene - scene to initialize
+        *@note The draw queue isn't created, a scene initialized this way is drawn in the item
+        *      order, without sorting them, see csrSceneCreate()
         */
         void csrSceneInit(CSR_Scene* pScene);
 
@@ -495,10 +579,15 @@ struct CSR_SceneContext
         *@param pScene - scene in which the model will be added
         *@param pMDL - model to add
         *@param transparent - if 1, the model is transparent, if 0 the model is opaque
-        *@param aabb - if 1, the AABB tree will be generated for the mesh
+        *@param aabb - AABB tree mode to apply, see CSR_EMDLAABBTreeMode. If 1, an AABB tree will be
+        *              generated for each mesh
         *@return the scene item containing the model on success, otherwise 0
         *@note Once successfully added, the MDL model will be owned by the scene and should no
         *      longer be released from outside
+        *@note In CSR_MA_Refit mode, the tree should be refit to the current frame with
+        *      csrSceneItemRefitAABBTree(), e.g. after csrMDLUpdateIndex() was called. In
+        *      CSR_MA_Union mode, the tree polygons belong to the first frame, so this mode is
+        *      rather intended for a cheap broad phase
         */
         CSR_SceneItem* csrSceneAddMDL(CSR_Scene* pScene, CSR_MDL* pMDL, int transparent, int aabb);
 
@@ -559,10 +648,67 @@ struct CSR_SceneContext
                                 const void*                pKey,
                                 const CSR_fOnDeleteTexture fOnDeleteTexture);
 
+        /**
+        * Enables or disables the scene broadphase. When enabled, the collision detection only
+        * checks the model instances whose bounding box is reached by the collision input, instead
+        * of all the instances of all the models
+        *@param[in, out] pScene - scene for which the broadphase should be enabled or disabled
+        *@param enable - if 1, the broadphase will be enabled, if 0 it will be disabled
+        *@return 1 on success, otherwise 0
+        *@note The model matrices are not owned by the scene, thus the scene cannot know when they
+        *      change. For that reason, when the broadphase is enabled, csrSceneMatrixChanged()
+        *      should be called each time a model matrix is modified
+        *@note The instance bounding boxes are calculated from the model AABB trees. If these trees
+        *      change, e.g. after csrSceneItemAddAABBTree() or csrSceneItemRefitAABBTree() was
+        *      called, the broadphase should be updated with csrSceneUpdateBroadphase()
+        *@note The models using the custom collision detection are always checked, whatever
+        *      their instances are reached or not
+        */
+        int csrSceneEnableBroadphase(CSR_Scene* pScene, int enable);
+
+        /**
+        * Updates the bounding box of all the model instances in the scene broadphase
+        *@param[in, out] pScene - scene for which the broadphase should be updated
+        *@return 1 on success, otherwise 0
+        */
+        int csrSceneUpdateBroadphase(CSR_Scene* pScene);
+
+        /**
+        * Enables or disables the scene occlusion culling. When enabled, the occluder items are drawn
+        * in a low resolution depth buffer before the scene, and the item instances they hide are not
+        * drawn
+        *@param[in, out] pScene - scene for which the occlusion culling should be enabled or disabled
+        *@param width - occlusion buffer width in pixels, if 0 the occlusion culling will be disabled
+        *@param height - occlusion buffer height in pixels, if 0 the occlusion culling will be disabled
+        *@return 1 on success, otherwise 0
+        *@note The occluders are the opaque items whose m_Occluder flag is set, e.g. the walls or the
+        *      landscape. Only the meshes and the models are drawn as occluders, the other types
+        *      are ignored
+        *@note As for the frustum culling, the items without AABB trees are always drawn
+        */
+        int csrSceneEnableOcclusion(CSR_Scene* pScene, size_t width, size_t height);
+
+        /**
+        * Notifies the scene that a model matrix was modified
+        *@param[in, out] pScene - scene containing the matrix
+        *@param pMatrix - modified matrix
+        *@return 1 on success, otherwise 0
+        *@note This function is required if the scene broadphase is enabled. Otherwise it's
+        *      optional, the matrices derived from the model matrix (e.g. its inverse) are cached
+        *      and recalculated when the collision detection finds that the model matrix changed,
+        *      but notifying the change allows to recalculate them before
+        */
+        int csrSceneMatrixChanged(CSR_Scene* pScene, const CSR_Matrix4* pMatrix);
+
         /**
         * Draws a scene
         *@param pScene - scene to draw
         *@param pContext - scene context
+        *@note The item instances out of the camera view are not drawn, see csrSceneItemDraw()
+        *@note If the occlusion culling is enabled, the item instances hidden by the occluders are
+        *      not drawn, see csrSceneEnableOcclusion()
+        *@note The opaque items are grouped by shader, and the transparent instances are drawn
+        *      from the farthest to the nearest
         */
         void csrSceneDraw(const CSR_Scene* pScene, const CSR_SceneContext* pContext);
 
@@ -586,6 +732,8 @@ struct CSR_SceneContext
         *@param pCollisionInput - collision input
         *@param[in, out] pCollisionOutput - collision output containing the result
         *@param fOnCustomDetectCollision - custom detection collision callback
+        *@note If the scene broadphase is enabled, only the model instances whose bounding box is
+        *      reached by the ground line, the mouse ray or the sphere motion are checked
         */
         void csrSceneDetectCollision(const CSR_Scene*                   pScene,
                                      const CSR_CollisionInput*          pCollisionInput,
@@ -21,6 +21,144 @@
 #include <math.h>
 #include <string.h>
 
+// threads drawing the raster tiles, if available on the target platform
+#if defined(_OS_IOS_) || defined(_OS_ANDROID_) || defined(_OS_WINDOWS_) || defined(CSR_RASTER_NO_THREADS)
+    // the tiles are drawn on the calling thread
+#elif defined(_WIN32)
+    #include <windows.h>
+    #define CSR_RASTER_WIN32_THREADS
+#else
+    #include <pthread.h>
+    #include <unistd.h>
+    #define CSR_RASTER_POSIX_THREADS
+#endif
+
+// vectorized pixel kernel, if available on the target platform
+#if defined(_OS_IOS_) || defined(_OS_ANDROID_) || defined(_OS_WINDOWS_) || defined(CSR_RASTER_NO_SIMD)
+    // the pixels are processed one by one
+#elif defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+    #include <emmintrin.h>
+    #define CSR_RASTER_SSE2
+#endif
+
+//---------------------------------------------------------------------------
+// Global defines
+//---------------------------------------------------------------------------
+#define M_CSR_Raster_Default_Tile_Size 64
+#define M_CSR_Raster_Vertex_Cache_Size 128
+#define M_CSR_Raster_Edge_Tolerance    1.0e-6f
+#define M_CSR_Occlusion_Far            1.0f
+#define M_CSR_Occlusion_Max_Test_Size  4
+//---------------------------------------------------------------------------
+// Raster private structures
+//---------------------------------------------------------------------------
+
+/**
+* Tile worker, i.e. a thread drawing a part of the raster tiles
+*/
+typedef struct
+{
+    CSR_RasterTiles* m_pTiles;
+    size_t           m_First;   // first tile to draw
+    size_t           m_Step;    // step to the next tile to draw, i.e. the worker count
+    int              m_Success;
+} CSR_RasterWorker;
+
+/**
+* Raster polygon edge, prepared to be evaluated on a pixel row
+*/
+typedef struct
+{
+    float m_X;      // edge start x position
+    float m_Y;      // edge start y position
+    float m_DeltaX; // edge end x position - edge start x position
+    float m_DeltaY; // edge end y position - edge start y position
+    float m_Row;    // row term, i.e. (pixel y position - edge start y position) * delta x
+} CSR_RasterEdge;
+
+/**
+* Raster vertex, i.e. a vertex on which the vertex shader was applied, and which was rasterized
+*/
+typedef struct
+{
+    CSR_Vector3 m_Vertex;
+    CSR_Vector2 m_ST;
+    CSR_Color   m_Color;
+    CSR_Vector3 m_RasterVertex;
+    size_t      m_Index;       // vertex index in the vertex buffer
+    int         m_Transformed;
+} CSR_RasterVertex;
+
+/**
+* Post-transform vertex cache, keeps the last transformed vertices of a vertex buffer
+*/
+typedef struct
+{
+    const CSR_Matrix4*       m_pMatrix;
+    const CSR_VertexBuffer*  m_pVB;
+    const CSR_Rect*          m_pScreenRect;
+          float              m_ZNear;
+          float              m_Width;
+          float              m_Height;
+    CSR_fOnApplyVertexShader m_fOnApplyVertexShader;
+    CSR_RasterVertex         m_Vertex[M_CSR_Raster_Vertex_Cache_Size]; // each vertex is kept in the slot matching its index
+    size_t                   m_Count;   // vertex count in the vertex buffer
+    size_t                   m_Next;    // next slot to use if the cache is disabled
+    int                      m_Enabled; // 0 if the polygons share no vertex, e.g. for not indexed triangles
+} CSR_RasterVertexCache;
+
+/**
+* Raster drawing context, i.e. the target in which the assembled polygons are drawn
+*/
+typedef struct
+{
+    CSR_RasterVertexCache*     m_pCache;
+    CSR_FrameBuffer*           m_pFB;
+    CSR_DepthBuffer*           m_pDB;
+    CSR_fOnApplyFragmentShader m_fOnApplyFragmentShader;
+    const void*                m_pCustomData;
+    CSR_RasterTiles*           m_pTiles; // tiled rasterizer in which the polygons are queued, 0 to draw them immediately
+} CSR_RasterDrawContext;
+
+/**
+* Occlusion vertex, i.e. a vertex transformed in the clip space
+*/
+typedef struct
+{
+    float m_X;
+    float m_Y;
+    float m_Z;
+    float m_W;
+    int   m_Transformed;
+} CSR_OcclusionVertex;
+
+/**
+* Occlusion drawing context, keeps the occluder vertices once transformed
+*/
+typedef struct
+{
+          CSR_OcclusionBuffer* m_pOB;
+    const CSR_VertexBuffer*    m_pVB;
+          CSR_Matrix4          m_Matrix;  // model view projection matrix
+          CSR_OcclusionVertex* m_pVertex; // one slot per unique vertex in the vertex buffer
+          size_t               m_Count;
+} CSR_OcclusionDrawContext;
+
+//---------------------------------------------------------------------------
+// Raster private callbacks
+//---------------------------------------------------------------------------
+
+/**
+* Called when a polygon was assembled from a vertex buffer
+*@param pContext - drawing context
+*@param v1Index - first polygon vertex offset in the vertex buffer, in the drawing order
+*@param v2Index - second polygon vertex offset in the vertex buffer, in the drawing order
+*@param v3Index - third polygon vertex offset in the vertex buffer, in the drawing order
+*@return 1 on success, otherwise 0
+*/
+typedef int (*CSR_fOnAssemblePolygon)(void* pContext, size_t v1Index, size_t v2Index, size_t v3Index);
+
+
 //---------------------------------------------------------------------------
 CSR_FrameBuffer* csrFrameBufferCreate(size_t width, size_t height)
 {
@@ -334,218 +472,132 @@ void csrRasterRasterizeVertex(const CSR_Vector3* pInVertex,
     pOutVertex->m_Z = -vertexCamera.m_Z;
 }
 //---------------------------------------------------------------------------
-int csrRasterGetPolygon(const CSR_Matrix4*             pMatrix,
-                              size_t                   v1Index,
-                              size_t                   v2Index,
-                              size_t                   v3Index,
+void csrRasterGetVertex(const CSR_Matrix4*             pMatrix,
+                              size_t                   offset,
                         const CSR_VertexBuffer*        pVB,
-                              CSR_Polygon3*            pPolygon,
+                              CSR_Vector3*             pVertex,
                               CSR_Vector3*             pNormal,
                               CSR_Vector2*             pST,
                               CSR_Color*               pColor,
                         const CSR_fOnApplyVertexShader fOnApplyVertexShader)
 {
-    size_t offset;
-    size_t i;
-
-    // validate the input
-    if (!pVB || !pPolygon || !pNormal || !pST || !pColor)
-        return 0;
-
-    offset = 0;
-
-    // extract the polygon from source vertex buffer
-    pPolygon->m_Vertex[0].m_X = pVB->m_pData[v1Index];
-    pPolygon->m_Vertex[0].m_Y = pVB->m_pData[v1Index + 1];
-    pPolygon->m_Vertex[0].m_Z = pVB->m_pData[v1Index + 2];
-    pPolygon->m_Vertex[1].m_X = pVB->m_pData[v2Index];
-    pPolygon->m_Vertex[1].m_Y = pVB->m_pData[v2Index + 1];
-    pPolygon->m_Vertex[1].m_Z = pVB->m_pData[v2Index + 2];
-    pPolygon->m_Vertex[2].m_X = pVB->m_pData[v3Index];
-    pPolygon->m_Vertex[2].m_Y = pVB->m_pData[v3Index + 1];
-    pPolygon->m_Vertex[2].m_Z = pVB->m_pData[v3Index + 2];
+    // extract the vertex from source vertex buffer
+    pVertex->m_X = pVB->m_pData[offset];
+    pVertex->m_Y = pVB->m_pData[offset + 1];
+    pVertex->m_Z = pVB->m_pData[offset + 2];
 
     offset += 3;
 
     // extract the normal from source vertex buffer
     if (pVB->m_Format.m_HasNormal)
     {
-        pNormal[0].m_X = pVB->m_pData[v1Index + offset];
-        pNormal[0].m_Y = pVB->m_pData[v1Index + offset + 1];
-        pNormal[0].m_Z = pVB->m_pData[v1Index + offset + 2];
-        pNormal[1].m_X = pVB->m_pData[v2Index + offset];
-        pNormal[1].m_Y = pVB->m_pData[v2Index + offset + 1];
-        pNormal[1].m_Z = pVB->m_pData[v2Index + offset + 2];
-        pNormal[2].m_X = pVB->m_pData[v3Index + offset];
-        pNormal[2].m_Y = pVB->m_pData[v3Index + offset + 1];
-        pNormal[2].m_Z = pVB->m_pData[v3Index + offset + 2];
+        pNormal->m_X = pVB->m_pData[offset];
+        pNormal->m_Y = pVB->m_pData[offset + 1];
+        pNormal->m_Z = pVB->m_pData[offset + 2];
 
         offset += 3;
     }
     else
     {
-        pNormal[0].m_X = 0.0f;
-        pNormal[0].m_Y = 0.0f;
-        pNormal[0].m_Z = 0.0f;
-        pNormal[1].m_X = 0.0f;
-        pNormal[1].m_Y = 0.0f;
-        pNormal[1].m_Z = 0.0f;
-        pNormal[2].m_X = 0.0f;
-        pNormal[2].m_Y = 0.0f;
-        pNormal[2].m_Z = 0.0f;
+        pNormal->m_X = 0.0f;
+        pNormal->m_Y = 0.0f;
+        pNormal->m_Z = 0.0f;
     }
 
     // extract the texture coordinates from source vertex buffer
     if (pVB->m_Format.m_HasTexCoords)
     {
-        pST[0].m_X = pVB->m_pData[v1Index + offset];
-        pST[0].m_Y = pVB->m_pData[v1Index + offset + 1];
-        pST[1].m_X = pVB->m_pData[v2Index + offset];
-        pST[1].m_Y = pVB->m_pData[v2Index + offset + 1];
-        pST[2].m_X = pVB->m_pData[v3Index + offset];
-        pST[2].m_Y = pVB->m_pData[v3Index + offset + 1];
+        pST->m_X = pVB->m_pData[offset];
+        pST->m_Y = pVB->m_pData[offset + 1];
 
         offset += 2;
     }
     else
     {
-        pST[0].m_X = 0.0f;
-        pST[0].m_Y = 0.0f;
-        pST[1].m_X = 0.0f;
-        pST[1].m_Y = 0.0f;
-        pST[2].m_X = 0.0f;
-        pST[2].m_Y = 0.0f;
+        pST->m_X = 0.0f;
+        pST->m_Y = 0.0f;
     }
 
     // extract the color from source vertex buffer
     if (pVB->m_Format.m_HasPerVertexColor)
     {
-        pColor[0].m_R = pVB->m_pData[v1Index + offset];
-        pColor[0].m_G = pVB->m_pData[v1Index + offset + 1];
-        pColor[0].m_B = pVB->m_pData[v1Index + offset + 2];
-        pColor[0].m_A = pVB->m_pData[v1Index + offset + 3];
-        pColor[1].m_R = pVB->m_pData[v2Index + offset];
-        pColor[1].m_G = pVB->m_pData[v2Index + offset + 1];
-        pColor[1].m_B = pVB->m_pData[v2Index + offset + 2];
-        pColor[1].m_A = pVB->m_pData[v2Index + offset + 3];
-        pColor[2].m_R = pVB->m_pData[v3Index + offset];
-        pColor[2].m_G = pVB->m_pData[v3Index + offset + 1];
-        pColor[2].m_B = pVB->m_pData[v3Index + offset + 2];
-        pColor[2].m_A = pVB->m_pData[v3Index + offset + 3];
+        pColor->m_R = pVB->m_pData[offset];
+        pColor->m_G = pVB->m_pData[offset + 1];
+        pColor->m_B = pVB->m_pData[offset + 2];
+        pColor->m_A = pVB->m_pData[offset + 3];
     }
     else
     {
-        pColor[0].m_R = 0.0f;
-        pColor[0].m_G = 0.0f;
-        pColor[0].m_B = 0.0f;
-        pColor[0].m_A = 0.0f;
-        pColor[1].m_R = 0.0f;
-        pColor[1].m_G = 0.0f;
-        pColor[1].m_B = 0.0f;
-        pColor[1].m_A = 0.0f;
-        pColor[2].m_R = 0.0f;
-        pColor[2].m_G = 0.0f;
-        pColor[2].m_B = 0.0f;
-        pColor[2].m_A = 0.0f;
+        pColor->m_R = 0.0f;
+        pColor->m_G = 0.0f;
+        pColor->m_B = 0.0f;
+        pColor->m_A = 0.0f;
     }
 
-    // for each vertex, apply the vertex shader
+    // apply the vertex shader
     if (fOnApplyVertexShader)
-        for (i = 0; i < 3; ++i)
-            fOnApplyVertexShader(pMatrix, &pPolygon->m_Vertex[i], &pNormal[i], &pST[i], &pColor[i]);
-
-    return 1;
+        fOnApplyVertexShader(pMatrix, pVertex, pNormal, pST, pColor);
 }
 //---------------------------------------------------------------------------
-int csrRasterDrawPolygon(const CSR_Polygon3*              pPolygon,
-                         const CSR_Vector3*               pNormal,
-                         const CSR_Vector2*               pST,
-                         const CSR_Color*                 pColor,
-                         const CSR_Matrix4*               pMatrix,
-                               float                      zNear,
-                               CSR_ECullingType           cullingType,
-                               CSR_ECullingFace           cullingFace,
-                         const CSR_Rect*                  pScreenRect,
-                               CSR_FrameBuffer*           pFB,
-                               CSR_DepthBuffer*           pDB,
-                         const CSR_fOnApplyFragmentShader fOnApplyFragmentShader)
+int csrRasterGetPolygon(const CSR_Matrix4*             pMatrix,
+                              size_t                   v1Index,
+                              size_t                   v2Index,
+                              size_t                   v3Index,
+                        const CSR_VertexBuffer*        pVB,
+                              CSR_Polygon3*            pPolygon,
+                              CSR_Vector3*             pNormal,
+                              CSR_Vector2*             pST,
+                              CSR_Color*               pColor,
+                        const CSR_fOnApplyVertexShader fOnApplyVertexShader)
 {
-    #ifdef _MSC_VER
-        float         xMin;
-        float         yMin;
-        float         xMax;
-        float         yMax;
-        float         xStart;
-        float         yStart;
-        float         xEnd;
-        float         yEnd;
-        float         area;
-        float         w0;
-        float         w1;
-        float         w2;
-        float         invZ;
-        float         z;
-        size_t        x;
-        size_t        y;
-        size_t        x0;
-        size_t        x1;
-        size_t        y0;
-        size_t        y1;
-        int           cullingMode;
-        int           pixelVisible;
-        CSR_Polygon3  rasterPoly  = {0};
-        CSR_Vector2   st[3]       = {0};
-        CSR_Vector2   stCoord     = {0};
-        CSR_Vector3   pixelSample = {0};
-        CSR_Vector3   sampler     = {0};
-        CSR_Color     color       = {0};
-    #else
-        float         xMin;
-        float         yMin;
-        float         xMax;
-        float         yMax;
-        float         xStart;
-        float         yStart;
-        float         xEnd;
-        float         yEnd;
-        float         area;
-        float         w0;
-        float         w1;
-        float         w2;
-        float         invZ;
-        float         z;
-        size_t        x;
-        size_t        y;
-        size_t        x0;
-        size_t        x1;
-        size_t        y0;
-        size_t        y1;
-        int           cullingMode;
-        int           pixelVisible;
-        CSR_Polygon3  rasterPoly;
-        CSR_Vector2   st[3];
-        CSR_Vector2   stCoord;
-        CSR_Vector3   pixelSample;
-        CSR_Vector3   sampler;
-        CSR_Color     color;
-    #endif
-
     // validate the input
-    if (!pPolygon || !pNormal || !pST || !pColor || !pMatrix || !pScreenRect || !pFB || !pDB)
+    if (!pVB || !pPolygon || !pNormal || !pST || !pColor)
         return 0;
 
-    // rasterize the polygon
-    csrRasterRasterizeVertex(&pPolygon->m_Vertex[0], pMatrix, pScreenRect, zNear, (float)pFB->m_Width, (float)pFB->m_Height, &rasterPoly.m_Vertex[0]);
-    csrRasterRasterizeVertex(&pPolygon->m_Vertex[1], pMatrix, pScreenRect, zNear, (float)pFB->m_Width, (float)pFB->m_Height, &rasterPoly.m_Vertex[1]);
-    csrRasterRasterizeVertex(&pPolygon->m_Vertex[2], pMatrix, pScreenRect, zNear, (float)pFB->m_Width, (float)pFB->m_Height, &rasterPoly.m_Vertex[2]);
+    // get the vertices data offsets, in case the vertex buffer is indexed
+    v1Index = csrVertexBufferGetOffset(pVB, v1Index);
+    v2Index = csrVertexBufferGetOffset(pVB, v2Index);
+    v3Index = csrVertexBufferGetOffset(pVB, v3Index);
+
+    // extract the polygon vertices from source vertex buffer and apply the vertex shader on them
+    csrRasterGetVertex(pMatrix, v1Index, pVB, &pPolygon->m_Vertex[0], &pNormal[0], &pST[0], &pColor[0], fOnApplyVertexShader);
+    csrRasterGetVertex(pMatrix, v2Index, pVB, &pPolygon->m_Vertex[1], &pNormal[1], &pST[1], &pColor[1], fOnApplyVertexShader);
+    csrRasterGetVertex(pMatrix, v3Index, pVB, &pPolygon->m_Vertex[2], &pNormal[2], &pST[2], &pColor[2], fOnApplyVertexShader);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrRasterPreparePolygon(const CSR_Polygon3*              pPolygon,
+                            const CSR_Polygon3*              pRasterPoly,
+                            const CSR_Vector2*               pST,
+                            const CSR_Color*                 pColor,
+                            const CSR_Matrix4*               pMatrix,
+                                  CSR_ECullingType           cullingType,
+                                  CSR_ECullingFace           cullingFace,
+                                  size_t                     width,
+                                  size_t                     height,
+                            const CSR_fOnApplyFragmentShader fOnApplyFragmentShader,
+                            const void*                      pCustomData,
+                                  CSR_RasterPolygon*         pR)
+{
+    float xMin;
+    float yMin;
+    float xMax;
+    float yMax;
+    float xStart;
+    float yStart;
+    float xEnd;
+    float yEnd;
+
+    // get the rasterized polygon
+    pR->m_RasterPoly = *pRasterPoly;
 
     // check if the polygon is culled and determine the culling mode to use (0 = CW, 1 = CCW, 2 = both)
     switch (cullingType)
     {
         case CSR_CT_None:
             // both faces are accepted
-            cullingType = 2;
-            cullingMode = 0;
+            pR->m_CullingMode = 2;
             break;
 
         case CSR_CT_Front:
@@ -564,9 +616,9 @@ int csrRasterDrawPolygon(const CSR_Polygon3*              pPolygon,
             #endif
 
             // calculate the rasterized polygon plane
-            csrPlaneFromPoints(&rasterPoly.m_Vertex[0],
-                               &rasterPoly.m_Vertex[1],
-                               &rasterPoly.m_Vertex[2],
+            csrPlaneFromPoints(&pR->m_RasterPoly.m_Vertex[0],
+                               &pR->m_RasterPoly.m_Vertex[1],
+                               &pR->m_RasterPoly.m_Vertex[2],
                                &polygonPlane);
 
             // calculate the rasterized polygon surface normal
@@ -587,24 +639,24 @@ int csrRasterDrawPolygon(const CSR_Polygon3*              pPolygon,
                 case CSR_CF_CW:
                     // is polygon rejected?
                     if (cullingDot <= 0.0f)
-                        return 1;
+                        return 0;
 
                     // apply a clockwise culling
-                    cullingMode = 0;
+                    pR->m_CullingMode = 0;
                     break;
 
                 case CSR_CF_CCW:
                     // is polygon rejected?
                     if (cullingDot >= 0.0f)
-                        return 1;
+                        return 0;
 
                     // apply a counter-clockwise culling
-                    cullingMode = 1;
+                    pR->m_CullingMode = 1;
                     break;
 
                 // error
                 default:
-                    return 1;
+                    return 0;
             }
 
             break;
@@ -613,71 +665,438 @@ int csrRasterDrawPolygon(const CSR_Polygon3*              pPolygon,
         case CSR_CT_Both:
         default:
             // both faces are rejected
-            return 1;
+            return 0;
     }
 
     // invert the vertex z-coordinate (to allow multiplication later instead of division)
-    rasterPoly.m_Vertex[0].m_Z = 1.0f / rasterPoly.m_Vertex[0].m_Z;
-    rasterPoly.m_Vertex[1].m_Z = 1.0f / rasterPoly.m_Vertex[1].m_Z;
-    rasterPoly.m_Vertex[2].m_Z = 1.0f / rasterPoly.m_Vertex[2].m_Z;
+    pR->m_RasterPoly.m_Vertex[0].m_Z = 1.0f / pR->m_RasterPoly.m_Vertex[0].m_Z;
+    pR->m_RasterPoly.m_Vertex[1].m_Z = 1.0f / pR->m_RasterPoly.m_Vertex[1].m_Z;
+    pR->m_RasterPoly.m_Vertex[2].m_Z = 1.0f / pR->m_RasterPoly.m_Vertex[2].m_Z;
 
     // calculate the texture coordinates, divide them by their vertex z-coordinate
-    st[0].m_X = pST[0].m_X * rasterPoly.m_Vertex[0].m_Z;
-    st[0].m_Y = pST[0].m_Y * rasterPoly.m_Vertex[0].m_Z;
-    st[1].m_X = pST[1].m_X * rasterPoly.m_Vertex[1].m_Z;
-    st[1].m_Y = pST[1].m_Y * rasterPoly.m_Vertex[1].m_Z;
-    st[2].m_X = pST[2].m_X * rasterPoly.m_Vertex[2].m_Z;
-    st[2].m_Y = pST[2].m_Y * rasterPoly.m_Vertex[2].m_Z;
+    pR->m_ST[0].m_X = pST[0].m_X * pR->m_RasterPoly.m_Vertex[0].m_Z;
+    pR->m_ST[0].m_Y = pST[0].m_Y * pR->m_RasterPoly.m_Vertex[0].m_Z;
+    pR->m_ST[1].m_X = pST[1].m_X * pR->m_RasterPoly.m_Vertex[1].m_Z;
+    pR->m_ST[1].m_Y = pST[1].m_Y * pR->m_RasterPoly.m_Vertex[1].m_Z;
+    pR->m_ST[2].m_X = pST[2].m_X * pR->m_RasterPoly.m_Vertex[2].m_Z;
+    pR->m_ST[2].m_Y = pST[2].m_Y * pR->m_RasterPoly.m_Vertex[2].m_Z;
 
     // calculate the polygon bounding rect
-    csrRasterFindMin(rasterPoly.m_Vertex[0].m_X, rasterPoly.m_Vertex[1].m_X, rasterPoly.m_Vertex[2].m_X, &xMin);
-    csrRasterFindMin(rasterPoly.m_Vertex[0].m_Y, rasterPoly.m_Vertex[1].m_Y, rasterPoly.m_Vertex[2].m_Y, &yMin);
-    csrRasterFindMax(rasterPoly.m_Vertex[0].m_X, rasterPoly.m_Vertex[1].m_X, rasterPoly.m_Vertex[2].m_X, &xMax);
-    csrRasterFindMax(rasterPoly.m_Vertex[0].m_Y, rasterPoly.m_Vertex[1].m_Y, rasterPoly.m_Vertex[2].m_Y, &yMax);
+    csrRasterFindMin(pR->m_RasterPoly.m_Vertex[0].m_X, pR->m_RasterPoly.m_Vertex[1].m_X, pR->m_RasterPoly.m_Vertex[2].m_X, &xMin);
+    csrRasterFindMin(pR->m_RasterPoly.m_Vertex[0].m_Y, pR->m_RasterPoly.m_Vertex[1].m_Y, pR->m_RasterPoly.m_Vertex[2].m_Y, &yMin);
+    csrRasterFindMax(pR->m_RasterPoly.m_Vertex[0].m_X, pR->m_RasterPoly.m_Vertex[1].m_X, pR->m_RasterPoly.m_Vertex[2].m_X, &xMax);
+    csrRasterFindMax(pR->m_RasterPoly.m_Vertex[0].m_Y, pR->m_RasterPoly.m_Vertex[1].m_Y, pR->m_RasterPoly.m_Vertex[2].m_Y, &yMax);
 
     // is the polygon out of screen?
-    if (xMin > (float)(pFB->m_Width  - 1) || xMax < 0.0f ||
-        yMin > (float)(pFB->m_Height - 1) || yMax < 0.0f)
-        return 1;
+    if (xMin > (float)(width  - 1) || xMax < 0.0f ||
+        yMin > (float)(height - 1) || yMax < 0.0f)
+        return 0;
 
     // calculate the area to draw
-    csrMathMax(0.0f,                       xMin, &xStart);
-    csrMathMin((float)(pFB->m_Width  - 1), xMax, &xEnd);
-    csrMathMax(0.0f,                       yMin, &yStart);
-    csrMathMin((float)(pFB->m_Height - 1), yMax, &yEnd);
+    csrMathMax(0.0f,                 xMin, &xStart);
+    csrMathMin((float)(width  - 1), xMax, &xEnd);
+    csrMathMax(0.0f,                 yMin, &yStart);
+    csrMathMin((float)(height - 1), yMax, &yEnd);
 
     #ifdef __CODEGEARC__
-        x0 = (size_t)floor(xStart);
-        x1 = (size_t)floor(xEnd);
-        y0 = (size_t)floor(yStart);
-        y1 = (size_t)floor(yEnd);
+        pR->m_X0 = (size_t)floor(xStart);
+        pR->m_X1 = (size_t)floor(xEnd);
+        pR->m_Y0 = (size_t)floor(yStart);
+        pR->m_Y1 = (size_t)floor(yEnd);
     #else
-        x0 = (size_t)floorf(xStart);
-        x1 = (size_t)floorf(xEnd);
-        y0 = (size_t)floorf(yStart);
-        y1 = (size_t)floorf(yEnd);
+        pR->m_X0 = (size_t)floorf(xStart);
+        pR->m_X1 = (size_t)floorf(xEnd);
+        pR->m_Y0 = (size_t)floorf(yStart);
+        pR->m_Y1 = (size_t)floorf(yEnd);
     #endif
 
     // calculate the triangle area (multiplied by 2)
-    csrRasterFindEdge(&rasterPoly.m_Vertex[0], &rasterPoly.m_Vertex[1], &rasterPoly.m_Vertex[2], &area);
+    csrRasterFindEdge(&pR->m_RasterPoly.m_Vertex[0],
+                      &pR->m_RasterPoly.m_Vertex[1],
+                      &pR->m_RasterPoly.m_Vertex[2],
+                      &pR->m_Area);
+
+    // keep the data the fragment shader will need
+    pR->m_Polygon                = *pPolygon;
+    pR->m_Color[0]               = pColor[0];
+    pR->m_Color[1]               = pColor[1];
+    pR->m_Color[2]               = pColor[2];
+    pR->m_pMatrix                = pMatrix;
+    pR->m_fOnApplyFragmentShader = fOnApplyFragmentShader;
+    pR->m_pCustomData            = pCustomData;
 
-    // iterate through pixels to draw
-    for (y = y0; y <= y1; ++y)
-        for (x = x0; x <= x1; ++x)
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrRasterPrepareEdge(const CSR_Vector3* pStart, const CSR_Vector3* pEnd, CSR_RasterEdge* pEdge)
+{
+    pEdge->m_X      = pStart->m_X;
+    pEdge->m_Y      = pStart->m_Y;
+    pEdge->m_DeltaX = pEnd->m_X - pStart->m_X;
+    pEdge->m_DeltaY = pEnd->m_Y - pStart->m_Y;
+    pEdge->m_Row    = 0.0f;
+}
+//---------------------------------------------------------------------------
+int csrRasterGetRowSpan(const CSR_RasterEdge* pEdge,
+                              int             cullingMode,
+                              size_t          x0,
+                              size_t          x1,
+                              size_t*         pStart,
+                              size_t*         pEnd)
+{
+    size_t i;
+    float  sign;
+    float  deltaY;
+    float  row;
+    float  absDeltaY;
+    float  absRow;
+    float  extent;
+    float  dist;
+    float  cross;
+    float  margin;
+    float  xStart = (float)x0;
+    float  xEnd   = (float)x1;
+
+    // select the sign the edge functions should have for a pixel to be visible. If both faces are
+    // drawn, a pixel may be visible with any sign, so the whole row should be tested
+    switch (cullingMode)
+    {
+        case 0:  sign =  1.0f; break;
+        case 1:  sign = -1.0f; break;
+
+        default:
+            *pStart = x0;
+            *pEnd   = x1;
+            return 1;
+    }
+
+    for (i = 0; i < 3; ++i)
+    {
+        deltaY = pEdge[i].m_DeltaY * sign;
+        row    = pEdge[i].m_Row    * sign;
+
+        // horizontal edge, the edge function is the same for the whole row
+        if (deltaY == 0.0f)
         {
-            pixelSample.m_X = x + 0.5f;
-            pixelSample.m_Y = y + 0.5f;
-            pixelSample.m_Z =     0.0f;
+            // is the whole row outside the polygon?
+            if (row > 0.0f)
+                return 0;
+
+            continue;
+        }
+
+        absDeltaY = deltaY < 0.0f ? -deltaY : deltaY;
+        absRow    = row    < 0.0f ? -row    : row;
+
+        // get the farthest pixel center from the edge start on the row
+        extent = pEdge[i].m_X - (float)x0;
+        dist   = ((float)x1 + 1.0f) - pEdge[i].m_X;
+
+        if (extent < 0.0f)
+            extent = -extent;
+
+        if (dist < 0.0f)
+            dist = -dist;
+
+        if (dist > extent)
+            extent = dist;
+
+        // calculate the pixel position where the edge crosses the row, and a margin covering the
+        // rounding errors the per-pixel edge function may do, in order to never reject a pixel the
+        // per-pixel test would keep
+        cross  = pEdge[i].m_X + (row / deltaY) - 0.5f;
+        margin = 1.0f + (((absRow + (absDeltaY * extent)) * M_CSR_Raster_Edge_Tolerance) / absDeltaY);
+
+        // restrict the span to the inner side of the edge
+        if (deltaY > 0.0f)
+        {
+            cross -= margin;
+
+            if (cross > xStart)
+                xStart = cross;
+        }
+        else
+        {
+            cross += margin;
+
+            if (cross < xEnd)
+                xEnd = cross;
+        }
+    }
+
+    // is the span empty?
+    if (xStart > xEnd)
+        return 0;
+
+    // get the first and last pixels to test, rounded outwards
+    *pStart = (size_t)xStart;
+    *pEnd   = (size_t)xEnd;
+
+    if ((float)*pStart < xStart)
+        ++(*pStart);
+
+    return (*pStart <= *pEnd);
+}
+//---------------------------------------------------------------------------
+void csrRasterShadePixel(const CSR_RasterPolygon* pPolygon,
+                               size_t             x,
+                               size_t             y,
+                               float              w0,
+                               float              w1,
+                               float              w2,
+                               float              z,
+                               CSR_FrameBuffer*   pFB,
+                               CSR_DepthBuffer*   pDB)
+{
+    #ifdef _MSC_VER
+        size_t             offset;
+        const CSR_Vector2* st;
+        const CSR_Color*   pColor;
+        CSR_Vector2        stCoord = {0};
+        CSR_Vector3        sampler = {0};
+        CSR_Color          color   = {0};
+    #else
+        size_t             offset;
+        const CSR_Vector2* st;
+        const CSR_Color*   pColor;
+        CSR_Vector2        stCoord;
+        CSR_Vector3        sampler;
+        CSR_Color          color;
+    #endif
+
+    offset = y * pFB->m_Width + x;
+    st     = pPolygon->m_ST;
+    pColor = pPolygon->m_Color;
+
+    // update the depth buffer
+    pDB->m_pData[offset] = z;
+
+    // calculate the default pixel color, based on the per-vertex color
+    color.m_R = w0 * pColor[0].m_R + w1 * pColor[1].m_R + w2 * pColor[2].m_R;
+    color.m_G = w0 * pColor[0].m_G + w1 * pColor[1].m_G + w2 * pColor[2].m_G;
+    color.m_B = w0 * pColor[0].m_B + w1 * pColor[1].m_B + w2 * pColor[2].m_B;
+
+    // calculate the texture coordinate
+    stCoord.m_X = ((st[0].m_X * w0) + (st[1].m_X * w1) + (st[2].m_X * w2)) * z;
+    stCoord.m_Y = ((st[0].m_Y * w0) + (st[1].m_Y * w1) + (st[2].m_Y * w2)) * z;
+
+    // for each pixel, apply the fragment shader
+    if (pPolygon->m_fOnApplyFragmentShader)
+    {
+        // set the sampler items
+        sampler.m_X = w0;
+        sampler.m_Y = w1;
+        sampler.m_Z = w2;
+
+        pPolygon->m_fOnApplyFragmentShader(pPolygon->m_pMatrix,
+                                          &pPolygon->m_Polygon,
+                                          &stCoord,
+                                          &sampler,
+                                           z,
+                                          &color,
+                                           pPolygon->m_pCustomData);
+    }
+
+    // limit the color components between 0.0 and 1.0
+    csrMathClamp(color.m_R, 0.0, 1.0, &color.m_R);
+    csrMathClamp(color.m_G, 0.0, 1.0, &color.m_G);
+    csrMathClamp(color.m_B, 0.0, 1.0, &color.m_B);
+
+    // write the final pixel inside the frame buffer
+    pFB->m_pPixel[offset].m_R = (unsigned char)(color.m_R * 255.0f);
+    pFB->m_pPixel[offset].m_G = (unsigned char)(color.m_G * 255.0f);
+    pFB->m_pPixel[offset].m_B = (unsigned char)(color.m_B * 255.0f);
+    pFB->m_pPixel[offset].m_A = (unsigned char)(color.m_A * 255.0f);
+}
+//---------------------------------------------------------------------------
+#ifdef CSR_RASTER_SSE2
+    int csrRasterFillRow(const CSR_RasterPolygon* pPolygon,
+                         const CSR_RasterEdge*    pEdge,
+                               size_t             y,
+                               size_t             xStart,
+                               size_t             xEnd,
+                               CSR_FrameBuffer*   pFB,
+                               CSR_DepthBuffer*   pDB)
+    {
+        size_t       x;
+        size_t       i;
+        size_t       count;
+        int          mask;
+        float        depth[4];
+        float        w0[4];
+        float        w1[4];
+        float        w2[4];
+        float        z[4];
+        const float* pDepth;
+        __m128       sampleX;
+        __m128       e0;
+        __m128       e1;
+        __m128       e2;
+        __m128       inside;
+        __m128       outside;
+        __m128       visible;
+        __m128       invert;
+        __m128       invZ;
+        __m128       pixelZ;
+
+        // the 4 pixels processed together, and their offset from the first pixel center
+        const __m128  pixelOffset = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+        const __m128i pixelIndex  = _mm_set_epi32(3, 2, 1, 0);
+
+        // polygon constants
+        const __m128 zero    = _mm_setzero_ps();
+        const __m128 one     = _mm_set1_ps(1.0f);
+        const __m128 signBit = _mm_set1_ps(-0.0f);
+        const __m128 area    = _mm_set1_ps(pPolygon->m_Area);
+        const __m128 x0      = _mm_set1_ps(pEdge[0].m_X);
+        const __m128 x1      = _mm_set1_ps(pEdge[1].m_X);
+        const __m128 x2      = _mm_set1_ps(pEdge[2].m_X);
+        const __m128 dy0     = _mm_set1_ps(pEdge[0].m_DeltaY);
+        const __m128 dy1     = _mm_set1_ps(pEdge[1].m_DeltaY);
+        const __m128 dy2     = _mm_set1_ps(pEdge[2].m_DeltaY);
+        const __m128 row0    = _mm_set1_ps(pEdge[0].m_Row);
+        const __m128 row1    = _mm_set1_ps(pEdge[1].m_Row);
+        const __m128 row2    = _mm_set1_ps(pEdge[2].m_Row);
+        const __m128 z0      = _mm_set1_ps(pPolygon->m_RasterPoly.m_Vertex[0].m_Z);
+        const __m128 z1      = _mm_set1_ps(pPolygon->m_RasterPoly.m_Vertex[1].m_Z);
+        const __m128 z2      = _mm_set1_ps(pPolygon->m_RasterPoly.m_Vertex[2].m_Z);
+
+        pDepth = &pDB->m_pData[y * pFB->m_Width];
+
+        for (x = xStart; x <= xEnd; x += 4)
+        {
+            // get the pixel count to process, which may be lower than 4 at the row end
+            count = xEnd - x + 1;
+
+            if (count > 4)
+                count = 4;
+
+            sampleX = _mm_add_ps(_mm_set1_ps((float)x), pixelOffset);
+
+            // calculate the sub-triangle areas (multiplied by 2)
+            e0 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(sampleX, x0), dy0), row0);
+            e1 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(sampleX, x1), dy1), row1);
+            e2 = _mm_sub_ps(_mm_mul_ps(_mm_sub_ps(sampleX, x2), dy2), row2);
+
+            inside  = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+            outside = _mm_and_ps(_mm_and_ps(_mm_cmple_ps(e0, zero), _mm_cmple_ps(e1, zero)), _mm_cmple_ps(e2, zero));
+
+            // check which pixels are visible. The culling mode is important to determine the sign
+            switch (pPolygon->m_CullingMode)
+            {
+                // clockwise
+                case 0:
+                    visible = inside;
+                    invert  = zero;
+                    break;
+
+                // counter-clockwise
+                case 1:
+                    visible = outside;
+                    invert  = outside;
+                    break;
+
+                // both
+                case 2:
+                    visible = _mm_or_ps(inside, outside);
+                    invert  = _mm_andnot_ps(inside, outside);
+                    break;
+
+                // error
+                default:
+                    return 0;
+            }
+
+            // ignore the pixels beyond the row end
+            visible = _mm_and_ps(visible,
+                                 _mm_castsi128_ps(_mm_cmplt_epi32(pixelIndex, _mm_set1_epi32((int)count))));
+
+            // are all pixels hidden?
+            if (!_mm_movemask_ps(visible))
+                continue;
+
+            // invert the sampler values where required
+            invert = _mm_and_ps(invert, signBit);
+            e0     = _mm_xor_ps(e0, invert);
+            e1     = _mm_xor_ps(e1, invert);
+            e2     = _mm_xor_ps(e2, invert);
+
+            // calculate the barycentric coordinates, which are the areas of the sub-triangles
+            // divided by the area of the main triangle
+            e0 = _mm_div_ps(e0, area);
+            e1 = _mm_div_ps(e1, area);
+            e2 = _mm_div_ps(e2, area);
+
+            // calculate the pixel depth
+            invZ   = _mm_add_ps(_mm_add_ps(_mm_mul_ps(z0, e0), _mm_mul_ps(z1, e1)), _mm_mul_ps(z2, e2));
+            pixelZ = _mm_div_ps(one, invZ);
+
+            // test the pixels against the depth buffer
+            if (count == 4)
+                visible = _mm_and_ps(visible, _mm_cmplt_ps(pixelZ, _mm_loadu_ps(&pDepth[x])));
+            else
+            {
+                for (i = 0; i < count; ++i)
+                    depth[i] = pDepth[x + i];
+
+                for (; i < 4; ++i)
+                    depth[i] = 0.0f;
+
+                visible = _mm_and_ps(visible, _mm_cmplt_ps(pixelZ, _mm_loadu_ps(depth)));
+            }
+
+            mask = _mm_movemask_ps(visible);
+
+            // did all pixels fail the depth test?
+            if (!mask)
+                continue;
+
+            _mm_storeu_ps(w0, e0);
+            _mm_storeu_ps(w1, e1);
+            _mm_storeu_ps(w2, e2);
+            _mm_storeu_ps(z,  pixelZ);
+
+            // draw the pixels which passed the test
+            for (i = 0; i < count; ++i)
+                if (mask & (1 << i))
+                    csrRasterShadePixel(pPolygon, x + i, y, w0[i], w1[i], w2[i], z[i], pFB, pDB);
+        }
+
+        return 1;
+    }
+#else
+    int csrRasterFillRow(const CSR_RasterPolygon* pPolygon,
+                         const CSR_RasterEdge*    pEdge,
+                               size_t             y,
+                               size_t             xStart,
+                               size_t             xEnd,
+                               CSR_FrameBuffer*   pFB,
+                               CSR_DepthBuffer*   pDB)
+    {
+        float                w0;
+        float                w1;
+        float                w2;
+        float                sampleX;
+        float                invZ;
+        float                z;
+        size_t               x;
+        int                  pixelVisible;
+        const CSR_Polygon3*  pRasterPoly = &pPolygon->m_RasterPoly;
+        float*               pDepth      = &pDB->m_pData[y * pFB->m_Width];
+
+        for (x = xStart; x <= xEnd; ++x)
+        {
+            sampleX = x + 0.5f;
 
             // calculate the sub-triangle areas (multiplied by 2)
-            csrRasterFindEdge(&rasterPoly.m_Vertex[1], &rasterPoly.m_Vertex[2], &pixelSample, &w0);
-            csrRasterFindEdge(&rasterPoly.m_Vertex[2], &rasterPoly.m_Vertex[0], &pixelSample, &w1);
-            csrRasterFindEdge(&rasterPoly.m_Vertex[0], &rasterPoly.m_Vertex[1], &pixelSample, &w2);
+            w0 = ((sampleX - pEdge[0].m_X) * pEdge[0].m_DeltaY) - pEdge[0].m_Row;
+            w1 = ((sampleX - pEdge[1].m_X) * pEdge[1].m_DeltaY) - pEdge[1].m_Row;
+            w2 = ((sampleX - pEdge[2].m_X) * pEdge[2].m_DeltaY) - pEdge[2].m_Row;
 
             pixelVisible = 0;
 
             // check if the pixel is visible. The culling mode is important to determine the sign
-            switch (cullingMode)
+            switch (pPolygon->m_CullingMode)
             {
                 // clockwise
                 case 0:
@@ -723,144 +1142,531 @@ int csrRasterDrawPolygon(const CSR_Polygon3*              pPolygon,
             }
 
             // is pixel visible?
-            if (pixelVisible)
-            {
-                // calculate the barycentric coordinates, which are the areas of the sub-triangles
-                // divided by the area of the main triangle
-                w0 /= area;
-                w1 /= area;
-                w2 /= area;
-
-                // calculate the pixel depth
-                invZ = (rasterPoly.m_Vertex[0].m_Z * w0) +
-                       (rasterPoly.m_Vertex[1].m_Z * w1) +
-                       (rasterPoly.m_Vertex[2].m_Z * w2);
-                z    = 1.0f / invZ;
-
-                // test the pixel against the depth buffer
-                if (z < pDB->m_pData[y * pFB->m_Width + x])
-                {
-                    // test passed, update the depth buffer
-                    pDB->m_pData[y * pFB->m_Width + x] = z;
+            if (!pixelVisible)
+                continue;
+
+            // calculate the barycentric coordinates, which are the areas of the sub-triangles
+            // divided by the area of the main triangle
+            w0 /= pPolygon->m_Area;
+            w1 /= pPolygon->m_Area;
+            w2 /= pPolygon->m_Area;
+
+            // calculate the pixel depth
+            invZ = (pRasterPoly->m_Vertex[0].m_Z * w0) +
+                   (pRasterPoly->m_Vertex[1].m_Z * w1) +
+                   (pRasterPoly->m_Vertex[2].m_Z * w2);
+            z    = 1.0f / invZ;
+
+            // test the pixel against the depth buffer
+            if (z < pDepth[x])
+                csrRasterShadePixel(pPolygon, x, y, w0, w1, w2, z, pFB, pDB);
+        }
 
-                    // calculate the default pixel color, based on the per-vertex color
-                    color.m_R = w0 * pColor[0].m_R + w1 * pColor[1].m_R + w2 * pColor[2].m_R;
-                    color.m_G = w0 * pColor[0].m_G + w1 * pColor[1].m_G + w2 * pColor[2].m_G;
-                    color.m_B = w0 * pColor[0].m_B + w1 * pColor[1].m_B + w2 * pColor[2].m_B;
+        return 1;
+    }
+#endif
+//---------------------------------------------------------------------------
+int csrRasterFillPolygon(const CSR_RasterPolygon* pPolygon,
+                               size_t             x0,
+                               size_t             y0,
+                               size_t             x1,
+                               size_t             y1,
+                               CSR_FrameBuffer*   pFB,
+                               CSR_DepthBuffer*   pDB)
+{
+    size_t              y;
+    size_t              xStart;
+    size_t              xEnd;
+    float               sampleY;
+    CSR_RasterEdge      edge[3];
+    const CSR_Polygon3* pRasterPoly;
 
-                    // calculate the texture coordinate
-                    stCoord.m_X = ((st[0].m_X * w0) + (st[1].m_X * w1) + (st[2].m_X * w2)) * z;
-                    stCoord.m_Y = ((st[0].m_Y * w0) + (st[1].m_Y * w1) + (st[2].m_Y * w2)) * z;
+    // restrict the area to draw to the polygon bounding rect
+    if (x0 < pPolygon->m_X0)
+        x0 = pPolygon->m_X0;
 
-                    // for each pixel, apply the fragment shader
-                    if (fOnApplyFragmentShader)
-                    {
-                        // set the sampler items
-                        sampler.m_X = w0;
-                        sampler.m_Y = w1;
-                        sampler.m_Z = w2;
-
-                        fOnApplyFragmentShader(pMatrix,
-                                               pPolygon,
-                                               &stCoord,
-                                               &sampler,
-                                               z,
-                                               &color);
-                    }
+    if (y0 < pPolygon->m_Y0)
+        y0 = pPolygon->m_Y0;
 
-                    // limit the color components between 0.0 and 1.0
-                    csrMathClamp(color.m_R, 0.0, 1.0, &color.m_R);
-                    csrMathClamp(color.m_G, 0.0, 1.0, &color.m_G);
-                    csrMathClamp(color.m_B, 0.0, 1.0, &color.m_B);
+    if (x1 > pPolygon->m_X1)
+        x1 = pPolygon->m_X1;
 
-                    // write the final pixel inside the frame buffer
-                    pFB->m_pPixel[y * pFB->m_Width + x].m_R = (unsigned char)(color.m_R * 255.0f);
-                    pFB->m_pPixel[y * pFB->m_Width + x].m_G = (unsigned char)(color.m_G * 255.0f);
-                    pFB->m_pPixel[y * pFB->m_Width + x].m_B = (unsigned char)(color.m_B * 255.0f);
-                    pFB->m_pPixel[y * pFB->m_Width + x].m_A = (unsigned char)(color.m_A * 255.0f);
-                }
-            }
-        }
+    if (y1 > pPolygon->m_Y1)
+        y1 = pPolygon->m_Y1;
+
+    // nothing to draw?
+    if (x0 > x1)
+        return 1;
+
+    pRasterPoly = &pPolygon->m_RasterPoly;
+
+    // prepare the edges of the sub-triangles
+    csrRasterPrepareEdge(&pRasterPoly->m_Vertex[1], &pRasterPoly->m_Vertex[2], &edge[0]);
+    csrRasterPrepareEdge(&pRasterPoly->m_Vertex[2], &pRasterPoly->m_Vertex[0], &edge[1]);
+    csrRasterPrepareEdge(&pRasterPoly->m_Vertex[0], &pRasterPoly->m_Vertex[1], &edge[2]);
+
+    // iterate through pixel rows to draw
+    for (y = y0; y <= y1; ++y)
+    {
+        sampleY = y + 0.5f;
+
+        // the edge function terms depending on the row remain the same for the whole row
+        edge[0].m_Row = (sampleY - edge[0].m_Y) * edge[0].m_DeltaX;
+        edge[1].m_Row = (sampleY - edge[1].m_Y) * edge[1].m_DeltaX;
+        edge[2].m_Row = (sampleY - edge[2].m_Y) * edge[2].m_DeltaX;
+
+        // get the part of the row the polygon may cover
+        if (!csrRasterGetRowSpan(edge, pPolygon->m_CullingMode, x0, x1, &xStart, &xEnd))
+            continue;
+
+        // draw the row pixels
+        if (!csrRasterFillRow(pPolygon, edge, y, xStart, xEnd, pFB, pDB))
+            return 0;
+    }
 
     return 1;
 }
 //---------------------------------------------------------------------------
-int csrRasterDraw(const CSR_Matrix4*               pMatrix,
-                        float                      zNear,
-                        float                      zFar,
-                  const CSR_VertexBuffer*          pVB,
-                  const CSR_Raster*                pRaster,
-                        CSR_FrameBuffer*           pFB,
-                        CSR_DepthBuffer*           pDB,
-                  const CSR_fOnApplyVertexShader   fOnApplyVertexShader,
-                  const CSR_fOnApplyFragmentShader fOnApplyFragmentShader)
+int csrRasterDrawPolygon(const CSR_Polygon3*              pPolygon,
+                         const CSR_Vector3*               pNormal,
+                         const CSR_Vector2*               pST,
+                         const CSR_Color*                 pColor,
+                         const CSR_Matrix4*               pMatrix,
+                               float                      zNear,
+                               CSR_ECullingType           cullingType,
+                               CSR_ECullingFace           cullingFace,
+                         const CSR_Rect*                  pScreenRect,
+                               CSR_FrameBuffer*           pFB,
+                               CSR_DepthBuffer*           pDB,
+                         const CSR_fOnApplyFragmentShader fOnApplyFragmentShader,
+                         const void*                      pCustomData)
 {
-    size_t       i;
-    size_t       index;
-    CSR_Rect     screenRect;
-    CSR_Polygon3 polygon;
-    CSR_Vector3  normal[3];
-    CSR_Vector2  st[3];
-    CSR_Color    color[3];
+    CSR_Polygon3      rasterPoly;
+    CSR_RasterPolygon rasterPolygon;
 
     // validate the input
-    if (!pMatrix || !pVB || !pVB->m_Format.m_Stride || !pRaster || !pFB || !pDB)
+    if (!pPolygon || !pNormal || !pST || !pColor || !pMatrix || !pScreenRect || !pFB || !pDB)
         return 0;
 
-    // get the raster screen coordinates
-    csrRasterGetScreenCoordinates(pRaster,
-                                  (float)pFB->m_Width,
-                                  (float)pFB->m_Height,
-                                  zNear,
-                                 &screenRect);
+    // rasterize the polygon
+    csrRasterRasterizeVertex(&pPolygon->m_Vertex[0], pMatrix, pScreenRect, zNear, (float)pFB->m_Width, (float)pFB->m_Height, &rasterPoly.m_Vertex[0]);
+    csrRasterRasterizeVertex(&pPolygon->m_Vertex[1], pMatrix, pScreenRect, zNear, (float)pFB->m_Width, (float)pFB->m_Height, &rasterPoly.m_Vertex[1]);
+    csrRasterRasterizeVertex(&pPolygon->m_Vertex[2], pMatrix, pScreenRect, zNear, (float)pFB->m_Width, (float)pFB->m_Height, &rasterPoly.m_Vertex[2]);
 
-    // search for vertex type
-    switch (pVB->m_Format.m_Type)
+    // prepare the polygon to draw. Nothing to draw if it's culled or out of screen
+    if (!csrRasterPreparePolygon(pPolygon,
+                                &rasterPoly,
+                                 pST,
+                                 pColor,
+                                 pMatrix,
+                                 cullingType,
+                                 cullingFace,
+                                 pFB->m_Width,
+                                 pFB->m_Height,
+                                 fOnApplyFragmentShader,
+                                 pCustomData,
+                                &rasterPolygon))
+        return 1;
+
+    // draw it
+    return csrRasterFillPolygon(&rasterPolygon, 0, 0, pFB->m_Width - 1, pFB->m_Height - 1, pFB, pDB);
+}
+//---------------------------------------------------------------------------
+int csrRasterTilesAddPolygon(const CSR_Polygon3*              pPolygon,
+                             const CSR_Polygon3*              pRasterPoly,
+                             const CSR_Vector2*               pST,
+                             const CSR_Color*                 pColor,
+                             const CSR_Matrix4*               pMatrix,
+                                   CSR_ECullingType           cullingType,
+                                   CSR_ECullingFace           cullingFace,
+                             const CSR_fOnApplyFragmentShader fOnApplyFragmentShader,
+                             const void*                      pCustomData,
+                                   CSR_RasterTiles*           pTiles)
+{
+    size_t             x;
+    size_t             y;
+    size_t             x0;
+    size_t             y0;
+    size_t             x1;
+    size_t             y1;
+    size_t             capacity;
+    CSR_RasterPolygon* pRasterPolygons;
+    CSR_RasterPolygon* pRasterPolygon;
+    CSR_RasterTile*    pTile;
+    size_t*            pIndex;
+
+    // add space for the new polygon, if required
+    if (pTiles->m_PolygonCount >= pTiles->m_PolygonCapacity)
     {
-        case CSR_VT_Triangles:
+        capacity = pTiles->m_PolygonCapacity ? pTiles->m_PolygonCapacity * 2 : 256;
+
+        pRasterPolygons = (CSR_RasterPolygon*)csrMemoryAlloc(pTiles->m_pPolygon,
+                                                             sizeof(CSR_RasterPolygon),
+                                                             capacity);
+
+        // succeeded?
+        if (!pRasterPolygons)
+            return 0;
+
+        pTiles->m_pPolygon        = pRasterPolygons;
+        pTiles->m_PolygonCapacity = capacity;
+    }
+
+    pRasterPolygon = &pTiles->m_pPolygon[pTiles->m_PolygonCount];
+
+    // prepare the polygon to queue. Nothing to queue if it's culled or out of screen
+    if (!csrRasterPreparePolygon(pPolygon,
+                                 pRasterPoly,
+                                 pST,
+                                 pColor,
+                                 pMatrix,
+                                 cullingType,
+                                 cullingFace,
+                                 pTiles->m_pFB->m_Width,
+                                 pTiles->m_pFB->m_Height,
+                                 fOnApplyFragmentShader,
+                                 pCustomData,
+                                 pRasterPolygon))
+        return 1;
+
+    // get the tiles the polygon bounding rect overlaps
+    x0 = pRasterPolygon->m_X0 / pTiles->m_TileSize;
+    y0 = pRasterPolygon->m_Y0 / pTiles->m_TileSize;
+    x1 = pRasterPolygon->m_X1 / pTiles->m_TileSize;
+    y1 = pRasterPolygon->m_Y1 / pTiles->m_TileSize;
+
+    // add the polygon to each of them
+    for (y = y0; y <= y1; ++y)
+        for (x = x0; x <= x1; ++x)
         {
-            // calculate iteration step
-            const unsigned step = (pVB->m_Format.m_Stride * 3);
+            pTile = &pTiles->m_pTile[y * pTiles->m_TileCountX + x];
 
-            // iterate through source vertices
-            for (i = 0; i < pVB->m_Count; i += step)
+            // add space for the new polygon, if required
+            if (pTile->m_Count >= pTile->m_Capacity)
             {
-                // get the next polygon to draw
-                if (!csrRasterGetPolygon(pMatrix,
-                                         i,
-                                         i +  (size_t)pVB->m_Format.m_Stride,
-                                         i + ((size_t)pVB->m_Format.m_Stride * 2),
-                                         pVB,
-                                        &polygon,
-                                         normal,
-                                         st,
-                                         color,
-                                         fOnApplyVertexShader))
-                    return 0;
+                capacity = pTile->m_Capacity ? pTile->m_Capacity * 2 : 64;
+                pIndex   = (size_t*)csrMemoryAlloc(pTile->m_pIndex, sizeof(size_t), capacity);
 
-                // draw the polygon
-                if (!csrRasterDrawPolygon(&polygon,
-                                           normal,
-                                           st,
-                                           color,
-                                           pMatrix,
-                                           zNear,
-                                           pVB->m_Culling.m_Type,
-                                           pVB->m_Culling.m_Face,
-                                          &screenRect,
-                                           pFB,
-                                           pDB,
-                                           fOnApplyFragmentShader))
+                // succeeded?
+                if (!pIndex)
                     return 0;
+
+                pTile->m_pIndex   = pIndex;
+                pTile->m_Capacity = capacity;
             }
 
-            return 1;
+            pTile->m_pIndex[pTile->m_Count] = pTiles->m_PolygonCount;
+            ++pTile->m_Count;
         }
 
-        case CSR_VT_TriangleStrip:
+    ++pTiles->m_PolygonCount;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrRasterTilesDrawTile(const CSR_RasterTiles* pTiles, size_t index)
+{
+    size_t                i;
+    size_t                x0;
+    size_t                y0;
+    size_t                x1;
+    size_t                y1;
+    const CSR_RasterTile* pTile = &pTiles->m_pTile[index];
+
+    // calculate the tile area, in pixels
+    x0 = (index % pTiles->m_TileCountX) * pTiles->m_TileSize;
+    y0 = (index / pTiles->m_TileCountX) * pTiles->m_TileSize;
+    x1 = x0 + pTiles->m_TileSize - 1;
+    y1 = y0 + pTiles->m_TileSize - 1;
+
+    // draw the polygons overlapping the tile, in the order they were queued. NOTE the polygon
+    // bounding rect is always inside the screen, thus the tile area doesn't need to be clamped
+    for (i = 0; i < pTile->m_Count; ++i)
+        if (!csrRasterFillPolygon(&pTiles->m_pPolygon[pTile->m_pIndex[i]],
+                                  x0,
+                                  y0,
+                                  x1,
+                                  y1,
+                                  pTiles->m_pFB,
+                                  pTiles->m_pDB))
+            return 0;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrRasterTilesWork(CSR_RasterWorker* pWorker)
+{
+    size_t i;
+    size_t count;
+
+    count = pWorker->m_pTiles->m_TileCountX * pWorker->m_pTiles->m_TileCountY;
+
+    // draw the worker tiles. NOTE each tile owns its frame and depth buffer pixels, thus the
+    // workers never write on the same memory
+    for (i = pWorker->m_First; i < count; i += pWorker->m_Step)
+        if (!csrRasterTilesDrawTile(pWorker->m_pTiles, i))
+            pWorker->m_Success = 0;
+}
+//---------------------------------------------------------------------------
+#if defined(CSR_RASTER_WIN32_THREADS)
+    DWORD WINAPI csrRasterTilesThreadProc(LPVOID pParam)
+    {
+        csrRasterTilesWork((CSR_RasterWorker*)pParam);
+        return 0;
+    }
+#elif defined(CSR_RASTER_POSIX_THREADS)
+    void* csrRasterTilesThreadProc(void* pParam)
+    {
+        csrRasterTilesWork((CSR_RasterWorker*)pParam);
+        return 0;
+    }
+#endif
+//---------------------------------------------------------------------------
+size_t csrRasterTilesGetThreadCount(const CSR_RasterTiles* pTiles)
+{
+    #if defined(CSR_RASTER_WIN32_THREADS)
+        SYSTEM_INFO systemInfo;
+
+        // thread count defined by the user?
+        if (pTiles->m_ThreadCount)
+            return pTiles->m_ThreadCount;
+
+        // use one thread per processor
+        GetSystemInfo(&systemInfo);
+
+        return systemInfo.dwNumberOfProcessors ? (size_t)systemInfo.dwNumberOfProcessors : 1;
+    #elif defined(CSR_RASTER_POSIX_THREADS)
+        long processorCount = 1;
+
+        // thread count defined by the user?
+        if (pTiles->m_ThreadCount)
+            return pTiles->m_ThreadCount;
+
+        // use one thread per processor
+        #ifdef _SC_NPROCESSORS_ONLN
+            processorCount = sysconf(_SC_NPROCESSORS_ONLN);
+        #endif
+
+        return processorCount > 0 ? (size_t)processorCount : 1;
+    #else
+        (void)pTiles;
+
+        // no thread support, everything is drawn on the calling thread
+        return 1;
+    #endif
+}
+//---------------------------------------------------------------------------
+int csrRasterSubmitPolygon(const CSR_Polygon3*              pPolygon,
+                           const CSR_Polygon3*              pRasterPoly,
+                           const CSR_Vector2*               pST,
+                           const CSR_Color*                 pColor,
+                           const CSR_Matrix4*               pMatrix,
+                                 CSR_ECullingType           cullingType,
+                                 CSR_ECullingFace           cullingFace,
+                                 CSR_FrameBuffer*           pFB,
+                                 CSR_DepthBuffer*           pDB,
+                           const CSR_fOnApplyFragmentShader fOnApplyFragmentShader,
+                           const void*                      pCustomData,
+                                 CSR_RasterTiles*           pTiles)
+{
+    CSR_RasterPolygon rasterPolygon;
+
+    // queue the polygon, it will be drawn with the tile it overlaps
+    if (pTiles)
+        return csrRasterTilesAddPolygon(pPolygon,
+                                        pRasterPoly,
+                                        pST,
+                                        pColor,
+                                        pMatrix,
+                                        cullingType,
+                                        cullingFace,
+                                        fOnApplyFragmentShader,
+                                        pCustomData,
+                                        pTiles);
+
+    // prepare the polygon to draw. Nothing to draw if it's culled or out of screen
+    if (!csrRasterPreparePolygon(pPolygon,
+                                 pRasterPoly,
+                                 pST,
+                                 pColor,
+                                 pMatrix,
+                                 cullingType,
+                                 cullingFace,
+                                 pFB->m_Width,
+                                 pFB->m_Height,
+                                 fOnApplyFragmentShader,
+                                 pCustomData,
+                                &rasterPolygon))
+        return 1;
+
+    // draw it
+    return csrRasterFillPolygon(&rasterPolygon, 0, 0, pFB->m_Width - 1, pFB->m_Height - 1, pFB, pDB);
+}
+//---------------------------------------------------------------------------
+void csrRasterVertexCacheInit(const CSR_Matrix4*             pMatrix,
+                                    float                    zNear,
+                              const CSR_VertexBuffer*        pVB,
+                              const CSR_Rect*                pScreenRect,
+                              const CSR_FrameBuffer*         pFB,
+                              const CSR_fOnApplyVertexShader fOnApplyVertexShader,
+                                    CSR_RasterVertexCache*   pCache)
+{
+    size_t i;
+
+    pCache->m_pMatrix              = pMatrix;
+    pCache->m_pVB                  = pVB;
+    pCache->m_pScreenRect          = pScreenRect;
+    pCache->m_ZNear                = zNear;
+    pCache->m_Width                = (float)pFB->m_Width;
+    pCache->m_Height               = (float)pFB->m_Height;
+    pCache->m_fOnApplyVertexShader = fOnApplyVertexShader;
+    pCache->m_Count                = pVB->m_Count / pVB->m_Format.m_Stride;
+    pCache->m_Next                 = 0;
+
+    // the polygons of a not indexed triangle list share no vertex, thus there is nothing to cache
+    pCache->m_Enabled = (pVB->m_Index.m_pData || pVB->m_Format.m_Type != CSR_VT_Triangles);
+
+    if (!pCache->m_Enabled)
+        return;
+
+    // mark all the slots as not transformed yet
+    for (i = 0; i < M_CSR_Raster_Vertex_Cache_Size; ++i)
+        pCache->m_Vertex[i].m_Transformed = 0;
+}
+//---------------------------------------------------------------------------
+const CSR_RasterVertex* csrRasterVertexCacheGet(CSR_RasterVertexCache* pCache, size_t offset)
+{
+    size_t            index;
+    CSR_Vector3       normal;
+    CSR_RasterVertex* pVertex;
+
+    // get the vertex data offset, in case the vertex buffer is indexed
+    offset = csrVertexBufferGetOffset(pCache->m_pVB, offset);
+    index  = offset / pCache->m_pVB->m_Format.m_Stride;
+
+    // is vertex out of bounds?
+    if (index >= pCache->m_Count)
+        return 0;
+
+    if (pCache->m_Enabled)
+    {
+        pVertex = &pCache->m_Vertex[index % M_CSR_Raster_Vertex_Cache_Size];
+
+        // vertex already transformed by a previous polygon?
+        if (pVertex->m_Transformed && pVertex->m_Index == index)
+            return pVertex;
+    }
+    else
+    {
+        // use the slots in turn. NOTE the 3 vertices of a polygon are thus never overwritten
+        // before the polygon is drawn
+        pVertex        = &pCache->m_Vertex[pCache->m_Next];
+        pCache->m_Next = (pCache->m_Next + 1) % M_CSR_Raster_Vertex_Cache_Size;
+    }
+
+    // extract the vertex and apply the vertex shader on it
+    csrRasterGetVertex(pCache->m_pMatrix,
+                       offset,
+                       pCache->m_pVB,
+                      &pVertex->m_Vertex,
+                      &normal,
+                      &pVertex->m_ST,
+                      &pVertex->m_Color,
+                       pCache->m_fOnApplyVertexShader);
+
+    // rasterize it
+    csrRasterRasterizeVertex(&pVertex->m_Vertex,
+                              pCache->m_pMatrix,
+                              pCache->m_pScreenRect,
+                              pCache->m_ZNear,
+                              pCache->m_Width,
+                              pCache->m_Height,
+                             &pVertex->m_RasterVertex);
+
+    pVertex->m_Index       = index;
+    pVertex->m_Transformed = 1;
+
+    return pVertex;
+}
+//---------------------------------------------------------------------------
+int csrRasterDrawCachedPolygon(void* pContext, size_t v1Index, size_t v2Index, size_t v3Index)
+{
+    size_t                       i;
+    const CSR_RasterVertex*      pVertex[3];
+    CSR_Polygon3                 polygon;
+    CSR_Polygon3                 rasterPoly;
+    CSR_Vector2                  st[3];
+    CSR_Color                    color[3];
+    const CSR_RasterDrawContext* pDrawContext = (const CSR_RasterDrawContext*)pContext;
+    CSR_RasterVertexCache*       pCache       = pDrawContext->m_pCache;
+
+    // get the polygon vertices, transforming them if not already done
+    pVertex[0] = csrRasterVertexCacheGet(pCache, v1Index);
+    pVertex[1] = csrRasterVertexCacheGet(pCache, v2Index);
+    pVertex[2] = csrRasterVertexCacheGet(pCache, v3Index);
+
+    if (!pVertex[0] || !pVertex[1] || !pVertex[2])
+        return 0;
+
+    // assemble the polygon
+    for (i = 0; i < 3; ++i)
+    {
+        polygon.m_Vertex[i]    = pVertex[i]->m_Vertex;
+        rasterPoly.m_Vertex[i] = pVertex[i]->m_RasterVertex;
+        st[i]                  = pVertex[i]->m_ST;
+        color[i]               = pVertex[i]->m_Color;
+    }
+
+    // draw the polygon
+    return csrRasterSubmitPolygon(&polygon,
+                                  &rasterPoly,
+                                   st,
+                                   color,
+                                   pCache->m_pMatrix,
+                                   pCache->m_pVB->m_Culling.m_Type,
+                                   pCache->m_pVB->m_Culling.m_Face,
+                                   pDrawContext->m_pFB,
+                                   pDrawContext->m_pDB,
+                                   pDrawContext->m_fOnApplyFragmentShader,
+                                   pDrawContext->m_pCustomData,
+                                   pDrawContext->m_pTiles);
+}
+//---------------------------------------------------------------------------
+int csrRasterAssemblePolygons(const CSR_VertexBuffer*      pVB,
+                                    CSR_fOnAssemblePolygon fOnAssemblePolygon,
+                                    void*                  pContext)
+{
+    size_t i;
+    size_t index;
+    size_t length;
+
+    // get the vertex buffer length in the drawing order, as if it wasn't indexed
+    length = csrVertexBufferGetVertexCount(pVB) * pVB->m_Format.m_Stride;
+
+    // search for vertex type
+    switch (pVB->m_Format.m_Type)
+    {
+        case CSR_VT_Triangles:
+        {
+            // calculate iteration step
+            const unsigned step = (pVB->m_Format.m_Stride * 3);
+
+            // iterate through source vertices
+            for (i = 0; i < length; i += step)
+                // assemble the next polygon
+                if (!fOnAssemblePolygon(pContext,
+                                        i,
+                                        i +  (size_t)pVB->m_Format.m_Stride,
+                                        i + ((size_t)pVB->m_Format.m_Stride * 2)))
+                    return 0;
+
+            return 1;
+        }
+
+        case CSR_VT_TriangleStrip:
         {
             // calculate length to read in triangle strip buffer
-            const unsigned stripLength = (unsigned)(pVB->m_Count - ((size_t)pVB->m_Format.m_Stride * 2));
+            const unsigned stripLength = (unsigned)(length - ((size_t)pVB->m_Format.m_Stride * 2));
 
             index = 0;
 
@@ -870,50 +1676,23 @@ int csrRasterDraw(const CSR_Matrix4*               pMatrix,
                 // extract polygon from source buffer, revert odd polygons
                 if (!index || !(index % 2))
                 {
-                    // get the next polygon to draw
-                    if (!csrRasterGetPolygon(pMatrix,
-                                             i,
-                                             i +  (size_t)pVB->m_Format.m_Stride,
-                                             i + ((size_t)pVB->m_Format.m_Stride * 2),
-                                             pVB,
-                                            &polygon,
-                                             normal,
-                                             st,
-                                             color,
-                                             fOnApplyVertexShader))
+                    // assemble the next polygon
+                    if (!fOnAssemblePolygon(pContext,
+                                            i,
+                                            i +  (size_t)pVB->m_Format.m_Stride,
+                                            i + ((size_t)pVB->m_Format.m_Stride * 2)))
                         return 0;
                 }
                 else
                 {
-                    // get the next polygon to draw
-                    if (!csrRasterGetPolygon(pMatrix,
-                                             i +  (size_t)pVB->m_Format.m_Stride,
-                                             i,
-                                             i + ((size_t)pVB->m_Format.m_Stride * 2),
-                                             pVB,
-                                            &polygon,
-                                             normal,
-                                             st,
-                                             color,
-                                             fOnApplyVertexShader))
+                    // assemble the next polygon
+                    if (!fOnAssemblePolygon(pContext,
+                                            i +  (size_t)pVB->m_Format.m_Stride,
+                                            i,
+                                            i + ((size_t)pVB->m_Format.m_Stride * 2)))
                         return 0;
                 }
 
-                // draw the polygon
-                if (!csrRasterDrawPolygon(&polygon,
-                                           normal,
-                                           st,
-                                           color,
-                                           pMatrix,
-                                           zNear,
-                                           pVB->m_Culling.m_Type,
-                                           pVB->m_Culling.m_Face,
-                                          &screenRect,
-                                           pFB,
-                                           pDB,
-                                           fOnApplyFragmentShader))
-                    return 0;
-
                 ++index;
             }
 
@@ -923,40 +1702,17 @@ int csrRasterDraw(const CSR_Matrix4*               pMatrix,
         case CSR_VT_TriangleFan:
         {
             // calculate length to read in triangle fan buffer
-            const unsigned fanLength = (unsigned)(pVB->m_Count - pVB->m_Format.m_Stride);
+            const unsigned fanLength = (unsigned)(length - pVB->m_Format.m_Stride);
 
             // iterate through source vertices
             for (i = pVB->m_Format.m_Stride; i < fanLength; i += pVB->m_Format.m_Stride)
-            {
-                // get the next polygon to draw
-                if (!csrRasterGetPolygon(pMatrix,
-                                         0,
-                                         i,
-                                         i + pVB->m_Format.m_Stride,
-                                         pVB,
-                                        &polygon,
-                                         normal,
-                                         st,
-                                         color,
-                                         fOnApplyVertexShader))
+                // assemble the next polygon
+                if (!fOnAssemblePolygon(pContext,
+                                        0,
+                                        i,
+                                        i + pVB->m_Format.m_Stride))
                     return 0;
 
-                // draw the polygon
-                if (!csrRasterDrawPolygon(&polygon,
-                                           normal,
-                                           st,
-                                           color,
-                                           pMatrix,
-                                           zNear,
-                                           pVB->m_Culling.m_Type,
-                                           pVB->m_Culling.m_Face,
-                                          &screenRect,
-                                           pFB,
-                                           pDB,
-                                           fOnApplyFragmentShader))
-                    return 0;
-            }
-
             return 1;
         }
 
@@ -966,7 +1722,7 @@ int csrRasterDraw(const CSR_Matrix4*               pMatrix,
             const unsigned step = (pVB->m_Format.m_Stride * 4);
 
             // iterate through source vertices
-            for (i = 0; i < pVB->m_Count; i += step)
+            for (i = 0; i < length; i += step)
             {
                 // calculate vertices position
                 const unsigned v1 = (unsigned) i;
@@ -974,60 +1730,11 @@ int csrRasterDraw(const CSR_Matrix4*               pMatrix,
                 const unsigned v3 = (unsigned)(i + ((size_t)pVB->m_Format.m_Stride * 2));
                 const unsigned v4 = (unsigned)(i + ((size_t)pVB->m_Format.m_Stride * 3));
 
-                // get the next polygon to draw
-                if (!csrRasterGetPolygon(pMatrix,
-                                         v1,
-                                         v2,
-                                         v3,
-                                         pVB,
-                                        &polygon,
-                                         normal,
-                                         st,
-                                         color,
-                                         fOnApplyVertexShader))
-                    return 0;
-
-                // draw the polygon
-                if (!csrRasterDrawPolygon(&polygon,
-                                           normal,
-                                           st,
-                                           color,
-                                           pMatrix,
-                                           zNear,
-                                           pVB->m_Culling.m_Type,
-                                           pVB->m_Culling.m_Face,
-                                          &screenRect,
-                                           pFB,
-                                           pDB,
-                                           fOnApplyFragmentShader))
+                // assemble the next polygons
+                if (!fOnAssemblePolygon(pContext, v1, v2, v3))
                     return 0;
 
-                // get the next polygon to draw
-                if (!csrRasterGetPolygon(pMatrix,
-                                         v3,
-                                         v2,
-                                         v4,
-                                         pVB,
-                                        &polygon,
-                                         normal,
-                                         st,
-                                         color,
-                                         fOnApplyVertexShader))
-                    return 0;
-
-                // draw the polygon
-                if (!csrRasterDrawPolygon(&polygon,
-                                           normal,
-                                           st,
-                                           color,
-                                           pMatrix,
-                                           zNear,
-                                           pVB->m_Culling.m_Type,
-                                           pVB->m_Culling.m_Face,
-                                          &screenRect,
-                                           pFB,
-                                           pDB,
-                                           fOnApplyFragmentShader))
+                if (!fOnAssemblePolygon(pContext, v3, v2, v4))
                     return 0;
             }
 
@@ -1040,7 +1747,7 @@ int csrRasterDraw(const CSR_Matrix4*               pMatrix,
             const unsigned step = (pVB->m_Format.m_Stride * 2);
 
             // calculate length to read in triangle strip buffer
-            const unsigned stripLength = (unsigned)(pVB->m_Count - ((size_t)pVB->m_Format.m_Stride * 2));
+            const unsigned stripLength = (unsigned)(length - ((size_t)pVB->m_Format.m_Stride * 2));
 
             // iterate through source vertices
             for (i = 0; i < stripLength; i += step)
@@ -1051,60 +1758,11 @@ int csrRasterDraw(const CSR_Matrix4*               pMatrix,
                 const unsigned v3 = (unsigned)(i + ((size_t)pVB->m_Format.m_Stride * 2));
                 const unsigned v4 = (unsigned)(i + ((size_t)pVB->m_Format.m_Stride * 3));
 
-                // get the next polygon to draw
-                if (!csrRasterGetPolygon(pMatrix,
-                                         v1,
-                                         v2,
-                                         v3,
-                                         pVB,
-                                        &polygon,
-                                         normal,
-                                         st,
-                                         color,
-                                         fOnApplyVertexShader))
-                    return 0;
-
-                // draw the polygon
-                if (!csrRasterDrawPolygon(&polygon,
-                                           normal,
-                                           st,
-                                           color,
-                                           pMatrix,
-                                           zNear,
-                                           pVB->m_Culling.m_Type,
-                                           pVB->m_Culling.m_Face,
-                                          &screenRect,
-                                           pFB,
-                                           pDB,
-                                           fOnApplyFragmentShader))
-                    return 0;
-
-                // get the next polygon to draw
-                if (!csrRasterGetPolygon(pMatrix,
-                                         v3,
-                                         v2,
-                                         v4,
-                                         pVB,
-                                        &polygon,
-                                         normal,
-                                         st,
-                                         color,
-                                         fOnApplyVertexShader))
+                // assemble the next polygons
+                if (!fOnAssemblePolygon(pContext, v1, v2, v3))
                     return 0;
 
-                // draw the polygon
-                if (!csrRasterDrawPolygon(&polygon,
-                                           normal,
-                                           st,
-                                           color,
-                                           pMatrix,
-                                           zNear,
-                                           pVB->m_Culling.m_Type,
-                                           pVB->m_Culling.m_Face,
-                                          &screenRect,
-                                           pFB,
-                                           pDB,
-                                           fOnApplyFragmentShader))
+                if (!fOnAssemblePolygon(pContext, v3, v2, v4))
                     return 0;
             }
 
@@ -1116,3 +1774,863 @@ int csrRasterDraw(const CSR_Matrix4*               pMatrix,
     }
 }
 //---------------------------------------------------------------------------
+int csrRasterDrawVertexBuffer(const CSR_Matrix4*               pMatrix,
+                                    float                      zNear,
+                              const CSR_VertexBuffer*          pVB,
+                              const CSR_Rect*                  pScreenRect,
+                                    CSR_FrameBuffer*           pFB,
+                                    CSR_DepthBuffer*           pDB,
+                              const CSR_fOnApplyVertexShader   fOnApplyVertexShader,
+                              const CSR_fOnApplyFragmentShader fOnApplyFragmentShader,
+                              const void*                      pCustomData,
+                                    CSR_RasterTiles*           pTiles)
+{
+    CSR_RasterVertexCache cache;
+    CSR_RasterDrawContext context;
+
+    // prepare the post-transform vertex cache, thus the vertices shared by nearby polygons are
+    // only transformed once
+    csrRasterVertexCacheInit(pMatrix, zNear, pVB, pScreenRect, pFB, fOnApplyVertexShader, &cache);
+
+    context.m_pCache                 = &cache;
+    context.m_pFB                    =  pFB;
+    context.m_pDB                    =  pDB;
+    context.m_fOnApplyFragmentShader =  fOnApplyFragmentShader;
+    context.m_pCustomData            =  pCustomData;
+    context.m_pTiles                 =  pTiles;
+
+    // assemble and draw the polygons
+    return csrRasterAssemblePolygons(pVB, csrRasterDrawCachedPolygon, &context);
+}
+//---------------------------------------------------------------------------
+int csrRasterDraw(const CSR_Matrix4*               pMatrix,
+                        float                      zNear,
+                        float                      zFar,
+                  const CSR_VertexBuffer*          pVB,
+                  const CSR_Raster*                pRaster,
+                        CSR_FrameBuffer*           pFB,
+                        CSR_DepthBuffer*           pDB,
+                  const CSR_fOnApplyVertexShader   fOnApplyVertexShader,
+                  const CSR_fOnApplyFragmentShader fOnApplyFragmentShader,
+                  const void*                      pCustomData)
+{
+    CSR_Rect screenRect;
+
+    // the far clipping plane isn't used while drawing, the depth buffer is cleared with it instead
+    (void)zFar;
+
+    // validate the input
+    if (!pMatrix || !pVB || !pVB->m_Format.m_Stride || !pRaster || !pFB || !pDB)
+        return 0;
+
+    // get the raster screen coordinates
+    csrRasterGetScreenCoordinates(pRaster,
+                                  (float)pFB->m_Width,
+                                  (float)pFB->m_Height,
+                                  zNear,
+                                 &screenRect);
+
+    // draw the vertex buffer
+    return csrRasterDrawVertexBuffer(pMatrix,
+                                     zNear,
+                                     pVB,
+                                    &screenRect,
+                                     pFB,
+                                     pDB,
+                                     fOnApplyVertexShader,
+                                     fOnApplyFragmentShader,
+                                     pCustomData,
+                                     0);
+}
+//---------------------------------------------------------------------------
+CSR_RasterTiles* csrRasterTilesCreate(size_t tileSize, size_t threadCount)
+{
+    // create a tiled rasterizer
+    CSR_RasterTiles* pTiles = (CSR_RasterTiles*)malloc(sizeof(CSR_RasterTiles));
+
+    // succeeded?
+    if (!pTiles)
+        return 0;
+
+    // initialize the tiled rasterizer content
+    csrRasterTilesInit(tileSize, threadCount, pTiles);
+
+    return pTiles;
+}
+//---------------------------------------------------------------------------
+void csrRasterTilesInit(size_t tileSize, size_t threadCount, CSR_RasterTiles* pTiles)
+{
+    // no tiled rasterizer to initialize?
+    if (!pTiles)
+        return;
+
+    pTiles->m_pPolygon        = 0;
+    pTiles->m_PolygonCount    = 0;
+    pTiles->m_PolygonCapacity = 0;
+    pTiles->m_pTile           = 0;
+    pTiles->m_TileCapacity    = 0;
+    pTiles->m_TileCountX      = 0;
+    pTiles->m_TileCountY      = 0;
+    pTiles->m_TileSize        = tileSize ? tileSize : M_CSR_Raster_Default_Tile_Size;
+    pTiles->m_ThreadCount     = threadCount;
+    pTiles->m_pFB             = 0;
+    pTiles->m_pDB             = 0;
+}
+//---------------------------------------------------------------------------
+void csrRasterTilesRelease(CSR_RasterTiles* pTiles)
+{
+    size_t i;
+
+    // nothing to release?
+    if (!pTiles)
+        return;
+
+    // release the tiles
+    if (pTiles->m_pTile)
+    {
+        for (i = 0; i < pTiles->m_TileCapacity; ++i)
+            free(pTiles->m_pTile[i].m_pIndex);
+
+        free(pTiles->m_pTile);
+    }
+
+    // release the polygons
+    free(pTiles->m_pPolygon);
+
+    // release the tiled rasterizer
+    free(pTiles);
+}
+//---------------------------------------------------------------------------
+int csrRasterTilesBegin(CSR_RasterTiles* pTiles, CSR_FrameBuffer* pFB, CSR_DepthBuffer* pDB)
+{
+    size_t          i;
+    size_t          tileCountX;
+    size_t          tileCountY;
+    CSR_RasterTile* pTile;
+
+    // validate the input
+    if (!pTiles || !pTiles->m_TileSize || !pFB || !pFB->m_Width || !pFB->m_Height || !pDB)
+        return 0;
+
+    // calculate the tile count required to cover the frame buffer
+    tileCountX = (pFB->m_Width  + pTiles->m_TileSize - 1) / pTiles->m_TileSize;
+    tileCountY = (pFB->m_Height + pTiles->m_TileSize - 1) / pTiles->m_TileSize;
+
+    // add the missing tiles, if any
+    if (tileCountX * tileCountY > pTiles->m_TileCapacity)
+    {
+        pTile = (CSR_RasterTile*)csrMemoryAlloc(pTiles->m_pTile,
+                                                sizeof(CSR_RasterTile),
+                                                tileCountX * tileCountY);
+
+        // succeeded?
+        if (!pTile)
+            return 0;
+
+        // initialize the new tiles
+        for (i = pTiles->m_TileCapacity; i < tileCountX * tileCountY; ++i)
+        {
+            pTile[i].m_pIndex   = 0;
+            pTile[i].m_Capacity = 0;
+        }
+
+        pTiles->m_pTile        = pTile;
+        pTiles->m_TileCapacity = tileCountX * tileCountY;
+    }
+
+    // clear the previously queued polygons, if any. NOTE the allocated memory is kept for the
+    // next drawing
+    for (i = 0; i < pTiles->m_TileCapacity; ++i)
+        pTiles->m_pTile[i].m_Count = 0;
+
+    pTiles->m_PolygonCount = 0;
+    pTiles->m_TileCountX   = tileCountX;
+    pTiles->m_TileCountY   = tileCountY;
+    pTiles->m_pFB          = pFB;
+    pTiles->m_pDB          = pDB;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrRasterTilesDraw(const CSR_Matrix4*               pMatrix,
+                             float                      zNear,
+                       const CSR_VertexBuffer*          pVB,
+                       const CSR_Raster*                pRaster,
+                             CSR_RasterTiles*           pTiles,
+                       const CSR_fOnApplyVertexShader   fOnApplyVertexShader,
+                       const CSR_fOnApplyFragmentShader fOnApplyFragmentShader,
+                       const void*                      pCustomData)
+{
+    CSR_Rect screenRect;
+
+    // validate the input
+    if (!pMatrix || !pVB || !pVB->m_Format.m_Stride || !pRaster || !pTiles || !pTiles->m_pFB)
+        return 0;
+
+    // get the raster screen coordinates
+    csrRasterGetScreenCoordinates(pRaster,
+                                  (float)pTiles->m_pFB->m_Width,
+                                  (float)pTiles->m_pFB->m_Height,
+                                  zNear,
+                                 &screenRect);
+
+    // queue the vertex buffer polygons
+    return csrRasterDrawVertexBuffer(pMatrix,
+                                     zNear,
+                                     pVB,
+                                    &screenRect,
+                                     pTiles->m_pFB,
+                                     pTiles->m_pDB,
+                                     fOnApplyVertexShader,
+                                     fOnApplyFragmentShader,
+                                     pCustomData,
+                                     pTiles);
+}
+//---------------------------------------------------------------------------
+int csrRasterTilesEnd(CSR_RasterTiles* pTiles)
+{
+    size_t            i;
+    size_t            workerCount;
+    int               success;
+    CSR_RasterWorker  worker;
+    CSR_RasterWorker* pWorkers;
+
+    #if defined(CSR_RASTER_WIN32_THREADS)
+        HANDLE*    pThreads;
+    #elif defined(CSR_RASTER_POSIX_THREADS)
+        pthread_t* pThreads;
+        int*       pStarted;
+    #endif
+
+    // validate the input
+    if (!pTiles || !pTiles->m_pFB || !pTiles->m_pDB)
+        return 0;
+
+    // get the worker count, there is no need to have more workers than tiles
+    workerCount = csrRasterTilesGetThreadCount(pTiles);
+
+    if (workerCount > pTiles->m_TileCountX * pTiles->m_TileCountY)
+        workerCount = pTiles->m_TileCountX * pTiles->m_TileCountY;
+
+    pWorkers = 0;
+
+    // create the workers
+    if (workerCount > 1)
+        pWorkers = (CSR_RasterWorker*)csrMemoryAlloc(0, sizeof(CSR_RasterWorker), workerCount);
+
+    // only one worker, or not enough memory to create them?
+    if (!pWorkers)
+    {
+        // draw all the tiles on the calling thread
+        worker.m_pTiles  = pTiles;
+        worker.m_First   = 0;
+        worker.m_Step    = 1;
+        worker.m_Success = 1;
+        csrRasterTilesWork(&worker);
+
+        success = worker.m_Success;
+    }
+    else
+    {
+        // configure the workers. NOTE the tiles are interleaved between the workers, thus they
+        // all get a part of the busiest screen areas
+        for (i = 0; i < workerCount; ++i)
+        {
+            pWorkers[i].m_pTiles  = pTiles;
+            pWorkers[i].m_First   = i;
+            pWorkers[i].m_Step    = workerCount;
+            pWorkers[i].m_Success = 1;
+        }
+
+        #if defined(CSR_RASTER_WIN32_THREADS)
+            pThreads = (HANDLE*)csrMemoryAlloc(0, sizeof(HANDLE), workerCount);
+
+            // start the workers on their own thread. NOTE the first worker runs on the calling
+            // thread, and any worker whose thread cannot be started will run on it too
+            if (pThreads)
+                for (i = 1; i < workerCount; ++i)
+                    pThreads[i] = CreateThread(0, 0, csrRasterTilesThreadProc, &pWorkers[i], 0, 0);
+
+            csrRasterTilesWork(&pWorkers[0]);
+
+            // wait until the workers finish, or run them if their thread wasn't started
+            for (i = 1; i < workerCount; ++i)
+                if (pThreads && pThreads[i])
+                {
+                    WaitForSingleObject(pThreads[i], INFINITE);
+                    CloseHandle(pThreads[i]);
+                }
+                else
+                    csrRasterTilesWork(&pWorkers[i]);
+
+            free(pThreads);
+        #elif defined(CSR_RASTER_POSIX_THREADS)
+            pThreads = (pthread_t*)csrMemoryAlloc(0, sizeof(pthread_t), workerCount);
+            pStarted = (int*)      csrMemoryAlloc(0, sizeof(int),       workerCount);
+
+            // start the workers on their own thread. NOTE the first worker runs on the calling
+            // thread, and any worker whose thread cannot be started will run on it too
+            if (pThreads && pStarted)
+                for (i = 1; i < workerCount; ++i)
+                    pStarted[i] = !pthread_create(&pThreads[i], 0, csrRasterTilesThreadProc, &pWorkers[i]);
+
+            csrRasterTilesWork(&pWorkers[0]);
+
+            // wait until the workers finish, or run them if their thread wasn't started
+            for (i = 1; i < workerCount; ++i)
+                if (pThreads && pStarted && pStarted[i])
+                    pthread_join(pThreads[i], 0);
+                else
+                    csrRasterTilesWork(&pWorkers[i]);
+
+            free(pThreads);
+            free(pStarted);
+        #else
+            for (i = 0; i < workerCount; ++i)
+                csrRasterTilesWork(&pWorkers[i]);
+        #endif
+
+        success = 1;
+
+        for (i = 0; i < workerCount; ++i)
+            if (!pWorkers[i].m_Success)
+                success = 0;
+
+        free(pWorkers);
+    }
+
+    // the drawing is done
+    pTiles->m_PolygonCount = 0;
+    pTiles->m_pFB          = 0;
+    pTiles->m_pDB          = 0;
+
+    return success;
+}
+//---------------------------------------------------------------------------
+// Occlusion buffer functions
+//---------------------------------------------------------------------------
+CSR_OcclusionBuffer* csrOcclusionBufferCreate(size_t width, size_t height)
+{
+    // create an occlusion buffer
+    CSR_OcclusionBuffer* pOB = (CSR_OcclusionBuffer*)malloc(sizeof(CSR_OcclusionBuffer));
+
+    // succeeded?
+    if (!pOB)
+        return 0;
+
+    // initialize the occlusion buffer content
+    if (!csrOcclusionBufferInit(width, height, pOB))
+    {
+        csrOcclusionBufferRelease(pOB);
+        return 0;
+    }
+
+    return pOB;
+}
+//---------------------------------------------------------------------------
+int csrOcclusionBufferInit(size_t width, size_t height, CSR_OcclusionBuffer* pOB)
+{
+    size_t i;
+    size_t levelCount;
+    size_t levelWidth;
+    size_t levelHeight;
+
+    // validate the input
+    if (!pOB)
+        return 0;
+
+    pOB->m_pLevel     = 0;
+    pOB->m_LevelCount = 0;
+    csrMat4Identity(&pOB->m_Matrix);
+
+    // no pixel?
+    if (!width || !height)
+        return 0;
+
+    levelCount  = 1;
+    levelWidth  = width;
+    levelHeight = height;
+
+    // count the pyramid levels, until a single pixel covers the whole buffer
+    while (levelWidth > 1 || levelHeight > 1)
+    {
+        levelWidth  = (levelWidth  + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+        ++levelCount;
+    }
+
+    // create the pyramid levels
+    pOB->m_pLevel = (CSR_DepthBuffer*)malloc(levelCount * sizeof(CSR_DepthBuffer));
+
+    // succeeded?
+    if (!pOB->m_pLevel)
+        return 0;
+
+    levelWidth  = width;
+    levelHeight = height;
+
+    for (i = 0; i < levelCount; ++i)
+    {
+        // create the level depth data
+        if (!csrDepthBufferInit(levelWidth, levelHeight, &pOB->m_pLevel[i]))
+            return 0;
+
+        // nothing hides anything until the occluders are drawn
+        csrDepthBufferClear(&pOB->m_pLevel[i], M_CSR_Occlusion_Far);
+
+        ++pOB->m_LevelCount;
+
+        levelWidth  = (levelWidth  + 1) / 2;
+        levelHeight = (levelHeight + 1) / 2;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrOcclusionBufferRelease(CSR_OcclusionBuffer* pOB)
+{
+    size_t i;
+
+    // nothing to release?
+    if (!pOB)
+        return;
+
+    // release the pyramid levels
+    if (pOB->m_pLevel)
+    {
+        for (i = 0; i < pOB->m_LevelCount; ++i)
+            free(pOB->m_pLevel[i].m_pData);
+
+        free(pOB->m_pLevel);
+    }
+
+    // release the occlusion buffer
+    free(pOB);
+}
+//---------------------------------------------------------------------------
+int csrOcclusionBufferBegin(CSR_OcclusionBuffer* pOB, const CSR_Matrix4* pMatrix)
+{
+    // validate the input
+    if (!pOB || !pOB->m_LevelCount || !pMatrix)
+        return 0;
+
+    // keep the matrix the occluders will be drawn with
+    pOB->m_Matrix = *pMatrix;
+
+    // clear the buffer. NOTE only the first level is drawn, the others are built from it
+    csrDepthBufferClear(&pOB->m_pLevel[0], M_CSR_Occlusion_Far);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+void csrOcclusionTransform(const CSR_Matrix4* pMatrix, const float* pVertex, CSR_OcclusionVertex* pR)
+{
+    // transform the vertex in the clip space
+    pR->m_X = (pVertex[0] * pMatrix->m_Table[0][0]) +
+              (pVertex[1] * pMatrix->m_Table[1][0]) +
+              (pVertex[2] * pMatrix->m_Table[2][0]) +
+                            pMatrix->m_Table[3][0];
+    pR->m_Y = (pVertex[0] * pMatrix->m_Table[0][1]) +
+              (pVertex[1] * pMatrix->m_Table[1][1]) +
+              (pVertex[2] * pMatrix->m_Table[2][1]) +
+                            pMatrix->m_Table[3][1];
+    pR->m_Z = (pVertex[0] * pMatrix->m_Table[0][2]) +
+              (pVertex[1] * pMatrix->m_Table[1][2]) +
+              (pVertex[2] * pMatrix->m_Table[2][2]) +
+                            pMatrix->m_Table[3][2];
+    pR->m_W = (pVertex[0] * pMatrix->m_Table[0][3]) +
+              (pVertex[1] * pMatrix->m_Table[1][3]) +
+              (pVertex[2] * pMatrix->m_Table[2][3]) +
+                            pMatrix->m_Table[3][3];
+}
+//---------------------------------------------------------------------------
+const CSR_OcclusionVertex* csrOcclusionGetVertex(CSR_OcclusionDrawContext* pContext, size_t offset)
+{
+    size_t               index;
+    CSR_OcclusionVertex* pVertex;
+
+    // get the vertex data offset, in case the vertex buffer is indexed
+    offset = csrVertexBufferGetOffset(pContext->m_pVB, offset);
+    index  = offset / pContext->m_pVB->m_Format.m_Stride;
+
+    // is vertex out of bounds?
+    if (index >= pContext->m_Count)
+        return 0;
+
+    pVertex = &pContext->m_pVertex[index];
+
+    // transform the vertex, if not already done by a previous polygon
+    if (!pVertex->m_Transformed)
+    {
+        csrOcclusionTransform(&pContext->m_Matrix, &pContext->m_pVB->m_pData[offset], pVertex);
+        pVertex->m_Transformed = 1;
+    }
+
+    return pVertex;
+}
+//---------------------------------------------------------------------------
+void csrOcclusionFillPolygon(const CSR_Polygon3* pPolygon, CSR_DepthBuffer* pDB)
+{
+    size_t      x;
+    size_t      y;
+    size_t      x0;
+    size_t      y0;
+    size_t      x1;
+    size_t      y1;
+    size_t      offset;
+    float       xMin;
+    float       yMin;
+    float       xMax;
+    float       yMax;
+    float       area;
+    float       sign;
+    float       w0;
+    float       w1;
+    float       w2;
+    float       z;
+    CSR_Vector3 pixelSample;
+
+    // calculate the polygon area (multiplied by 2)
+    csrRasterFindEdge(&pPolygon->m_Vertex[0], &pPolygon->m_Vertex[1], &pPolygon->m_Vertex[2], &area);
+
+    // degenerated polygon?
+    if (!(area > 0.0f || area < 0.0f))
+        return;
+
+    // the occluders hide whatever their face is, so get the sign which makes the sub-areas positive
+    sign = area > 0.0f ? 1.0f : -1.0f;
+    area = area * sign;
+
+    // calculate the polygon bounding rect
+    csrRasterFindMin(pPolygon->m_Vertex[0].m_X, pPolygon->m_Vertex[1].m_X, pPolygon->m_Vertex[2].m_X, &xMin);
+    csrRasterFindMin(pPolygon->m_Vertex[0].m_Y, pPolygon->m_Vertex[1].m_Y, pPolygon->m_Vertex[2].m_Y, &yMin);
+    csrRasterFindMax(pPolygon->m_Vertex[0].m_X, pPolygon->m_Vertex[1].m_X, pPolygon->m_Vertex[2].m_X, &xMax);
+    csrRasterFindMax(pPolygon->m_Vertex[0].m_Y, pPolygon->m_Vertex[1].m_Y, pPolygon->m_Vertex[2].m_Y, &yMax);
+
+    // get the pixels whose center is inside the bounding rect
+    xMin -= 0.5f;
+    yMin -= 0.5f;
+    xMax -= 0.5f;
+    yMax -= 0.5f;
+
+    // is the polygon out of the buffer?
+    if (xMax < 0.0f || yMax < 0.0f || xMin > (float)(pDB->m_Width - 1) || yMin > (float)(pDB->m_Height - 1))
+        return;
+
+    x0 = xMin <= 0.0f ? 0 : (size_t)xMin;
+    y0 = yMin <= 0.0f ? 0 : (size_t)yMin;
+    x1 = xMax >= (float)(pDB->m_Width  - 1) ? pDB->m_Width  - 1 : (size_t)xMax;
+    y1 = yMax >= (float)(pDB->m_Height - 1) ? pDB->m_Height - 1 : (size_t)yMax;
+
+    if ((float)x0 < xMin)
+        ++x0;
+
+    if ((float)y0 < yMin)
+        ++y0;
+
+    pixelSample.m_Z = 0.0f;
+
+    // iterate through the pixels to draw
+    for (y = y0; y <= y1; ++y)
+    {
+        pixelSample.m_Y = y + 0.5f;
+
+        for (x = x0; x <= x1; ++x)
+        {
+            pixelSample.m_X = x + 0.5f;
+
+            // calculate the sub-triangle areas (multiplied by 2)
+            csrRasterFindEdge(&pPolygon->m_Vertex[1], &pPolygon->m_Vertex[2], &pixelSample, &w0);
+            csrRasterFindEdge(&pPolygon->m_Vertex[2], &pPolygon->m_Vertex[0], &pixelSample, &w1);
+            csrRasterFindEdge(&pPolygon->m_Vertex[0], &pPolygon->m_Vertex[1], &pixelSample, &w2);
+
+            w0 *= sign;
+            w1 *= sign;
+            w2 *= sign;
+
+            // is pixel center outside the polygon?
+            if (w0 < 0.0f || w1 < 0.0f || w2 < 0.0f)
+                continue;
+
+            // interpolate the pixel depth. NOTE the normalized device z coordinate is linear in
+            // the screen space, thus no perspective correction is required
+            z = ((pPolygon->m_Vertex[0].m_Z * w0) +
+                 (pPolygon->m_Vertex[1].m_Z * w1) +
+                 (pPolygon->m_Vertex[2].m_Z * w2)) / area;
+
+            offset = y * pDB->m_Width + x;
+
+            // keep the nearest occluder
+            if (z < pDB->m_pData[offset])
+                pDB->m_pData[offset] = z;
+        }
+    }
+}
+//---------------------------------------------------------------------------
+int csrOcclusionDrawPolygon(void* pContext, size_t v1Index, size_t v2Index, size_t v3Index)
+{
+    size_t                     i;
+    size_t                     count;
+    float                      dist;
+    float                      nextDist;
+    float                      t;
+    const CSR_OcclusionVertex* pVertex[3];
+    const CSR_OcclusionVertex* pNext;
+    CSR_OcclusionVertex        clipped[4];
+    CSR_Polygon3               polygon;
+    CSR_Vector3                screen[4];
+    CSR_OcclusionDrawContext*  pDrawContext = (CSR_OcclusionDrawContext*)pContext;
+    CSR_DepthBuffer*           pDB          = &pDrawContext->m_pOB->m_pLevel[0];
+
+    // get the polygon vertices, transforming them if not already done
+    pVertex[0] = csrOcclusionGetVertex(pDrawContext, v1Index);
+    pVertex[1] = csrOcclusionGetVertex(pDrawContext, v2Index);
+    pVertex[2] = csrOcclusionGetVertex(pDrawContext, v3Index);
+
+    if (!pVertex[0] || !pVertex[1] || !pVertex[2])
+        return 0;
+
+    count = 0;
+
+    // clip the polygon against the near plane, i.e. keep the part where z >= -w
+    for (i = 0; i < 3; ++i)
+    {
+        pNext    = pVertex[(i + 1) % 3];
+        dist     = pVertex[i]->m_Z + pVertex[i]->m_W;
+        nextDist = pNext->m_Z      + pNext->m_W;
+
+        if (dist >= 0.0f)
+            clipped[count++] = *pVertex[i];
+
+        // does the edge cross the near plane?
+        if ((dist >= 0.0f) != (nextDist >= 0.0f))
+        {
+            t = dist / (dist - nextDist);
+
+            clipped[count].m_X = pVertex[i]->m_X + ((pNext->m_X - pVertex[i]->m_X) * t);
+            clipped[count].m_Y = pVertex[i]->m_Y + ((pNext->m_Y - pVertex[i]->m_Y) * t);
+            clipped[count].m_Z = pVertex[i]->m_Z + ((pNext->m_Z - pVertex[i]->m_Z) * t);
+            clipped[count].m_W = pVertex[i]->m_W + ((pNext->m_W - pVertex[i]->m_W) * t);
+            ++count;
+        }
+    }
+
+    // is the polygon fully behind the near plane?
+    if (count < 3)
+        return 1;
+
+    // project the vertices on the buffer
+    for (i = 0; i < count; ++i)
+    {
+        // vertex behind the point of view? (NOTE may happen with an unusual projection)
+        if (clipped[i].m_W <= 0.0f)
+            return 1;
+
+        screen[i].m_X = ((clipped[i].m_X / clipped[i].m_W) * 0.5f + 0.5f) * (float)pDB->m_Width;
+        screen[i].m_Y = (0.5f - (clipped[i].m_Y / clipped[i].m_W) * 0.5f) * (float)pDB->m_Height;
+        screen[i].m_Z =   clipped[i].m_Z / clipped[i].m_W;
+    }
+
+    // draw the clipped polygon, which may have been split in 2 triangles
+    polygon.m_Vertex[0] = screen[0];
+    polygon.m_Vertex[1] = screen[1];
+    polygon.m_Vertex[2] = screen[2];
+    csrOcclusionFillPolygon(&polygon, pDB);
+
+    if (count == 4)
+    {
+        polygon.m_Vertex[1] = screen[2];
+        polygon.m_Vertex[2] = screen[3];
+        csrOcclusionFillPolygon(&polygon, pDB);
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrOcclusionBufferDraw(      CSR_OcclusionBuffer* pOB,
+                           const CSR_Matrix4*         pMatrix,
+                           const CSR_VertexBuffer*    pVB)
+{
+    int                      success;
+    CSR_OcclusionDrawContext context;
+
+    // validate the input
+    if (!pOB || !pOB->m_LevelCount || !pVB || !pVB->m_Format.m_Stride)
+        return 0;
+
+    context.m_pOB     = pOB;
+    context.m_pVB     = pVB;
+    context.m_pVertex = 0;
+    context.m_Count   = pVB->m_Count / pVB->m_Format.m_Stride;
+
+    // get the model view projection matrix
+    if (pMatrix)
+        csrMat4Multiply(pMatrix, &pOB->m_Matrix, &context.m_Matrix);
+    else
+        context.m_Matrix = pOB->m_Matrix;
+
+    // empty vertex buffer?
+    if (!context.m_Count)
+        return 1;
+
+    // create a slot for each unique vertex, all marked as not transformed yet
+    context.m_pVertex = (CSR_OcclusionVertex*)calloc(context.m_Count, sizeof(CSR_OcclusionVertex));
+
+    // succeeded?
+    if (!context.m_pVertex)
+        return 0;
+
+    // assemble and draw the polygons
+    success = csrRasterAssemblePolygons(pVB, csrOcclusionDrawPolygon, &context);
+
+    free(context.m_pVertex);
+
+    return success;
+}
+//---------------------------------------------------------------------------
+void csrOcclusionBufferEnd(CSR_OcclusionBuffer* pOB)
+{
+    size_t                 i;
+    size_t                 x;
+    size_t                 y;
+    size_t                 srcX;
+    size_t                 srcY;
+    size_t                 nextX;
+    size_t                 nextY;
+    float                  depth;
+    const CSR_DepthBuffer* pSrc;
+    CSR_DepthBuffer*       pDst;
+
+    // validate the input
+    if (!pOB)
+        return;
+
+    // build each pyramid level from the previous one
+    for (i = 1; i < pOB->m_LevelCount; ++i)
+    {
+        pSrc = &pOB->m_pLevel[i - 1];
+        pDst = &pOB->m_pLevel[i];
+
+        for (y = 0; y < pDst->m_Height; ++y)
+        {
+            srcY  = y * 2;
+            nextY = srcY + 1 < pSrc->m_Height ? srcY + 1 : srcY;
+
+            for (x = 0; x < pDst->m_Width; ++x)
+            {
+                srcX  = x * 2;
+                nextX = srcX + 1 < pSrc->m_Width ? srcX + 1 : srcX;
+
+                // keep the farthest depth of the 4 covered pixels
+                csrMathMax(pSrc->m_pData[srcY  * pSrc->m_Width + srcX],
+                           pSrc->m_pData[srcY  * pSrc->m_Width + nextX],
+                          &depth);
+                csrMathMax(pSrc->m_pData[nextY * pSrc->m_Width + srcX],  depth, &depth);
+                csrMathMax(pSrc->m_pData[nextY * pSrc->m_Width + nextX], depth, &depth);
+
+                pDst->m_pData[y * pDst->m_Width + x] = depth;
+            }
+        }
+    }
+}
+//---------------------------------------------------------------------------
+int csrOcclusionBufferBoxVisible(const CSR_OcclusionBuffer* pOB, const CSR_Box* pBox)
+{
+    size_t                 i;
+    size_t                 x;
+    size_t                 y;
+    size_t                 x0;
+    size_t                 y0;
+    size_t                 x1;
+    size_t                 y1;
+    size_t                 level;
+    float                  corner[3];
+    float                  screenX;
+    float                  screenY;
+    float                  z;
+    float                  xMin;
+    float                  yMin;
+    float                  xMax;
+    float                  yMax;
+    float                  zMin;
+    const CSR_DepthBuffer* pDB;
+    CSR_OcclusionVertex    vertex;
+
+    // no occlusion buffer? (NOTE in this case nothing is hidden)
+    if (!pOB || !pOB->m_LevelCount || !pBox)
+        return 1;
+
+    pDB  = &pOB->m_pLevel[0];
+    xMin =  0.0f;
+    yMin =  0.0f;
+    xMax =  0.0f;
+    yMax =  0.0f;
+    zMin =  0.0f;
+
+    // project the box corners on the buffer, and get the screen rect and nearest depth they cover
+    for (i = 0; i < 8; ++i)
+    {
+        corner[0] = (i & 1) ? pBox->m_Max.m_X : pBox->m_Min.m_X;
+        corner[1] = (i & 2) ? pBox->m_Max.m_Y : pBox->m_Min.m_Y;
+        corner[2] = (i & 4) ? pBox->m_Max.m_Z : pBox->m_Min.m_Z;
+
+        csrOcclusionTransform(&pOB->m_Matrix, corner, &vertex);
+
+        // does the box cross the near plane? (NOTE the occluders cannot be in front of it)
+        if (vertex.m_Z + vertex.m_W < 0.0f || vertex.m_W <= 0.0f)
+            return 1;
+
+        screenX = ((vertex.m_X / vertex.m_W) * 0.5f + 0.5f) * (float)pDB->m_Width;
+        screenY = (0.5f - (vertex.m_Y / vertex.m_W) * 0.5f) * (float)pDB->m_Height;
+        z       =   vertex.m_Z / vertex.m_W;
+
+        if (!i)
+        {
+            xMin = screenX;
+            yMin = screenY;
+            xMax = screenX;
+            yMax = screenY;
+            zMin = z;
+            continue;
+        }
+
+        csrMathMin(xMin, screenX, &xMin);
+        csrMathMin(yMin, screenY, &yMin);
+        csrMathMax(xMax, screenX, &xMax);
+        csrMathMax(yMax, screenY, &yMax);
+        csrMathMin(zMin, z,       &zMin);
+    }
+
+    // is the box out of the buffer? (NOTE the frustum culling should reject it)
+    if (!(xMax >= 0.0f && yMax >= 0.0f && xMin < (float)pDB->m_Width && yMin < (float)pDB->m_Height))
+        return 1;
+
+    // get the pixels the box covers
+    x0 = xMin <= 0.0f ? 0 : (size_t)xMin;
+    y0 = yMin <= 0.0f ? 0 : (size_t)yMin;
+    x1 = xMax >= (float)(pDB->m_Width  - 1) ? pDB->m_Width  - 1 : (size_t)xMax;
+    y1 = yMax >= (float)(pDB->m_Height - 1) ? pDB->m_Height - 1 : (size_t)yMax;
+
+    level = 0;
+
+    // search for the first level on which the box covers only a few pixels
+    while (level + 1 < pOB->m_LevelCount &&
+          (((x1 >> level) - (x0 >> level)) >= M_CSR_Occlusion_Max_Test_Size ||
+           ((y1 >> level) - (y0 >> level)) >= M_CSR_Occlusion_Max_Test_Size))
+        ++level;
+
+    pDB = &pOB->m_pLevel[level];
+    x0 >>= level;
+    y0 >>= level;
+    x1 >>= level;
+    y1 >>= level;
+
+    // the box may be visible if it's in front of any occluder pixel it covers
+    for (y = y0; y <= y1; ++y)
+        for (x = x0; x <= x1; ++x)
+            if (zMin <= pDB->m_pData[y * pDB->m_Width + x])
+                return 1;
+
+    return 0;
+}
+//---------------------------------------------------------------------------
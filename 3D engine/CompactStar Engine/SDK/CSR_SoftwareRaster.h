@@ -114,13 +114,83 @@ typedef void (*CSR_fOnApplyVertexShader)(const CSR_Matrix4* pMatrix,
 *@param pSampler - sampler items (x = w0, y = w1, z = w2)
 *@param z - pixel z order
 *@param[in, out] pColor - pixel color
+*@param pCustomData - custom data passed with the drawn vertex buffer, 0 if not used
 */
 typedef void (*CSR_fOnApplyFragmentShader)(const CSR_Matrix4*  pMatrix,
                                            const CSR_Polygon3* pPolygon,
                                            const CSR_Vector2*  pST,
                                            const CSR_Vector3*  pSampler,
                                                  float         z,
-                                                 CSR_Color*    pColor);
+                                                 CSR_Color*    pColor,
+                                           const void*         pCustomData);
+
+//---------------------------------------------------------------------------
+// Tiled raster structures
+//---------------------------------------------------------------------------
+
+/**
+* Polygon rasterized and ready to be drawn in the frame buffer
+*/
+typedef struct
+{
+    CSR_Polygon3               m_Polygon;                // source polygon, passed to the fragment shader
+    CSR_Polygon3               m_RasterPoly;             // polygon in raster space, with inverted z coordinates
+    CSR_Vector2                m_ST[3];                  // texture coordinates, divided by their vertex z coordinate
+    CSR_Color                  m_Color[3];               // per-vertex colors
+    float                      m_Area;                   // polygon area, multiplied by 2
+    int                        m_CullingMode;            // 0 = CW, 1 = CCW, 2 = both
+    size_t                     m_X0;                     // bounding rect left pixel
+    size_t                     m_Y0;                     // bounding rect top pixel
+    size_t                     m_X1;                     // bounding rect right pixel, included
+    size_t                     m_Y1;                     // bounding rect bottom pixel, included
+    const CSR_Matrix4*         m_pMatrix;
+    CSR_fOnApplyFragmentShader m_fOnApplyFragmentShader;
+    const void*                m_pCustomData;            // custom data passed to the fragment shader
+} CSR_RasterPolygon;
+
+/**
+* Raster tile, i.e. a square screen area and the polygons overlapping it
+*/
+typedef struct
+{
+    size_t* m_pIndex;   // polygons to draw in the tile, in the drawing order
+    size_t  m_Count;
+    size_t  m_Capacity;
+} CSR_RasterTile;
+
+/**
+* Tiled rasterizer, which draws each screen tile on its own thread
+*/
+typedef struct
+{
+    CSR_RasterPolygon* m_pPolygon;        // polygons to draw, queued since the drawing began
+    size_t             m_PolygonCount;
+    size_t             m_PolygonCapacity;
+    CSR_RasterTile*    m_pTile;           // screen tiles, from left to right and top to bottom
+    size_t             m_TileCapacity;
+    size_t             m_TileCountX;      // tile count on the screen width
+    size_t             m_TileCountY;      // tile count on the screen height
+    size_t             m_TileSize;        // tile width and height, in pixels
+    size_t             m_ThreadCount;     // threads drawing the tiles, 0 to use one thread per processor
+    CSR_FrameBuffer*   m_pFB;             // frame buffer in which the scene is drawn, 0 if not drawing
+    CSR_DepthBuffer*   m_pDB;             // depth buffer used for depth checking, 0 if not drawing
+} CSR_RasterTiles;
+
+//---------------------------------------------------------------------------
+// Occlusion structures
+//---------------------------------------------------------------------------
+
+/**
+* Occlusion buffer, i.e. a low resolution depth pyramid in which the occluders are drawn, and
+* against which the objects they may hide are tested
+*@note The depths are the normalized device z coordinates, between -1 (near) and 1 (far)
+*/
+typedef struct
+{
+    CSR_DepthBuffer* m_pLevel;     // pyramid levels, each level is half as large as the previous one and keeps the farthest depth of the pixels it covers
+    size_t           m_LevelCount;
+    CSR_Matrix4      m_Matrix;     // view projection matrix the occluders are drawn with
+} CSR_OcclusionBuffer;
 
 #ifdef __cplusplus
     extern "C"
@@ -281,6 +351,8 @@ typedef void (*CSR_fOnApplyFragmentShader)(const CSR_Matrix4*  pMatrix,
         *@param[out] pColor - polygon per-vertex colors (array of 3 items)
         *@param fOnApplyVertexShader - vertex shader callback
         *@return 1 on success, otherwise 0
+        *@note The vertex indices are the data offsets in the vertex buffer drawing order. If the
+        *      vertex buffer is indexed, they are resolved through its index buffer
         */
         int csrRasterGetPolygon(const CSR_Matrix4*             pMatrix,
                                       size_t                   v1Index,
@@ -307,6 +379,7 @@ typedef void (*CSR_fOnApplyFragmentShader)(const CSR_Matrix4*  pMatrix,
         *@param[in, out] pFB - frame buffer in which the scene will be drawn
         *@param[in, out] pDB - depth buffer to use for depth checking
         *@param fOnApplyFragmentShader - fragment shader callback
+        *@param pCustomData - custom data to send to fOnApplyFragmentShader, 0 if not used
         *@return 1 on success, otherwise 0
         */
         int csrRasterDrawPolygon(const CSR_Polygon3*              pPolygon,
@@ -320,7 +393,8 @@ typedef void (*CSR_fOnApplyFragmentShader)(const CSR_Matrix4*  pMatrix,
                                  const CSR_Rect*                  pScreenRect,
                                        CSR_FrameBuffer*           pFB,
                                        CSR_DepthBuffer*           pDB,
-                                 const CSR_fOnApplyFragmentShader fOnApplyFragmentShader);
+                                 const CSR_fOnApplyFragmentShader fOnApplyFragmentShader,
+                                 const void*                      pCustomData);
 
         /**
         * Draws a vertex buffer
@@ -333,7 +407,11 @@ typedef void (*CSR_fOnApplyFragmentShader)(const CSR_Matrix4*  pMatrix,
         *@param[in, out] pDB - depth buffer to use for depth checking
         *@param fOnApplyVertexShader - vertex shader callback
         *@param fOnApplyFragmentShader - fragment shader callback
+        *@param pCustomData - custom data to send to fOnApplyFragmentShader, 0 if not used
         *@return 1 on success, otherwise 0
+        *@note The last transformed vertices are cached, thus a vertex shared by nearby polygons is
+        *      usually transformed once. The vertex shader may however be called several times for
+        *      the same vertex, and its result should only depend on its input
         */
         int csrRasterDraw(const CSR_Matrix4*               pMatrix,
                                 float                      zNear,
@@ -343,7 +421,145 @@ typedef void (*CSR_fOnApplyFragmentShader)(const CSR_Matrix4*  pMatrix,
                                 CSR_FrameBuffer*           pFB,
                                 CSR_DepthBuffer*           pDB,
                           const CSR_fOnApplyVertexShader   fOnApplyVertexShader,
-                          const CSR_fOnApplyFragmentShader fOnApplyFragmentShader);
+                          const CSR_fOnApplyFragmentShader fOnApplyFragmentShader,
+                          const void*                      pCustomData);
+
+        //-------------------------------------------------------------------
+        // Tiled raster functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates a tiled rasterizer
+        *@param tileSize - tile width and height in pixels, if 0 a default size will be used
+        *@param threadCount - number of threads drawing the tiles, if 0 one thread per processor
+        *                     will be used
+        *@return newly created tiled rasterizer, 0 on error
+        *@note The tiled rasterizer must be released when no longer used, see csrRasterTilesRelease()
+        */
+        CSR_RasterTiles* csrRasterTilesCreate(size_t tileSize, size_t threadCount);
+
+        /**
+        * Initializes a tiled rasterizer
+        *@param tileSize - tile width and height in pixels, if 0 a default size will be used
+        *@param threadCount - number of threads drawing the tiles, if 0 one thread per processor
+        *                     will be used
+        *@param[in, out] pTiles - tiled rasterizer to initialize
+        */
+        void csrRasterTilesInit(size_t tileSize, size_t threadCount, CSR_RasterTiles* pTiles);
+
+        /**
+        * Releases a tiled rasterizer
+        *@param[in, out] pTiles - tiled rasterizer to release
+        */
+        void csrRasterTilesRelease(CSR_RasterTiles* pTiles);
+
+        /**
+        * Begins to draw with a tiled rasterizer
+        *@param[in, out] pTiles - tiled rasterizer
+        *@param pFB - frame buffer in which the scene will be drawn
+        *@param pDB - depth buffer to use for depth checking
+        *@return 1 on success, otherwise 0
+        */
+        int csrRasterTilesBegin(CSR_RasterTiles* pTiles, CSR_FrameBuffer* pFB, CSR_DepthBuffer* pDB);
+
+        /**
+        * Queues a vertex buffer to draw with a tiled rasterizer
+        *@param pMatrix - matrix
+        *@param zNear - near clipping plane value
+        *@param pVB - vertex buffer to draw
+        *@aram pRaster - raster options
+        *@param[in, out] pTiles - tiled rasterizer, on which csrRasterTilesBegin() was called
+        *@param fOnApplyVertexShader - vertex shader callback
+        *@param fOnApplyFragmentShader - fragment shader callback
+        *@param pCustomData - custom data to send to fOnApplyFragmentShader, 0 if not used
+        *@return 1 on success, otherwise 0
+        *@note The vertex shader is applied immediately, but the polygons are only drawn when
+        *      csrRasterTilesEnd() is called, thus the matrix and the custom data should remain
+        *      valid until then
+        */
+        int csrRasterTilesDraw(const CSR_Matrix4*               pMatrix,
+                                     float                      zNear,
+                               const CSR_VertexBuffer*          pVB,
+                               const CSR_Raster*                pRaster,
+                                     CSR_RasterTiles*           pTiles,
+                               const CSR_fOnApplyVertexShader   fOnApplyVertexShader,
+                               const CSR_fOnApplyFragmentShader fOnApplyFragmentShader,
+                               const void*                      pCustomData);
+
+        /**
+        * Ends to draw with a tiled rasterizer, and draws all the queued polygons
+        *@param[in, out] pTiles - tiled rasterizer
+        *@return 1 on success, otherwise 0
+        *@note The result is the same as if the vertex buffers were drawn with csrRasterDraw(), but
+        *      the tiles are drawn in parallel, thus the fragment shader may be called from several
+        *      threads at once. If it isn't thread-safe, the thread count should be set to 1
+        */
+        int csrRasterTilesEnd(CSR_RasterTiles* pTiles);
+
+        //-------------------------------------------------------------------
+        // Occlusion buffer functions
+        //-------------------------------------------------------------------
+
+        /**
+        * Creates an occlusion buffer
+        *@param width - occlusion buffer width in pixels
+        *@param height - occlusion buffer height in pixels
+        *@return newly created occlusion buffer, 0 on error
+        *@note The occlusion buffer must be released when no longer used, see csrOcclusionBufferRelease()
+        *@note A low resolution, e.g. 256x128, is generally enough to cull the hidden objects
+        */
+        CSR_OcclusionBuffer* csrOcclusionBufferCreate(size_t width, size_t height);
+
+        /**
+        * Initializes an occlusion buffer
+        *@param width - occlusion buffer width in pixels
+        *@param height - occlusion buffer height in pixels
+        *@param[in, out] pOB - occlusion buffer to initialize
+        *@return 1 on success, otherwise 0
+        */
+        int csrOcclusionBufferInit(size_t width, size_t height, CSR_OcclusionBuffer* pOB);
+
+        /**
+        * Releases an occlusion buffer
+        *@param[in, out] pOB - occlusion buffer to release
+        */
+        void csrOcclusionBufferRelease(CSR_OcclusionBuffer* pOB);
+
+        /**
+        * Begins to draw the occluders in an occlusion buffer, and clears it
+        *@param[in, out] pOB - occlusion buffer
+        *@param pMatrix - view projection matrix, i.e. the view matrix multiplied by the projection matrix
+        *@return 1 on success, otherwise 0
+        */
+        int csrOcclusionBufferBegin(CSR_OcclusionBuffer* pOB, const CSR_Matrix4* pMatrix);
+
+        /**
+        * Draws an occluder in an occlusion buffer
+        *@param[in, out] pOB - occlusion buffer, on which csrOcclusionBufferBegin() was called
+        *@param pMatrix - occluder model matrix, if 0 the occluder is drawn in its own coordinates system
+        *@param pVB - occluder vertex buffer to draw
+        *@return 1 on success, otherwise 0
+        *@note The occluder faces are drawn whatever their culling, and only cover the pixels whose
+        *      center they contain
+        */
+        int csrOcclusionBufferDraw(      CSR_OcclusionBuffer* pOB,
+                                   const CSR_Matrix4*         pMatrix,
+                                   const CSR_VertexBuffer*    pVB);
+
+        /**
+        * Ends to draw the occluders in an occlusion buffer, and builds its depth pyramid
+        *@param[in, out] pOB - occlusion buffer
+        */
+        void csrOcclusionBufferEnd(CSR_OcclusionBuffer* pOB);
+
+        /**
+        * Checks if a box may be visible, or is hidden by the occluders
+        *@param pOB - occlusion buffer, on which csrOcclusionBufferEnd() was called
+        *@param pBox - box to check, in the coordinates system the view projection matrix applies to
+        *@return 1 if the box may be visible, 0 if it's hidden by the occluders
+        *@note The boxes crossing the near plane or out of the screen are always considered as visible
+        */
+        int csrOcclusionBufferBoxVisible(const CSR_OcclusionBuffer* pOB, const CSR_Box* pBox);
 
 #ifdef __cplusplus
     }
@@ -17,6 +17,7 @@
 
 // std
 #include <stdlib.h>
+#include <string.h>
 
 //---------------------------------------------------------------------------
 // Line functions
@@ -109,6 +110,62 @@ void csrVertexCullingInit(CSR_VertexCulling* pVertexCulling)
     pVertexCulling->m_Face = CSR_CF_CCW;
 }
 //---------------------------------------------------------------------------
+// Vertex buffer private functions
+//---------------------------------------------------------------------------
+int csrVertexBufferGrow(size_t count, CSR_VertexBuffer* pVB)
+{
+    size_t required;
+    size_t capacity;
+    float* pNewData;
+
+    // calculate the required size
+    required = pVB->m_Count + count;
+
+    // is the vertex buffer already large enough?
+    if (pVB->m_pData && required <= pVB->m_Capacity)
+        return 1;
+
+    // grow the capacity geometrically, thus adding many vertices doesn't realloc on each of them
+    capacity = pVB->m_Capacity ? pVB->m_Capacity : (size_t)pVB->m_Format.m_Stride * 16;
+
+    if (!capacity)
+        capacity = required;
+
+    while (capacity < required)
+        capacity *= 2;
+
+    // allocate memory for the new capacity
+    pNewData = (float*)csrMemoryAlloc(pVB->m_pData, sizeof(float), capacity);
+
+    // succeeded?
+    if (!pNewData)
+        return 0;
+
+    pVB->m_pData    = pNewData;
+    pVB->m_Capacity = capacity;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+size_t csrVertexBufferHashVertex(const float* pVertex, size_t stride)
+{
+    size_t   i;
+    size_t   hash = 2166136261u;
+    unsigned value;
+
+    // calculate the vertex hash (FNV-1a, applied on each value bits) from its whole content
+    for (i = 0; i < stride; ++i)
+    {
+        memcpy(&value, &pVertex[i], sizeof(unsigned));
+
+        hash ^= value;
+        hash *= 16777619u;
+    }
+
+    // mix the highest bits with the lowest ones, which will be used to select a slot
+    return hash ^ (hash >> 15);
+}
+//---------------------------------------------------------------------------
 // Vertex buffer functions
 //---------------------------------------------------------------------------
 CSR_VertexBuffer* csrVertexBufferCreate(void)
@@ -136,6 +193,10 @@ void csrVertexBufferRelease(CSR_VertexBuffer* pVB)
     if (pVB->m_pData)
         free(pVB->m_pData);
 
+    // free the vertex indices
+    if (pVB->m_Index.m_pData)
+        free(pVB->m_Index.m_pData);
+
     // free the vertex buffer
     free(pVB);
 }
@@ -156,9 +217,13 @@ void csrVertexBufferInit(CSR_VertexBuffer* pVB)
     csrMaterialInit(&pVB->m_Material);
 
     // initialize the vertex buffer content
-    pVB->m_pData = 0;
-    pVB->m_Count = 0;
-    pVB->m_Time  = 0.0;
+    pVB->m_pData          = 0;
+    pVB->m_Count          = 0;
+    pVB->m_Capacity       = 0;
+    pVB->m_Index.m_Format = CSR_IF_16Bit;
+    pVB->m_Index.m_pData  = 0;
+    pVB->m_Index.m_Count  = 0;
+    pVB->m_Time           = 0.0;
 }
 //---------------------------------------------------------------------------
 int csrVertexBufferAdd(const CSR_Vector3*          pVertex,
@@ -169,23 +234,16 @@ int csrVertexBufferAdd(const CSR_Vector3*          pVertex,
                              CSR_VertexBuffer*     pVB)
 {
     size_t offset;
-    float* pNewData;
 
     // no vertex buffer to add to?
     if (!pVB)
         return 0;
 
     // allocate memory for the new vertex
-    pNewData = (float*)csrMemoryAlloc(pVB->m_pData,
-                                      sizeof(float),
-                                      pVB->m_Count + pVB->m_Format.m_Stride);
-
-    // succeeded?
-    if (!pNewData)
+    if (!csrVertexBufferGrow(pVB->m_Format.m_Stride, pVB))
         return 0;
 
-    pVB->m_pData = pNewData;
-    offset       = pVB->m_Count;
+    offset = pVB->m_Count;
 
     // source vertex exists?
     if (!pVertex)
@@ -293,6 +351,276 @@ int csrVertexBufferAdd(const CSR_Vector3*          pVertex,
     return 1;
 }
 //---------------------------------------------------------------------------
+int csrVertexBufferReserve(size_t count, CSR_VertexBuffer* pVB)
+{
+    size_t capacity;
+    float* pNewData;
+
+    // no vertex buffer to reserve for?
+    if (!pVB)
+        return 0;
+
+    // calculate the capacity to reserve
+    capacity = count * pVB->m_Format.m_Stride;
+
+    // is the vertex buffer already large enough?
+    if (!capacity || (pVB->m_pData && capacity <= pVB->m_Capacity))
+        return 1;
+
+    // allocate memory for the vertices
+    pNewData = (float*)csrMemoryAlloc(pVB->m_pData, sizeof(float), capacity);
+
+    // succeeded?
+    if (!pNewData)
+        return 0;
+
+    pVB->m_pData    = pNewData;
+    pVB->m_Capacity = capacity;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrVertexBufferWeldFrames(CSR_VertexBuffer** ppVB, size_t count)
+{
+    size_t          i;
+    size_t          j;
+    size_t          slot;
+    size_t          slotCount;
+    size_t          stride;
+    size_t          dataCount;
+    size_t          vertexCount;
+    size_t          uniqueCount;
+    size_t*         pSlot;
+    unsigned short* pIndices;
+    void**          ppFrameIndices;
+    float*          pNewData;
+    int             identical;
+
+    // validate the input
+    if (!ppVB || !count || !ppVB[0])
+        return 0;
+
+    stride    = ppVB[0]->m_Format.m_Stride;
+    dataCount = ppVB[0]->m_Count;
+
+    // nothing to weld?
+    if (!stride || dataCount < stride * 2)
+        return 1;
+
+    // all the frames should share the same layout, and not be already indexed
+    for (i = 0; i < count; ++i)
+    {
+        if (!ppVB[i])
+            return 0;
+
+        if (!ppVB[i]->m_pData                        ||
+             ppVB[i]->m_Format.m_Stride != stride    ||
+             ppVB[i]->m_Count           != dataCount ||
+             ppVB[i]->m_Index.m_pData)
+            return 1;
+    }
+
+    vertexCount = dataCount / stride;
+
+    // keep the hash table at most half full
+    slotCount = 16;
+
+    while (slotCount < vertexCount * 2)
+        slotCount *= 2;
+
+    // create the hash table, each slot contains the index + 1 of a unique vertex, 0 if empty
+    pSlot = (size_t*)csrMemoryAlloc(0, sizeof(size_t), slotCount);
+
+    // succeeded?
+    if (!pSlot)
+        return 0;
+
+    memset(pSlot, 0, sizeof(size_t) * slotCount);
+
+    // create the vertex indices
+    pIndices = (unsigned short*)csrMemoryAlloc(0, sizeof(unsigned short), vertexCount);
+
+    // succeeded?
+    if (!pIndices)
+    {
+        free(pSlot);
+        return 0;
+    }
+
+    uniqueCount = 0;
+
+    // iterate through vertices and search for the identical ones. NOTE the vertices are hashed
+    // on the first frame only, identical vertices have the same content there anyway
+    for (i = 0; i < vertexCount; ++i)
+    {
+        slot = csrVertexBufferHashVertex(&ppVB[0]->m_pData[i * stride], stride) & (slotCount - 1);
+
+        // search for a vertex which was already found, and which is identical in every frame
+        while (pSlot[slot])
+        {
+            identical = 1;
+
+            for (j = 0; j < count; ++j)
+                if (memcmp(&ppVB[j]->m_pData[(pSlot[slot] - 1) * stride],
+                           &ppVB[j]->m_pData[i * stride],
+                            stride * sizeof(float)))
+                {
+                    identical = 0;
+                    break;
+                }
+
+            if (identical)
+                break;
+
+            slot = (slot + 1) & (slotCount - 1);
+        }
+
+        // found it?
+        if (pSlot[slot])
+        {
+            pIndices[i] = pIndices[pSlot[slot] - 1];
+            continue;
+        }
+
+        // no, the vertex is unique. NOTE the indices are limited to 16 bit, because the 32 bit
+        // indices aren't supported by OpenGL ES 2.0 without the OES_element_index_uint extension,
+        // so the vertices remain unindexed if they cannot be referenced on 16 bit
+        if (uniqueCount > 0xFFFF)
+        {
+            free(pSlot);
+            free(pIndices);
+            return 1;
+        }
+
+        pSlot[slot] = i + 1;
+        pIndices[i] = (unsigned short)uniqueCount;
+        ++uniqueCount;
+    }
+
+    free(pSlot);
+
+    // do nothing if the welding doesn't save memory
+    if ((vertexCount - uniqueCount) * stride * sizeof(float) <= vertexCount * sizeof(unsigned short))
+    {
+        free(pIndices);
+        return 1;
+    }
+
+    // create the index buffer of each frame before any frame is modified, thus the frames remain
+    // unchanged if the memory is missing
+    ppFrameIndices = (void**)csrMemoryAlloc(0, sizeof(void*), count);
+
+    // succeeded?
+    if (!ppFrameIndices)
+    {
+        free(pIndices);
+        return 0;
+    }
+
+    for (j = 0; j < count; ++j)
+    {
+        ppFrameIndices[j] = csrMemoryAlloc(0, sizeof(unsigned short), vertexCount);
+
+        // succeeded?
+        if (!ppFrameIndices[j])
+        {
+            for (i = 0; i < j; ++i)
+                free(ppFrameIndices[i]);
+
+            free(ppFrameIndices);
+            free(pIndices);
+            return 0;
+        }
+
+        // each frame owns a copy of the same indices
+        memcpy(ppFrameIndices[j], pIndices, vertexCount * sizeof(unsigned short));
+    }
+
+    for (j = 0; j < count; ++j)
+    {
+        CSR_VertexBuffer* pVB = ppVB[j];
+
+        // move each unique vertex to its welded position. NOTE the unique vertices keep their
+        // order and the welded position is never after the source one, so the data may be moved
+        // in place
+        for (i = 0, uniqueCount = 0; i < vertexCount; ++i)
+            if (pIndices[i] == uniqueCount)
+            {
+                if (uniqueCount != i)
+                    memcpy(&pVB->m_pData[uniqueCount * stride],
+                           &pVB->m_pData[i           * stride],
+                            stride * sizeof(float));
+
+                ++uniqueCount;
+            }
+
+        pVB->m_Index.m_Format = CSR_IF_16Bit;
+        pVB->m_Index.m_pData  = ppFrameIndices[j];
+        pVB->m_Index.m_Count  = vertexCount;
+
+        // update the vertex count
+        pVB->m_Count = uniqueCount * stride;
+
+        // release the memory no longer used
+        pNewData = (float*)csrMemoryAlloc(pVB->m_pData, sizeof(float), pVB->m_Count);
+
+        // succeeded? (if not the previous memory is kept)
+        if (pNewData)
+        {
+            pVB->m_pData    = pNewData;
+            pVB->m_Capacity = pVB->m_Count;
+        }
+    }
+
+    free(ppFrameIndices);
+    free(pIndices);
+
+    return 1;
+}
+//---------------------------------------------------------------------------
+int csrVertexBufferWeld(CSR_VertexBuffer* pVB)
+{
+    // validate the input
+    if (!pVB)
+        return 0;
+
+    // a single vertex buffer is welded as an animation containing only one frame
+    return csrVertexBufferWeldFrames(&pVB, 1);
+}
+//---------------------------------------------------------------------------
+size_t csrVertexBufferGetVertexCount(const CSR_VertexBuffer* pVB)
+{
+    // validate the input
+    if (!pVB || !pVB->m_Format.m_Stride)
+        return 0;
+
+    // is vertex buffer indexed?
+    if (pVB->m_Index.m_pData)
+        return pVB->m_Index.m_Count;
+
+    return pVB->m_Count / pVB->m_Format.m_Stride;
+}
+//---------------------------------------------------------------------------
+size_t csrVertexBufferGetOffset(const CSR_VertexBuffer* pVB, size_t offset)
+{
+    size_t index;
+
+    // not indexed? (in this case the offset is already the data offset)
+    if (!pVB || !pVB->m_Index.m_pData || !pVB->m_Format.m_Stride)
+        return offset;
+
+    // get the index position
+    index = offset / pVB->m_Format.m_Stride;
+
+    // get the vertex index and convert it to a data offset
+    if (pVB->m_Index.m_Format == CSR_IF_16Bit)
+        index = ((const unsigned short*)pVB->m_Index.m_pData)[index];
+    else
+        index = ((const unsigned*)pVB->m_Index.m_pData)[index];
+
+    return (index * pVB->m_Format.m_Stride) + (offset % pVB->m_Format.m_Stride);
+}
+//---------------------------------------------------------------------------
 // Mesh functions
 //---------------------------------------------------------------------------
 CSR_Mesh* csrMeshCreate(void)
@@ -326,9 +654,14 @@ void csrMeshRelease(CSR_Mesh* pMesh, const CSR_fOnDeleteTexture fOnDeleteTexture
     {
         // free the static mesh vertex buffer content
         for (i = 0; i < pMesh->m_Count; ++i)
+        {
             if (pMesh->m_pVB[i].m_pData)
                 free(pMesh->m_pVB[i].m_pData);
 
+            if (pMesh->m_pVB[i].m_Index.m_pData)
+                free(pMesh->m_pVB[i].m_Index.m_pData);
+        }
+
         // free the static mesh vertex buffer
         free(pMesh->m_pVB);
     }
@@ -352,6 +685,22 @@ void csrMeshInit(CSR_Mesh* pMesh)
     pMesh->m_Time  = 0.0;
 }
 //---------------------------------------------------------------------------
+int csrMeshWeld(CSR_Mesh* pMesh)
+{
+    size_t i;
+
+    // no mesh to weld?
+    if (!pMesh)
+        return 0;
+
+    // weld each vertex buffer
+    for (i = 0; i < pMesh->m_Count; ++i)
+        if (!csrVertexBufferWeld(&pMesh->m_pVB[i]))
+            return 0;
+
+    return 1;
+}
+//---------------------------------------------------------------------------
 // Indexed polygon functions
 //---------------------------------------------------------------------------
 void csrIndexedPolygonInit(CSR_IndexedPolygon* pIndexedPolygon)
@@ -421,6 +770,21 @@ int csrIndexedPolygonToPolygon(const CSR_IndexedPolygon* pIndexedPolygon,
     return success;
 }
 //---------------------------------------------------------------------------
+// Indexed polygon buffer private functions
+//---------------------------------------------------------------------------
+int csrIndexedPolygonBufferAddFromVB(CSR_IndexedPolygon* pIndexedPolygon, CSR_IndexedPolygonBuffer* pIPB)
+{
+    size_t i;
+
+    // the indexed polygon offsets are in the vertex buffer drawing order, convert them to data
+    // offsets, in case the vertex buffer is indexed
+    for (i = 0; i < 3; ++i)
+        pIndexedPolygon->m_pIndex[i] = csrVertexBufferGetOffset(pIndexedPolygon->m_pVB,
+                                                                pIndexedPolygon->m_pIndex[i]);
+
+    return csrIndexedPolygonBufferAdd(pIndexedPolygon, pIPB);
+}
+//---------------------------------------------------------------------------
 // Indexed polygon buffer functions
 //---------------------------------------------------------------------------
 CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferCreate(void)
@@ -502,12 +866,14 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
         size_t                    i;
         size_t                    j;
         size_t                    index;
+        size_t                    length;
         CSR_IndexedPolygon        indexedPolygon = {0};
         CSR_IndexedPolygonBuffer* pIPB           =  0;
     #else
         size_t                    i;
         size_t                    j;
         size_t                    index;
+        size_t                    length;
         CSR_IndexedPolygon        indexedPolygon;
         CSR_IndexedPolygonBuffer* pIPB;
     #endif
@@ -533,6 +899,9 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
         // assign the reference to the source vertex buffer
         indexedPolygon.m_pVB = &pMesh->m_pVB[i];
 
+        // get the vertex buffer length in the drawing order, as if it wasn't indexed
+        length = csrVertexBufferGetVertexCount(&pMesh->m_pVB[i]) * pMesh->m_pVB[i].m_Format.m_Stride;
+
         // search for vertex type
         switch (pMesh->m_pVB[i].m_Format.m_Type)
         {
@@ -542,13 +911,13 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
                 const unsigned step = (pMesh->m_pVB[i].m_Format.m_Stride * 3);
 
                 // iterate through source vertices
-                for (j = 0; j < pMesh->m_pVB[i].m_Count; j += step)
+                for (j = 0; j < length; j += step)
                 {
                     // extract polygon from source vertex buffer and add it to polygon buffer
                     indexedPolygon.m_pIndex[0] = j;
                     indexedPolygon.m_pIndex[1] = j +  (size_t)pMesh->m_pVB[i].m_Format.m_Stride;
                     indexedPolygon.m_pIndex[2] = j + ((size_t)pMesh->m_pVB[i].m_Format.m_Stride * 2);
-                    csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
+                    csrIndexedPolygonBufferAddFromVB(&indexedPolygon, pIPB);
                 }
 
                 continue;
@@ -558,8 +927,7 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
             {
                 // calculate length to read in triangle strip buffer
                 const unsigned stripLength =
-                        (unsigned)(pMesh->m_pVB[i].m_Count -
-                                ((size_t)pMesh->m_pVB[i].m_Format.m_Stride * 2));
+                        (unsigned)(length - ((size_t)pMesh->m_pVB[i].m_Format.m_Stride * 2));
 
                 index = 0;
 
@@ -580,7 +948,7 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
                         indexedPolygon.m_pIndex[2] = j + ((size_t)pMesh->m_pVB[i].m_Format.m_Stride * 2);
                     }
 
-                    csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
+                    csrIndexedPolygonBufferAddFromVB(&indexedPolygon, pIPB);
                     ++index;
                 }
 
@@ -591,7 +959,7 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
             {
                 // calculate length to read in triangle fan buffer
                 const unsigned fanLength =
-                        (unsigned)(pMesh->m_pVB[i].m_Count - pMesh->m_pVB[i].m_Format.m_Stride);
+                        (unsigned)(length - pMesh->m_pVB[i].m_Format.m_Stride);
 
                 // iterate through source vertices
                 for (j  = pMesh->m_pVB[i].m_Format.m_Stride;
@@ -602,7 +970,7 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
                     indexedPolygon.m_pIndex[0] = 0;
                     indexedPolygon.m_pIndex[1] = j;
                     indexedPolygon.m_pIndex[2] = j + pMesh->m_pVB[i].m_Format.m_Stride;
-                    csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
+                    csrIndexedPolygonBufferAddFromVB(&indexedPolygon, pIPB);
                 }
 
                 continue;
@@ -614,7 +982,7 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
                 const unsigned step = (pMesh->m_pVB[i].m_Format.m_Stride * 4);
 
                 // iterate through source vertices
-                for (j = 0; j < pMesh->m_pVB[i].m_Count; j += step)
+                for (j = 0; j < length; j += step)
                 {
                     // calculate vertices position
                     const unsigned v1 = (unsigned) j;
@@ -626,13 +994,13 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
                     indexedPolygon.m_pIndex[0] = v1;
                     indexedPolygon.m_pIndex[1] = v2;
                     indexedPolygon.m_pIndex[2] = v3;
-                    csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
+                    csrIndexedPolygonBufferAddFromVB(&indexedPolygon, pIPB);
 
                     // extract second polygon from source buffer
                     indexedPolygon.m_pIndex[0] = v3;
                     indexedPolygon.m_pIndex[1] = v2;
                     indexedPolygon.m_pIndex[2] = v4;
-                    csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
+                    csrIndexedPolygonBufferAddFromVB(&indexedPolygon, pIPB);
                 }
 
                 continue;
@@ -645,8 +1013,7 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
 
                 // calculate length to read in triangle strip buffer
                 const unsigned stripLength =
-                        (unsigned)(pMesh->m_pVB[i].m_Count -
-                                ((size_t)pMesh->m_pVB[i].m_Format.m_Stride * 2));
+                        (unsigned)(length - ((size_t)pMesh->m_pVB[i].m_Format.m_Stride * 2));
 
                 // iterate through source vertices
                 for (j = 0; j < stripLength; j += step)
@@ -661,13 +1028,13 @@ CSR_IndexedPolygonBuffer* csrIndexedPolygonBufferFromMesh(const CSR_Mesh* pMesh)
                     indexedPolygon.m_pIndex[0] = v1;
                     indexedPolygon.m_pIndex[1] = v2;
                     indexedPolygon.m_pIndex[2] = v3;
-                    csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
+                    csrIndexedPolygonBufferAddFromVB(&indexedPolygon, pIPB);
 
                     // extract second polygon from source buffer
                     indexedPolygon.m_pIndex[0] = v3;
                     indexedPolygon.m_pIndex[1] = v2;
                     indexedPolygon.m_pIndex[2] = v4;
-                    csrIndexedPolygonBufferAdd(&indexedPolygon, pIPB);
+                    csrIndexedPolygonBufferAddFromVB(&indexedPolygon, pIPB);
                 }
 
                 continue;
@@ -58,6 +58,15 @@ typedef enum
     CSR_VT_QuadStrip
 } CSR_EVertexType;
 
+/**
+* Vertex index format
+*/
+typedef enum
+{
+    CSR_IF_16Bit,
+    CSR_IF_32Bit
+} CSR_EIndexFormat;
+
 //---------------------------------------------------------------------------
 // Structures
 //---------------------------------------------------------------------------
@@ -97,6 +106,16 @@ typedef struct
     CSR_ECullingFace m_Face;
 } CSR_VertexCulling;
 
+/**
+* Vertex index buffer
+*/
+typedef struct
+{
+    CSR_EIndexFormat m_Format;
+    void*            m_pData;  // unsigned short or unsigned int indices, depending on the format
+    size_t           m_Count;  // index count
+} CSR_IndexBuffer;
+
 /**
 * Vertex buffer
 */
@@ -106,7 +125,9 @@ typedef struct
     CSR_VertexCulling m_Culling;
     CSR_Material      m_Material;
     float*            m_pData;
-    size_t            m_Count;
+    size_t            m_Count;    // data size, in floats
+    size_t            m_Capacity; // allocated data size, in floats
+    CSR_IndexBuffer   m_Index;    // optional vertex indices, the vertex buffer isn't indexed if empty
     double            m_Time;
 } CSR_VertexBuffer;
 
@@ -236,6 +257,62 @@ typedef unsigned (*CSR_fOnGetVertexColor)(const CSR_VertexBuffer* pVB,
                                const CSR_fOnGetVertexColor fOnGetVertexColor,
                                      CSR_VertexBuffer*     pVB);
 
+        /**
+        * Reserves enough memory in a vertex buffer to contain a given number of vertices
+        *@param count - total number of vertices the vertex buffer should be able to contain
+        *@param[in, out] pVB - vertex buffer for which the memory should be reserved
+        *@return 1 on success, otherwise 0
+        *@note The vertex format stride should be calculated before this function is called
+        *@note The memory is never shrunk, nothing happens if the vertex buffer is already large
+        *      enough to contain the vertices
+        */
+        int csrVertexBufferReserve(size_t count, CSR_VertexBuffer* pVB);
+
+        /**
+        * Welds the identical vertices of a vertex buffer and replaces them by an index buffer
+        *@param[in, out] pVB - vertex buffer to weld
+        *@return 1 on success, otherwise 0
+        *@note The vertices are welded only if their whole content (position, normal, texture
+        *      coordinates and color) is identical. The vertex buffer is kept unchanged if no vertex
+        *      can be welded, or if it contains more than 65536 unique vertices, because the indices
+        *      are always 16 bit, which any OpenGL ES 2.0 device supports
+        *@note The vertex buffer should be complete before it is welded, because the vertices added
+        *      later will not be referenced by the index buffer
+        *@note BE CAREFUL, the vertex buffers whose data offsets are referenced elsewhere, e.g. by the
+        *      skin weights of a X or Collada model, should not be welded
+        */
+        int csrVertexBufferWeld(CSR_VertexBuffer* pVB);
+
+        /**
+        * Welds the identical vertices of several vertex buffers representing the frames of an
+        * animation
+        *@param[in, out] ppVB - vertex buffers to weld, one per frame
+        *@param count - vertex buffer count
+        *@return 1 on success, otherwise 0
+        *@note The vertices are welded only if they are identical in every frame, thus all the
+        *      frames get the same index buffer, and a vertex keeps the same position in the data
+        *      of each frame. The vertex buffers are kept unchanged if they differ in size or in
+        *      layout
+        *@note See csrVertexBufferWeld()
+        */
+        int csrVertexBufferWeldFrames(CSR_VertexBuffer** ppVB, size_t count);
+
+        /**
+        * Gets the number of vertices to draw in a vertex buffer
+        *@param pVB - vertex buffer
+        *@return the vertex count, or the index count if the vertex buffer is indexed
+        */
+        size_t csrVertexBufferGetVertexCount(const CSR_VertexBuffer* pVB);
+
+        /**
+        * Gets the data offset of a vertex in a vertex buffer
+        *@param pVB - vertex buffer
+        *@param offset - vertex offset, in floats, in the drawing order (i.e as if the vertex buffer
+        *                wasn't indexed)
+        *@return the vertex offset, in floats, in the vertex buffer data
+        */
+        size_t csrVertexBufferGetOffset(const CSR_VertexBuffer* pVB, size_t offset);
+
         //-------------------------------------------------------------------
         // Mesh functions
         //-------------------------------------------------------------------
@@ -260,6 +337,14 @@ typedef unsigned (*CSR_fOnGetVertexColor)(const CSR_VertexBuffer* pVB,
         */
         void csrMeshInit(CSR_Mesh* pMesh);
 
+        /**
+        * Welds the identical vertices of all the vertex buffers contained in a mesh
+        *@param[in, out] pMesh - mesh to weld
+        *@return 1 on success, otherwise 0
+        *@note See csrVertexBufferWeld()
+        */
+        int csrMeshWeld(CSR_Mesh* pMesh);
+
         //-------------------------------------------------------------------
         // Indexed polygon functions
         //-------------------------------------------------------------------
@@ -1225,6 +1225,7 @@ int csrXBuildMesh(const CSR_Item_X*           pItem,
     size_t                      index;
     size_t                      meshWeightsIndex;
     size_t                      materialIndex;
+    size_t                      vertexCount;
     unsigned                    prevColor;
     int                         hasTexture;
     CSR_Mesh*                   pMesh;
@@ -1281,6 +1282,9 @@ int csrXBuildMesh(const CSR_Item_X*           pItem,
         // initialize the mesh skin weights item
         pX->m_pMeshWeights[meshWeightsIndex].m_pSkinWeights = 0;
         pX->m_pMeshWeights[meshWeightsIndex].m_Count        = 0;
+        pX->m_pMeshWeights[meshWeightsIndex].m_pMatrices    = 0;
+        csrSkinVertexWeightsInit(&pX->m_pMeshWeights[meshWeightsIndex].m_VertexWeights);
+        csrVertexBufferInit(&pX->m_pMeshWeights[meshWeightsIndex].m_SkinnedVB);
     }
     else
         meshWeightsIndex = 0;
@@ -1560,6 +1564,17 @@ int csrXBuildMesh(const CSR_Item_X*           pItem,
                     break;
         }
 
+    vertexCount = 0;
+
+    // count the vertices the indices table will generate
+    for (i = 0; i < pMeshDataset->m_IndiceCount; i += pMeshDataset->m_pIndices[i] + 1)
+        if (pMeshDataset->m_pIndices[i])
+            vertexCount += (pMeshDataset->m_pIndices[i] - 1) * 3;
+
+    // reserve the memory for all the vertices at once
+    if (!csrVertexBufferReserve(vertexCount, pX->m_pMesh[index].m_pVB))
+        return 0;
+
     // keep the previous color, it may change while the mesh is created
     prevColor     = pX->m_pMesh[index].m_pVB->m_Material.m_Color;
     materialIndex = 0;
@@ -1658,6 +1673,7 @@ int csrXBuildAnimationSet(const CSR_Item_X* pItem, CSR_X* pX)
         // iterate through source animation keys
         for (j = 0; j < pItem->m_pChildren[i].m_ChildrenCount; ++j)
         {
+            size_t                       stride;
             CSR_AnimationKeys*           pAnimationKeys;
             CSR_Dataset_AnimationKeys_X* pData;
 
@@ -1718,38 +1734,41 @@ int csrXBuildAnimationSet(const CSR_Item_X* pItem, CSR_X* pX)
             pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_Type       = pData->m_Type;
             pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_ColOverRow = 0;
 
-            // iterate through keys
-            for (k = 0; k < pData->m_KeyCount; ++k)
-            {
-                // allocate memory for a new animation key
-                CSR_AnimationKey* pAnimationKey =
-                        (CSR_AnimationKey*)csrMemoryAlloc(pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pKey,
-                                                          sizeof(CSR_AnimationKeys),
-                                                          pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_Count + 1);
+            // no key to copy?
+            if (!pData->m_KeyCount)
+                continue;
 
-                // succeeded?
-                if (!pAnimationKey)
-                    return 0;
+            // get the value count per key
+            stride = pData->m_pKeys[0].m_Count;
 
-                // update the animation keys
-                pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pKey = pAnimationKey;
-                ++pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_Count;
+            // allocate memory for the key frames and values
+            pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pFrames =
+                    (size_t*)malloc(pData->m_KeyCount * sizeof(size_t));
+            pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pValues =
+                    (float*)malloc(pData->m_KeyCount * stride * sizeof(float));
+
+            // succeeded?
+            if (!pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pFrames ||
+                !pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pValues)
+                return 0;
 
-                // get the key frame and assign memory for values
-                pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pKey[k].m_Frame   = pData->m_pKeys[k].m_Frame;
-                pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pKey[k].m_pValues =
-                        (float*)malloc(pData->m_pKeys[k].m_Count * sizeof(float));
+            pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_Stride = stride;
+            pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_Count  = pData->m_KeyCount;
 
-                if (!pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pKey[k].m_pValues)
+            // iterate through keys
+            for (k = 0; k < pData->m_KeyCount; ++k)
+            {
+                // all the keys should contain the same value count
+                if (pData->m_pKeys[k].m_Count != stride)
                     return 0;
 
-                // get the key values
-                memcpy(pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pKey[k].m_pValues,
-                       pData->m_pKeys[k].m_pValues,
-                       pData->m_pKeys[k].m_Count * sizeof(float));
+                // get the key frame
+                pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pFrames[k] = pData->m_pKeys[k].m_Frame;
 
-                // get the key count
-                pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pKey[k].m_Count = pData->m_pKeys[k].m_Count;
+                // get the key values
+                memcpy(&pX->m_pAnimationSet[index].m_pAnimation[i].m_pKeys[j].m_pValues[k * stride],
+                        pData->m_pKeys[k].m_pValues,
+                        stride * sizeof(float));
             }
         }
     }
@@ -3745,6 +3764,19 @@ CSR_X* csrXCreate(const CSR_Buffer*           pBuffer,
                 for (j = 0; j < pX->m_pMeshWeights[i].m_Count; ++j)
                     pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pBone =
                             csrBoneFind(pX->m_pSkeleton, pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pBoneName);
+
+            // convert the skin weights per vertex, thus the skinning may be processed by the GPU
+            for (i = 0; i < pX->m_MeshWeightsCount && i < pX->m_MeshCount; ++i)
+                if (pX->m_pMeshWeights[i].m_pSkinWeights && pX->m_pMesh[i].m_Count == 1)
+                    csrSkinVertexWeightsFromGroup(&pX->m_pMeshWeights[i],
+                                                  pX->m_pMesh[i].m_pVB,
+                                                  &pX->m_pMeshWeights[i].m_VertexWeights);
+
+            // allocate the final matrix of each skin weights, thus they aren't allocated on each frame
+            for (i = 0; i < pX->m_MeshWeightsCount; ++i)
+                if (pX->m_pMeshWeights[i].m_pSkinWeights)
+                    pX->m_pMeshWeights[i].m_pMatrices =
+                            (CSR_Matrix4*)malloc(pX->m_pMeshWeights[i].m_Count * sizeof(CSR_Matrix4));
         }
 
         // animation set?
@@ -3759,6 +3791,27 @@ CSR_X* csrXCreate(const CSR_Buffer*           pBuffer,
                     pX->m_pAnimationSet[i].m_pAnimation[j].m_pBone =
                             csrBoneFind(pX->m_pSkeleton, pX->m_pAnimationSet[i].m_pAnimation[j].m_pBoneName);
         }
+
+        // create the bone pose, which calculates all the bone matrices of a frame at once
+        pX->m_pPose = csrBonePoseCreate();
+
+        // succeeded?
+        if (pX->m_pPose && csrBonePoseAddSkeleton(pX->m_pSkeleton, pX->m_pPose))
+        {
+            size_t i;
+            size_t j;
+
+            // link the animations to the bones
+            if (!pX->m_PoseOnly)
+                csrBonePoseLinkAnimSets(pX->m_pAnimationSet, pX->m_AnimationSetCount, pX->m_pPose);
+
+            // link the skin weights to the bones
+            if (pX->m_pMeshWeights)
+                for (i = 0; i < pX->m_MeshWeightsCount; ++i)
+                    for (j = 0; j < pX->m_pMeshWeights[i].m_Count; ++j)
+                        pX->m_pMeshWeights[i].m_pSkinWeights[j].m_BoneIndex =
+                                csrBonePoseGetIndex(pX->m_pPose, pX->m_pMeshWeights[i].m_pSkinWeights[j].m_pBone);
+        }
     }
 
     // release the parsed items (since now no longer used)
@@ -3825,6 +3878,8 @@ void csrXInit(CSR_X* pX)
     pX->m_pSkeleton           = 0;
     pX->m_pAnimationSet       = 0;
     pX->m_AnimationSetCount   = 0;
+    pX->m_pPose               = 0;
+    pX->m_pClips              = 0;
     pX->m_MeshOnly            = 0;
     pX->m_PoseOnly            = 0;
 }
@@ -3852,9 +3907,14 @@ void csrXRelease(CSR_X* pX, const CSR_fOnDeleteTexture fOnDeleteTexture)
             {
                 // free the mesh vertex buffer content
                 for (j = 0; j < pX->m_pMesh[i].m_Count; ++j)
+                {
                     if (pX->m_pMesh[i].m_pVB[j].m_pData)
                         free(pX->m_pMesh[i].m_pVB[j].m_pData);
 
+                    if (pX->m_pMesh[i].m_pVB[j].m_Index.m_pData)
+                        free(pX->m_pMesh[i].m_pVB[j].m_Index.m_pData);
+                }
+
                 // free the mesh vertex buffer
                 free(pX->m_pMesh[i].m_pVB);
             }
@@ -3876,6 +3936,13 @@ void csrXRelease(CSR_X* pX, const CSR_fOnDeleteTexture fOnDeleteTexture)
 
             // free the mesh skin weights
             free(pX->m_pMeshWeights[i].m_pSkinWeights);
+
+            // release the mesh vertex skin weights
+            csrSkinVertexWeightsRelease(&pX->m_pMeshWeights[i].m_VertexWeights);
+
+            // free the skin weights matrices and the skinned vertices
+            free(pX->m_pMeshWeights[i].m_pMatrices);
+            free(pX->m_pMeshWeights[i].m_SkinnedVB.m_pData);
         }
 
         // free the mesh weights
@@ -3900,7 +3967,68 @@ void csrXRelease(CSR_X* pX, const CSR_fOnDeleteTexture fOnDeleteTexture)
         free(pX->m_pAnimationSet);
     }
 
+    // release the baked animation clips
+    if (pX->m_pClips)
+    {
+        // release the baked animation clips content
+        for (i = 0; i < pX->m_AnimationSetCount; ++i)
+            csrBoneClipRelease(&pX->m_pClips[i], 1);
+
+        // free the baked animation clips
+        free(pX->m_pClips);
+    }
+
+    // release the bone pose
+    csrBonePoseRelease(pX->m_pPose, 0);
+
     // release the model
     free(pX);
 }
 //---------------------------------------------------------------------------
+int csrXBakeAnimations(CSR_X* pX, size_t frameStep, int quantize)
+{
+    size_t i;
+    size_t frameCount;
+
+    // validate the inputs
+    if (!pX || !pX->m_pPose || !pX->m_pAnimationSet || !frameStep)
+        return 0;
+
+    // create the baked animation clips, if still not done
+    if (!pX->m_pClips)
+    {
+        pX->m_pClips = (CSR_Bone_Clip*)malloc(pX->m_AnimationSetCount * sizeof(CSR_Bone_Clip));
+
+        // succeeded?
+        if (!pX->m_pClips)
+            return 0;
+
+        // initialize the baked animation clips
+        for (i = 0; i < pX->m_AnimationSetCount; ++i)
+            csrBoneClipInit(&pX->m_pClips[i]);
+    }
+
+    // bake each animation set
+    for (i = 0; i < pX->m_AnimationSetCount; ++i)
+    {
+        // get the animation set frame count
+        frameCount = csrBoneAnimSetGetFrameCount(&pX->m_pAnimationSet[i]);
+
+        // nothing to bake?
+        if (!frameCount)
+            continue;
+
+        // bake the animation set
+        if (!csrBoneClipBake(pX->m_pPose,
+                             i,
+                             frameCount,
+                             frameStep,
+                             0,
+                             quantize,
+                             &pX->m_pClips[i]))
+            return 0;
+    }
+
+    return 1;
+}
+//---------------------------------------------------------------------------